@@ -22,6 +22,7 @@
 #include <cassert>
 #include <iostream>
 #include <set>
+#include <unistd.h>
 
 /*--------------------------------------------------------------------------*/
 
@@ -38,9 +39,9 @@ bool caliper_procedure(File &file, Cursor c, bool internal_procedure,
 bool exclude_procedure(Procedure const &subp);
 void count_return_stmts(Procedure const &proc, int &num_if_stmt_returns,
                         int &num_internal_returns, int &num_final_returns);
-void convert_return_stmts(Procedure &proc, int label);
+void convert_return_stmts(File &file, Procedure &proc, int label);
 bool caliper_file(std::string const &filename);
-void write_file(std::ostream &os, File const &f);
+bool write_file(int fd, File const &f);
 
 /*--------------------------------------------------------------------------*/
 
@@ -63,9 +64,8 @@ bool caliper_file(std::string const &filename) {
 
   FLPR::Procedure_Visitor puv(file, caliper_procedure);
   bool const changed = puv.visit();
-  if (changed) {
-    write_file(std::cout, file);
-  }
+  if (changed && !write_file(STDOUT_FILENO, file))
+    return false;
   return changed;
 }
 
@@ -149,7 +149,7 @@ bool caliper_procedure(File &file, Cursor c, bool internal_procedure,
       /* apply the new label */
       file.logical_file().set_stmt_label(end_it, new_label);
     }
-    convert_return_stmts(proc, new_label);
+    convert_return_stmts(file, proc, new_label);
   }
   return true;
 }
@@ -210,11 +210,13 @@ void count_return_stmts(Procedure const &proc, int &num_if_stmt_returns,
 
 /*--------------------------------------------------------------------------*/
 
-void convert_return_stmts(Procedure &proc, int label) {
+void convert_return_stmts(File &file, Procedure &proc, int label) {
   /* for each return-stmt that we want to replace, we need the LL_Stmt iterator
-     that holds it, and the LL_TT_Range of the return_stmt. */
+     that holds it, and the LL_TT_Range of the return_stmt.  The replacements
+     are collected in a transaction and applied together at the end. */
 
   std::string const goto_stmt = "go to " + std::to_string(label);
+  FLPR::Edit_Transaction edits{file.logical_file()};
 
   Procedure::Region_Iterator ebegin = proc.begin(Procedure::EXECUTION_PART);
   Procedure::Region_Iterator eend = proc.end(Procedure::EXECUTION_PART);
@@ -232,19 +234,24 @@ void convert_return_stmts(Procedure &proc, int label) {
         assert(TAG(SG_ACTION_STMT) == scursor->syntag);
         scursor.down();
         assert(TAG(SG_RETURN_STMT) == scursor->syntag);
-        proc.replace_stmt_substr(llsi, scursor->token_range, goto_stmt);
+        edits.replace_stmt_substr(llsi, scursor->token_range, goto_stmt);
       }
     } else if (TAG(SG_RETURN_STMT) == stmt_tag) {
       assert(std::next(llsi) != eend); // should be gone already
-      proc.replace_stmt(llsi, goto_stmt, TAG(SG_GOTO_STMT));
+      edits.replace_stmt_text(llsi, goto_stmt, TAG(SG_GOTO_STMT));
     }
   }
+  if (!edits.commit())
+    std::cerr << "unable to convert the return statements in " << proc.name()
+              << std::endl;
 }
 
 /*--------------------------------------------------------------------------*/
 
-void write_file(std::ostream &os, File const &f) {
-  for (auto const &ll : f.logical_lines()) {
-    os << ll;
-  }
+bool write_file(int fd, File const &f) {
+  /* Only the edited procedures are rendered: the rest of the file is copied
+     straight from the input */
+  FLPR::Text_Writer out;
+  out.append(f.logical_lines());
+  return out.write(fd);
 }
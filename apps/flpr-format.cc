@@ -22,9 +22,22 @@
 
 #include "flpr_format_base.hh"
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+/* Define the indentation pattern based on the input format. It would be nice
+   if this was setup from an external configuration file */
+void select_indents(FLPR::Indent_Table &indents, File const &file,
+                    Options const &options) {
+  if (file.logical_file().is_fixed_format() && !options[OPT(FIXED_TO_FREE)]) {
+    indents.apply_constant_fixed_indent(4);
+    indents.set_continued_offset(5);
+  } else {
+    indents.apply_emacs_indent();
+  }
+}
+
 int main(int argc, char *const argv[]) {
 
   /* Read the command-line arguments */
@@ -45,22 +58,15 @@ int main(int argc, char *const argv[]) {
      below. */
   FLPR::Indent_Table indents;
 
+  /* The output of every file is rendered into the same buffer, which grows
+     to fit the largest one */
+  FLPR::Text_Writer out;
+
   /* Process each input file */
+  int status = 0;
   for (auto const &fname : filenames) {
-    File file;
-    VERBOSE_BEGIN("read_file");
-    file.read_file(fname, options[OPT(COL72)] ? 72 : 0);
-    VERBOSE_END;
-    /* Define the indentation pattern based on the input format. It would be
-       nice if this was setup from an external configuration file */
-    if (file.logical_file().is_fixed_format() && !options[OPT(FIXED_TO_FREE)]) {
-      indents.apply_constant_fixed_indent(4);
-      indents.set_continued_offset(5);
-    } else {
-      indents.apply_emacs_indent();
-    }
-    if (flpr_format_file(file, options, indents)) {
-      std::cerr << "Error formating file \"" << fname << "\"" << std::endl;
-    }
+    if (!flpr_format_named_file(fname, options, select_indents, indents, out))
+      status = 1;
   }
+  return status;
 }
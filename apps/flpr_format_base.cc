@@ -20,6 +20,7 @@
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <unistd.h>
 
 /* Define a handy shortcut */
@@ -34,7 +35,8 @@ bool split_compound_stmts(typename FLPR::LL_List &ll_seq);
 /* -------------------------------------------------------------------------- */
 
 int flpr_format_file(File &file, Options const &options,
-                     FLPR::Indent_Table const &indents) {
+                     FLPR::Indent_Table const &indents,
+                     FLPR::Text_Writer &out) {
   if (file) {
     bool do_write = false;
 
@@ -106,13 +108,17 @@ int flpr_format_file(File &file, Options const &options,
     }
 
     /* now, if any transformation made a change, write the output. */
-    if (options.do_output() || (do_write && !options.quiet())) {
+    if (options.write_inplace()) {
+      /* The caller replaces the file once all of it has been rendered, and
+         only if the text actually changed */
+      VERBOSE_BEGIN("render");
+      write_file(out, file);
+      VERBOSE_END;
+    } else if (options.do_output() || (do_write && !options.quiet())) {
       VERBOSE_BEGIN("write");
-      if (options.write_inplace()) {
-        std::cerr << "write in place not implemented yet" << '\n';
-      } else {
-        write_file(std::cout, file);
-      }
+      write_file(out, file);
+      if (!out.write(STDOUT_FILENO))
+        return 1;
       VERBOSE_END;
     } else {
       if (options.verbose())
@@ -122,6 +128,55 @@ int flpr_format_file(File &file, Options const &options,
   return 0;
 }
 
+bool flpr_format_named_file(std::string const &fname, Options const &options,
+                            Indent_Selector select_indents,
+                            FLPR::Indent_Table &indents,
+                            FLPR::Text_Writer &out) {
+  int const last_fixed_col = options[OPT(COL72)] ? 72 : 0;
+  std::shared_ptr<FLPR::Text_Buffer const> buffer;
+  VERBOSE_BEGIN("read_file");
+  buffer = FLPR::Text_Buffer::from_file(fname);
+  VERBOSE_END;
+  if (!buffer) {
+    std::cerr << "Unable to open file \"" << fname << "\" for reading"
+              << std::endl;
+    return false;
+  }
+  bool ok = true;
+  if (options.by_unit()) {
+    /* Each program unit is formatted and rendered, then released before the
+       next one is read, so a huge file doesn't have to fit in memory. */
+    FLPR::Unit_Stream<> units{buffer, fname, last_fixed_col};
+    while (auto unit = units.next()) {
+      select_indents(indents, *unit, options);
+      bool const formatted = !flpr_format_file(*unit, options, indents, out);
+      ok = formatted && bool(*unit) && ok;
+    }
+    ok = ok && !units.failed();
+  } else {
+    FLPR::Logical_File lf;
+    ok = lf.scan(buffer, fname, last_fixed_col);
+    File file{std::move(lf)};
+    if (ok) {
+      select_indents(indents, file, options);
+      ok = !flpr_format_file(file, options, indents, out) && bool(file);
+    }
+  }
+  /* Never replace a file with the rendering of a failed scan or parse */
+  if (ok && options.write_inplace()) {
+    bool const changed = (out.text() != buffer->text());
+    ok = out.replace_file(fname, buffer->text());
+    if (ok && options.verbose())
+      std::cerr << fname << (changed ? ": rewritten" : ": unchanged")
+                << std::endl;
+  }
+  out.clear();
+  if (!ok) {
+    std::cerr << "Error formating file \"" << fname << "\"" << std::endl;
+  }
+  return ok;
+}
+
 bool remove_empty_stmts(typename FLPR::LL_List &ll_seq) {
   bool changed = false;
   for (FLPR::Logical_Line &ll : ll_seq) {
@@ -195,14 +250,12 @@ bool elaborate_end_stmts(File &f) {
   return false;
 }
 
-void write_file(std::ostream &os, File const &f) {
-  for (auto const &ll : f.logical_lines()) {
-    os << ll;
-  }
+void write_file(FLPR::Text_Writer &out, File const &f) {
+  out.append(f.logical_lines());
 }
 
 void print_usage(std::ostream &os) {
-  os << "usage: flpr-format [-foqtv] file ...\n";
+  os << "usage: flpr-format [-cefioqtuvw] file ...\n";
   os << "\t-c\ttreat fixed-format input past col 72 as comments\n";
   os << "\t-e\telaborate procedure END statements\n";
   os << "\t-f\tdo fixed-format to free-format conversion\n";
@@ -210,13 +263,15 @@ void print_usage(std::ostream &os) {
   os << "\t-o\tforce output, even if no changes\n";
   os << "\t-q\tquiet: no output of any kind \n";
   os << "\t-t\ttime each phase\n";
+  os << "\t-u\tread and write one program unit at a time (implies -o)\n";
   os << "\t-v\tshow transformation phases\n";
+  os << "\t-w\twrite the output back to each file, if it changed\n";
 }
 
 bool parse_cmd_line(std::vector<std::string> &filenames, Options &options,
                     int argc, char *const argv[]) {
   int ch;
-  while ((ch = getopt(argc, argv, "cefioqtv")) != -1) {
+  while ((ch = getopt(argc, argv, "cefioqtuvw")) != -1) {
     switch (ch) {
     case 'c':
       options[Options::COL72] = true;
@@ -243,9 +298,17 @@ bool parse_cmd_line(std::vector<std::string> &filenames, Options &options,
       options.set_do_timing(true);
       options.set_verbose(true);
       break;
+    case 'u':
+      /* every unit has to be written to reproduce the whole file */
+      options.set_by_unit(true);
+      options.set_do_output(true);
+      break;
     case 'v':
       options.set_verbose(true);
       break;
+    case 'w':
+      options.set_write_inplace(true);
+      break;
     default:
       std::cerr << "unknown option\n";
       print_usage(std::cerr);
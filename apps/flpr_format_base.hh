@@ -30,8 +30,8 @@ struct Options {
   };
 
   Options() noexcept
-      : write_inplace_{false}, verbose_{false}, do_timing_{false}, quiet_{
-                                                                       false} {
+      : write_inplace_{false}, verbose_{false}, do_timing_{false},
+        quiet_{false}, do_output_{false}, by_unit_{false} {
     disable_all_filters();
   }
   void disable_all_filters() noexcept { filters_.fill(false); }
@@ -54,6 +54,8 @@ struct Options {
   constexpr bool quiet() const noexcept { return quiet_; }
   constexpr void set_do_output(bool const val) noexcept { do_output_ = val; }
   constexpr bool do_output() const noexcept { return do_output_; }
+  constexpr void set_by_unit(bool const val) noexcept { by_unit_ = val; }
+  constexpr bool by_unit() const noexcept { return by_unit_; }
 
 private:
   bool write_inplace_;
@@ -61,6 +63,7 @@ private:
   bool do_timing_;
   bool quiet_;
   bool do_output_;
+  bool by_unit_;
   std::array<bool, NUM_FILTERS> filters_;
 };
 
@@ -71,8 +74,20 @@ using File = FLPR::Parsed_File<>;
 bool parse_cmd_line(std::vector<std::string> &filenames, Options &options,
                     int argc, char *const argv[]);
 int flpr_format_file(File &file, Options const &options,
-                     FLPR::Indent_Table const &indents);
-void write_file(std::ostream &os, File const &file);
+                     FLPR::Indent_Table const &indents,
+                     FLPR::Text_Writer &out);
+void write_file(FLPR::Text_Writer &out, File const &file);
+
+/* Choose the indentation pattern for a file (or a program unit of one) */
+using Indent_Selector = void (*)(FLPR::Indent_Table &indents, File const &file,
+                                 Options const &options);
+
+/* Read, format, and output (or rewrite in place) the named file.  Returns
+   false on any error, in which case the file is left as it was. */
+bool flpr_format_named_file(std::string const &fname, Options const &options,
+                            Indent_Selector select_indents,
+                            FLPR::Indent_Table &indents,
+                            FLPR::Text_Writer &out);
 
 #define OPT(T) Options::T
 /* -------------------------------------------------------------------------- */
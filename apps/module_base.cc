@@ -91,7 +91,7 @@ bool Module_Action::operator()(File &file, Cursor c,
   for (auto &stmt : use_stmts) {
     Stmt_Cursor use_c = find_use_module_name(stmt);
     assert(use_c->token_range.size() == 1);
-    if (use_c->token_range.front().lower() == module_lc_)
+    if (use_c->token_range.front().symbol() == module_symbol_)
       found = true;
   }
 
@@ -107,8 +107,9 @@ bool Module_Action::operator()(File &file, Cursor c,
 
 /*--------------------------------------------------------------------------*/
 
-bool has_call_named(FLPR::LL_Stmt const &stmt,
-                    std::unordered_set<std::string> const &lowercase_names) {
+bool has_call_named(
+    FLPR::LL_Stmt const &stmt,
+    std::unordered_set<FLPR::Symbol_Table::Symbol> const &name_symbols) {
   int const stmt_tag = stmt.syntax_tag();
   if (TAG(SG_CALL_STMT) != stmt_tag && TAG(SG_IF_STMT) != stmt_tag)
     return false;
@@ -157,8 +158,7 @@ bool has_call_named(FLPR::LL_Stmt const &stmt,
      binding-name (depending on the type of procedure-designator).  See if it is
      listed in our set of matchers */
   assert(TAG(TK_NAME) == c->syntag);
-  std::string lname = c->token_range.front().lower();
-  return (lowercase_names.count(lname) == 1);
+  return (name_symbols.count(c->token_range.front().symbol()) == 1);
 }
 
 Stmt_Cursor find_use_module_name(FLPR::LL_Stmt &stmt) {
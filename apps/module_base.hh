@@ -40,13 +40,11 @@ public:
                 std::vector<std::string> &&only_names)
       : module_name_{std::move(module_name)}, only_names_{
                                                   std::move(only_names)} {
-    module_lc_ = module_name_;
-    FLPR::tolower(module_lc_);
+    module_symbol_ = FLPR::Symbol_Table::global().intern(module_name_);
     assert(only_names_.empty());
   }
-  void add_subroutine_name(std::string name) {
-    FLPR::tolower(name);
-    subroutine_names_.emplace(std::move(name));
+  void add_subroutine_name(std::string const &name) {
+    subroutine_names_.emplace(FLPR::Symbol_Table::global().intern(name));
   }
 
   bool operator()(File &file, Cursor c, bool const internal_procedure,
@@ -55,15 +53,16 @@ public:
 private:
   std::string module_name_;
   std::vector<std::string> only_names_;
-  std::unordered_set<std::string> subroutine_names_;
-  std::string module_lc_;
+  std::unordered_set<FLPR::Symbol_Table::Symbol> subroutine_names_;
+  FLPR::Symbol_Table::Symbol module_symbol_;
 };
 
 bool do_file(std::string const &filename, int const last_fixed_col,
              FLPR::File_Type file_type, Module_Action const &action);
 void write_file(std::ostream &os, File const &f);
-bool has_call_named(FLPR::LL_Stmt const &stmt,
-                    std::unordered_set<std::string> const &lowercase_names);
+bool has_call_named(
+    FLPR::LL_Stmt const &stmt,
+    std::unordered_set<FLPR::Symbol_Table::Symbol> const &name_symbols);
 
 Stmt_Cursor find_use_module_name(FLPR::LL_Stmt &stmt);
 FLPR::File_Type file_type_from_ext(std::string const &filename);
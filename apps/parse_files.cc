@@ -14,11 +14,26 @@
   This executable just runs the FLPR parser on a list of files.
 */
 
+#include "Timer.hh"
 #include "flpr/Logical_File.hh"
+#include "flpr/Parse_Cache.hh"
 #include "flpr/Prgm_Parsers.hh"
 #include "flpr/Prgm_Tree.hh"
+#include "flpr/Stmt_Memo.hh"
+#include "flpr/Tree_Image_Writer.hh"
+#include "flpr/Work_Stealing_Pool.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
 
 using Parse = FLPR::Prgm::Parsers<FLPR::Prgm::Prgm_Node_Data>;
@@ -29,61 +44,216 @@ struct File {
   Parse_Tree parse_tree;
 };
 
-bool read_file(std::string const &filename, std::vector<File> &files,
-               bool const col72);
+//! The size limit for a -C cache directory
+constexpr std::uintmax_t cache_max_bytes = std::uintmax_t{1} << 30;
+//! The suffix of the -t tree image files
+constexpr char const image_suffix[] = ".flprt";
+
+bool read_file(std::string const &filename, std::ostream &os,
+               bool const col72, FLPR::Parse_Cache *cache,
+               bool const write_image, int const scan_threads = 1);
+bool load_file(std::string const &filename, std::ostream &os,
+               bool const col72, FLPR::Parse_Cache &cache,
+               bool const write_image);
+void parallel_read_files(std::vector<std::string> const &filenames,
+                         int const num_threads, bool const col72,
+                         FLPR::Parse_Cache *cache, bool const write_image);
 bool parse_cmd_line(std::vector<std::string> &filenames, int argc,
-                    char *const argv[], bool &col72);
+                    char *const argv[], bool &col72, int &num_threads,
+                    bool &memoize, std::string &cache_dir,
+                    bool &write_image);
 
 int main(int argc, char *const argv[]) {
   std::vector<std::string> filenames;
   bool col72{false};
+  int num_threads{1};
+  bool memoize{false};
+  std::string cache_dir;
+  bool write_image{false};
 
-  if (!parse_cmd_line(filenames, argc, argv, col72)) {
-    std::cerr << "Usage: parse_files [-c] {-f <filename> | <filename>+}\n";
+  if (!parse_cmd_line(filenames, argc, argv, col72, num_threads, memoize,
+                      cache_dir, write_image)) {
+    std::cerr << "Usage: parse_files [-c] [-m] [-t] [-j <num_threads>] [-C "
+                 "<cache_dir>] {-f <filename> | <filename>+}\n";
     std::cerr << "\t-c\t\tenforce 72-column limit in fixed format\n";
+    std::cerr << "\t-C\t\tkeep parse results in a cache directory, and "
+                 "reuse them\n\t\t\tfor unchanged files\n";
     std::cerr << "\t-f\t\tprovide a list of files to process\n";
+    std::cerr << "\t-j\t\tnumber of files to process concurrently (0 -> "
+                 "one per hardware thread),\n\t\t\tor of threads to scan a "
+                 "single file with\n";
+    std::cerr << "\t-m\t\tmemoize sub-rules in the statement parsers\n";
+    std::cerr << "\t-t\t\twrite the parse tree of each file to "
+                 "<filename>"
+              << image_suffix << '\n';
     std::cerr << "exiting on error." << std::endl;
     return 1;
   }
 
-  std::vector<File> files;
-  for (auto const &f : filenames) {
-    read_file(f, files, col72);
+  FLPR::Stmt::Stmt_Memo::set_enabled(memoize);
+  std::unique_ptr<FLPR::Parse_Cache> cache;
+  if (!cache_dir.empty())
+    cache = std::make_unique<FLPR::Parse_Cache>(cache_dir, cache_max_bytes);
+  Timer total;
+  total.start();
+  if (num_threads == 1 || filenames.size() == 1) {
+    /* The threads can still share the scan of a single file */
+    if (cache)
+      cache->set_scan_threads(num_threads);
+    for (auto const &f : filenames) {
+      read_file(f, std::cout, col72, cache.get(), write_image, num_threads);
+    }
+  } else {
+    parallel_read_files(filenames, num_threads, col72, cache.get(),
+                        write_image);
   }
-  std::cout << "done." << std::endl;
+  total.stop();
+  if (cache) {
+    auto const stats = cache->stats();
+    std::cout << "cache: " << stats.hits << " hits, " << stats.misses
+              << " misses, " << stats.stores << " stores, " << stats.evictions
+              << " evictions.\n";
+  }
+  std::cout << "done (" << total << ")." << std::endl;
   return 0;
 }
 
-bool read_file(std::string const &filename, std::vector<File> &files,
-               bool const col72) {
+/* Write a Tree_Image of a parse tree next to the file it came from */
+template <typename TREE>
+bool save_image(std::string const &filename, std::ostream &os,
+                TREE const &tree) {
+  FLPR::Tree_Image_Writer writer;
+  std::string const image_name{filename + image_suffix};
+  if (!writer.encode(tree, filename) || !writer.save(image_name)) {
+    os << "\ttree image FAILED" << std::endl;
+    return false;
+  }
+  os << "\twrote " << writer.image().size() << " byte tree image to '"
+     << image_name << "'." << std::endl;
+  return true;
+}
+
+bool read_file(std::string const &filename, std::ostream &os,
+               bool const col72, FLPR::Parse_Cache *cache,
+               bool const write_image, int const scan_threads) {
+  if (cache)
+    return load_file(filename, os, col72, *cache, write_image);
   File f;
-  std::cout << "Processing: '" << filename << "'"
-            << "\n\tscanning..." << std::endl;
-  if (!f.logical_file.read_and_scan(filename, (col72) ? 72 : 0)) {
-    std::cout << "\tread/scan FAILED" << std::endl;
+  f.logical_file.set_scan_threads(scan_threads);
+  Timer scan_timer, parse_timer;
+  os << "Processing: '" << filename << "'"
+     << "\n\tscanning..." << std::endl;
+  scan_timer.start();
+  bool const scanned = f.logical_file.read_and_scan(filename, (col72) ? 72 : 0);
+  scan_timer.stop();
+  if (!scanned) {
+    os << "\tread/scan FAILED" << std::endl;
     return false;
   }
-  std::cout << "\tscan created " << f.logical_file.lines.size()
-            << " logical lines from " << f.logical_file.num_input_lines
-            << " input text lines." << std::endl;
-  std::cout << "\tparsing..." << std::endl;
+  os << "\tscan created " << f.logical_file.lines.size()
+     << " logical lines from " << f.logical_file.num_input_lines
+     << " input text lines in " << scan_timer << '.' << std::endl;
+  os << "\tparsing..." << std::endl;
+  parse_timer.start();
   f.logical_file.make_stmts();
   Parse::State state(f.logical_file.ll_stmts);
   auto result{Parse::program(state)};
+  parse_timer.stop();
   if (!result.match) {
-    std::cout << "\tparsing FAILED" << std::endl;
+    os << "\tparsing FAILED after " << parse_timer << std::endl;
     return false;
   }
 
   auto c{result.parse_tree.ccursor()};
-  std::cout << "\troot rule \"" << *c << "\" has " << c.node().num_branches()
-            << " branches. " << '\n';
+  os << "\troot rule \"" << *c << "\" has " << c.node().num_branches()
+     << " branches, parsed in " << parse_timer << ".\n";
 
   f.parse_tree.swap(result.parse_tree);
 
+  if (write_image)
+    return save_image(filename, os, f.parse_tree);
+  return true;
+}
+
+/* Scan and parse a file through a Parse_Cache */
+bool load_file(std::string const &filename, std::ostream &os,
+               bool const col72, FLPR::Parse_Cache &cache,
+               bool const write_image) {
+  Timer load_timer;
+  os << "Processing: '" << filename << "'"
+     << "\n\tloading..." << std::endl;
+  load_timer.start();
+  auto f = cache.load(filename, (col72) ? 72 : 0);
+  load_timer.stop();
+  if (!f) {
+    os << "\tload FAILED after " << load_timer << std::endl;
+    return false;
+  }
+  os << "\tloaded " << f.logical_lines().size() << " logical lines from "
+     << f.logical_file().num_input_lines << " input text lines";
+  if (!f.parse_tree().empty()) {
+    auto c{f.parse_tree().ccursor()};
+    os << ", root rule \"" << *c << "\" has " << c.node().num_branches()
+       << " branches,";
+  }
+  os << " in " << load_timer << ".\n";
+  if (write_image)
+    return save_image(filename, os, f.parse_tree());
   return true;
 }
 
+//! Return the size of the named file, or zero if it can't be determined
+off_t file_size(std::string const &filename) {
+  struct stat sb;
+  if (stat(filename.c_str(), &sb) != 0)
+    return 0;
+  return sb.st_size;
+}
+
+/* Process the files on a Work_Stealing_Pool.  The largest files are scheduled
+   first, so that a big file picked up late doesn't leave one thread running
+   long after the others have finished.  Each file writes its report into its
+   own buffer, and the reports are emitted in command-line order as soon as
+   all of their predecessors are complete.  Each File is released once its
+   report is written. */
+void parallel_read_files(std::vector<std::string> const &filenames,
+                         int const num_threads, bool const col72,
+                         FLPR::Parse_Cache *cache, bool const write_image) {
+  size_t const N = filenames.size();
+  std::vector<off_t> sizes(N);
+  std::transform(filenames.begin(), filenames.end(), sizes.begin(), file_size);
+  std::vector<size_t> order(N);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+    return sizes[a] > sizes[b];
+  });
+
+  std::vector<std::ostringstream> reports(N);
+  std::vector<char> done(N, 0);
+  size_t next_report{0};
+  std::mutex report_mutex;
+
+  std::vector<FLPR::Work_Stealing_Pool::Task> tasks;
+  tasks.reserve(N);
+  for (size_t const i : order) {
+    tasks.emplace_back([&, i]() {
+      read_file(filenames[i], reports[i], col72, cache, write_image);
+      std::lock_guard<std::mutex> lock(report_mutex);
+      done[i] = 1;
+      while (next_report < N && done[next_report]) {
+        std::cout << reports[next_report].str();
+        reports[next_report] = std::ostringstream{};
+        next_report += 1;
+      }
+      std::cout.flush();
+    });
+  }
+
+  FLPR::Work_Stealing_Pool pool(num_threads);
+  pool.run(std::move(tasks));
+  assert(next_report == N);
+}
+
 bool file_list_from_file(std::vector<std::string> &filenames,
                          char const *file_list_name) {
   std::ifstream is(file_list_name);
@@ -102,21 +272,50 @@ bool file_list_from_file(std::vector<std::string> &filenames,
 }
 
 bool parse_cmd_line(std::vector<std::string> &filenames, int argc,
-                    char *const argv[], bool &col72) {
+                    char *const argv[], bool &col72, int &num_threads,
+                    bool &memoize, std::string &cache_dir,
+                    bool &write_image) {
   int ch;
   bool has_filelist{false};
   col72 = false;
+  num_threads = 1;
+  memoize = false;
+  write_image = false;
 
-  while ((ch = getopt(argc, argv, "cf:")) != -1) {
+  while ((ch = getopt(argc, argv, "cC:f:j:mt")) != -1) {
     switch (ch) {
     case 'c':
       col72 = true;
       break;
+    case 'C':
+      cache_dir = optarg;
+      break;
     case 'f':
       if (!file_list_from_file(filenames, optarg))
         return false;
       has_filelist = true;
       break;
+    case 'j': {
+      char *end{nullptr};
+      errno = 0;
+      long const val = std::strtol(optarg, &end, 10);
+      if (end == optarg || *end != '\0' || errno == ERANGE || val < 0 ||
+          val > std::numeric_limits<int>::max()) {
+        std::cerr << "number of threads must be a non-negative integer"
+                  << std::endl;
+        return false;
+      }
+      num_threads = static_cast<int>(val);
+      if (num_threads == 0)
+        num_threads = std::max(1U, std::thread::hardware_concurrency());
+      break;
+    }
+    case 'm':
+      memoize = true;
+      break;
+    case 't':
+      write_image = true;
+      break;
     default:
       std::cerr << "unknown option" << std::endl;
       return false;
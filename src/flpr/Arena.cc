@@ -0,0 +1,78 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Arena.cc
+*/
+
+#include "flpr/Arena.hh"
+#include <algorithm>
+
+namespace FLPR {
+
+thread_local Arena *Arena::current_{nullptr};
+
+namespace {
+//! Blocks stop growing at this size
+constexpr std::size_t max_block_size{4 * 1024 * 1024};
+//! The space reserved at the front of each block for the Block_ header
+constexpr std::size_t header_size{alignof(std::max_align_t)};
+} // namespace
+
+Arena::Arena(std::size_t first_block_size)
+    : next_block_size_{std::max(first_block_size, 4 * header_size)} {}
+
+Arena::~Arena() {
+  while (blocks_) {
+    Block_ *const next = blocks_->next;
+    ::operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+Arena::Block_ *Arena::new_block_(std::size_t bytes) {
+  Block_ *const b = static_cast<Block_ *>(::operator new(bytes));
+  bytes_reserved_ += bytes;
+  num_blocks_ += 1;
+  return b;
+}
+
+void *Arena::allocate_slow_(std::size_t bytes, std::size_t align) {
+  std::size_t const need = header_size + bytes + align;
+
+  /* Requests that would use up a good part of a regular block get a block of
+     their own, which is linked in behind the current block so that the space
+     left in the current block isn't wasted. */
+  if (need > next_block_size_ / 4) {
+    Block_ *const b = new_block_(need);
+    if (blocks_) {
+      b->next = blocks_->next;
+      blocks_->next = b;
+    } else {
+      b->next = nullptr;
+      blocks_ = b;
+    }
+    char *const start = reinterpret_cast<char *>(b) + header_size;
+    std::size_t const pad =
+        (-reinterpret_cast<std::uintptr_t>(start)) & (align - 1);
+    bytes_allocated_ += bytes;
+    return start + pad;
+  }
+
+  Block_ *const b = new_block_(next_block_size_);
+  b->next = blocks_;
+  blocks_ = b;
+  cur_ = reinterpret_cast<char *>(b) + header_size;
+  end_ = reinterpret_cast<char *>(b) + next_block_size_;
+  next_block_size_ = std::min(2 * next_block_size_, max_block_size);
+  return allocate(bytes, align);
+}
+
+} // namespace FLPR
@@ -0,0 +1,205 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Arena.hh
+
+  A monotonic memory arena, and the allocator that the FLPR containers use to
+  draw from it.
+*/
+
+#ifndef FLPR_ARENA_HH
+#define FLPR_ARENA_HH 1
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace FLPR {
+
+//! A monotonic (bump-pointer) memory arena
+/*!
+  Memory is carved sequentially out of large blocks, and is only returned to
+  the system when the Arena is destroyed.  This makes allocation very cheap,
+  and makes it possible to release all of the nodes of a big structure (e.g. a
+  Logical_File) at once.  The trade-off is that memory which is deallocated
+  before the Arena is destroyed is not reused.
+
+  An Arena is not thread-safe: each one should only be used by one thread at a
+  time.  Containers are given their Arena through an Arena_Allocator, except
+  for Trees, which draw from the Arena of the innermost Arena::Scope (see
+  Scope_Allocator).
+*/
+class Arena {
+public:
+  explicit Arena(std::size_t first_block_size = 64 * 1024);
+  Arena(Arena const &) = delete;
+  Arena(Arena &&) = delete;
+  Arena &operator=(Arena const &) = delete;
+  Arena &operator=(Arena &&) = delete;
+  ~Arena();
+
+  //! Return \p bytes of storage aligned to \p align (a power of two)
+  void *allocate(std::size_t bytes, std::size_t align) {
+    assert(align && !(align & (align - 1)));
+    std::size_t const pad = (-reinterpret_cast<std::uintptr_t>(cur_)) &
+                            (align - 1);
+    if (bytes + pad <= static_cast<std::size_t>(end_ - cur_)) {
+      void *const result = cur_ + pad;
+      cur_ += pad + bytes;
+      bytes_allocated_ += bytes;
+      return result;
+    }
+    return allocate_slow_(bytes, align);
+  }
+
+  //! The number of bytes handed out by allocate()
+  constexpr std::size_t bytes_allocated() const noexcept {
+    return bytes_allocated_;
+  }
+  //! The number of bytes obtained from the system
+  constexpr std::size_t bytes_reserved() const noexcept {
+    return bytes_reserved_;
+  }
+  //! The number of blocks obtained from the system
+  constexpr std::size_t num_blocks() const noexcept { return num_blocks_; }
+
+  //! The Arena used by default-constructed Scope_Allocators on this thread
+  /*! This returns nullptr when no Scope is active. */
+  static Arena *current() noexcept { return current_; }
+
+  //! Make an Arena current on this thread for the lifetime of the Scope
+  /*! Scopes nest: the previously current Arena (which may be nullptr) is
+      restored when a Scope is destroyed. */
+  class Scope {
+  public:
+    explicit Scope(Arena *arena) noexcept : prev_{current_} {
+      current_ = arena;
+    }
+    Scope(Scope const &) = delete;
+    Scope &operator=(Scope const &) = delete;
+    ~Scope() { current_ = prev_; }
+
+  private:
+    Arena *prev_;
+  };
+
+private:
+  //! The header at the start of each block obtained from the system
+  struct Block_ {
+    Block_ *next;
+  };
+
+  void *allocate_slow_(std::size_t bytes, std::size_t align);
+  Block_ *new_block_(std::size_t bytes);
+
+private:
+  //! The list of blocks, most recent first (except for oversize requests)
+  Block_ *blocks_{nullptr};
+  //! The next free byte in the current block
+  char *cur_{nullptr};
+  //! One past the last byte of the current block
+  char *end_{nullptr};
+  //! The size of the next block to allocate
+  std::size_t next_block_size_;
+  std::size_t bytes_allocated_{0};
+  std::size_t bytes_reserved_{0};
+  std::size_t num_blocks_{0};
+
+  static thread_local Arena *current_;
+};
+
+//! An allocator that draws from an Arena, or from the heap if there is none
+/*!
+  A default-constructed Arena_Allocator has no Arena, and behaves like
+  std::allocator.  A container that is constructed with an Arena_Allocator for
+  an Arena draws from that Arena for as long as it lives, but copies of it go
+  back to the heap.
+
+  Deallocation from an Arena is a no-op, so the Arena must outlive every
+  container that uses it.
+*/
+template <class T> class Arena_Allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  Arena_Allocator() noexcept : arena_{nullptr} {}
+  explicit Arena_Allocator(Arena *arena) noexcept : arena_{arena} {}
+  template <class U>
+  Arena_Allocator(Arena_Allocator<U> const &other) noexcept
+      : arena_{other.arena()} {}
+
+  T *allocate(std::size_t n) {
+    if (!arena_)
+      return std::allocator<T>{}.allocate(n);
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_alloc{};
+    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (!arena_)
+      std::allocator<T>{}.deallocate(p, n);
+  }
+
+  //! Copies of containers draw from the heap, not the original's Arena
+  Arena_Allocator select_on_container_copy_construction() const noexcept {
+    return Arena_Allocator{};
+  }
+
+  constexpr Arena *arena() const noexcept { return arena_; }
+
+private:
+  //! The source of memory (nullptr means use the heap)
+  Arena *arena_;
+};
+
+//! An Arena_Allocator that draws from the Arena of the innermost Arena::Scope
+/*!
+  The parsers build Trees from the bottom up, deep inside of recursive calls,
+  so there is no one place to hand them an Arena.  Tree uses this allocator
+  instead: each default-constructed one, and so each node, draws from
+  Arena::current() at the time.
+*/
+template <class T> class Scope_Allocator : public Arena_Allocator<T> {
+public:
+  Scope_Allocator() noexcept : Arena_Allocator<T>{Arena::current()} {}
+  explicit Scope_Allocator(Arena *arena) noexcept
+      : Arena_Allocator<T>{arena} {}
+  template <class U>
+  Scope_Allocator(Scope_Allocator<U> const &other) noexcept
+      : Arena_Allocator<T>{other.arena()} {}
+
+  //! Copies of containers draw from the current Arena, not the original's
+  Scope_Allocator select_on_container_copy_construction() const noexcept {
+    return Scope_Allocator{};
+  }
+};
+
+template <class T, class U>
+inline bool operator==(Arena_Allocator<T> const &a,
+                       Arena_Allocator<U> const &b) noexcept {
+  return a.arena() == b.arena();
+}
+template <class T, class U>
+inline bool operator!=(Arena_Allocator<T> const &a,
+                       Arena_Allocator<U> const &b) noexcept {
+  return a.arena() != b.arena();
+}
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,184 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Byte_Stream.hh
+
+  Simple variable-length integer encoding for FLPR's binary formats.
+*/
+
+#ifndef FLPR_BYTE_STREAM_HH
+#define FLPR_BYTE_STREAM_HH 1
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace FLPR {
+
+//! Append integers and strings to a byte buffer
+/*!
+  Unsigned integers are written in LEB128 form (seven bits per byte, least
+  significant first, with the high bit set on all but the last byte), so the
+  small values that dominate parse data take a single byte.  Signed integers
+  are zigzag-encoded first, so that small negative values are small too.
+*/
+class Byte_Writer {
+public:
+  void put_uint(std::uint64_t val) {
+    while (val >= 0x80) {
+      buf_.push_back(static_cast<char>((val & 0x7f) | 0x80));
+      val >>= 7;
+    }
+    buf_.push_back(static_cast<char>(val));
+  }
+  void put_int(std::int64_t const val) {
+    put_uint((static_cast<std::uint64_t>(val) << 1) ^
+             static_cast<std::uint64_t>(val >> 63));
+  }
+  //! Write a length-prefixed string
+  void put_string(std::string_view const s) {
+    put_uint(s.size());
+    buf_.append(s);
+  }
+  //! Write bytes with no length prefix
+  void put_raw(std::string_view const s) { buf_.append(s); }
+
+  //! The number of bytes that put_uint(val) writes
+  static constexpr std::size_t uint_size(std::uint64_t val) noexcept {
+    std::size_t size{1};
+    for (; val >= 0x80; val >>= 7)
+      size += 1;
+    return size;
+  }
+  //! The number of bytes that put_int(val) writes
+  static constexpr std::size_t int_size(std::int64_t const val) noexcept {
+    return uint_size((static_cast<std::uint64_t>(val) << 1) ^
+                     static_cast<std::uint64_t>(val >> 63));
+  }
+
+  std::string const &str() const noexcept { return buf_; }
+  std::string &str() noexcept { return buf_; }
+
+private:
+  std::string buf_;
+};
+
+//! Read the values written by a Byte_Writer
+/*!
+  Reading past the end of the data, or an over-long integer, puts the reader
+  into a failed state: every later read returns zero (or an empty string),
+  and operator bool returns false.  This lets a decoder check for corruption
+  once, at the end, rather than after every value.
+*/
+class Byte_Reader {
+public:
+  explicit Byte_Reader(std::string_view const data) noexcept
+      : curr_{data.data()}, end_{data.data() + data.size()} {}
+
+  std::uint64_t get_uint() noexcept {
+    std::uint64_t val{0};
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (curr_ == end_)
+        break;
+      auto const byte = static_cast<unsigned char>(*curr_++);
+      val |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return val;
+    }
+    return fail_();
+  }
+  std::int64_t get_int() noexcept {
+    std::uint64_t const u = get_uint();
+    return static_cast<std::int64_t>(u >> 1) ^
+           -static_cast<std::int64_t>(u & 1);
+  }
+  //! Read a length-prefixed string
+  std::string_view get_string() noexcept { return get_raw(get_uint()); }
+  //! Read count bytes
+  std::string_view get_raw(std::uint64_t const count) noexcept {
+    if (count > static_cast<std::uint64_t>(end_ - curr_)) {
+      fail_();
+      return {};
+    }
+    std::string_view const result{curr_, count};
+    curr_ += count;
+    return result;
+  }
+
+  //! Record a problem found by the caller, such as an out-of-range value
+  void set_failed() noexcept { fail_(); }
+
+  //! True if all of the reads so far have succeeded
+  explicit operator bool() const noexcept { return !failed_; }
+  //! True if all of the data has been read
+  bool at_end() const noexcept { return curr_ == end_; }
+  //! The number of bytes left to read
+  std::size_t remaining() const noexcept {
+    return static_cast<std::size_t>(end_ - curr_);
+  }
+
+private:
+  std::uint64_t fail_() noexcept {
+    failed_ = true;
+    curr_ = end_;
+    return 0;
+  }
+
+  char const *curr_;
+  char const *end_;
+  bool failed_{false};
+};
+
+//! The header of a tree node, in FLPR's binary formats
+/*!
+  Tree_Image and Parse_Cache both write a tree in preorder, and each node
+  starts with this header: its syntag, then its shape, which is the number
+  of branches shifted left two bits, with bit 1 set if the node covers the
+  same tokens as its parent, and bit 0 set if it is a statement of a
+  Prgm_Tree.  What follows the header is up to the format.
+*/
+struct Node_Code {
+  int syntag{0};
+  std::uint64_t num_branches{0};
+  bool same_span{false};
+  bool is_stmt{false};
+
+  constexpr std::uint64_t shape() const noexcept {
+    return (num_branches << 2) | (std::uint64_t{same_span} << 1) |
+           std::uint64_t{is_stmt};
+  }
+  //! The number of bytes that put() writes
+  constexpr std::size_t size() const noexcept {
+    return Byte_Writer::uint_size(static_cast<std::uint64_t>(syntag)) +
+           Byte_Writer::uint_size(shape());
+  }
+  void put(Byte_Writer &out) const {
+    out.put_uint(static_cast<std::uint64_t>(syntag));
+    out.put_uint(shape());
+  }
+  //! Read a header, returning false if the data is corrupt
+  bool get(Byte_Reader &in) {
+    std::uint64_t const tag = in.get_uint();
+    std::uint64_t const bits = in.get_uint();
+    if (!in || tag > std::uint64_t{std::numeric_limits<int>::max()})
+      return false;
+    syntag = static_cast<int>(tag);
+    num_branches = bits >> 2;
+    same_span = bits & 2;
+    is_stmt = bits & 1;
+    return true;
+  }
+};
+
+} // namespace FLPR
+#endif
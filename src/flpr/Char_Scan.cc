@@ -0,0 +1,206 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Char_Scan.cc
+*/
+
+#include "flpr/Char_Scan.hh"
+#include <atomic>
+#include <cassert>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FLPR_CHAR_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+using size_t = std::size_t;
+constexpr size_t npos = std::string_view::npos;
+
+/* All of the implementations search for exactly four characters: shorter sets
+   are padded by repeating the first character. */
+struct Scan_Fns {
+  FLPR::Char_Scan_Impl impl;
+  size_t (*any)(char const *txt, size_t n, size_t pos, char const *set);
+  size_t (*nonblank)(char const *txt, size_t n, size_t pos);
+};
+
+inline bool is_blank(char const c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+size_t any_scalar(char const *txt, size_t const n, size_t pos,
+                  char const *set) {
+  for (; pos < n; ++pos) {
+    char const c = txt[pos];
+    if (c == set[0] || c == set[1] || c == set[2] || c == set[3])
+      return pos;
+  }
+  return npos;
+}
+
+size_t nonblank_scalar(char const *txt, size_t const n, size_t pos) {
+  for (; pos < n; ++pos)
+    if (!is_blank(txt[pos]))
+      return pos;
+  return npos;
+}
+
+#ifdef FLPR_CHAR_SCAN_X86
+size_t any_sse2(char const *txt, size_t const n, size_t pos,
+                char const *set) {
+  __m128i const s0 = _mm_set1_epi8(set[0]);
+  __m128i const s1 = _mm_set1_epi8(set[1]);
+  __m128i const s2 = _mm_set1_epi8(set[2]);
+  __m128i const s3 = _mm_set1_epi8(set[3]);
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(txt + pos));
+    __m128i const hit =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, s0), _mm_cmpeq_epi8(v, s1)),
+                     _mm_or_si128(_mm_cmpeq_epi8(v, s2), _mm_cmpeq_epi8(v, s3)));
+    int const mask = _mm_movemask_epi8(hit);
+    if (mask)
+      return pos + __builtin_ctz(mask);
+  }
+  return any_scalar(txt, n, pos, set);
+}
+
+size_t nonblank_sse2(char const *txt, size_t const n, size_t pos) {
+  __m128i const sp = _mm_set1_epi8(' ');
+  __m128i const tab = _mm_set1_epi8('\t');
+  __m128i const cr = _mm_set1_epi8('\r');
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i const v =
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(txt + pos));
+    __m128i const blank = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+        _mm_cmpeq_epi8(v, cr));
+    int const mask = ~_mm_movemask_epi8(blank) & 0xffff;
+    if (mask)
+      return pos + __builtin_ctz(mask);
+  }
+  return nonblank_scalar(txt, n, pos);
+}
+
+__attribute__((target("avx2"))) size_t
+any_avx2(char const *txt, size_t const n, size_t pos, char const *set) {
+  __m256i const s0 = _mm256_set1_epi8(set[0]);
+  __m256i const s1 = _mm256_set1_epi8(set[1]);
+  __m256i const s2 = _mm256_set1_epi8(set[2]);
+  __m256i const s3 = _mm256_set1_epi8(set[3]);
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(txt + pos));
+    __m256i const hit = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, s0), _mm256_cmpeq_epi8(v, s1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, s2), _mm256_cmpeq_epi8(v, s3)));
+    unsigned const mask = _mm256_movemask_epi8(hit);
+    if (mask)
+      return pos + __builtin_ctz(mask);
+  }
+  return any_sse2(txt, n, pos, set);
+}
+
+__attribute__((target("avx2"))) size_t nonblank_avx2(char const *txt,
+                                                     size_t const n,
+                                                     size_t pos) {
+  __m256i const sp = _mm256_set1_epi8(' ');
+  __m256i const tab = _mm256_set1_epi8('\t');
+  __m256i const cr = _mm256_set1_epi8('\r');
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(txt + pos));
+    __m256i const blank = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)),
+        _mm256_cmpeq_epi8(v, cr));
+    unsigned const mask = ~static_cast<unsigned>(_mm256_movemask_epi8(blank));
+    if (mask)
+      return pos + __builtin_ctz(mask);
+  }
+  return nonblank_sse2(txt, n, pos);
+}
+#endif
+
+constexpr Scan_Fns scalar_fns{FLPR::Char_Scan_Impl::scalar, any_scalar,
+                              nonblank_scalar};
+#ifdef FLPR_CHAR_SCAN_X86
+constexpr Scan_Fns sse2_fns{FLPR::Char_Scan_Impl::sse2, any_sse2,
+                            nonblank_sse2};
+constexpr Scan_Fns avx2_fns{FLPR::Char_Scan_Impl::avx2, any_avx2,
+                            nonblank_avx2};
+#endif
+
+Scan_Fns const *fns_for(FLPR::Char_Scan_Impl const impl) {
+  switch (impl) {
+  case FLPR::Char_Scan_Impl::scalar:
+    return &scalar_fns;
+#ifdef FLPR_CHAR_SCAN_X86
+  case FLPR::Char_Scan_Impl::sse2:
+    return &sse2_fns;
+  case FLPR::Char_Scan_Impl::avx2:
+    if (__builtin_cpu_supports("avx2"))
+      return &avx2_fns;
+    return nullptr;
+#endif
+  default:
+    return nullptr;
+  }
+}
+
+Scan_Fns const *best_fns() {
+#ifdef FLPR_CHAR_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return &avx2_fns;
+  return &sse2_fns;
+#else
+  return &scalar_fns;
+#endif
+}
+
+std::atomic<Scan_Fns const *> &active_fns() {
+  static std::atomic<Scan_Fns const *> fns{best_fns()};
+  return fns;
+}
+
+inline Scan_Fns const &fns() {
+  return *active_fns().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+namespace FLPR {
+
+std::size_t scan_for_any(std::string_view txt, std::size_t pos,
+                         std::string_view chars) noexcept {
+  assert(!chars.empty() && chars.size() <= 4);
+  char set[4];
+  for (size_t i = 0; i < 4; ++i)
+    set[i] = (i < chars.size()) ? chars[i] : chars[0];
+  return fns().any(txt.data(), txt.size(), pos, set);
+}
+
+std::size_t scan_for_nonblank(std::string_view txt, std::size_t pos) noexcept {
+  return fns().nonblank(txt.data(), txt.size(), pos);
+}
+
+Char_Scan_Impl char_scan_impl() noexcept { return fns().impl; }
+
+bool set_char_scan_impl(Char_Scan_Impl impl) noexcept {
+  Scan_Fns const *f = fns_for(impl);
+  if (!f)
+    return false;
+  active_fns().store(f, std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace FLPR
@@ -0,0 +1,51 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Char_Scan.hh
+
+  Vectorized character searches used to classify raw input lines.
+*/
+
+#ifndef FLPR_CHAR_SCAN_HH
+#define FLPR_CHAR_SCAN_HH 1
+
+#include <cstddef>
+#include <string_view>
+
+namespace FLPR {
+
+//! The implementations available for the Char_Scan functions
+enum class Char_Scan_Impl { scalar, sse2, avx2 };
+
+//! Return the position of the first character at or after pos in chars
+/*! chars must contain between one and four characters.  Returns
+    std::string_view::npos if there is no such character.  This is equivalent
+    to txt.find_first_of(chars, pos), but examines 16 or 32 characters at a
+    time when the hardware allows it. */
+std::size_t scan_for_any(std::string_view txt, std::size_t pos,
+                         std::string_view chars) noexcept;
+
+//! Return the position of the first character at or after pos that isn't a
+//! space, tab, or carriage return
+/*! Equivalent to txt.find_first_not_of(" \t\r", pos). */
+std::size_t scan_for_nonblank(std::string_view txt, std::size_t pos) noexcept;
+
+//! The implementation currently in use
+Char_Scan_Impl char_scan_impl() noexcept;
+
+//! Select an implementation, returning false if the CPU doesn't support it
+/*! The best available implementation is chosen automatically the first time
+    that the scan functions are used, so this is only needed for testing.  It
+    is not safe to call this while other threads are scanning. */
+bool set_char_scan_impl(Char_Scan_Impl impl) noexcept;
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,203 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Edit_Transaction.cc
+*/
+
+#include "flpr/Edit_Transaction.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace FLPR {
+
+namespace {
+using Text_Edit = Logical_Line::Text_Edit;
+
+/* Returns true if layout position (l0, c0) is not after (l1, c1) */
+constexpr bool not_after(int l0, int c0, int l1, int c1) noexcept {
+  return l0 < l1 || (l0 == l1 && c0 <= c1);
+}
+
+bool disjoint(Text_Edit const &a, Text_Edit const &b) noexcept {
+  return not_after(a.end_line, a.end_col, b.begin_line, b.begin_col) ||
+         not_after(b.end_line, b.end_col, a.begin_line, a.begin_col);
+}
+
+/* Returns true if b lies within a */
+bool covers(Text_Edit const &a, Text_Edit const &b) noexcept {
+  return not_after(a.begin_line, a.begin_col, b.begin_line, b.begin_col) &&
+         not_after(b.end_line, b.end_col, a.end_line, a.end_col);
+}
+
+bool same_insertion_point(Text_Edit const &a, Text_Edit const &b) noexcept {
+  return a.is_insertion() && b.is_insertion() &&
+         a.begin_line == b.begin_line && a.begin_col == b.begin_col;
+}
+
+/* The edit that replaces the text of tokens */
+Text_Edit replacement(TT_Range const &tokens, std::string const &new_text) {
+  assert(!tokens.empty());
+  Token_Text const &first = tokens.front();
+  Token_Text const &last = tokens.back();
+  return Text_Edit{first.main_text_line(), first.main_text_col(),
+                   last.main_text_eline(), last.main_text_ecol(), new_text};
+}
+
+/* The edit that inserts text after a token */
+Text_Edit insertion_after(Token_Text const &tt, std::string const &new_text) {
+  return Text_Edit{tt.main_text_eline(), tt.main_text_ecol(),
+                   tt.main_text_eline(), tt.main_text_ecol(), new_text};
+}
+} // namespace
+
+bool Edit_Transaction::replace_stmt_substr(LL_STMT_SEQ::iterator stmt,
+                                           LL_TT_Range const &tokens,
+                                           std::string const &new_text) {
+  return record_(stmt, replacement(tokens, new_text), Syntax_Tags::UNKNOWN);
+}
+
+bool Edit_Transaction::replace_stmt_text(LL_STMT_SEQ::iterator stmt,
+                                         std::string const &new_text,
+                                         int new_syntag) {
+  return record_(stmt, replacement(*stmt, new_text), new_syntag);
+}
+
+bool Edit_Transaction::insert_text_after(LL_STMT_SEQ::iterator stmt,
+                                         TT_List::iterator frag,
+                                         std::string const &new_text) {
+  return record_(stmt, insertion_after(*frag, new_text), Syntax_Tags::UNKNOWN);
+}
+
+bool Edit_Transaction::append_stmt_text(LL_STMT_SEQ::iterator stmt,
+                                        std::string const &new_text) {
+  return record_(stmt, insertion_after(stmt->back(), new_text),
+                 Syntax_Tags::UNKNOWN);
+}
+
+bool Edit_Transaction::set_stmt_label(LL_STMT_SEQ::iterator stmt, int label) {
+  assert(!(label < 0));
+  if (stmt->is_compound() > 1)
+    return label == 0; // can't label something in a compound
+  Line_Edits &line = line_edits_(stmt);
+  if (line.label < 0)
+    num_labels_ += 1;
+  line.label = label;
+  return true;
+}
+
+bool Edit_Transaction::commit() {
+  /* Stage the new version of each line, and make sure that it holds the same
+     number of statements as before */
+  std::vector<Logical_Line> staged;
+  staged.reserve(lines_.size());
+  for (Line_Edits &line : lines_) {
+    staged.emplace_back(*line.ll);
+    if (!line.edits.empty()) {
+      size_t num_stmts{0};
+      for (auto s = line.first_stmt;
+           s != lf_.ll_stmts.end() && s->stmt_ll() == line.ll; ++s)
+        num_stmts += 1;
+      staged.back().apply_text_edits(std::move(line.edits));
+      if (staged.back().stmts().size() != num_stmts) {
+        rollback();
+        return false;
+      }
+    }
+    if (line.label >= 0)
+      staged.back().set_label(line.label);
+  }
+
+  /* Nothing can fail now: install the new lines, and point their LL_Stmts at
+     the new tokens.  Every statement on a rewritten line loses whatever it
+     had worked out about its old tokens, edited or not. */
+  for (size_t i = 0; i < lines_.size(); ++i) {
+    Line_Edits &line = lines_[i];
+    *line.ll = std::move(staged[i]);
+    auto stmt = line.first_stmt;
+    for (TT_Range const &r : line.ll->stmts()) {
+      stmt->assign_range(r);
+      stmt->drop_stmt_tree();
+      stmt->preclassify();
+      ++stmt;
+    }
+    for (auto &[edited, syntag] : line.stmts) {
+      if (syntag != Syntax_Tags::UNKNOWN)
+        edited->set_stmt_syntag(syntag);
+      lf_.mark_edited(edited);
+    }
+    if (line.label >= 0 && line.first_stmt->label() != line.ll->label) {
+      line.first_stmt->cache_new_label_value(line.ll->label);
+      /* labels can change how do-constructs end */
+      lf_.mark_edited(line.first_stmt);
+    }
+  }
+
+  rollback();
+  return true;
+}
+
+void Edit_Transaction::rollback() noexcept {
+  lines_.clear();
+  line_index_.clear();
+  num_edited_ = 0;
+  num_labels_ = 0;
+}
+
+bool Edit_Transaction::record_(LL_STMT_SEQ::iterator stmt, Text_Edit &&edit,
+                               int const new_syntag) {
+  Line_Edits &line = line_edits_(stmt);
+  std::vector<Text_Edit> &edits = line.edits;
+  if (edits.empty())
+    num_edited_ += 1;
+  /* Check for conflicts before changing anything */
+  for (Text_Edit const &e : edits)
+    if (!same_insertion_point(e, edit) && !disjoint(e, edit) &&
+        !covers(edit, e))
+      return false;
+  auto same = std::find_if(
+      edits.begin(), edits.end(),
+      [&edit](Text_Edit const &e) { return same_insertion_point(e, edit); });
+  if (same != edits.end()) {
+    same->text += edit.text;
+  } else {
+    /* Drop the earlier edits that this one replaces */
+    edits.erase(std::remove_if(edits.begin(), edits.end(),
+                               [&edit](Text_Edit const &e) {
+                                 return !disjoint(e, edit);
+                               }),
+                edits.end());
+    edits.push_back(std::move(edit));
+  }
+
+  auto &stmts = line.stmts;
+  auto s = std::find_if(stmts.begin(), stmts.end(),
+                        [stmt](auto const &p) { return p.first == stmt; });
+  if (s == stmts.end())
+    stmts.emplace_back(stmt, new_syntag);
+  else if (new_syntag != Syntax_Tags::UNKNOWN)
+    s->second = new_syntag;
+  return true;
+}
+
+auto Edit_Transaction::line_edits_(LL_STMT_SEQ::iterator stmt)
+    -> Line_Edits & {
+  auto const ll = stmt->stmt_ll();
+  auto const [where, added] = line_index_.try_emplace(&(*ll), lines_.size());
+  if (added) {
+    auto first = stmt;
+    while (first != lf_.ll_stmts.begin() && std::prev(first)->stmt_ll() == ll)
+      --first;
+    lines_.push_back(Line_Edits{ll, first, {}, {}, -1});
+  }
+  return lines_[where->second];
+}
+
+} // namespace FLPR
@@ -0,0 +1,116 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Edit_Transaction.hh
+*/
+
+#ifndef FLPR_EDIT_TRANSACTION_HH
+#define FLPR_EDIT_TRANSACTION_HH 1
+
+#include "flpr/Logical_File.hh"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace FLPR {
+
+//! Collect edits to the statements of a Logical_File and apply them at once
+/*!
+  Each Logical_File edit function re-tokenizes the Logical_Line that it
+  changes, so a transformation that touches the same statement several times
+  lexes it several times.  An Edit_Transaction records the edits instead, in
+  terms of the tokens as they are now, and commit() applies them with one
+  re-tokenization and one LL_Stmt update per Logical_Line.
+
+  As every edit refers to the original tokens, an edit that covers an earlier
+  one replaces it, and insertions at the same place are concatenated in the
+  order that they were recorded.  Any other overlap is refused.  Unlike the
+  Logical_File functions, compound statements are not split up.
+
+  The transaction is atomic: if commit() finds that the new text of a line
+  doesn't hold the same number of statements as before, nothing is changed.
+  Edits that are never committed are discarded.
+*/
+class Edit_Transaction {
+public:
+  explicit Edit_Transaction(Logical_File &lf) : lf_{lf} {}
+  Edit_Transaction(Edit_Transaction const &) = delete;
+  Edit_Transaction &operator=(Edit_Transaction const &) = delete;
+
+  //! Replace the text covered by tokens with new_text
+  /*! Returns false, and records nothing, if this conflicts with an earlier
+      edit. */
+  bool replace_stmt_substr(LL_STMT_SEQ::iterator stmt,
+                           LL_TT_Range const &tokens,
+                           std::string const &new_text);
+
+  //! Replace all of the text of a statement, and give it a new syntag
+  bool replace_stmt_text(LL_STMT_SEQ::iterator stmt,
+                         std::string const &new_text, int new_syntag);
+
+  //! Insert some text after a fragment
+  bool insert_text_after(LL_STMT_SEQ::iterator stmt, TT_List::iterator frag,
+                         std::string const &new_text);
+
+  //! Append some text to the end of stmt
+  bool append_stmt_text(LL_STMT_SEQ::iterator stmt,
+                        std::string const &new_text);
+
+  //! Label a statement (label == 0 will unlabel it)
+  /*! The last label recorded for a line wins.  Returns false, and records
+      nothing, if stmt follows another statement on a compound line, as it
+      can't be labelled without splitting the line. */
+  bool set_stmt_label(LL_STMT_SEQ::iterator stmt, int label);
+
+  //! Apply the recorded edits
+  /*! Returns false, having changed nothing, if the edits would change the
+      statement structure of a line.  Either way, the transaction is empty
+      afterwards. */
+  bool commit();
+
+  //! Discard the recorded edits
+  void rollback() noexcept;
+
+  //! The number of Logical_Lines with text edits, plus the number of labels
+  size_t size() const noexcept { return num_edited_ + num_labels_; }
+  bool empty() const noexcept { return size() == 0; }
+
+private:
+  using Text_Edit = Logical_Line::Text_Edit;
+
+  //! The recorded edits for one Logical_Line
+  struct Line_Edits {
+    LL_List::iterator ll;
+    //! The first LL_Stmt on ll
+    LL_STMT_SEQ::iterator first_stmt;
+    std::vector<Text_Edit> edits;
+    //! The edited statements, and their new syntag (or UNKNOWN)
+    std::vector<std::pair<LL_STMT_SEQ::iterator, int>> stmts;
+    //! The new label of the first statement on ll, or -1 to leave it alone
+    int label{-1};
+  };
+
+  bool record_(LL_STMT_SEQ::iterator stmt, Text_Edit &&edit,
+               int const new_syntag);
+  Line_Edits &line_edits_(LL_STMT_SEQ::iterator stmt);
+
+private:
+  Logical_File &lf_;
+  std::vector<Line_Edits> lines_;
+  //! Map a Logical_Line to its entry in lines_
+  std::unordered_map<Logical_Line const *, size_t> line_index_;
+  size_t num_edited_{0};
+  size_t num_labels_{0};
+};
+
+} // namespace FLPR
+#endif
@@ -13,6 +13,7 @@
 */
 
 #include "flpr/File_Line.hh"
+#include "flpr/Char_Scan.hh"
 #include "flpr/utils.hh"
 
 #include <cassert>
@@ -28,75 +29,97 @@
 #define UNSET_CLASS(A) bits.reset(static_cast<int>(class_flags::A))
 
 namespace {
-bool is_include_line(std::string const &txt, std::string::size_type non_blank);
-bool is_flpr_literal(std::string const &txt,
-                     std::string::size_type comment_pos);
+using SV = std::string_view;
 
-bool is_flpr_directive(std::string const &txt,
-                       std::string::size_type comment_pos);
+bool is_include_line(SV txt, SV::size_type non_blank);
+bool is_flpr_literal(SV txt, SV::size_type comment_pos);
 
-std::string::size_type find_trailing_fixed(
-    std::string const &txt, std::string::size_type const start_idx,
-    int const last_column, char const previous_open_delim, char &open_delim);
+bool is_flpr_directive(SV txt, SV::size_type comment_pos);
 
-std::string::size_type
-find_trailing_free(std::string const &txt,
-                   std::string::size_type const start_idx,
-                   char const previous_open_delim, char &open_delim);
+SV::size_type find_trailing_fixed(SV txt, SV::size_type const start_idx,
+                                  int const last_column,
+                                  char const previous_open_delim,
+                                  char &open_delim);
+
+SV::size_type find_trailing_free(SV txt, SV::size_type const start_idx,
+                                 char const previous_open_delim,
+                                 char &open_delim);
+
+/* Make a field that refers into the source, or a copy if there is none */
+inline FLPR::Line_Text make_field(SV txt, bool const borrow) {
+  return borrow ? FLPR::Line_Text::borrow(txt) : FLPR::Line_Text(txt);
+}
 
 constexpr char filler(bool const cond, char const c) { return cond ? c : '_'; }
 
 } // namespace
 
 namespace FLPR {
-File_Line::File_Line(const int ln, BITS const &c, std::string const &lt,
-                     std::string const &ls, std::string const &mt,
-                     std::string const &rs, std::string const &rt,
-                     const char od)
-    : linenum(ln), left_text(lt), left_space(ls), main_text(mt),
-      right_space(rs), right_text(rt), open_delim(od), classification_(c) {
+File_Line::File_Line(const int ln, BITS const &c, SOURCE const &src,
+                     std::string_view lt, std::string_view ls,
+                     std::string_view mt, std::string_view rs,
+                     std::string_view rt, const char od)
+    : linenum(ln), left_text(make_field(lt, bool(src))),
+      left_space(make_field(ls, bool(src))),
+      main_text(make_field(mt, bool(src))),
+      right_space(make_field(rs, bool(src))),
+      right_text(make_field(rt, bool(src))), open_delim(od),
+      classification_(c), source_(src) {
   assert(open_delim == '\0' || open_delim == '\"' || open_delim == '\'');
 }
 
-File_Line::File_Line(int ln, BITS const &c, std::string const &lt)
-    : linenum(ln), left_text(lt), open_delim('\0'), classification_(c) {}
+File_Line::File_Line(int ln, BITS const &c, SOURCE const &src,
+                     std::string_view lt)
+    : linenum(ln), left_text(make_field(lt, bool(src))), open_delim('\0'),
+      classification_(c), source_(src) {
+  if (src)
+    raw_ = lt;
+}
 
 File_Line File_Line::analyze_fixed(int const linenum,
-                                   std::string const &raw_txt_in,
+                                   std::string_view const raw_txt_in,
                                    char const prev_open_delim,
-                                   int const last_column) {
-  using ST = std::string::size_type;
+                                   int const last_column,
+                                   SOURCE const &raw_source) {
+  using ST = std::string_view::size_type;
+  constexpr ST npos = std::string_view::npos;
   BITS bits;
-  std::string left_text, left_sp, main_text, right_sp, right_text;
+  std::string_view left_text, left_sp, main_text, right_sp, right_text;
 
   SET_CLASS(fixed_format);
   if (raw_txt_in.empty()) {
     SET_CLASS(blank);
-    return File_Line(linenum, bits, raw_txt_in);
+    return File_Line(linenum, bits, raw_source, raw_txt_in);
   }
 
   // expand tabs in the control columns.  They shouldn't be here,
   // but... if there is a tab in the control columns, expand it and
   // any adjacent tabs into 6-space blocks
-  std::string raw_txt{raw_txt_in};
+  std::string expanded;
+  std::string_view raw_txt{raw_txt_in};
   {
-    const ST tab_begin = raw_txt.find_first_of("\t");
+    const ST tab_begin = raw_txt.find_first_of('\t');
     if (tab_begin < 6) {
+      expanded.assign(raw_txt);
       ST tab_end = tab_begin + 1;
-      while (tab_end < raw_txt.size() && raw_txt[tab_end] == '\t')
+      while (tab_end < expanded.size() && expanded[tab_end] == '\t')
         ++tab_end;
       int num_tabs = tab_end - tab_begin;
       for (ST i = tab_begin; i < tab_end; ++i)
-        raw_txt[i] = ' ';
-      raw_txt.insert(tab_end, 5 * num_tabs, ' ');
+        expanded[i] = ' ';
+      expanded.insert(tab_end, 5 * num_tabs, ' ');
+      raw_txt = expanded;
     }
   }
+  // Text that was rewritten can't refer to the source
+  SOURCE const no_source;
+  SOURCE const &source = expanded.empty() ? raw_source : no_source;
 
   // Find the first non-blank character
-  ST ri = raw_txt.find_first_not_of(" \t\r");
-  if (ri == std::string::npos) {
+  ST ri = scan_for_nonblank(raw_txt, 0);
+  if (ri == npos) {
     SET_CLASS(blank);
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
 
   const char c = std::toupper(raw_txt[ri]);
@@ -106,12 +129,12 @@ File_Line File_Line::analyze_fixed(int const linenum,
     // Check for standard preprocessor commands
     if (ri == 0 && c == '#') {
       SET_CLASS(preprocessor);
-      return File_Line(linenum, bits, raw_txt);
+      return File_Line(linenum, bits, source, raw_txt);
     }
     // How about a Fortran include directive? (Section 6.4 of the standard)
     if (is_include_line(raw_txt, ri)) {
       SET_CLASS(include);
-      return File_Line(linenum, bits, raw_txt);
+      return File_Line(linenum, bits, source, raw_txt);
     }
     // Look for comment lines (or flpr preprocessor directives)
     if (c == '!' || (ri == 0 && (c == '*' || c == 'C'))) {
@@ -124,9 +147,9 @@ File_Line File_Line::analyze_fixed(int const linenum,
         SET_CLASS(flpr_pp);
       else {
         SET_CLASS(comment);
-        return File_Line(linenum, bits, raw_txt);
+        return File_Line(linenum, bits, source, raw_txt);
       }
-      return File_Line(linenum, bits, raw_txt);
+      return File_Line(linenum, bits, source, raw_txt);
     }
   }
 
@@ -157,7 +180,7 @@ File_Line File_Line::analyze_fixed(int const linenum,
         ri += 1;
       if (ri == raw_txt.size()) {
         SET_CLASS(blank);
-        return File_Line(linenum, bits, raw_txt);
+        return File_Line(linenum, bits, source, raw_txt);
       }
     }
   }
@@ -172,7 +195,8 @@ File_Line File_Line::analyze_fixed(int const linenum,
   ST trailing_begin = find_trailing_fixed(raw_txt, ri, last_column,
                                           prev_open_delim, open_delim_char);
 
-  if (trailing_begin == std::string::npos) {
+  bool implicit_comment{false};
+  if (trailing_begin == npos) {
     main_text = raw_txt.substr(ri);
   } else {
     main_text = raw_txt.substr(ri, trailing_begin - ri);
@@ -180,11 +204,11 @@ File_Line File_Line::analyze_fixed(int const linenum,
     if (last_column > 0 && trailing_begin == static_cast<ST>(last_column)) {
       /* add a comment character if this is some col>72 implicit comment */
       ST ri = right_text.find_first_not_of(" \t\r");
-      if (ri == std::string::npos) {
-        right_text.clear();
+      if (ri == npos) {
+        right_text = std::string_view{};
       } else {
         if (right_text[ri] != '&' && right_text[ri] != '!') {
-          right_text.insert(0, "! ");
+          implicit_comment = true;
         }
       }
     }
@@ -198,40 +222,52 @@ File_Line File_Line::analyze_fixed(int const linenum,
   if (!open_delim_char) {
     ST last_char = main_text.find_last_not_of(" \t");
     if (last_char + 1 < main_text.size()) {
-      right_sp =
-          main_text.substr(last_char + 1, main_text.size() - last_char - 1);
-      main_text.erase(last_char + 1);
+      right_sp = main_text.substr(last_char + 1);
+      main_text = main_text.substr(0, last_char + 1);
     }
   }
 
-  return File_Line(linenum, bits, left_text, left_sp, main_text, right_sp,
-                   right_text, open_delim_char);
+  File_Line result(linenum, bits, source, left_text, left_sp, main_text,
+                   right_sp, right_text, open_delim_char);
+  if (source) {
+    /* Blanks past last_column were dropped, rather than being put in a
+       field */
+    result.raw_ = (right_text.empty() && trailing_begin != npos)
+                      ? raw_txt.substr(0, trailing_begin)
+                      : raw_txt;
+  }
+  if (implicit_comment)
+    result.right_text.insert(0, "! ");
+  return result;
 }
 
-File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
+File_Line File_Line::analyze_free(const int linenum,
+                                  std::string_view const raw_txt,
                                   const char prev_open_delim,
                                   const bool prev_line_cont,
-                                  bool &in_literal_block) {
-  using ST = std::string::size_type;
+                                  bool &in_literal_block,
+                                  SOURCE const &source) {
+  using ST = std::string_view::size_type;
+  constexpr ST npos = std::string_view::npos;
   BITS bits;
-  std::string left_text, left_sp, main_text, right_sp, right_text;
+  std::string_view left_text, left_sp, main_text, right_sp, right_text;
 
   // Find the first non-blank character
-  ST ri = raw_txt.find_first_not_of(" \t\r");
+  ST ri = scan_for_nonblank(raw_txt, 0);
 
   if (in_literal_block) {
     SET_CLASS(flpr_lit);
-    if (std::string::npos != ri && raw_txt[ri] == '!') {
+    if (npos != ri && raw_txt[ri] == '!') {
       if (is_flpr_literal(raw_txt, ri))
         in_literal_block = false;
     }
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
 
   // There isn't one...
-  if (std::string::npos == ri) {
+  if (npos == ri) {
     SET_CLASS(blank);
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
 
   const char c = std::toupper(raw_txt[ri]);
@@ -239,12 +275,12 @@ File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
   // Check for standard preprocessor commands
   if (ri == 0 && c == '#') {
     SET_CLASS(preprocessor);
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
   // How about a Fortran include directive? (Section 6.4 of the standard)
   if (is_include_line(raw_txt, ri)) {
     SET_CLASS(include);
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
 
   // Look for comment lines (or flpr preprocessor directives)
@@ -260,20 +296,20 @@ File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
       if (prev_line_cont)
         SET_CLASS(continued);
       SET_CLASS(comment);
-      return File_Line(linenum, bits, raw_txt);
+      return File_Line(linenum, bits, source, raw_txt);
     }
-    return File_Line(linenum, bits, raw_txt);
+    return File_Line(linenum, bits, source, raw_txt);
   }
 
   // Now we have a standard Fortran line
 
   ST indent_begin = 0;
+  const ST N = raw_txt.size();
 
   // Identify things before the main body
   if (!prev_line_cont && std::isdigit(c)) {
     // Read a <= 5-digit integer statement label
     ST label_begin = ri;
-    const ST N = raw_txt.size();
     while (ri < N && (ri - label_begin < 6) && std::isdigit(raw_txt[ri]))
       ri += 1;
     indent_begin = ri;
@@ -289,7 +325,7 @@ File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
   /* If we set anything in the left text, we need to advance to the next
      non-blank, UNLESS this is a continuation */
   if (!left_text.empty() && !IS_CLASS(continuation))
-    while (std::isspace(raw_txt[ri]))
+    while (ri < N && std::isspace(raw_txt[ri]))
       ri += 1;
 
   /* Now record any indent (whitespace between first character of Fortran text
@@ -303,7 +339,7 @@ File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
   ST trailing_begin =
       find_trailing_free(raw_txt, ri, prev_open_delim, open_delim);
 
-  if (trailing_begin == std::string::npos) {
+  if (trailing_begin == npos) {
     main_text = raw_txt.substr(ri);
   } else {
     main_text = raw_txt.substr(ri, trailing_begin - ri);
@@ -316,25 +352,29 @@ File_Line File_Line::analyze_free(const int linenum, std::string const &raw_txt,
   if (!open_delim) {
     ST last_char = main_text.find_last_not_of(" \t");
     if (last_char + 1 < main_text.size()) {
-      right_sp =
-          main_text.substr(last_char + 1, main_text.size() - last_char - 1);
-      main_text.erase(last_char + 1);
+      right_sp = main_text.substr(last_char + 1);
+      main_text = main_text.substr(0, last_char + 1);
     }
   }
 
-  return File_Line(linenum, bits, left_text, left_sp, main_text, right_sp,
-                   right_text, open_delim);
+  File_Line result(linenum, bits, source, left_text, left_sp, main_text,
+                   right_sp, right_text, open_delim);
+  if (source)
+    result.raw_ = raw_txt;
+  return result;
 }
 
 void File_Line::swap(File_Line &other) {
   std::swap(linenum, other.linenum);
-  left_text.swap(other.left_text);
-  left_space.swap(other.left_space);
-  main_text.swap(other.main_text);
-  right_space.swap(other.right_space);
-  right_text.swap(other.right_text);
+  std::swap(left_text, other.left_text);
+  std::swap(left_space, other.left_space);
+  std::swap(main_text, other.main_text);
+  std::swap(right_space, other.right_space);
+  std::swap(right_text, other.right_text);
   std::swap(open_delim, other.open_delim);
   std::swap(classification_, other.classification_);
+  source_.swap(other.source_);
+  std::swap(raw_, other.raw_);
 }
 
 void File_Line::unspace_main() {
@@ -353,7 +393,7 @@ void File_Line::unspace_main() {
     size_t num_blanks = main_text.size();
     main_text.erase(ftb);
     num_blanks -= main_text.size();
-    right_space.insert(right_space.end(), num_blanks, ' ');
+    right_space.append(num_blanks, ' ');
   }
 }
 
@@ -398,7 +438,10 @@ void File_Line::make_preprocessor() {
   classification_.reset();
   classification_[ff] = is_fixed_format;
   classification_[pp] = true;
-  left_text += left_space + main_text + right_space + right_text;
+  left_text.append(left_space.view())
+      .append(main_text.view())
+      .append(right_space.view())
+      .append(right_text.view());
   left_space.clear();
   main_text.clear();
   right_space.clear();
@@ -457,6 +500,47 @@ size_t File_Line::size() const noexcept {
          right_space.size() + right_text.size();
 }
 
+/* raw_ can stop short of the end of its line, if blanks past the last
+   column were dropped, so look for a newline anywhere after it */
+bool File_Line::ends_without_newline() const noexcept {
+  if (!source_ || !raw_.data())
+    return false;
+  std::string_view const text = source_->text();
+  char const *const raw_end = raw_.data() + raw_.size();
+  std::string_view const rest(raw_end, text.data() + text.size() - raw_end);
+  return rest.find('\n') == std::string_view::npos;
+}
+
+bool File_Line::is_unmodified() const noexcept {
+  if (!raw_.data())
+    return false;
+  char const *const begin = raw_.data();
+  char const *const end = begin + raw_.size();
+  char const *curr = begin;
+  for (Line_Text const *f :
+       {&left_text, &left_space, &main_text, &right_space, &right_text}) {
+    if (f->empty())
+      continue;
+    if (!f->is_borrowed())
+      return false;
+    if (f->data() != curr) {
+      /* The only hole that analyze_fixed leaves is the blank padding after a
+         label, which the output fills back in */
+      if (f == &left_text || !is_fixed_format() || !is_fortran() ||
+          curr != begin + left_text.size() || f->data() < curr ||
+          f->data() > begin + 6)
+        return false;
+      for (char const *c = curr; c != f->data(); ++c)
+        if (*c != ' ')
+          return false;
+    }
+    curr = f->data() + f->size();
+    if (curr > end)
+      return false;
+  }
+  return curr == end;
+}
+
 bool File_Line::set_leading_spaces(int const spaces) {
   if (is_comment()) {
     std::string::size_type pos = left_text.find('!');
@@ -678,7 +762,7 @@ std::ostream &operator<<(std::ostream &os, FLPR::File_Line const &fl) {
 
 namespace {
 
-bool is_include_line(std::string const &txt, std::string::size_type non_blank) {
+bool is_include_line(SV txt, SV::size_type non_blank) {
   if (non_blank >= txt.size())
     return false;
   if (txt[non_blank] != 'i' && txt[non_blank] != 'I')
@@ -696,15 +780,13 @@ bool is_include_line(std::string const &txt, std::string::size_type non_blank) {
   return false;
 }
 
-bool is_flpr_directive(std::string const &txt,
-                       std::string::size_type comment_pos) {
+bool is_flpr_directive(SV txt, SV::size_type comment_pos) {
   return (txt.size() > comment_pos + 5 && txt[comment_pos + 1] == '#' &&
           txt[comment_pos + 2] == 'f' && txt[comment_pos + 3] == 'l' &&
           txt[comment_pos + 4] == 'p' && txt[comment_pos + 5] == 'r');
 }
 
-bool is_flpr_literal(std::string const &txt,
-                     std::string::size_type comment_pos) {
+bool is_flpr_literal(SV txt, SV::size_type comment_pos) {
   return (is_flpr_directive(txt, comment_pos) &&
           txt.size() > comment_pos + 5 + 8 && txt[comment_pos + 9] == ' ' &&
           txt[comment_pos + 10] == 'l' && txt[comment_pos + 11] == 'i' &&
@@ -715,10 +797,11 @@ bool is_flpr_literal(std::string const &txt,
 
 /* Find trailing comments in fixed format.  Note that start_idx needs to be past
  any prefixed labels, continuations, or control blocks. */
-std::string::size_type find_trailing_fixed(
-    std::string const &txt, std::string::size_type const start_idx,
-    int const last_column, char const previous_open_delim, char &open_delim) {
-  using ST = std::string::size_type;
+SV::size_type find_trailing_fixed(SV txt, SV::size_type const start_idx,
+                                  int const last_column,
+                                  char const previous_open_delim,
+                                  char &open_delim) {
+  using ST = SV::size_type;
   assert(previous_open_delim == '\0' || previous_open_delim == '\"' ||
          previous_open_delim == '\'');
 
@@ -730,24 +813,28 @@ std::string::size_type find_trailing_fixed(
   /* Truncate lines at the last column, if active */
   ST const lc =
       (last_column > 0) ? std::min(static_cast<ST>(last_column), N) : N;
+  SV const active{txt.substr(0, lc)};
   for (ST i = start_idx; i < lc; ++i) {
-    const char c = txt[i];
     if (!char_context) {
       /* Note that you shouldn't use this technique to find the extent of
          strings, as they are allowed to contain doubled delimiters as
          escapes.  For example: 'Paul''s code' is equivalent to "Paul's code",
          not two strings.  For our purpose, this doesn't matter. */
-      if (c == '\'' || c == '"')
-        char_context = c;
-      else if (c == '!')
+      i = FLPR::scan_for_any(active, i, "'\"!");
+      if (i == SV::npos)
+        break;
+      if (active[i] == '!')
         return i;
+      char_context = active[i];
     } else {
-      if (c == char_context)
-        char_context = '\0';
+      i = FLPR::scan_for_any(active, i, SV{&char_context, 1});
+      if (i == SV::npos)
+        break;
+      char_context = '\0';
     }
   }
   open_delim = char_context;
-  return (lc < N) ? lc : std::string::npos;
+  return (lc < N) ? lc : SV::npos;
 }
 
 /* Find trailing continuation and/or comments.  Note that start_idx needs to be
@@ -755,11 +842,10 @@ std::string::size_type find_trailing_fixed(
    complicated than find_trailing_fixed() because we have to handle trailing
    continuations, and the possibility that they can appear inside a character
    context. */
-std::string::size_type
-find_trailing_free(std::string const &txt,
-                   std::string::size_type const start_idx,
-                   char const previous_open_delim, char &open_delim) {
-  using ST = std::string::size_type;
+SV::size_type find_trailing_free(SV txt, SV::size_type const start_idx,
+                                 char const previous_open_delim,
+                                 char &open_delim) {
+  using ST = SV::size_type;
   assert(previous_open_delim == '\0' || previous_open_delim == '\"' ||
          previous_open_delim == '\'');
 
@@ -767,22 +853,28 @@ find_trailing_free(std::string const &txt,
   char char_context = previous_open_delim;
 
   for (ST i = start_idx; i < N; ++i) {
-    const char c = txt[i];
     if (!char_context) {
       /* Note that you shouldn't use this technique to find the extent of
          strings, as they are allowed to contain doubled delimiters as escapes.
          For example: 'Paul''s code' is equivalent to "Paul's code", not two
          strings.  For our purpose, this doesn't matter. */
-      if (c == '\'' || c == '"')
-        char_context = c;
-      else if (c == '!' || c == '&') {
+      i = FLPR::scan_for_any(txt, i, "'\"!&");
+      if (i == SV::npos)
+        break;
+      const char c = txt[i];
+      if (c == '!' || c == '&') {
         open_delim = '\0';
         return i;
       }
+      char_context = c;
     } else {
-      if (c == char_context)
+      char const in_context[2] = {char_context, '&'};
+      i = FLPR::scan_for_any(txt, i, SV{in_context, 2});
+      if (i == SV::npos)
+        break;
+      if (txt[i] == char_context)
         char_context = 0;
-      else if (c == '&') {
+      else {
         // In F90 free-format, an ampersand with no tailing
         // non-blank characters can signal a continuation of a
         // character context.
@@ -804,7 +896,7 @@ find_trailing_free(std::string const &txt,
                              "in character context");
 
   open_delim = '\0';
-  return std::string::npos;
+  return SV::npos;
 }
 
 } // namespace
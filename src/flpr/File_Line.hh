@@ -15,22 +15,34 @@
 #ifndef FLPR_FILE_LINE_HH
 #define FLPR_FILE_LINE_HH
 
+#include "flpr/Line_Text.hh"
+#include "flpr/Text_Buffer.hh"
 #include <bitset>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #define GET_CLASS(A) classification_[static_cast<int>(class_flags::A)]
 
 namespace FLPR {
+class Parse_Cache;
+
 /*!
   \brief An input line partitioned into fields
 
   A representation of the textual layout of a single source line.  This
   separates the line into "fields", which describe parts of the line that
   Fortran treats specially (e.g. labels, continuations, trailing comments, etc).
+
+  When a File_Line is created from a Text_Buffer, the fields refer into that
+  buffer (which the File_Line keeps alive), and a field only gets its own copy
+  of the text when it is modified.
 */
 class File_Line {
 public:
+  friend class Parse_Cache;
+
   //! Characteristics of a line
   /*! Note that we distinguish between a blank (or all whitespace) line and a
       comment, although the standard says that they are the same. This is
@@ -53,15 +65,15 @@ public:
   //! The (index origin=1) line number in the source
   int linenum;
   //! Labels, continuation symbols, preprocessor statements, and comments
-  std::string left_text;
+  Line_Text left_text;
   //! The whitespace between left_text and main_text
-  std::string left_space;
+  Line_Text left_space;
   //! The body of a fortran line, trimmed of whitespace on both ends
-  std::string main_text;
+  Line_Text main_text;
   //! The whitespace between main_text and right_text
-  std::string right_space;
+  Line_Text right_space;
   //! Trailing comments and/or continuation symbols.
-  std::string right_text;
+  Line_Text right_text;
   //! Any open character context
   /*! If this line ends while in a character context, this is the
       character that must be matched in order to close the context.
@@ -110,7 +122,18 @@ public:
   */
   static File_Line analyze_fixed(int const linenum, std::string const &raw_txt,
                                  char const prev_open_delim,
-                                 int const last_column);
+                                 int const last_column) {
+    return analyze_fixed(linenum, std::string_view{raw_txt}, prev_open_delim,
+                         last_column, nullptr);
+  }
+
+  //! A version of analyze_fixed that can refer to text in a Text_Buffer
+  /*! If source is non-null, raw_txt must be part of source->text(), and the
+      fields of the result refer to it rather than copying it. */
+  static File_Line
+  analyze_fixed(int const linenum, std::string_view raw_txt,
+                char const prev_open_delim, int const last_column,
+                std::shared_ptr<Text_Buffer const> const &source);
 
   //! Simple wrapper for analyze_fixed
   static File_Line analyze_fixed(std::string const &raw_txt,
@@ -133,7 +156,19 @@ public:
   static File_Line analyze_free(const int linenum, std::string const &raw_txt,
                                 const char prev_open_delim,
                                 const bool prev_line_cont,
-                                bool &in_literal_block);
+                                bool &in_literal_block) {
+    return analyze_free(linenum, std::string_view{raw_txt}, prev_open_delim,
+                        prev_line_cont, in_literal_block, nullptr);
+  }
+
+  //! A version of analyze_free that can refer to text in a Text_Buffer
+  /*! If source is non-null, raw_txt must be part of source->text(), and the
+      fields of the result refer to it rather than copying it. */
+  static File_Line
+  analyze_free(const int linenum, std::string_view raw_txt,
+               const char prev_open_delim, const bool prev_line_cont,
+               bool &in_literal_block,
+               std::shared_ptr<Text_Buffer const> const &source);
 
   static File_Line analyze_free(std::string const &raw_txt,
                                 int const linenum = -1) {
@@ -182,6 +217,21 @@ public:
   //! Return the number of characters across
   size_t size() const noexcept;
 
+  //! The text of the line as it was read, if the fields refer to it
+  /*! This is empty if the line wasn't scanned from a Text_Buffer, or if its
+      text had to be rewritten to be analyzed (e.g. tabs in the control
+      columns). */
+  constexpr std::string_view raw_text() const noexcept { return raw_; }
+
+  //! True if the fields are still the parts of raw_text() found by analysis
+  /*! Changing a field either gives it a private copy of its text, or leaves
+      a hole in the layout of raw_text(), so this is a constant-time check
+      that raw_text() can be output in place of the fields. */
+  bool is_unmodified() const noexcept;
+
+  //! True if this is the last line of a Text_Buffer with no final newline
+  bool ends_without_newline() const noexcept;
+
   //! Set the number of spaces aligning the main_text or comment
   /*! Note that this will make no changes if not is_fortran() or is_comment().
       This function returns true if the spacing was altered, false otherwise. */
@@ -196,13 +246,18 @@ public:
 
 private:
   using BITS = std::bitset<static_cast<size_t>(class_flags::zzz_num)>;
+  using SOURCE = std::shared_ptr<Text_Buffer const>;
   BITS classification_;
+  //! The buffer that any borrowed fields refer into (may be null)
+  SOURCE source_;
+  //! The analyzed text, when the fields refer into source_
+  std::string_view raw_;
 
 private:
-  File_Line(const int ln, BITS const &c, std::string const &lt,
-            std::string const &ls, std::string const &mt, std::string const &rs,
-            std::string const &rt, const char od);
-  File_Line(int ln, BITS const &c, std::string const &lt);
+  File_Line(const int ln, BITS const &c, SOURCE const &src,
+            std::string_view lt, std::string_view ls, std::string_view mt,
+            std::string_view rs, std::string_view rt, const char od);
+  File_Line(int ln, BITS const &c, SOURCE const &src, std::string_view lt);
 };
 
 //! Used for diagnostic output
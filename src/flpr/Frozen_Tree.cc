@@ -0,0 +1,180 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Frozen_Tree.cc
+*/
+
+#include "flpr/Frozen_Tree.hh"
+
+namespace FLPR {
+
+bool Frozen_Tree::freeze(Stmt::Stmt_Tree const &t) {
+  clear();
+  if (!t.empty()) {
+    add_tokens_((*t)->token_range);
+    if (!add_stmt_tree_(*t, npos)) {
+      clear();
+      return false;
+    }
+  }
+  finish_();
+  return true;
+}
+
+void Frozen_Tree::clear() {
+  syntag_.clear();
+  parent_.clear();
+  first_child_.clear();
+  next_sibling_.clear();
+  subtree_end_.clear();
+  token_begin_.clear();
+  num_tokens_.clear();
+  stmt_.clear();
+  tokens_.clear();
+  is_prgm_tree_ = false;
+  stmt_index_.clear();
+  window_begin_ = window_end_ = search_hint_ = 0;
+}
+
+Frozen_Tree::index_type Frozen_Tree::num_branches(index_type const n) const {
+  index_type count{0};
+  for (index_type b = first_child_[n]; b != npos; b = next_sibling_[b])
+    count += 1;
+  return count;
+}
+
+std::vector<Frozen_Tree::index_type>
+Frozen_Tree::find(int const syntag, index_type const root) const {
+  std::vector<index_type> result;
+  if (root < size()) {
+    index_type const end = subtree_end_[root];
+    for (index_type n = root; n < end; ++n)
+      if (syntag_[n] == syntag)
+        result.push_back(n);
+  }
+  return result;
+}
+
+std::size_t Frozen_Tree::count(int const syntag, index_type const root) const {
+  if (root >= size())
+    return 0;
+  return static_cast<std::size_t>(
+      std::count(syntag_.begin() + root, syntag_.begin() + subtree_end_[root],
+                 syntag));
+}
+
+Frozen_Tree::index_type Frozen_Tree::add_node_(int const syntag,
+                                               index_type const parent) {
+  syntag_.push_back(syntag);
+  parent_.push_back(parent);
+  token_begin_.push_back(0);
+  num_tokens_.push_back(0);
+  stmt_.push_back(nullptr);
+  return size() - 1;
+}
+
+/* Append the tokens of r to the table, and search them for spans */
+void Frozen_Tree::add_tokens_(LL_TT_Range const &r) {
+  window_begin_ = search_hint_ = static_cast<index_type>(tokens_.size());
+  for (auto const &tt : r)
+    tokens_.push_back(&tt);
+  window_end_ = static_cast<index_type>(tokens_.size());
+}
+
+/* The same statement can be in several leaves of a Prgm_Tree, but its tokens
+   are only added once */
+bool Frozen_Tree::add_stmt_tokens_(LL_Stmt const &stmt) {
+  auto const [it, added] =
+      stmt_index_.emplace(&stmt, static_cast<index_type>(tokens_.size()));
+  if (added) {
+    add_tokens_(stmt);
+  } else {
+    window_begin_ = search_hint_ = it->second;
+    window_end_ = window_begin_ + static_cast<index_type>(stmt.size());
+  }
+  return window_end_ <= tokens_.size();
+}
+
+/* The tokens of r must be consecutive entries of the current window.  The
+   search starts at the hint, and wraps around. */
+bool Frozen_Tree::set_span_(index_type const node, LL_TT_Range const &r) {
+  if (r.empty())
+    return true;
+  Token_Text const *const front = &r.front();
+  index_type first = search_hint_;
+  while (first < window_end_ && tokens_[first] != front)
+    first += 1;
+  if (first == window_end_) {
+    for (first = window_begin_; first < search_hint_; ++first)
+      if (tokens_[first] == front)
+        break;
+    if (first == search_hint_)
+      return false;
+  }
+  std::size_t const end = first + r.size();
+  if (end > window_end_ || tokens_[end - 1] != &r.back())
+    return false;
+  token_begin_[node] = first;
+  num_tokens_[node] = static_cast<index_type>(r.size());
+  /* The first branch usually starts where its parent does... */
+  search_hint_ = first;
+  return true;
+}
+
+bool Frozen_Tree::add_stmt_tree_(Stmt::Stmt_Tree::node const &n,
+                                 index_type const parent) {
+  index_type const self = add_node_(n->syntag, parent);
+  if (!set_span_(self, n->token_range))
+    return false;
+  if (n.is_fork()) {
+    for (auto const &b : n.branches()) {
+      index_type const child = size();
+      if (!add_stmt_tree_(b, self))
+        return false;
+      /* ...and each sibling where the last one ended */
+      if (num_tokens_[child])
+        search_hint_ = token_end(child);
+    }
+  }
+  return true;
+}
+
+/* Fill in the links between the nodes, which follow from the parents and
+   the preorder numbering */
+void Frozen_Tree::finish_() {
+  index_type const N = size();
+  first_child_.assign(N, npos);
+  next_sibling_.assign(N, npos);
+  subtree_end_.resize(N);
+  std::vector<index_type> last_child(N, npos);
+  for (index_type n = 0; n < N; ++n) {
+    subtree_end_[n] = n + 1;
+    index_type const p = parent_[n];
+    if (p == npos)
+      continue;
+    if (last_child[p] == npos)
+      first_child_[p] = n;
+    else
+      next_sibling_[last_child[p]] = n;
+    last_child[p] = n;
+    /* A node that covers no tokens starts where its parent does */
+    if (!num_tokens_[n])
+      token_begin_[n] = token_begin_[p];
+  }
+  /* The descendants of a node come after it */
+  for (index_type n = N; n-- > 1;) {
+    index_type const p = parent_[n];
+    subtree_end_[p] = std::max(subtree_end_[p], subtree_end_[n]);
+  }
+  stmt_index_.clear();
+}
+
+} // namespace FLPR
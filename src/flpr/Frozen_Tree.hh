@@ -0,0 +1,284 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Frozen_Tree.hh
+*/
+
+#ifndef FLPR_FROZEN_TREE_HH
+#define FLPR_FROZEN_TREE_HH 1
+
+#include "flpr/LL_Stmt.hh"
+#include "flpr/Stmt_Tree.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace FLPR {
+
+//! A read-only, flattened copy of a Prgm_Tree or Stmt_Tree
+/*!
+  A Tree is a web of separately allocated nodes, so walking one chases
+  several pointers per step.  Passes that only query a tree (find every
+  call-stmt, list the use-stmts) can freeze it first: the nodes are numbered
+  in preorder, and each property of a node is kept in its own array, indexed
+  by that number.  So a scan for a syntag is a linear pass over an array of
+  ints, the descendants of node n are the nodes n+1 up to subtree_end(n), and
+  the whole tree takes a few words per node.
+
+  The token span of each node is a range of entries in a table of the
+  Token_Texts that the tree covers, in file order: those of its statements,
+  for a Prgm_Tree, or those of the root, for a Stmt_Tree.  A Prgm_Tree is
+  normally frozen together with the Stmt_Tree of each statement, which
+  becomes the only branch of the statement node.
+
+  A Frozen_Tree refers to the Token_Texts and LL_Stmts of the tree that it
+  was made from, so it can't be used after that tree (or its Logical_File)
+  has been changed or destroyed.  It can be moved and copied.
+*/
+class Frozen_Tree {
+public:
+  //! The (preorder) number of a node
+  using index_type = std::uint32_t;
+  //! A missing parent, child or sibling
+  static constexpr index_type npos = static_cast<index_type>(-1);
+
+  class Cursor;
+
+  //! Replace the contents with a copy of a Stmt_Tree
+  /*! Returns false, leaving this empty, if a node of t covers tokens that
+      aren't covered by its root. */
+  bool freeze(Stmt::Stmt_Tree const &t);
+  //! Replace the contents with a copy of a Prgm_Tree
+  /*! Returns false, leaving this empty, if the Stmt_Tree of a statement
+      covers tokens that aren't in the statement. */
+  template <typename PG_NODE_DATA, typename ALLOC>
+  bool freeze(Tree<PG_NODE_DATA, ALLOC> const &t,
+              bool const with_stmt_trees = true);
+  void clear();
+
+  //! True if the last freeze() was of a Prgm_Tree
+  bool is_prgm_tree() const noexcept { return is_prgm_tree_; }
+  //! The number of nodes
+  index_type size() const noexcept {
+    return static_cast<index_type>(syntag_.size());
+  }
+  bool empty() const noexcept { return syntag_.empty(); }
+
+  int syntag(index_type const n) const { return syntag_[n]; }
+  index_type parent(index_type const n) const { return parent_[n]; }
+  index_type first_child(index_type const n) const { return first_child_[n]; }
+  index_type next_sibling(index_type const n) const {
+    return next_sibling_[n];
+  }
+  //! One past the last descendant of n
+  index_type subtree_end(index_type const n) const { return subtree_end_[n]; }
+  bool is_leaf(index_type const n) const { return first_child_[n] == npos; }
+  index_type num_branches(index_type const n) const;
+
+  //! True for the statement nodes of a Prgm_Tree
+  bool is_stmt(index_type const n) const { return stmt_[n] != nullptr; }
+  //! The statement of a Prgm_Tree statement node, or nullptr
+  LL_Stmt const *ll_stmt(index_type const n) const { return stmt_[n]; }
+
+  //! The index into tokens() of the first token covered by n
+  index_type token_begin(index_type const n) const { return token_begin_[n]; }
+  index_type token_end(index_type const n) const {
+    return token_begin_[n] + num_tokens_[n];
+  }
+  index_type num_tokens(index_type const n) const { return num_tokens_[n]; }
+  //! The table of tokens covered by the tree
+  std::vector<Token_Text const *> const &tokens() const noexcept {
+    return tokens_;
+  }
+
+  //! The syntag of each node, for custom scans
+  std::vector<int> const &syntags() const noexcept { return syntag_; }
+  //! Return the nodes, within the subtree of root, that have a syntag
+  std::vector<index_type> find(int const syntag, index_type root = 0) const;
+  //! Return the number of nodes, within the subtree of root, with a syntag
+  std::size_t count(int const syntag, index_type root = 0) const;
+
+  //! Return a Cursor on node n
+  Cursor cursor(index_type const n = 0) const;
+
+private:
+  index_type add_node_(int syntag, index_type parent);
+  void add_tokens_(LL_TT_Range const &r);
+  bool add_stmt_tokens_(LL_Stmt const &stmt);
+  bool set_span_(index_type node, LL_TT_Range const &r);
+  bool add_stmt_tree_(Stmt::Stmt_Tree::node const &n, index_type parent);
+  template <typename NODE>
+  bool add_prgm_(NODE const &n, index_type parent,
+                 bool const with_stmt_trees);
+  void finish_();
+
+private:
+  std::vector<int> syntag_;
+  std::vector<index_type> parent_;
+  std::vector<index_type> first_child_;
+  std::vector<index_type> next_sibling_;
+  std::vector<index_type> subtree_end_;
+  std::vector<index_type> token_begin_;
+  std::vector<index_type> num_tokens_;
+  std::vector<LL_Stmt const *> stmt_;
+  std::vector<Token_Text const *> tokens_;
+  bool is_prgm_tree_{false};
+
+  /* Scratch space for freeze() */
+  //! The first token of each statement that has been added
+  std::unordered_map<LL_Stmt const *, index_type> stmt_index_;
+  //! The tokens of the current statement
+  index_type window_begin_{0}, window_end_{0};
+  //! Where to start searching for the next span
+  index_type search_hint_{0};
+};
+
+//! Navigate a Frozen_Tree, in the manner of a TN_Const_Cursor
+class Frozen_Tree::Cursor {
+public:
+  Cursor() = default;
+  Cursor(Frozen_Tree const &tree, index_type const n)
+      : tree_{&tree}, n_{n} {}
+
+  //! Return true if this Cursor is on a node
+  explicit operator bool() const noexcept { return tree_ != nullptr; }
+  //! The node that the Cursor is on
+  index_type index() const noexcept { return n_; }
+  Frozen_Tree const &tree() const noexcept { return *tree_; }
+
+  int syntag() const { return tree_->syntag(n_); }
+  bool is_root() const { return tree_->parent(n_) == npos; }
+  bool is_leaf() const { return tree_->is_leaf(n_); }
+  bool is_fork() const { return !is_leaf(); }
+  index_type num_branches() const { return tree_->num_branches(n_); }
+  bool is_stmt() const { return tree_->is_stmt(n_); }
+  LL_Stmt const *ll_stmt() const { return tree_->ll_stmt(n_); }
+  index_type token_begin() const { return tree_->token_begin(n_); }
+  index_type token_end() const { return tree_->token_end(n_); }
+
+  [[nodiscard]] bool has_up() const { return !is_root(); }
+  Cursor &up(int const count = 1) {
+    for (int i = 0; i < count; ++i) {
+      assert(has_up());
+      n_ = tree_->parent(n_);
+    }
+    return *this;
+  }
+  [[nodiscard]] bool has_prev() const {
+    return !is_root() && tree_->first_child(tree_->parent(n_)) != n_;
+  }
+  //! Move backwards: this is linear in the number of earlier siblings
+  Cursor &prev(int const count = 1) {
+    for (int i = 0; i < count; ++i) {
+      assert(has_prev());
+      index_type p = tree_->first_child(tree_->parent(n_));
+      while (tree_->next_sibling(p) != n_)
+        p = tree_->next_sibling(p);
+      n_ = p;
+    }
+    return *this;
+  }
+  [[nodiscard]] bool has_next() const {
+    return tree_->next_sibling(n_) != npos;
+  }
+  Cursor &next(int const count = 1) {
+    for (int i = 0; i < count; ++i) {
+      assert(has_next());
+      n_ = tree_->next_sibling(n_);
+    }
+    return *this;
+  }
+  bool try_next(int const count = 1) {
+    int i{0};
+    for (i = 0; i < count && has_next(); ++i)
+      n_ = tree_->next_sibling(n_);
+    return i == count;
+  }
+  [[nodiscard]] bool has_down() const { return is_fork(); }
+  Cursor &down(int const count = 1) {
+    for (int i = 0; i < count; ++i) {
+      assert(has_down());
+      n_ = tree_->first_child(n_);
+    }
+    return *this;
+  }
+  bool try_down(int const count = 1) {
+    int i{0};
+    for (i = 0; i < count && has_down(); ++i)
+      n_ = tree_->first_child(n_);
+    return i == count;
+  }
+
+private:
+  Frozen_Tree const *tree_{nullptr};
+  index_type n_{0};
+};
+
+inline Frozen_Tree::Cursor Frozen_Tree::cursor(index_type const n) const {
+  assert(n < size());
+  return Cursor{*this, n};
+}
+
+template <typename PG_NODE_DATA, typename ALLOC>
+bool Frozen_Tree::freeze(Tree<PG_NODE_DATA, ALLOC> const &t,
+                         bool const with_stmt_trees) {
+  clear();
+  is_prgm_tree_ = true;
+  if (!t.empty() && !add_prgm_(*t, npos, with_stmt_trees)) {
+    clear();
+    return false;
+  }
+  finish_();
+  return true;
+}
+
+/* A statement covers its own tokens, which are added to the table as they
+   are met.  Other nodes cover those of their branches. */
+template <typename NODE>
+bool Frozen_Tree::add_prgm_(NODE const &n, index_type const parent,
+                            bool const with_stmt_trees) {
+  index_type const self = add_node_(n->syntag(), parent);
+  if (n->is_stmt()) {
+    LL_Stmt const &stmt = n->ll_stmt();
+    stmt_[self] = &stmt;
+    if (!add_stmt_tokens_(stmt) || !set_span_(self, stmt))
+      return false;
+    if (with_stmt_trees) {
+      auto const &st = stmt.stmt_tree();
+      if (!st.empty() && !add_stmt_tree_(*st, self))
+        return false;
+    }
+    return true;
+  }
+  if (n.is_leaf())
+    return true;
+  /* A shared do termination is in several leaves, so the branches aren't
+     necessarily in token order */
+  index_type begin{0}, end{0};
+  for (auto const &b : n.branches()) {
+    index_type const child = size();
+    if (!add_prgm_(b, self, with_stmt_trees))
+      return false;
+    if (num_tokens_[child]) {
+      begin = (begin == end) ? token_begin_[child]
+                             : std::min(begin, token_begin_[child]);
+      end = std::max(end, token_end(child));
+    }
+  }
+  token_begin_[self] = begin;
+  num_tokens_[self] = end - begin;
+  return true;
+}
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,433 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Hand_Lexer.cc
+
+  Each scan_*_() follows one start condition of scan_fort.l, taking the
+  longest match of its rules, and the earliest rule for matches of the same
+  length.  Rules that "yyless(0)" and change state are a change of state_
+  here, followed by another pass through next().
+*/
+
+#include "flpr/Hand_Lexer.hh"
+#include "flpr/Keyword_Hash.hh"
+#include "flpr/Syntax_Tags.hh"
+#include <array>
+#include <cstring>
+
+namespace FLPR {
+
+namespace {
+
+enum Char_Class : unsigned char { LETTER = 1, DIGIT = 2, UNDERSCORE = 4 };
+
+constexpr std::array<unsigned char, 256> make_char_classes() {
+  std::array<unsigned char, 256> classes{};
+  for (int c = 'a'; c <= 'z'; ++c) {
+    classes[c] = LETTER;
+    classes[c - 'a' + 'A'] = LETTER;
+  }
+  for (int c = '0'; c <= '9'; ++c)
+    classes[c] = DIGIT;
+  classes['_'] = UNDERSCORE;
+  return classes;
+}
+
+constexpr std::array<unsigned char, 256> char_classes{make_char_classes()};
+
+inline bool is_class(char const c, unsigned char const mask) noexcept {
+  return char_classes[static_cast<unsigned char>(c)] & mask;
+}
+inline bool is_letter(char const c) noexcept { return is_class(c, LETTER); }
+inline bool is_digit(char const c) noexcept { return is_class(c, DIGIT); }
+inline bool is_quote(char const c) noexcept { return c == '\'' || c == '"'; }
+
+/* The matchers below take the input, its size, and a starting offset.  They
+   return the offset just past the longest match, or -1 if there is none. */
+
+/* [0-9]*, so this never fails */
+int digits_end(char const *const s, int const n, int p) noexcept {
+  while (p < n && is_digit(s[p]))
+    p += 1;
+  return p;
+}
+
+/* [a-z]* */
+int letters_end(char const *const s, int const n, int p) noexcept {
+  while (p < n && is_letter(s[p]))
+    p += 1;
+  return p;
+}
+
+/* {NAME}: [a-z][a-z0-9_]* */
+int name_end(char const *const s, int const n, int p) noexcept {
+  if (p >= n || !is_letter(s[p]))
+    return -1;
+  p += 1;
+  while (p < n && is_class(s[p], LETTER | DIGIT | UNDERSCORE))
+    p += 1;
+  return p;
+}
+
+/* {KIND}: [0-9]+ | {NAME} */
+int kind_end(char const *const s, int const n, int const p) noexcept {
+  if (p < n && is_digit(s[p]))
+    return digits_end(s, n, p);
+  return name_end(s, n, p);
+}
+
+/* (_{KIND})?, so this never fails */
+int opt_kind_end(char const *const s, int const n, int const p) noexcept {
+  if (p < n && s[p] == '_') {
+    int const k = kind_end(s, n, p + 1);
+    if (k > 0)
+      return k;
+  }
+  return p;
+}
+
+/* {EXPONENT}: [ed][-+]?[0-9]+ */
+int exponent_end(char const *const s, int const n, int p) noexcept {
+  if (p >= n || ((s[p] | 0x20) != 'e' && (s[p] | 0x20) != 'd'))
+    return -1;
+  p += 1;
+  if (p < n && (s[p] == '+' || s[p] == '-'))
+    p += 1;
+  int const e = digits_end(s, n, p);
+  return (e > p) ? e : -1;
+}
+
+/* {SIGNIFICAND}: ([0-9]+\.[0-9]*) | (\.[0-9]+) */
+int significand_end(char const *const s, int const n, int const p) noexcept {
+  if (p < n && is_digit(s[p])) {
+    int const d = digits_end(s, n, p);
+    return (d < n && s[d] == '.') ? digits_end(s, n, d + 1) : -1;
+  }
+  if (p + 1 < n && s[p] == '.' && is_digit(s[p + 1]))
+    return digits_end(s, n, p + 1);
+  return -1;
+}
+
+/* [0-9]+\.[a-z]+\. : digits followed by an operator like .and. */
+int digits_op_end(char const *const s, int const n, int const p) noexcept {
+  int const d = digits_end(s, n, p);
+  if (d == p || d + 1 >= n || s[d] != '.' || !is_letter(s[d + 1]))
+    return -1;
+  int const e = letters_end(s, n, d + 1);
+  return (e < n && s[e] == '.') ? e + 1 : -1;
+}
+
+/* '(''|[^'])*' (or the same with "), where s[p] is the opening quote.  In the
+   longest match, a doubled quote continues the string unless nothing closes
+   it afterwards. */
+int char_literal_end(char const *const s, int const n, int const p) noexcept {
+  char const q = s[p];
+  int last = -1;
+  int i = p + 1;
+  for (;;) {
+    while (i < n && s[i] != q)
+      i += 1;
+    if (i >= n)
+      return last;
+    last = i + 1;
+    if (last >= n || s[last] != q)
+      return last;
+    i = last + 1;
+  }
+}
+
+/* The tag of a dotted operator or logical constant, \.[a-z]+\. */
+int dot_word_tag(char const *const s, int const len) noexcept {
+  struct Dot_Word {
+    char const *word;
+    int len;
+    int tag;
+  };
+  static constexpr Dot_Word words[] = {
+      {"eq", 2, Syntax_Tags::TK_REL_EQ},
+      {"ne", 2, Syntax_Tags::TK_REL_NE},
+      {"lt", 2, Syntax_Tags::TK_REL_LT},
+      {"le", 2, Syntax_Tags::TK_REL_LE},
+      {"gt", 2, Syntax_Tags::TK_REL_GT},
+      {"ge", 2, Syntax_Tags::TK_REL_GE},
+      {"or", 2, Syntax_Tags::TK_OR_OP},
+      {"not", 3, Syntax_Tags::TK_NOT_OP},
+      {"and", 3, Syntax_Tags::TK_AND_OP},
+      {"eqv", 3, Syntax_Tags::TK_EQV_OP},
+      {"neqv", 4, Syntax_Tags::TK_NEQV_OP},
+      {"true", 4, Syntax_Tags::TK_TRUE_CONSTANT},
+      {"false", 5, Syntax_Tags::TK_FALSE_CONSTANT},
+  };
+  for (Dot_Word const &w : words) {
+    if (w.len != len)
+      continue;
+    int i = 0;
+    while (i < len && (s[i] | 0x20) == w.word[i])
+      i += 1;
+    if (i == len)
+      return w.tag;
+  }
+  return Syntax_Tags::TK_DEF_OP;
+}
+
+/* A scan_*_() result that means "state_ changed, scan again" */
+constexpr int again = -1;
+
+} // namespace
+
+void Hand_Lexer::set_input(std::string const &text) noexcept {
+  /* Like yy_scan_string(), stop at a null character */
+  input_ = text.c_str();
+  size_ = static_cast<int>(std::strlen(input_));
+  pos_ = 0;
+  text_ = input_;
+  length_ = 0;
+  state_ = State::initial;
+  pushed_ = State::initial;
+}
+
+int Hand_Lexer::emit_(int const len, int const tag) noexcept {
+  text_ = input_ + pos_;
+  length_ = len;
+  pos_ += len;
+  return tag;
+}
+
+int Hand_Lexer::next() noexcept {
+  char const *const s = input_;
+  int const n = size_;
+  for (;;) {
+    int result;
+    switch (state_) {
+    case State::initial:
+      result = scan_initial_();
+      break;
+    case State::real:
+      result = scan_real_();
+      break;
+    case State::exponent:
+      /* e|d, then [-+]?{DIGIT}+ */
+      if (pos_ >= n)
+        return emit_(0, Syntax_Tags::EOL);
+      if ((s[pos_] | 0x20) == 'e' || (s[pos_] | 0x20) == 'd')
+        return emit_(1, Syntax_Tags::SG_EXPONENT_LETTER);
+      {
+        int const sign = (s[pos_] == '+' || s[pos_] == '-') ? 1 : 0;
+        int const e = digits_end(s, n, pos_ + sign);
+        if (e > pos_ + sign) {
+          state_ = pushed_;
+          return emit_(e - pos_, Syntax_Tags::SG_EXPONENT);
+        }
+      }
+      pos_ += 1; // the flex default rule
+      result = again;
+      break;
+    case State::kind:
+      /* "_", then {KIND} */
+      if (pos_ >= n)
+        return emit_(0, Syntax_Tags::EOL);
+      if (s[pos_] == '_')
+        return emit_(1, Syntax_Tags::TK_UNDERSCORE);
+      {
+        int const k = kind_end(s, n, pos_);
+        if (k > 0) {
+          state_ = pushed_;
+          return emit_(k - pos_, Syntax_Tags::SG_KIND_PARAM);
+        }
+      }
+      pos_ += 1;
+      result = again;
+      break;
+    case State::int_only:
+      if (pos_ >= n)
+        return emit_(0, Syntax_Tags::EOL);
+      if (is_digit(s[pos_])) {
+        state_ = State::initial;
+        return emit_(digits_end(s, n, pos_) - pos_,
+                     Syntax_Tags::SG_INT_LITERAL_CONSTANT);
+      }
+      pos_ += 1;
+      result = again;
+      break;
+    }
+    if (result != again)
+      return result;
+  }
+}
+
+int Hand_Lexer::scan_initial_() noexcept {
+  char const *const s = input_;
+  int const n = size_;
+  while (pos_ < n) {
+    int const p = pos_;
+    char const c = s[p];
+    char const c1 = (p + 1 < n) ? s[p + 1] : '\0';
+
+    if (is_letter(c)) {
+      int const e = name_end(s, n, p);
+      /* {NAME}_'...' is a character literal with a kind prefix */
+      if (s[e - 1] == '_' && e < n && is_quote(s[e])) {
+        int const q = char_literal_end(s, n, e);
+        if (q > 0)
+          return emit_(q - p, Syntax_Tags::SG_CHAR_LITERAL_CONSTANT);
+      }
+      details_::Keyword const *const kw =
+          details_::Keyword_Hash::in_word_set(s + p, e - p);
+      return emit_(e - p, kw ? kw->tag : Syntax_Tags::TK_NAME);
+    }
+
+    if (is_digit(c)) {
+      int const d = digits_end(s, n, p);
+      if (d + 1 < n && s[d] == '_' && is_quote(s[d + 1])) {
+        int const q = char_literal_end(s, n, d + 1);
+        if (q > 0)
+          return emit_(q - p, Syntax_Tags::SG_CHAR_LITERAL_CONSTANT);
+      }
+      /* A real literal is split up by the real state, starting over here */
+      int real = -1;
+      if (d < n && s[d] == '.') {
+        int const x = digits_end(s, n, d + 1);
+        int const e = exponent_end(s, n, x);
+        real = opt_kind_end(s, n, (e > 0) ? e : x);
+      } else {
+        int const e = exponent_end(s, n, d);
+        if (e > 0)
+          real = opt_kind_end(s, n, e);
+      }
+      int const integer = opt_kind_end(s, n, d);
+      if (real >= integer) {
+        state_ = State::real;
+        return again;
+      }
+      return emit_(integer - p, Syntax_Tags::SG_INT_LITERAL_CONSTANT);
+    }
+
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n': // the flex default rule
+      pos_ += 1;
+      continue;
+    case '\'':
+    case '"': {
+      int const q = char_literal_end(s, n, p);
+      if (q > 0)
+        return emit_(q - p, Syntax_Tags::SG_CHAR_LITERAL_CONSTANT);
+      return emit_(1, Syntax_Tags::UNKNOWN);
+    }
+    case '.':
+      if (is_digit(c1)) {
+        state_ = State::real;
+        return again;
+      }
+      if (c1 == '.')
+        return emit_(2, Syntax_Tags::TK_DBL_DOT);
+      if (is_letter(c1)) {
+        int const e = letters_end(s, n, p + 1);
+        if (e < n && s[e] == '.') {
+          int const tag = dot_word_tag(s + p + 1, e - p - 1);
+          if (tag == Syntax_Tags::TK_TRUE_CONSTANT ||
+              tag == Syntax_Tags::TK_FALSE_CONSTANT)
+            return emit_(opt_kind_end(s, n, e + 1) - p, tag);
+          return emit_(e + 1 - p, tag);
+        }
+      }
+      return emit_(1, Syntax_Tags::UNKNOWN);
+    case '(':
+      return emit_(1, Syntax_Tags::TK_PARENL);
+    case ')':
+      return emit_(1, Syntax_Tags::TK_PARENR);
+    case '[':
+      return emit_(1, Syntax_Tags::TK_BRACKETL);
+    case ']':
+      return emit_(1, Syntax_Tags::TK_BRACKETR);
+    case '+':
+      return emit_(1, Syntax_Tags::TK_PLUS);
+    case '-':
+      return emit_(1, Syntax_Tags::TK_MINUS);
+    case ';':
+      return emit_(1, Syntax_Tags::TK_SEMICOLON);
+    case '%':
+      return emit_(1, Syntax_Tags::TK_PERCENT);
+    case ',':
+      return emit_(1, Syntax_Tags::TK_COMMA);
+    case '|':
+      return emit_(1, Syntax_Tags::TK_VBAR);
+    case '=':
+      if (c1 == '=')
+        return emit_(2, Syntax_Tags::TK_REL_EQ);
+      if (c1 == '>')
+        return emit_(2, Syntax_Tags::TK_ARROW);
+      return emit_(1, Syntax_Tags::TK_EQUAL);
+    case ':':
+      if (c1 == ':')
+        return emit_(2, Syntax_Tags::TK_DBL_COLON);
+      return emit_(1, Syntax_Tags::TK_COLON);
+    case '/':
+      if (c1 == '/')
+        return emit_(2, Syntax_Tags::TK_CONCAT);
+      if (c1 == '=')
+        return emit_(2, Syntax_Tags::TK_REL_NE);
+      return emit_(1, Syntax_Tags::TK_SLASHF);
+    case '*':
+      if (c1 == '*')
+        return emit_(2, Syntax_Tags::TK_POWER_OP);
+      return emit_(1, Syntax_Tags::TK_ASTERISK);
+    case '<':
+      if (c1 == '=')
+        return emit_(2, Syntax_Tags::TK_REL_LE);
+      return emit_(1, Syntax_Tags::TK_REL_LT);
+    case '>':
+      if (c1 == '=')
+        return emit_(2, Syntax_Tags::TK_REL_GE);
+      return emit_(1, Syntax_Tags::TK_REL_GT);
+    default:
+      return emit_(1, Syntax_Tags::UNKNOWN);
+    }
+  }
+  return emit_(0, Syntax_Tags::EOL);
+}
+
+int Hand_Lexer::scan_real_() noexcept {
+  char const *const s = input_;
+  int const n = size_;
+  int const p = pos_;
+  if (p >= n) {
+    state_ = State::initial;
+    return emit_(0, Syntax_Tags::EOL);
+  }
+  if (is_digit(s[p])) {
+    /* "1.and." is an integer followed by an operator */
+    if (digits_op_end(s, n, p) > 0) {
+      state_ = State::int_only;
+      return again;
+    }
+    int const sig = significand_end(s, n, p);
+    int const end = (sig > 0) ? sig : digits_end(s, n, p);
+    return emit_(end - p, Syntax_Tags::SG_SIGNIFICAND);
+  }
+  int const sig = significand_end(s, n, p);
+  if (sig > 0)
+    return emit_(sig - p, Syntax_Tags::SG_SIGNIFICAND);
+  if (exponent_end(s, n, p) > 0) {
+    pushed_ = State::real;
+    state_ = State::exponent;
+  } else if (s[p] == '_' && kind_end(s, n, p + 1) > 0) {
+    pushed_ = State::real;
+    state_ = State::kind;
+  } else {
+    state_ = State::initial;
+  }
+  return again;
+}
+
+} // namespace FLPR
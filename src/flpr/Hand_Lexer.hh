@@ -0,0 +1,76 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Hand_Lexer.hh
+*/
+
+#ifndef FLPR_HAND_LEXER_HH
+#define FLPR_HAND_LEXER_HH 1
+
+#include <string>
+
+namespace FLPR {
+
+//! A hand-written equivalent of the flex scanner in scan_fort.l
+/*!
+  This produces the same tokens, lexemes and positions as the flex scanner,
+  including its treatment of real literals as a sequence of significand,
+  exponent and kind tokens, but it recognizes a name and decides if it is a
+  keyword in one pass over the characters and one Keyword_Hash probe, rather
+  than running the name through a DFA with a state for every keyword prefix.
+
+  Lexer uses this in place of the flex scanner when FLPR is configured with
+  FLPR_HAND_LEXER=ON (which also removes the build dependence on flex).  It
+  is always built, so that the two can be compared.
+
+  The interface is that of Lexer: set_input(), then next() until it returns
+  Syntax_Tags::EOL.  Unlike the flex scanner, text() points into the input
+  string, and is NOT null-terminated.
+*/
+class Hand_Lexer {
+public:
+  Hand_Lexer() = default;
+  Hand_Lexer(Hand_Lexer const &) = delete;
+  Hand_Lexer &operator=(Hand_Lexer const &) = delete;
+
+  //! Start scanning a new string, resetting the position to zero
+  void set_input(std::string const &text) noexcept;
+  //! Return the next token, or Syntax_Tags::EOL at the end of the input
+  int next() noexcept;
+  //! The lexeme of the last token returned by next()
+  char const *text() const noexcept { return text_; }
+  //! The number of characters in text()
+  int length() const noexcept { return length_; }
+  //! The offset into the input of the character following the last token
+  int position() const noexcept { return pos_; }
+
+private:
+  //! The scan_fort.l start conditions
+  enum class State { initial, real, exponent, kind, int_only };
+
+  int scan_initial_() noexcept;
+  int scan_real_() noexcept;
+  //! Consume len characters as the token tag
+  int emit_(int len, int tag) noexcept;
+
+private:
+  char const *input_{nullptr};
+  int size_{0};
+  int pos_{0};
+  char const *text_{""};
+  int length_{0};
+  State state_{State::initial};
+  //! The state to return to from exponent or kind (the flex state stack)
+  State pushed_{State::initial};
+};
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,236 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Keyword_Hash.hh
+  A perfect hash over the Fortran keywords, and over the names that are
+  actually two adjacent keywords without a space (section 6.3.2.2).
+
+  The keywords are the KW_ Syntax_Tags, spelled as their labels, so the
+  table can't drift from Syntax_Tags_Defs.hh.  It is built by the compiler: the
+  keys are spread over a small number of buckets by a hash of their
+  case-folded characters, and each bucket is given a displacement that maps
+  its keys to unused slots (the "hash, displace" scheme).  A lookup is then a
+  single pass over the characters, one displacement and one slot probe, with
+  no chained comparisons.
+
+  NOTE: doubleprecision is a keyword (KW_DOUBLEPRECISION), but is NOT a
+  smashed pair: the parsers handle it directly by combining DOUBLE PRECISION
+  under a KW_DOUBLEPRECISION root.
+*/
+
+#ifndef FLPR_KEYWORD_HASH_HH
+#define FLPR_KEYWORD_HASH_HH 1
+
+#include "flpr/Syntax_Tags.hh"
+#include <cstddef>
+#include <cstdint>
+
+namespace FLPR {
+namespace details_ {
+
+//! A keyword or smashed keyword pair known to Keyword_Hash
+struct Keyword {
+  //! The spelling, in either case (the Syntax_Tags label for keywords)
+  char const *name;
+  int length;
+  //! The KW_ tag of a keyword, or TK_NAME for a smashed pair
+  int tag;
+  //! For a smashed pair, the tags of the two keywords
+  int tok1;
+  int tok2;
+  //! For a smashed pair, the length of the first keyword, otherwise 0
+  int splitpos;
+  constexpr bool is_smashed() const noexcept { return splitpos > 0; }
+};
+
+//! A name that is two keywords without a space
+struct Smashed {
+  char const *name;
+  int tok1;
+  int tok2;
+  int splitpos;
+};
+
+// clang-format off
+//! The names that are two keywords without a space, as per 6.3.2.2
+inline constexpr Smashed smashed_keywords[] = {
+  {"blockdata", Syntax_Tags::KW_BLOCK, Syntax_Tags::KW_DATA, 5},
+  {"elseif", Syntax_Tags::KW_ELSE, Syntax_Tags::KW_IF, 4},
+  {"elsewhere", Syntax_Tags::KW_ELSE, Syntax_Tags::KW_WHERE, 4},
+  {"endassociate", Syntax_Tags::KW_END, Syntax_Tags::KW_ASSOCIATE, 3},
+  {"endblock", Syntax_Tags::KW_END, Syntax_Tags::KW_BLOCK, 3},
+  {"endcritical", Syntax_Tags::KW_END, Syntax_Tags::KW_CRITICAL, 3},
+  {"enddo", Syntax_Tags::KW_END, Syntax_Tags::KW_DO, 3},
+  {"endenum", Syntax_Tags::KW_END, Syntax_Tags::KW_ENUM, 3},
+  {"endfile", Syntax_Tags::KW_END, Syntax_Tags::KW_FILE, 3},
+  {"endforall", Syntax_Tags::KW_END, Syntax_Tags::KW_FORALL, 3},
+  {"endfunction", Syntax_Tags::KW_END, Syntax_Tags::KW_FUNCTION, 3},
+  {"endif", Syntax_Tags::KW_END, Syntax_Tags::KW_IF, 3},
+  {"endinterface", Syntax_Tags::KW_END, Syntax_Tags::KW_INTERFACE, 3},
+  {"endmodule", Syntax_Tags::KW_END, Syntax_Tags::KW_MODULE, 3},
+  {"endprocedure", Syntax_Tags::KW_END, Syntax_Tags::KW_PROCEDURE, 3},
+  {"endprogram", Syntax_Tags::KW_END, Syntax_Tags::KW_PROGRAM, 3},
+  {"endselect", Syntax_Tags::KW_END, Syntax_Tags::KW_SELECT, 3},
+  {"endsubmodule", Syntax_Tags::KW_END, Syntax_Tags::KW_SUBMODULE, 3},
+  {"endsubroutine", Syntax_Tags::KW_END, Syntax_Tags::KW_SUBROUTINE, 3},
+  {"endteam", Syntax_Tags::KW_END, Syntax_Tags::KW_TEAM, 3},
+  {"endtype", Syntax_Tags::KW_END, Syntax_Tags::KW_TYPE, 3},
+  {"endwhere", Syntax_Tags::KW_END, Syntax_Tags::KW_WHERE, 3},
+  {"goto", Syntax_Tags::KW_GO, Syntax_Tags::KW_TO, 2},
+  {"selectcase", Syntax_Tags::KW_SELECT, Syntax_Tags::KW_CASE, 6},
+  {"selecttype", Syntax_Tags::KW_SELECT, Syntax_Tags::KW_TYPE, 6},
+};
+// clang-format on
+
+/* Names are made of [A-Za-z0-9_], and setting the 0x20 bit is one-to-one on
+   that set, and maps both cases of a letter to the lower case one */
+constexpr unsigned char keyword_fold(char const c) noexcept {
+  return static_cast<unsigned char>(c) | 0x20;
+}
+
+//! FNV-1a over the case-folded characters of a name
+constexpr std::uint32_t keyword_hash(char const *const str,
+                                     std::size_t const len) noexcept {
+  std::uint32_t h{2166136261u};
+  for (std::size_t i = 0; i < len; ++i)
+    h = (h ^ keyword_fold(str[i])) * 16777619u;
+  return h;
+}
+
+constexpr int keyword_length(char const *const str) noexcept {
+  int len = 0;
+  while (str[len])
+    len += 1;
+  return len;
+}
+
+//! The compiler-built table behind Keyword_Hash
+struct Keyword_Hash_Table {
+  static constexpr int num_slots = 256;
+  static constexpr int num_buckets = 64;
+  static constexpr int max_length = 16;
+
+  static constexpr int bucket(std::uint32_t const h) noexcept {
+    return static_cast<int>(h >> 26);
+  }
+  static constexpr int slot(std::uint32_t h,
+                            std::uint32_t const disp) noexcept {
+    h ^= disp * 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return static_cast<int>(h & (num_slots - 1));
+  }
+
+  Keyword slots[num_slots]{};
+  std::uint32_t disp[num_buckets]{};
+  //! False if the build failed: a duplicate or overlong key, or no fit
+  bool ok{false};
+};
+
+constexpr Keyword_Hash_Table build_keyword_hash_table() noexcept {
+  constexpr int num_keys = [] {
+    return Syntax_Tags::kw_end_tag() - Syntax_Tags::kw_begin_tag() +
+           static_cast<int>(sizeof(smashed_keywords) / sizeof(Smashed));
+  }();
+
+  using Table = Keyword_Hash_Table;
+  Table t;
+  Keyword keys[num_keys]{};
+  std::uint32_t hashes[num_keys]{};
+  int n = 0;
+  for (int tag = Syntax_Tags::kw_begin_tag(); tag < Syntax_Tags::kw_end_tag();
+       ++tag)
+    keys[n++] = Keyword{Syntax_Tags::builtin_label(tag), 0, tag, tag,
+                        Syntax_Tags::BAD, 0};
+  for (Smashed const &r : smashed_keywords)
+    keys[n++] = Keyword{r.name, 0, Syntax_Tags::TK_NAME, r.tok1, r.tok2,
+                        r.splitpos};
+
+  int bucket_size[Table::num_buckets]{};
+  int max_bucket_size = 0;
+  for (int k = 0; k < num_keys; ++k) {
+    keys[k].length = keyword_length(keys[k].name);
+    if (keys[k].length > Table::max_length)
+      return t;
+    hashes[k] = keyword_hash(keys[k].name, keys[k].length);
+    int const b = Table::bucket(hashes[k]);
+    bucket_size[b] += 1;
+    if (bucket_size[b] > max_bucket_size)
+      max_bucket_size = bucket_size[b];
+  }
+
+  /* Place the crowded buckets first, while there is the most room */
+  for (int size = max_bucket_size; size > 0; --size) {
+    for (int b = 0; b < Table::num_buckets; ++b) {
+      if (bucket_size[b] != size)
+        continue;
+      bool placed = false;
+      for (std::uint32_t d = 1; !placed && d < 100000; ++d) {
+        int taken[num_keys]{};
+        int num_taken = 0;
+        bool fits = true;
+        for (int k = 0; fits && k < num_keys; ++k) {
+          if (Table::bucket(hashes[k]) != b)
+            continue;
+          int const s = Table::slot(hashes[k], d);
+          fits = (t.slots[s].name == nullptr);
+          for (int j = 0; fits && j < num_taken; ++j)
+            fits = (taken[j] != s);
+          taken[num_taken++] = s;
+        }
+        if (!fits)
+          continue;
+        for (int k = 0; k < num_keys; ++k)
+          if (Table::bucket(hashes[k]) == b)
+            t.slots[Table::slot(hashes[k], d)] = keys[k];
+        t.disp[b] = d;
+        placed = true;
+      }
+      if (!placed)
+        return t;
+    }
+  }
+  t.ok = true;
+  return t;
+}
+
+inline constexpr Keyword_Hash_Table keyword_hash_table{
+    build_keyword_hash_table()};
+static_assert(keyword_hash_table.ok,
+              "Keyword_Hash: unable to build a perfect hash of the keywords");
+
+//! Case-insensitive lookup of keywords and smashed keyword pairs
+class Keyword_Hash {
+public:
+  //! Return the Keyword spelled by str[0, len), or nullptr
+  /*! str must be a name: the letters, digits and underscores of a TK_NAME */
+  static Keyword const *in_word_set(char const *const str,
+                                    std::size_t const len) noexcept {
+    using Table = Keyword_Hash_Table;
+    if (len > Table::max_length)
+      return nullptr;
+    std::uint32_t const h = keyword_hash(str, len);
+    Keyword const &k{keyword_hash_table.slots[Table::slot(
+        h, keyword_hash_table.disp[Table::bucket(h)])]};
+    if (static_cast<std::size_t>(k.length) != len)
+      return nullptr;
+    for (std::size_t i = 0; i < len; ++i)
+      if (keyword_fold(str[i]) != keyword_fold(k.name[i]))
+        return nullptr;
+    return &k;
+  }
+};
+
+} // namespace details_
+} // namespace FLPR
+
+#endif
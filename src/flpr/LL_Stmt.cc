@@ -13,7 +13,11 @@
 */
 
 #include "flpr/LL_Stmt.hh"
+#include "flpr/Arena.hh"
+#include "flpr/Stmt_Memo.hh"
+#include "flpr/Stmt_Tree_Budget.hh"
 #include "flpr/parse_stmt.hh"
+#include <algorithm>
 #include <ostream>
 
 #define DEBUG_PRINT 0
@@ -24,6 +28,39 @@
 
 namespace FLPR {
 
+LL_Stmt::LL_Stmt(LL_Stmt &&src) noexcept
+    : LL_TT_Range(std::move(src)), prefix_lines{std::move(src.prefix_lines)},
+      label_{src.label_}, compound_{src.compound_}, hook_{src.hook_},
+      stmt_tree_{std::move(src.stmt_tree_)}, stmt_syntag_{src.stmt_syntag_},
+      tree_parser_{src.tree_parser_}, rejected_by_{std::move(src.rejected_by_)},
+      prefetched_{std::move(src.prefetched_)},
+      prefetch_kinds_{std::move(src.prefetch_kinds_)},
+      toks_{std::move(src.toks_)}, toks_ok_{src.toks_ok_},
+      lead_tag_{src.lead_tag_}, tree_budget_{src.tree_budget_} {
+  /* A Tree_Pin would be left pointing at src */
+  assert(src.tree_pins_ == 0);
+  if (tree_budget_) {
+    tree_budget_->forget(src);
+    src.tree_budget_ = nullptr;
+    if (!stmt_tree_.empty())
+      budget_note_();
+  }
+}
+
+void LL_Stmt::set_tree_budget(Stmt_Tree_Budget *const budget) {
+  if (budget == tree_budget_)
+    return;
+  if (tree_budget_)
+    budget_forget_();
+  tree_budget_ = budget;
+  if (tree_budget_ && !stmt_tree_.empty())
+    budget_note_();
+}
+
+void LL_Stmt::budget_note_() const { tree_budget_->note_use(*this); }
+
+void LL_Stmt::budget_forget_() const noexcept { tree_budget_->forget(*this); }
+
 bool LL_Stmt::set_leading_spaces(int const spaces, int const continued_offset) {
   assert(spaces >= 0);
   bool changed = false;
@@ -65,7 +102,12 @@ bool LL_Stmt::rebuild_tree_() const {
 #endif
     return false;
   }
+  /* A budgeted tree comes from the heap, so that dropping it frees memory */
+  Arena::Scope tree_scope{tree_budget_ ? nullptr : Arena::current()};
   TT_Stream tts{*const_cast<LL_Stmt *>(this)};
+  Stmt::Stmt_Memo memo;
+  if (Stmt::Stmt_Memo::enabled())
+    tts.set_memo(&memo);
   if (Stmt::is_action_stmt(stmt_syntag_)) {
     stmt_tree_ = Stmt::parse_stmt_dispatch(Syntax_Tags::SG_ACTION_STMT, tts);
   } else {
@@ -81,6 +123,147 @@ bool LL_Stmt::rebuild_tree_() const {
   return !stmt_tree_.empty();
 }
 
+bool LL_Stmt::parse_with(parser_function const f) {
+  if (tree_parser_ == f && !stmt_tree_.empty())
+    return true;
+  for (parser_function const r : rejected_by_)
+    if (r == f)
+      return false;
+  if (!Stmt::may_lead(f, lead_tag())) {
+    rejected_by_.push_back(f);
+    return false;
+  }
+  auto const pre = std::find_if(
+      prefetched_.begin(), prefetched_.end(),
+      [f](Prefetched const &p) { return p.parser == f; });
+  if (pre != prefetched_.end()) {
+    if (token_kinds_() == prefetch_kinds_) {
+      Prefetched p{std::move(*pre)};
+      prefetched_.erase(pre);
+      bool const changed{!p.kinds.empty()};
+      if (changed) {
+        set_token_kinds_(p.kinds);
+        tokens_changed_();
+      }
+      if (!p.tree) {
+        if (!changed)
+          rejected_by_.push_back(f);
+        return false;
+      }
+      clear_tree_();
+      stmt_tree_ = std::move(p.tree);
+      extract_tree_tag_();
+      if (!changed)
+        tree_parser_ = f;
+      if (tree_budget_)
+        budget_note_();
+      return true;
+    }
+    /* An earlier parser unkeyworded some tokens, and that can't be undone,
+       so none of the prefetched outcomes apply any more */
+    drop_prefetched_();
+  }
+  Arena::Scope tree_scope{tree_budget_ ? nullptr : Arena::current()};
+  TT_Stream tts{*this, token_array_()};
+  Stmt::Stmt_Memo memo;
+  if (Stmt::Stmt_Memo::enabled())
+    tts.set_memo(&memo);
+  Stmt_Tree st = f(tts);
+  bool const changed{tts.unkeyworded() > 0};
+  if (changed)
+    tokens_changed_();
+  if (!st) {
+    if (!changed)
+      rejected_by_.push_back(f);
+    return false;
+  }
+  clear_tree_();
+  stmt_tree_ = std::move(st);
+  extract_tree_tag_();
+  if (!changed)
+    tree_parser_ = f;
+  if (tree_budget_)
+    budget_note_();
+  return true;
+}
+
+/* Some keywords became names, so the outcomes recorded for the old token
+   kinds no longer hold: a parser that failed might match now, and the lead
+   token may have become a name.  The parser that made the change isn't
+   recorded either, as running it again on the new kinds may differ. */
+void LL_Stmt::tokens_changed_() {
+  tree_parser_ = nullptr;
+  rejected_by_.clear();
+  drop_prefetched_();
+  lead_tag_ = find_lead_tag_();
+}
+
+void LL_Stmt::prefetch_parses(std::vector<parser_function> const &parsers) {
+  drop_prefetched_();
+  prefetch_kinds_ = token_kinds_();
+  /* The trees come from the heap, so that any that aren't used give their
+     memory back */
+  Arena::Scope tree_scope{nullptr};
+  for (parser_function const f : parsers) {
+    if (!Stmt::may_lead(f, lead_tag()) || f == tree_parser_ ||
+        std::find(rejected_by_.begin(), rejected_by_.end(), f) !=
+            rejected_by_.end())
+      continue;
+    TT_Stream tts{*this, token_array_()};
+    Stmt::Stmt_Memo memo;
+    if (Stmt::Stmt_Memo::enabled())
+      tts.set_memo(&memo);
+    Prefetched p{f, f(tts), {}};
+    std::vector<int> kinds{token_kinds_()};
+    if (kinds != prefetch_kinds_) {
+      p.kinds = std::move(kinds);
+      set_token_kinds_(prefetch_kinds_);
+    }
+    prefetched_.push_back(std::move(p));
+  }
+}
+
+std::vector<int> LL_Stmt::token_kinds_() const {
+  std::vector<int> kinds;
+  for (auto tt = begin(); tt != end(); ++tt)
+    kinds.push_back(tt->token);
+  return kinds;
+}
+
+void LL_Stmt::set_token_kinds_(std::vector<int> const &kinds) {
+  auto k = kinds.begin();
+  for (auto tt = begin(); tt != end(); ++tt, ++k)
+    tt->token = *k;
+  if (toks_ok_)
+    toks_.refresh();
+}
+
+TT_Array &LL_Stmt::token_array_() {
+  if (!toks_ok_) {
+    toks_ = TT_Array{*this};
+    toks_ok_ = true;
+  }
+  return toks_;
+}
+
+void LL_Stmt::preclassify() {
+  lead_tag_ = find_lead_tag_();
+  clear_parse_cache_();
+}
+
+/* Skip over a "construct-name :" prefix, which is the only way that a
+   statement can start with a name followed by a colon */
+int LL_Stmt::find_lead_tag_() const {
+  if (empty())
+    return Syntax_Tags::BAD;
+  auto it = cbegin();
+  int const first = it->token;
+  if (size() > 2 && Syntax_Tags::is_name(first) &&
+      Syntax_Tags::TK_COLON == std::next(it)->token)
+    return std::next(it, 2)->token;
+  return first;
+}
+
 std::ostream &LL_Stmt::print_me(std::ostream &os,
                                 bool const print_prefix) const {
   if (empty())
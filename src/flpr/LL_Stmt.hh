@@ -18,13 +18,23 @@
 #include "flpr/LL_TT_Range.hh"
 #include "flpr/Safe_List.hh"
 #include "flpr/Stmt_Tree.hh"
+#include "flpr/TT_Array.hh"
 #include <ostream>
+#include <vector>
 
 namespace FLPR {
+class Parse_Cache;
+class Stmt_Tree_Budget;
+class TT_Stream;
+
 //! Identify a LL_TT_Range that describes a Fortran statement
 class LL_Stmt : public LL_TT_Range {
 public:
+  friend class Parse_Cache;
+  friend class Stmt_Tree_Budget;
   using Stmt_Tree = FLPR::Stmt::Stmt_Tree;
+  //! The signature of the statement parsers in parse_stmt.hh
+  using parser_function = Stmt_Tree (*)(TT_Stream &ts);
 
 public:
   LL_Stmt()
@@ -33,12 +43,21 @@ public:
   LL_Stmt(LL_IT line_ref, TT_Range r, int label, int compound)
       : LL_TT_Range(line_ref, r), label_{label}, compound_{compound},
         hook_{nullptr}, stmt_syntag_{Syntax_Tags::UNKNOWN} {}
+  //! The new statement is attached to the Stmt_Tree_Budget of src, if any
+  LL_Stmt(LL_Stmt &&src) noexcept;
+  LL_Stmt &operator=(LL_Stmt &&) = delete;
+  LL_Stmt &operator=(LL_Stmt const &) = delete;
+  ~LL_Stmt() {
+    if (tree_budget_)
+      budget_forget_();
+  }
 
   void update_range(LL_Stmt &&src) {
     LL_TT_Range::operator=(src);
     compound_ = src.compound_;
     label_ = src.label_;
-    stmt_tree_.clear(); // It is bad at this point
+    clear_tree_(); // It is bad at this point
+    preclassify();
   }
 
   constexpr bool has_label() const { return label_ > 0; }
@@ -72,37 +91,145 @@ public:
   bool set_leading_spaces(int const spaces, int const continued_offset);
   int get_leading_spaces() const noexcept { return ll().get_leading_spaces(); }
 
-  Stmt_Tree const &stmt_tree() const noexcept {
+  //! Return the Stmt_Tree, rebuilding it from the syntag if need be
+  /*! If the statement is attached to a Stmt_Tree_Budget, the reference is
+      only good until stmt_tree() is called on another statement, unless
+      the tree is pinned (see pinned_tree()).  Either way, building the tree
+      allocates. */
+  Stmt_Tree const &stmt_tree() const {
     if (stmt_tree_.empty()) {
       bool res = rebuild_tree_();
       assert(res);
     }
+    if (tree_budget_)
+      budget_note_();
     return stmt_tree_;
   }
-  Stmt_Tree &stmt_tree() noexcept {
+  Stmt_Tree &stmt_tree() {
     if (stmt_tree_.empty()) {
       bool res = rebuild_tree_();
       assert(res);
     }
+    if (tree_budget_)
+      budget_note_();
     return stmt_tree_;
   }
+
+  //! A handle that keeps a Stmt_Tree_Budget from dropping a statement tree
+  /*! While a Tree_Pin is held, the tree that it refers to stays put, however
+      many other trees are used.  Editing the statement still replaces its
+      tree, so get the tree through the pin rather than holding on to a
+      reference. */
+  class Tree_Pin {
+  public:
+    explicit Tree_Pin(LL_Stmt const &stmt) : stmt_{&stmt} {
+      stmt.tree_pins_ += 1;
+    }
+    Tree_Pin(Tree_Pin &&src) noexcept : stmt_{src.stmt_} {
+      src.stmt_ = nullptr;
+    }
+    Tree_Pin(Tree_Pin const &) = delete;
+    Tree_Pin &operator=(Tree_Pin const &) = delete;
+    Tree_Pin &operator=(Tree_Pin &&) = delete;
+    ~Tree_Pin() {
+      if (stmt_)
+        stmt_->tree_pins_ -= 1;
+    }
+    Stmt_Tree const &operator*() const { return stmt_->stmt_tree(); }
+    Stmt_Tree const *operator->() const { return &stmt_->stmt_tree(); }
+
+  private:
+    LL_Stmt const *stmt_;
+  };
+  //! Build the Stmt_Tree if need be, and pin it
+  Tree_Pin pinned_tree() const {
+    Tree_Pin pin{*this};
+    stmt_tree();
+    return pin;
+  }
+  //! True if a Tree_Pin is held on this statement
+  constexpr bool tree_pinned() const noexcept { return tree_pins_ > 0; }
+  //! True if the Stmt_Tree is built (i.e. stmt_tree() won't rebuild it)
+  bool has_stmt_tree() const noexcept { return !stmt_tree_.empty(); }
   void set_stmt_tree(Stmt_Tree &&stmt_tree) {
+    clear_tree_();
     stmt_tree_ = std::move(stmt_tree);
     extract_tree_tag_();
+    clear_parse_cache_();
+    if (tree_budget_ && !stmt_tree_.empty())
+      budget_note_();
+  }
+  void drop_stmt_tree() {
+    clear_tree_();
+    clear_parse_cache_();
   }
-  void drop_stmt_tree() { stmt_tree_.clear(); }
   void reset_stmt_tree() {
-    stmt_tree_.clear();
+    clear_tree_();
     extract_tree_tag_();
+    clear_parse_cache_();
   }
   void set_stmt_syntag(int syntag) {
     /* This overrules anything in the tree */
     if (syntag != stmt_syntag_) {
-      stmt_tree_.clear();
+      clear_tree_();
+      clear_parse_cache_();
     }
     stmt_syntag_ = syntag;
   }
 
+  //! Limit the memory held in Stmt_Trees (nullptr to detach)
+  /*! See Stmt_Tree_Budget.  Any tree that the statement has is kept, and
+      counted against the new budget. */
+  void set_tree_budget(Stmt_Tree_Budget *budget);
+  constexpr Stmt_Tree_Budget *tree_budget() const noexcept {
+    return tree_budget_;
+  }
+
+  //! Try to parse this statement with f, reusing earlier attempts
+  /*!
+    Returns true, with the result in stmt_tree(), if f matches this statement.
+    The program parsers try the same statement with the same parser many
+    times as they backtrack, so the outcome of each parser is remembered
+    until the statement or its tree is changed, or a parser turns some of
+    its keywords into names (TT_Stream::unkeyword()).  Parsers that can't
+    start with lead_tag() are rejected without looking at the rest of the
+    tokens.
+  */
+  bool parse_with(parser_function const f);
+
+  //! Run each of parsers that may lead this statement, for parse_with()
+  /*!
+    The outcomes are kept until parse_with() asks for them, so this can do
+    the work of the program parsers ahead of time.  Each parser starts from
+    the token kinds the statement has now, and any TT_Stream::unkeyword()
+    it does is undone before the next parser runs.  parse_with(f) only uses
+    the outcome of f if the token kinds still match the ones the prefetch
+    started from, and then it applies the kinds that f left behind, so the
+    statement ends up as if f had run in order.  This doesn't touch the
+    Stmt_Tree_Budget, and the trees come from the heap, so it is safe to
+    call concurrently on different statements.
+  */
+  void prefetch_parses(std::vector<parser_function> const &parsers);
+  //! Release what parse_with() keeps to speed up the next call
+  /*! That is the TT_Array of the tokens that its streams share, and any
+      prefetch_parses() outcomes that weren't asked for.  Which parsers
+      matched is still remembered. */
+  void end_parses() {
+    drop_prefetched_();
+    drop_token_array_();
+  }
+
+  //! Cheap classification of the statement, done before parsing
+  /*! This records the lead_tag() and forgets any parse_with() results */
+  void preclassify();
+
+  //! The first token of the statement, ignoring any construct-name
+  int lead_tag() const {
+    if (Syntax_Tags::UNKNOWN == lead_tag_)
+      lead_tag_ = find_lead_tag_();
+    return lead_tag_;
+  }
+
   //! Produce a meaningful tag for statements, BAD otherwise
   int stmt_tag(bool look_inside_if_stmt) const;
 
@@ -148,6 +275,31 @@ private:
   mutable Stmt_Tree stmt_tree_;
   mutable int stmt_syntag_;
 
+  /* The parse_with() cache: the parser that produced stmt_tree_ (if any),
+     and the parsers that have failed on this statement */
+  parser_function tree_parser_{nullptr};
+  std::vector<parser_function> rejected_by_;
+  //! An outcome of prefetch_parses()
+  struct Prefetched {
+    parser_function parser;
+    //! Empty if parser failed
+    Stmt_Tree tree;
+    //! The token kinds that parser left behind (empty if unchanged)
+    std::vector<int> kinds;
+  };
+  std::vector<Prefetched> prefetched_;
+  //! The token kinds that each of prefetched_ started from
+  std::vector<int> prefetch_kinds_;
+  //! The tokens for the parse_with() streams, built when first needed
+  TT_Array toks_;
+  bool toks_ok_{false};
+  mutable int lead_tag_{Syntax_Tags::UNKNOWN};
+
+  //! The budget that stmt_tree_ is counted against, if any
+  Stmt_Tree_Budget *tree_budget_{nullptr};
+  //! The number of Tree_Pins held on this statement
+  mutable int tree_pins_{0};
+
 private:
   void extract_tree_tag_() const {
     if (stmt_tree_.empty())
@@ -160,6 +312,32 @@ private:
     }
   }
   bool rebuild_tree_() const;
+  int find_lead_tag_() const;
+  void clear_tree_() {
+    if (tree_budget_)
+      budget_forget_();
+    stmt_tree_.clear();
+  }
+  void budget_note_() const;
+  void budget_forget_() const noexcept;
+  void clear_parse_cache_() {
+    tree_parser_ = nullptr;
+    rejected_by_.clear();
+    drop_prefetched_();
+    drop_token_array_();
+  }
+  void drop_prefetched_() noexcept {
+    prefetched_.clear();
+    prefetch_kinds_.clear();
+  }
+  void drop_token_array_() {
+    toks_ = TT_Array{};
+    toks_ok_ = false;
+  }
+  TT_Array &token_array_();
+  void tokens_changed_();
+  std::vector<int> token_kinds_() const;
+  void set_token_kinds_(std::vector<int> const &kinds);
 };
 
 //! Container for a sequence of LL_Stmts
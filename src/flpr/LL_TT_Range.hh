@@ -19,9 +19,12 @@
 #include "flpr/Token_Text.hh"
 
 namespace FLPR {
+class Parse_Cache;
+
 //! Identify a range of elements in the fragments of a particular Logical_Line
 class LL_TT_Range : public TT_Range {
 public:
+  friend class Parse_Cache;
   using LL_IT = LL_List::iterator;
 
   LL_TT_Range() : TT_Range(), ll_set_{false} {}
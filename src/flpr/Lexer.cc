@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Lexer.cc
+*/
+
+#include "flpr/Lexer.hh"
+
+#if FLPR_HAND_LEXER
+
+#include "flpr/Hand_Lexer.hh"
+
+namespace FLPR {
+
+Lexer::Lexer() : scanner_{new Hand_Lexer}, buffer_{nullptr} {}
+
+Lexer::~Lexer() { delete static_cast<Hand_Lexer *>(scanner_); }
+
+void Lexer::set_input(std::string const &text) {
+  static_cast<Hand_Lexer *>(scanner_)->set_input(text);
+}
+
+int Lexer::next() { return static_cast<Hand_Lexer *>(scanner_)->next(); }
+
+char const *Lexer::text() const {
+  return static_cast<Hand_Lexer const *>(scanner_)->text();
+}
+
+int Lexer::length() const {
+  return static_cast<Hand_Lexer const *>(scanner_)->length();
+}
+
+int Lexer::position() const {
+  return static_cast<Hand_Lexer const *>(scanner_)->position();
+}
+
+#else
+
+#include <cassert>
+#include <stdexcept>
+
+#include "scan_fort.hh"
+
+namespace FLPR {
+
+Lexer::Lexer() : scanner_{nullptr}, buffer_{nullptr} {
+  yyscan_t scanner;
+  if (yylex_init_extra(0, &scanner) != 0)
+    throw std::runtime_error("FLPR::Lexer: unable to initialize scanner");
+  scanner_ = scanner;
+}
+
+Lexer::~Lexer() {
+  yyscan_t scanner = static_cast<yyscan_t>(scanner_);
+  if (buffer_)
+    yy_delete_buffer(static_cast<YY_BUFFER_STATE>(buffer_), scanner);
+  yylex_destroy(scanner);
+}
+
+void Lexer::set_input(std::string const &text) {
+  yyscan_t scanner = static_cast<yyscan_t>(scanner_);
+  if (buffer_)
+    yy_delete_buffer(static_cast<YY_BUFFER_STATE>(buffer_), scanner);
+  buffer_ = yy_scan_string(text.c_str(), scanner);
+  yyset_extra(0, scanner);
+}
+
+int Lexer::next() {
+  assert(buffer_);
+  return yylex(static_cast<yyscan_t>(scanner_));
+}
+
+char const *Lexer::text() const {
+  return yyget_text(static_cast<yyscan_t>(scanner_));
+}
+
+int Lexer::length() const {
+  return yyget_leng(static_cast<yyscan_t>(scanner_));
+}
+
+int Lexer::position() const {
+  return yyget_extra(static_cast<yyscan_t>(scanner_));
+}
+
+#endif
+
+bool Lexer::is_flex() noexcept {
+#if FLPR_HAND_LEXER
+  return false;
+#else
+  return true;
+#endif
+}
+
+Lexer &Lexer::thread_instance() {
+  thread_local Lexer lexer;
+  return lexer;
+}
+
+} // namespace FLPR
@@ -0,0 +1,74 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Lexer.hh
+*/
+
+#ifndef FLPR_LEXER_HH
+#define FLPR_LEXER_HH 1
+
+#include <string>
+
+namespace FLPR {
+
+//! A reentrant interface to the Fortran lexical analyzer
+/*!
+  Each Lexer owns an independent scanner context, so any number of them may be
+  used concurrently (one per thread).  A Lexer is reused by calling
+  set_input() for each new string, then next() until it returns
+  Syntax_Tags::EOL.  The input string must outlive the scan.
+
+  Code that doesn't want to manage a Lexer can use thread_instance(), which
+  returns a Lexer private to the calling thread.
+
+  The scanner is the flex one generated from scan_fort.l, or Hand_Lexer when
+  FLPR is configured with FLPR_HAND_LEXER=ON.  They give the same tokens.
+*/
+class Lexer {
+public:
+  Lexer();
+  ~Lexer();
+  Lexer(Lexer const &) = delete;
+  Lexer(Lexer &&) = delete;
+  Lexer &operator=(Lexer const &) = delete;
+  Lexer &operator=(Lexer &&) = delete;
+
+  //! Start scanning a new string, resetting the position to zero
+  void set_input(std::string const &text);
+
+  //! Return the next token, or Syntax_Tags::EOL at the end of the input
+  int next();
+
+  //! The lexeme of the last token returned by next()
+  /*! This is length() characters, and isn't necessarily null-terminated */
+  char const *text() const;
+
+  //! The number of characters in text()
+  int length() const;
+
+  //! The offset into the input of the character following the last token
+  int position() const;
+
+  //! Return a Lexer that belongs to the calling thread
+  static Lexer &thread_instance();
+
+  //! True if the scanner is the flex one, false if it is Hand_Lexer
+  static bool is_flex() noexcept;
+
+private:
+  //! The flex yyscan_t reentrant scanner handle (or the Hand_Lexer)
+  void *scanner_;
+  //! The flex YY_BUFFER_STATE for the current input (or nullptr)
+  void *buffer_;
+};
+
+} // namespace FLPR
+#endif
@@ -13,6 +13,7 @@
 */
 
 #include "flpr/Line_Accum.hh"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <ostream>
@@ -20,7 +21,7 @@
 namespace FLPR {
 void Line_Accum::add_line(int const file_lineno, int const num_left_spaces,
                           int const main_text_file_colno,
-                          std::string const &main_text,
+                          std::string_view main_text,
                           int const num_right_spaces) {
   /* main_text starts at lli_to_accum_offset_[i], and relates to file line
      numbers lli_to_file_line_num_[i], and column number
@@ -38,41 +39,48 @@ void Line_Accum::add_line(int const file_lineno, int const num_left_spaces,
 }
 
 bool Line_Accum::linecolno(int accum_offset, int &lineno, int &colno) const {
-  if (lli_to_accum_offset_.empty())
-    return false;
-
-  /* find the LLI */
-  size_t const N = lli_to_accum_offset_.size();
-  size_t lli{0};
-  while (lli + 1 < N && lli_to_accum_offset_[lli + 1] <= accum_offset) {
-    lli += 1;
-  }
-
-  assert(lli < lli_to_accum_offset_.size());
-  assert(lli_to_accum_offset_[lli] <= accum_offset);
-
-  /* adjust to be the offset within the main_text for this LLI */
-  accum_offset -= lli_to_accum_offset_[lli];
-  lineno = lli_to_file_line_num_[lli];
-  colno = lli_to_file_column_num_[lli] + accum_offset;
-
-  assert(colno > 0);
-
-  return true;
+  int txt_lineno, txt_colno;
+  return linecolno(accum_offset, lineno, colno, txt_lineno, txt_colno);
 }
 
 bool Line_Accum::linecolno(int accum_offset, int &lineno, int &colno,
                            int &txt_lineno, int &txt_colno) const {
   if (lli_to_accum_offset_.empty())
     return false;
+  convert_(find_lli_(accum_offset, lli_to_accum_offset_.size()),
+           accum_offset, lineno, colno, txt_lineno, txt_colno);
+  return true;
+}
 
-  /* find the LLI */
+bool Line_Accum::Cursor::linecolno(int accum_offset, int &lineno, int &colno,
+                                   int &txt_lineno, int &txt_colno) {
+  if (la_->lli_to_accum_offset_.empty())
+    return false;
+  lli_ = la_->find_lli_(accum_offset, lli_);
+  la_->convert_(lli_, accum_offset, lineno, colno, txt_lineno, txt_colno);
+  return true;
+}
+
+/* Return the last LLI that starts at or before accum_offset.  If hint is
+   such an LLI, step forward from it, otherwise do a binary search. */
+size_t Line_Accum::find_lli_(int const accum_offset,
+                             size_t const hint) const {
   size_t const N = lli_to_accum_offset_.size();
-  size_t lli{0};
-  while (lli + 1 < N && lli_to_accum_offset_[lli + 1] <= accum_offset) {
-    lli += 1;
+  if (hint < N && lli_to_accum_offset_[hint] <= accum_offset) {
+    size_t lli{hint};
+    while (lli + 1 < N && lli_to_accum_offset_[lli + 1] <= accum_offset)
+      lli += 1;
+    return lli;
   }
+  auto const next = std::upper_bound(lli_to_accum_offset_.begin(),
+                                     lli_to_accum_offset_.end(), accum_offset);
+  if (next == lli_to_accum_offset_.begin())
+    return 0;
+  return std::distance(lli_to_accum_offset_.begin(), next) - 1;
+}
 
+void Line_Accum::convert_(size_t const lli, int accum_offset, int &lineno,
+                          int &colno, int &txt_lineno, int &txt_colno) const {
   assert(lli < lli_to_accum_offset_.size());
   assert(lli_to_accum_offset_[lli] <= accum_offset);
 
@@ -87,8 +95,6 @@ bool Line_Accum::linecolno(int accum_offset, int &lineno, int &colno,
   assert(txt_lineno >= 0);
   assert(txt_lineno < static_cast<int>(lli_to_file_line_num_.size()));
   assert(txt_colno >= 0);
-
-  return true;
 }
 
 std::ostream &Line_Accum::print(std::ostream &os) const {
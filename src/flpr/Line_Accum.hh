@@ -17,6 +17,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace FLPR {
@@ -30,7 +31,7 @@ class Line_Accum {
 public:
   //! Add a main_text string to the accumulator.
   void add_line(int const file_lineno, int const num_left_spaces,
-                int const main_text_file_colno, std::string const &main_text,
+                int const main_text_file_colno, std::string_view main_text,
                 int const num_right_spaces);
 
   //! Return the file line and column
@@ -52,6 +53,25 @@ public:
   bool linecolno(int accum_offset, int &lineno, int &colno, int &txt_lineno,
                  int &txt_colno) const;
 
+  //! Map a non-decreasing sequence of offsets to line and column numbers
+  /*! Line_Accum::linecolno() does a binary search over the lines for each
+      offset.  A Cursor remembers the line of the last offset, and steps
+      forward from there, so that mapping every token of a logical line is
+      linear in its length.  An offset before the last one falls back to a
+      binary search. */
+  class Cursor {
+  public:
+    explicit Cursor(Line_Accum const &la) noexcept : la_{&la} {}
+    //! As Line_Accum::linecolno()
+    bool linecolno(int accum_offset, int &lineno, int &colno, int &txt_lineno,
+                   int &txt_colno);
+
+  private:
+    Line_Accum const *la_;
+    size_t lli_{0};
+  };
+  Cursor cursor() const noexcept { return Cursor{*this}; }
+
   std::string const &accum() const { return accum_; }
   std::ostream &print(std::ostream &os) const;
 
@@ -62,6 +82,11 @@ private:
   std::vector<int> lli_to_accum_offset_;
   std::vector<int> lli_to_file_line_num_;
   std::vector<int> lli_to_file_column_num_;
+
+private:
+  size_t find_lli_(int const accum_offset, size_t const hint) const;
+  void convert_(size_t const lli, int accum_offset, int &lineno, int &colno,
+                int &txt_lineno, int &txt_colno) const;
 };
 } // namespace FLPR
 #endif
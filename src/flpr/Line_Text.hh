@@ -0,0 +1,251 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Line_Text.hh
+*/
+
+#ifndef FLPR_LINE_TEXT_HH
+#define FLPR_LINE_TEXT_HH 1
+
+#include <cassert>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace FLPR {
+
+//! A copy-on-write piece of source text
+/*!
+  A Line_Text either borrows a span of some longer-lived buffer (such as a
+  Text_Buffer), or owns a private std::string.  Reads always go through the
+  view, so a borrowed Line_Text costs no allocation.  The first modification
+  copies the text into a private string, so only text that is actually edited
+  consumes memory.  The interface is the subset of std::string used on
+  File_Line fields.
+
+  Whoever creates a borrowed Line_Text is responsible for keeping the
+  underlying buffer alive (File_Line does this by holding a reference to its
+  Text_Buffer).
+*/
+class Line_Text {
+public:
+  using size_type = std::string::size_type;
+  static constexpr size_type npos = std::string::npos;
+
+  Line_Text() noexcept = default;
+
+  //! Make an owned copy of text
+  explicit Line_Text(std::string_view text)
+      : own_{text}, owned_{true}, view_{own_} {}
+
+  //! Make an owned copy of text
+  explicit Line_Text(std::string const &text)
+      : Line_Text(std::string_view{text}) {}
+
+  //! Make a Line_Text that refers to text without copying it
+  static Line_Text borrow(std::string_view text) noexcept {
+    Line_Text result;
+    result.view_ = text;
+    return result;
+  }
+
+  /* The view has to be re-pointed whenever own_ is copied or moved, as a
+     short string lives inside the std::string object itself */
+  Line_Text(Line_Text const &src)
+      : own_{src.own_}, owned_{src.owned_},
+        view_{owned_ ? std::string_view{own_} : src.view_} {}
+  Line_Text(Line_Text &&src) noexcept
+      : own_{std::move(src.own_)}, owned_{src.owned_},
+        view_{owned_ ? std::string_view{own_} : src.view_} {
+    src.release_();
+  }
+  Line_Text &operator=(Line_Text const &src) {
+    if (this != &src) {
+      if (src.owned_) {
+        assign(src.view_);
+      } else {
+        release_();
+        view_ = src.view_;
+      }
+    }
+    return *this;
+  }
+  Line_Text &operator=(Line_Text &&src) noexcept {
+    if (this != &src) {
+      own_ = std::move(src.own_);
+      owned_ = src.owned_;
+      view_ = owned_ ? std::string_view{own_} : src.view_;
+      src.release_();
+    }
+    return *this;
+  }
+
+  Line_Text &operator=(std::string_view text) { return assign(text); }
+  Line_Text &operator=(std::string const &text) { return assign(text); }
+  Line_Text &operator=(char const *text) { return assign(text); }
+  Line_Text &operator=(char const c) { return assign(1, c); }
+
+  //! True if this refers to text owned by someone else
+  bool is_borrowed() const noexcept { return !owned_ && !view_.empty(); }
+
+  //! Read-only access to the text
+  constexpr std::string_view view() const noexcept { return view_; }
+  operator std::string() const { return std::string{view_}; }
+
+  /* ------------------------- read-only interface ------------------------ */
+  constexpr size_type size() const noexcept { return view_.size(); }
+  constexpr size_type length() const noexcept { return view_.size(); }
+  constexpr bool empty() const noexcept { return view_.empty(); }
+  constexpr char const &operator[](size_type pos) const noexcept {
+    return view_[pos];
+  }
+  constexpr char front() const noexcept { return view_.front(); }
+  constexpr char back() const noexcept { return view_.back(); }
+  constexpr char const *data() const noexcept { return view_.data(); }
+  constexpr auto begin() const noexcept { return view_.begin(); }
+  constexpr auto end() const noexcept { return view_.end(); }
+  size_type find(char const c, size_type pos = 0) const noexcept {
+    return view_.find(c, pos);
+  }
+  size_type find(std::string_view s, size_type pos = 0) const noexcept {
+    return view_.find(s, pos);
+  }
+  size_type find_first_of(std::string_view s, size_type pos = 0) const
+      noexcept {
+    return view_.find_first_of(s, pos);
+  }
+  size_type find_first_not_of(char const c, size_type pos = 0) const noexcept {
+    return view_.find_first_not_of(c, pos);
+  }
+  size_type find_first_not_of(std::string_view s, size_type pos = 0) const
+      noexcept {
+    return view_.find_first_not_of(s, pos);
+  }
+  size_type find_last_not_of(char const c, size_type pos = npos) const
+      noexcept {
+    return view_.find_last_not_of(c, pos);
+  }
+  size_type find_last_not_of(std::string_view s, size_type pos = npos) const
+      noexcept {
+    return view_.find_last_not_of(s, pos);
+  }
+  std::string substr(size_type pos = 0, size_type count = npos) const {
+    return std::string{view_.substr(pos, count)};
+  }
+
+  /* ------------------------- modifying interface ------------------------ */
+  //! Writable access to a character (makes a private copy)
+  char &operator[](size_type pos) {
+    own_text_();
+    return own_[pos];
+  }
+  void clear() noexcept {
+    own_.clear();
+    view_ = std::string_view{};
+  }
+  Line_Text &assign(std::string_view s) {
+    own_.assign(s.data(), s.size());
+    owned_ = true;
+    return sync_();
+  }
+  Line_Text &assign(size_type count, char const c) {
+    own_.assign(count, c);
+    owned_ = true;
+    return sync_();
+  }
+  Line_Text &append(std::string_view s) {
+    own_text_();
+    own_.append(s.data(), s.size());
+    return sync_();
+  }
+  Line_Text &append(size_type count, char const c) {
+    own_text_();
+    own_.append(count, c);
+    return sync_();
+  }
+  Line_Text &operator+=(std::string_view s) { return append(s); }
+  Line_Text &operator+=(char const c) { return append(1, c); }
+  Line_Text &insert(size_type pos, std::string_view s) {
+    own_text_();
+    own_.insert(pos, s.data(), s.size());
+    return sync_();
+  }
+  Line_Text &insert(size_type pos, size_type count, char const c) {
+    own_text_();
+    own_.insert(pos, count, c);
+    return sync_();
+  }
+  Line_Text &erase(size_type pos = 0, size_type count = npos) {
+    own_text_();
+    own_.erase(pos, count);
+    return sync_();
+  }
+  Line_Text &replace(size_type pos, size_type count, std::string_view s) {
+    own_text_();
+    own_.replace(pos, count, s.data(), s.size());
+    return sync_();
+  }
+
+  friend bool operator==(Line_Text const &a, Line_Text const &b) noexcept {
+    return a.view_ == b.view_;
+  }
+  friend bool operator!=(Line_Text const &a, Line_Text const &b) noexcept {
+    return a.view_ != b.view_;
+  }
+  friend bool operator==(Line_Text const &a, std::string_view b) noexcept {
+    return a.view_ == b;
+  }
+  friend bool operator==(std::string_view a, Line_Text const &b) noexcept {
+    return a == b.view_;
+  }
+  friend bool operator!=(Line_Text const &a, std::string_view b) noexcept {
+    return a.view_ != b;
+  }
+  friend bool operator!=(std::string_view a, Line_Text const &b) noexcept {
+    return a != b.view_;
+  }
+
+private:
+  //! Make sure that own_ holds the text
+  void own_text_() {
+    if (!owned_) {
+      own_.assign(view_.data(), view_.size());
+      owned_ = true;
+      view_ = own_;
+    }
+  }
+  //! Point the view at the (possibly reallocated) owned text
+  Line_Text &sync_() noexcept {
+    assert(owned_);
+    view_ = own_;
+    return *this;
+  }
+  //! Go back to the default state, keeping own_'s storage
+  void release_() noexcept {
+    own_.clear();
+    owned_ = false;
+    view_ = std::string_view{};
+  }
+
+private:
+  //! The private copy of the text, if owned_
+  std::string own_;
+  bool owned_{false};
+  //! The current text, which refers into own_ if owned_
+  std::string_view view_;
+};
+
+inline std::ostream &operator<<(std::ostream &os, Line_Text const &lt) {
+  return os << lt.view();
+}
+
+} // namespace FLPR
+#endif
@@ -15,12 +15,14 @@
 #include "flpr/Logical_File.hh"
 #include "flpr/File_Line.hh"
 #include "flpr/LL_Stmt_Src.hh"
+#include "flpr/Lexer.hh"
+#include "flpr/Work_Stealing_Pool.hh"
 #include "flpr/utils.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <deque>
-#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <set>
@@ -31,77 +33,229 @@ void Logical_File::clear() {
   lines.clear();
   ll_stmts.clear();
   has_flpr_pp = false;
+  scan_failed = false;
   num_input_lines = 0;
 }
 
 bool Logical_File::read_and_scan(std::string const &filename,
                                  int const last_fixed_col,
                                  File_Type file_type) {
-  std::ifstream is(filename.c_str());
-  if (!is) {
+  auto buffer = Text_Buffer::from_file(filename);
+  if (!buffer) {
     std::cerr << "Logical_File::read_and_scan: unable to open file \""
               << filename << "\" for reading\n";
     return false;
   }
-
-  bool res = read_and_scan(is, filename, last_fixed_col, file_type);
-
-  is.close();
-  return res;
+  return scan(buffer, filename, last_fixed_col, file_type);
 }
 
 bool Logical_File::read_and_scan(std::istream &is,
                                  std::string const &stream_name,
                                  int const last_fixed_col,
                                  File_Type stream_type) {
-  Line_Buf buf;
-  buf.reserve(1024);
-  for (std::string line; std::getline(is, line);) {
-    buf.push_back(line);
+  return scan(Text_Buffer::from_stream(is), stream_name, last_fixed_col,
+              stream_type);
+}
+
+namespace {
+/* Views of a Line_Buf, used when scanning text that we don't own */
+Text_Buffer::Line_Views views_of(Logical_File::Line_Buf const &buf) {
+  return Text_Buffer::Line_Views(buf.begin(), buf.end());
+}
+
+/* Files with fewer lines than this per thread are scanned serially */
+constexpr size_t min_lines_per_task = 1024;
+
+/* The pool for a scan of num_lines lines, or nullptr to scan serially */
+std::unique_ptr<Work_Stealing_Pool> scan_pool(int const num_threads,
+                                              size_t const num_lines) {
+  size_t const workers =
+      std::min(static_cast<size_t>(std::max(num_threads, 1)),
+               num_lines / min_lines_per_task);
+  if (workers < 2)
+    return nullptr;
+  return std::make_unique<Work_Stealing_Pool>(static_cast<int>(workers));
+}
+
+/* The state that File_Line analysis carries from one line to the next */
+struct Scan_State {
+  char open_delim{'\0'};
+  bool continued{false};
+  bool in_literal_block{false};
+  bool operator==(Scan_State const &other) const {
+    return open_delim == other.open_delim && continued == other.continued &&
+           in_literal_block == other.in_literal_block;
+  }
+};
+
+/* A run of lines analyzed from a guessed entry state */
+struct Scan_Chunk {
+  size_t begin;
+  size_t end;
+  /* The end of the lines that were analyzed before an exception */
+  size_t analyzed_end;
+};
+
+/* Set fl[i] = analyze(i, state) for each line, where analyze updates state
+   for the next line.  Returns the index of the first line that fails (with
+   its exception message in error), or fl.size().
+
+   A line only depends on its predecessors through the Scan_State, which
+   nearly always returns to the default at a statement boundary.  So with
+   a pool, chunks of lines are analyzed in parallel, each assuming
+   the default entry state.  Then the chunks are stitched together in order:
+   where a guess was wrong, lines are re-analyzed serially until the state
+   after a line matches the speculative one, after which the rest of the
+   chunk is known to be right. */
+template <typename Analyze>
+size_t analyze_lines(std::vector<File_Line> &fl, Analyze const &analyze,
+                     Work_Stealing_Pool *pool, std::string &error) {
+  size_t const N = fl.size();
+  size_t const num_chunks = (pool) ? pool->num_threads() : 1;
+  Scan_State state;
+  if (num_chunks < 2) {
+    for (size_t i = 0; i < N; ++i) {
+      try {
+        fl[i] = analyze(i, state);
+      } catch (std::exception &e) {
+        error = e.what();
+        return i;
+      }
+    }
+    return N;
+  }
+
+  std::vector<Scan_State> exits(N);
+  std::vector<Scan_Chunk> chunks(num_chunks);
+  std::vector<Work_Stealing_Pool::Task> tasks;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    Scan_Chunk &chunk{chunks[c]};
+    chunk.begin = (N * c) / num_chunks;
+    chunk.end = (N * (c + 1)) / num_chunks;
+    chunk.analyzed_end = chunk.begin;
+    tasks.emplace_back([&fl, &analyze, &exits, &chunk]() {
+      Scan_State guess;
+      for (size_t i = chunk.begin; i < chunk.end; ++i) {
+        try {
+          fl[i] = analyze(i, guess);
+        } catch (std::exception &) {
+          /* Maybe a bad guess: the stitching will redo this line */
+          return;
+        }
+        exits[i] = guess;
+        chunk.analyzed_end = i + 1;
+      }
+    });
+  }
+  pool->run(std::move(tasks));
+
+  for (Scan_Chunk const &chunk : chunks) {
+    bool synced = (state == Scan_State{});
+    size_t i = chunk.begin;
+    while (i < chunk.end) {
+      if (synced && i < chunk.analyzed_end) {
+        i = chunk.analyzed_end;
+        state = exits[i - 1];
+        continue;
+      }
+      try {
+        fl[i] = analyze(i, state);
+      } catch (std::exception &e) {
+        error = e.what();
+        return i;
+      }
+      synced = (i < chunk.analyzed_end && state == exits[i]);
+      i += 1;
+    }
   }
-  return scan(buf, stream_name, last_fixed_col, stream_type);
+  return N;
 }
+} // namespace
 
 bool Logical_File::scan(Line_Buf const &buf, std::string const &buffer_name,
                         int const last_fixed_col, File_Type buffer_type) {
+  return scan_(views_of(buf), 0, nullptr, buffer_name, last_fixed_col,
+               buffer_type);
+}
+
+bool Logical_File::scan(std::shared_ptr<Text_Buffer const> const &buffer,
+                        std::string const &buffer_name,
+                        int const last_fixed_col, File_Type buffer_type) {
+  assert(buffer);
+  return scan_(buffer->lines(), 0, buffer, buffer_name, last_fixed_col,
+               buffer_type);
+}
+
+bool Logical_File::scan(std::shared_ptr<Text_Buffer const> const &buffer,
+                        Text_Buffer::Line_Views const &raw_lines,
+                        size_t const first_line, std::string const &buffer_name,
+                        int const last_fixed_col, File_Type buffer_type) {
+  assert(buffer);
+  return scan_(raw_lines, first_line, buffer, buffer_name, last_fixed_col,
+               buffer_type);
+}
+
+bool Logical_File::scan_(Text_Buffer::Line_Views const &raw_lines,
+                         size_t const first_line,
+                         std::shared_ptr<Text_Buffer const> const &source,
+                         std::string const &buffer_name,
+                         int const last_fixed_col, File_Type buffer_type) {
   file_info = std::make_shared<File_Info>(buffer_name, buffer_type);
 
   bool res = false;
   switch (file_type()) {
   case File_Type::FIXEDFMT:
     file_info->last_fixed_column = last_fixed_col;
-    res = scan_fixed(buf, last_fixed_col);
+    res = scan_fixed_(raw_lines, first_line, last_fixed_col, source);
     break;
   case File_Type::FREEFMT:
-    res = scan_free(buf);
+    res = scan_free_(raw_lines, first_line, source);
     break;
   default:
     std::cerr << "FLPR::Logical_File::scan Error: "
                  "unsupported file type with "
               << file_type() << "\n";
   };
+  scan_failed = !res;
   return res;
 }
 
 bool Logical_File::scan_fixed(Line_Buf const &raw_lines, int const last_col) {
+  scan_failed = !scan_fixed_(views_of(raw_lines), 0, last_col, nullptr);
+  return !scan_failed;
+}
+
+bool Logical_File::scan_free(Line_Buf const &raw_lines) {
+  scan_failed = !scan_free_(views_of(raw_lines), 0, nullptr);
+  return !scan_failed;
+}
+
+bool Logical_File::scan_fixed_(
+    Text_Buffer::Line_Views const &raw_lines, size_t const first_line,
+    int const last_col, std::shared_ptr<Text_Buffer const> const &source) {
   const size_t N = raw_lines.size();
   num_input_lines = N;
   // Convert the raw text input into File_Lines
   std::vector<File_Line> fl(N);
-  char prev_open_delim = '\0';
-  for (size_t i = 0; i < N; ++i) {
-    try {
-      fl[i] = File_Line::analyze_fixed((int)i + 1, raw_lines[i],
-                                       prev_open_delim, last_col);
-    } catch (std::exception &e) {
-      std::cerr << "At line " << i + 1 << " of \"" << file_info->filename
-                << "\":\n"
-                << raw_lines[i] << '\n'
-                << "scan_fixed error: " << e.what() << std::endl;
-      return false;
-    }
-    prev_open_delim = fl[i].open_delim;
+  auto const analyze = [&](size_t const i, Scan_State &state) {
+    File_Line line = File_Line::analyze_fixed((int)(first_line + i) + 1,
+                                              raw_lines[i], state.open_delim,
+                                              last_col, source);
+    state.open_delim = line.open_delim;
+    return line;
+  };
+  /* One pool analyzes the lines and then tokenizes them */
+  auto const pool = scan_pool(scan_threads_, N);
+  std::string error;
+  size_t const bad = analyze_lines(fl, analyze, pool.get(), error);
+  if (bad < N) {
+    std::cerr << "At line " << first_line + bad + 1 << " of \""
+              << file_info->filename << "\":\n"
+              << raw_lines[bad] << '\n'
+              << "scan_fixed error: " << error << std::endl;
+    return false;
   }
+  std::vector<Line_Group> groups;
 
   /* Identify "logical lines": blocks of lines that represent a
      comment/whitespace block or a single statement. */
@@ -112,8 +266,7 @@ bool Logical_File::scan_fixed(Line_Buf const &raw_lines, int const last_col) {
       curr += 1;
     if (curr > start_line) {
       // Have a trivial block [start_line..curr)
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      lines.back().file_info = file_info;
+      groups.push_back({start_line, curr, LineCat::UNKNOWN, false});
       continue;
     }
 
@@ -134,21 +287,19 @@ bool Logical_File::scan_fixed(Line_Buf const &raw_lines, int const last_col) {
 
       /* absorb any continued preprocessor lines */
       size_t start_line = curr++;
-      while (curr < N && last_non_blank_char(fl[curr - 1].left_text) == '\\') {
+      while (curr < N &&
+             last_non_blank_char(fl[curr - 1].left_text.view()) == '\\') {
         fl[curr].make_preprocessor();
         curr += 1;
       }
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      Logical_Line &ll = lines.back();
-      ll.file_info = file_info;
-      ll.cat = cat;
+      groups.push_back({start_line, curr, cat, false});
       continue;
     }
 
     if (curr < N) {
       if (!fl[curr].is_fortran()) {
-        std::cerr << "scan_fixed confused on line " << curr + 1 << "of \""
-                  << file_info->filename << "\": \n"
+        std::cerr << "scan_fixed confused on line " << first_line + curr + 1
+                  << "of \"" << file_info->filename << "\": \n"
                   << fl[curr] << '\n';
         exit(1);
       }
@@ -167,38 +318,41 @@ bool Logical_File::scan_fixed(Line_Buf const &raw_lines, int const last_col) {
       curr = last_code_line + 1;
 
       // code for this statement is now in [start_line..curr)
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      Logical_Line &ll = lines.back();
-      ll.needs_reformat = true;
-      ll.file_info = file_info;
+      groups.push_back({start_line, curr, LineCat::UNKNOWN, true});
     }
   }
 
+  make_lines_(fl, groups, pool.get());
   return true;
 }
 
-bool Logical_File::scan_free(std::vector<std::string> const &raw_lines) {
+bool Logical_File::scan_free_(
+    Text_Buffer::Line_Views const &raw_lines, size_t const first_line,
+    std::shared_ptr<Text_Buffer const> const &source) {
   const size_t N = raw_lines.size();
   num_input_lines = N;
-  bool in_literal_block = false;
   // Convert the raw text input into File_Lines
   std::vector<File_Line> fl(N);
-  char prev_open_delim = '\0';
-  bool prev_line_cont = false;
-  for (size_t i = 0; i < N; ++i) {
-    try {
-      fl[i] = File_Line::analyze_free((int)i + 1, raw_lines[i], prev_open_delim,
-                                      prev_line_cont, in_literal_block);
-    } catch (std::exception &e) {
-      std::cerr << "At line " << i + 1 << " of \"" << file_info->filename
-                << "\":\n"
-                << raw_lines[i] << '\n'
-                << "scan_free error: " << e.what() << std::endl;
-      return false;
-    }
-    prev_open_delim = fl[i].open_delim;
-    prev_line_cont = fl[i].is_continued();
+  auto const analyze = [&](size_t const i, Scan_State &state) {
+    File_Line line = File_Line::analyze_free(
+        (int)(first_line + i) + 1, raw_lines[i], state.open_delim,
+        state.continued, state.in_literal_block, source);
+    state.open_delim = line.open_delim;
+    state.continued = line.is_continued();
+    return line;
+  };
+  /* One pool analyzes the lines and then tokenizes them */
+  auto const pool = scan_pool(scan_threads_, N);
+  std::string error;
+  size_t const bad = analyze_lines(fl, analyze, pool.get(), error);
+  if (bad < N) {
+    std::cerr << "At line " << first_line + bad + 1 << " of \""
+              << file_info->filename << "\":\n"
+              << raw_lines[bad] << '\n'
+              << "scan_free error: " << error << std::endl;
+    return false;
   }
+  std::vector<Line_Group> groups;
 
   // Identify "logical lines": blocks of lines that represent a
   // comment/whitespace block or a single statement.
@@ -210,9 +364,7 @@ bool Logical_File::scan_free(std::vector<std::string> const &raw_lines) {
       curr += 1;
     if (curr > start_line) {
       // Have a trivial block [start_line..curr)
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      Logical_Line &ll = lines.back();
-      ll.file_info = file_info;
+      groups.push_back({start_line, curr, LineCat::UNKNOWN, false});
       continue;
     }
 
@@ -222,10 +374,7 @@ bool Logical_File::scan_free(std::vector<std::string> const &raw_lines) {
       curr += 1;
     if (curr > start_line) {
       // Have a literal block [start_line..curr)
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      Logical_Line &ll = lines.back();
-      ll.file_info = file_info;
-      ll.cat = LineCat::LITERAL;
+      groups.push_back({start_line, curr, LineCat::LITERAL, false});
       continue;
     }
 
@@ -246,21 +395,19 @@ bool Logical_File::scan_free(std::vector<std::string> const &raw_lines) {
 
       /* absorb any continued lines */
       size_t start_line = curr++;
-      while (curr < N && last_non_blank_char(fl[curr - 1].left_text) == '\\') {
+      while (curr < N &&
+             last_non_blank_char(fl[curr - 1].left_text.view()) == '\\') {
         fl[curr].make_preprocessor();
         curr += 1;
       }
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      Logical_Line &ll = lines.back();
-      ll.file_info = file_info;
-      ll.cat = cat;
+      groups.push_back({start_line, curr, cat, false});
       continue;
     }
 
     if (curr < N) {
       if (!fl[curr].is_fortran()) {
-        std::cerr << "scan_free confused on line " << curr + 1 << "of \""
-                  << file_info->filename << "\": \n"
+        std::cerr << "scan_free confused on line " << first_line + curr + 1
+                  << "of \"" << file_info->filename << "\": \n"
                   << fl[curr] << '\n';
         exit(1);
       }
@@ -277,13 +424,68 @@ bool Logical_File::scan_free(std::vector<std::string> const &raw_lines) {
       curr = last_code_line + 1;
 
       // code for this statement is now in [start_line..curr)
-      lines.emplace_back(fl.begin() + start_line, fl.begin() + curr);
-      lines.back().file_info = file_info;
+      groups.push_back({start_line, curr, LineCat::UNKNOWN, false});
     }
   }
+  make_lines_(fl, groups, pool.get());
   return true;
 }
 
+/* The groups are split into a task per pool thread, of about the same number
+   of File_Lines.
+   Each task tokenizes into its own Arena, which the Logical_File keeps, and
+   the Logical_Lines are then moved into lines in order. */
+void Logical_File::make_lines_(std::vector<File_Line> &fl,
+                               std::vector<Line_Group> const &groups,
+                               Work_Stealing_Pool *pool) {
+  auto const finish = [this](Logical_Line &ll, Line_Group const &g) {
+    ll.file_info = file_info;
+    if (LineCat::UNKNOWN != g.cat)
+      ll.cat = g.cat;
+    if (g.needs_reformat)
+      ll.needs_reformat = true;
+  };
+  size_t const num_tasks = (pool) ? pool->num_threads() : 1;
+  if (num_tasks < 2) {
+    // A private Lexer keeps this scan independent of any other thread
+    Lexer lexer;
+    for (Line_Group const &g : groups) {
+      finish(lines.emplace_back(fl.begin() + g.begin, fl.begin() + g.end,
+                                lexer, arena.get()),
+             g);
+    }
+    return;
+  }
+
+  std::vector<std::vector<Logical_Line>> parts(num_tasks);
+  std::vector<Work_Stealing_Pool::Task> tasks;
+  size_t g = 0;
+  for (size_t t = 0; t < num_tasks; ++t) {
+    size_t const first = g;
+    size_t const last_line = (fl.size() * (t + 1)) / num_tasks;
+    while (g < groups.size() && (groups[g].begin < last_line))
+      g += 1;
+    scan_arenas.emplace_back(std::make_unique<Arena>());
+    Arena *const task_arena = scan_arenas.back().get();
+    std::vector<Logical_Line> &part{parts[t]};
+    tasks.emplace_back([&fl, &groups, &part, task_arena, first, g]() {
+      Lexer lexer;
+      part.reserve(g - first);
+      for (size_t i = first; i < g; ++i)
+        part.emplace_back(fl.begin() + groups[i].begin,
+                          fl.begin() + groups[i].end, lexer, task_arena);
+    });
+  }
+  assert(g == groups.size());
+  pool->run(std::move(tasks));
+
+  g = 0;
+  for (auto &part : parts) {
+    for (Logical_Line &ll : part)
+      finish(lines.emplace_back(std::move(ll)), groups[g++]);
+  }
+}
+
 void Logical_File::make_stmts() {
   ll_stmts.clear();
   LL_Stmt_Src ss{lines, false};
@@ -365,6 +567,7 @@ LL_STMT_SEQ::iterator Logical_File::emplace_ll_stmt(LL_STMT_SEQ::iterator pos,
   LL_Stmt_Src ss{ll_new, true};
   auto result = ll_stmts.emplace(pos, ss.move());
   result->set_stmt_syntag(new_syntag);
+  mark_edited(result);
 
   return result;
 }
@@ -388,6 +591,7 @@ Logical_File::emplace_ll_stmt_after_prefix(LL_STMT_SEQ::iterator pos,
   LL_Stmt_Src ss{ll_new, true};
   auto result = ll_stmts.emplace(pos, ss.move());
   result->set_stmt_syntag(new_syntag);
+  mark_edited(result);
 
   /* Now transfer the prefix from the old to the new */
   assert(pos->prefix_ll_end() == ll_new);
@@ -406,8 +610,10 @@ void Logical_File::replace_stmt_text(LL_STMT_SEQ::iterator stmt,
   assert(stmt->ll().has_stmts());
   assert(stmt->ll().stmts().size() == 1);
   stmt->assign_range(stmt->ll().stmts()[0]);
+  /* the old tree is bad, even if the syntag is unchanged */
+  stmt->drop_stmt_tree();
   stmt->set_stmt_syntag(new_syntag);
-  stmt->unhook();
+  mark_edited(stmt);
 }
 
 void Logical_File::replace_stmt_substr(LL_STMT_SEQ::iterator stmt,
@@ -432,7 +638,7 @@ void Logical_File::replace_stmt_substr(LL_STMT_SEQ::iterator stmt,
   assert(stmt->ll().stmts().size() == 1);
   stmt->assign_range(stmt->ll().stmts()[0]);
   stmt->drop_stmt_tree();
-  stmt->unhook();
+  mark_edited(stmt);
 }
 
 void Logical_File::insert_text_after(LL_STMT_SEQ::iterator stmt,
@@ -444,7 +650,7 @@ void Logical_File::insert_text_after(LL_STMT_SEQ::iterator stmt,
   stmt->ll().insert_text_after(new_frag_it, new_text);
   stmt->assign_range(stmt->ll().stmts()[0]);
   stmt->drop_stmt_tree();
-  stmt->unhook();
+  mark_edited(stmt);
 }
 
 void Logical_File::append_stmt_text(LL_STMT_SEQ::iterator stmt,
@@ -457,7 +663,7 @@ void Logical_File::append_stmt_text(LL_STMT_SEQ::iterator stmt,
   assert(stmt->ll().stmts().size() == 1);
   stmt->assign_range(stmt->ll().stmts()[0]);
   stmt->drop_stmt_tree();
-  stmt->unhook();
+  mark_edited(stmt);
 }
 
 bool Logical_File::set_stmt_label(LL_STMT_SEQ::iterator stmt, int label) {
@@ -469,6 +675,9 @@ bool Logical_File::set_stmt_label(LL_STMT_SEQ::iterator stmt, int label) {
   }
   bool retval = stmt->ll().set_label(label);
   stmt->cache_new_label_value(stmt->ll().label);
+  /* labels can change how do-constructs end */
+  if (retval)
+    mark_edited(stmt);
   return retval;
 }
 
@@ -15,16 +15,21 @@
 #ifndef FLPR_LOGICAL_FILE_HH
 #define FLPR_LOGICAL_FILE_HH 1
 
+#include "flpr/Arena.hh"
 #include "flpr/File_Info.hh"
 #include "flpr/LL_Stmt.hh"
 #include "flpr/Logical_Line.hh"
 #include "flpr/Safe_List.hh"
+#include "flpr/Text_Buffer.hh"
 #include <istream>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace FLPR {
+
+class Work_Stealing_Pool;
+
 /*! \brief A sequence of Logical_Lines and LL_Stmts that make up a file, plus
   other identifying information. */
 class Logical_File {
@@ -35,7 +40,11 @@ public:
   using const_iterator = typename LL_List::const_iterator;
   using iterator = typename LL_List::iterator;
 
-  constexpr Logical_File() : has_flpr_pp{false}, num_input_lines{0} {}
+  Logical_File()
+      : arena{std::make_unique<Arena>()},
+        lines{LL_List::allocator_type{arena.get()}},
+        ll_stmts{LL_STMT_SEQ::allocator_type{arena.get()}}, has_flpr_pp{false},
+        scan_failed{false}, num_input_lines{0} {}
   Logical_File(Logical_File &&) = default;
   Logical_File(Logical_File const &) = delete;
   Logical_File &operator=(Logical_File const &) = delete;
@@ -55,6 +64,22 @@ public:
   bool scan(Line_Buf const &line_buffer, std::string const &buffer_name,
             int const last_fixed_col, File_Type file_type = File_Type::UNKNOWN);
 
+  //! Scan the contents of a Text_Buffer
+  /*! The resulting File_Lines refer to the buffer text in place, and keep the
+      buffer alive until they no longer need it. */
+  bool scan(std::shared_ptr<Text_Buffer const> const &buffer,
+            std::string const &buffer_name, int const last_fixed_col,
+            File_Type file_type = File_Type::UNKNOWN);
+
+  //! Scan some of the lines of a Text_Buffer
+  /*! raw_lines are views into buffer, the first of which is (index origin = 0)
+      line first_line of the buffer.  They should begin and end on statement
+      boundaries.  The File_Lines are numbered as lines of the whole buffer. */
+  bool scan(std::shared_ptr<Text_Buffer const> const &buffer,
+            Text_Buffer::Line_Views const &raw_lines, size_t const first_line,
+            std::string const &buffer_name, int const last_fixed_col,
+            File_Type file_type = File_Type::UNKNOWN);
+
   //! Scan the file assuming F77-style fixed format
   bool scan_fixed(Line_Buf const &fl, int const last_col);
 
@@ -113,10 +138,50 @@ public:
   //! Label a statement (label == 0 will unlabel it)
   bool set_stmt_label(LL_STMT_SEQ::iterator stmt, int label);
 
+  //! Record that a statement has changed since it was last parsed
+  /*! The edit functions above (and Edit_Transaction) call this for the
+      statements they touch.  It forgets any parse_with() results, and drops
+      the statement's uplink to the Prgm_Tree so that a Parsed_File knows to
+      re-parse the construct that contains the statement.  Call it after
+      changing a statement by other means. */
+  void mark_edited(LL_STMT_SEQ::iterator stmt) {
+    stmt->unhook();
+    stmt->preclassify();
+    edit_count_ += 1;
+  }
+
+  //! The number of mark_edited() calls on this Logical_File
+  constexpr size_t edit_count() const noexcept { return edit_count_; }
+
   //! Convert fixed format to free
   bool convert_fixed_to_free();
 
+  //! Set the number of threads that a scan of a large file may use
+  /*! With more than one thread, the File_Line analysis of a large file is
+      done in chunks that are speculatively analyzed in parallel, then
+      stitched together, and the Logical_Lines are tokenized in parallel,
+      all on one pool of threads.  The results are the same as a serial
+      scan.  The default is 1, which is what you want when files are already
+      being scanned concurrently: each file's scan would otherwise start a
+      pool of its own inside the caller's. */
+  void set_scan_threads(int const num_threads) noexcept {
+    scan_threads_ = num_threads;
+  }
+  //! The number of threads that a scan of a large file may use
+  constexpr int scan_threads() const noexcept { return scan_threads_; }
+
 public:
+  //! The memory for lines, ll_stmts, and everything that they contain
+  /*! This is declared first so that it is destroyed last.  lines and
+      ll_stmts are constructed with it, and scanning hands it to each new
+      Logical_Line for its tokens, so the whole structure is released at
+      once when the Logical_File is destroyed.  The parse trees that
+      Parsed_File builds first share it as well. */
+  std::unique_ptr<Arena> arena;
+  //! The Arenas that a parallel scan tokenized into (one per task)
+  /*! These hold the fragments of some of the lines, so they are also
+      declared before lines. */
+  std::vector<std::unique_ptr<Arena>> scan_arenas;
   //! Basic information about the input file
   std::shared_ptr<File_Info> file_info;
   //! The scanned Logical_Lines
@@ -125,12 +190,43 @@ public:
   LL_STMT_SEQ ll_stmts;
   //! True if read_and_scan found FLPR preprocessor lines
   bool has_flpr_pp;
+  //! True if the last scan failed, leaving lines incomplete
+  bool scan_failed;
   //! Number of scanned line
   size_t num_input_lines;
 
 private:
+  //! The File_Lines [begin, end) that make up one Logical_Line
+  struct Line_Group {
+    size_t begin;
+    size_t end;
+    LineCat cat;
+    bool needs_reformat;
+  };
+
+  size_t edit_count_{0};
+  int scan_threads_{1};
+
   //! Clear the contents of this structure
   void clear();
+
+  //! Scan lines, which refer into source (if that is non-null)
+  /*! raw_lines[0] is numbered as line first_line + 1 */
+  bool scan_(Text_Buffer::Line_Views const &raw_lines, size_t const first_line,
+             std::shared_ptr<Text_Buffer const> const &source,
+             std::string const &buffer_name, int const last_fixed_col,
+             File_Type file_type);
+  bool scan_fixed_(Text_Buffer::Line_Views const &raw_lines,
+                   size_t const first_line, int const last_col,
+                   std::shared_ptr<Text_Buffer const> const &source);
+  bool scan_free_(Text_Buffer::Line_Views const &raw_lines,
+                  size_t const first_line,
+                  std::shared_ptr<Text_Buffer const> const &source);
+  //! Construct (and tokenize) the Logical_Line for each group of fl
+  /*! The lines are tokenized on pool, if it is non-null */
+  void make_lines_(std::vector<File_Line> &fl,
+                   std::vector<Line_Group> const &groups,
+                   Work_Stealing_Pool *pool);
 };
 
 } // namespace FLPR
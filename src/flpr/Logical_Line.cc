@@ -17,19 +17,21 @@
 #include <stdexcept>
 
 #include "flpr/Logical_Line.hh"
+#include "flpr/Keyword_Hash.hh"
+#include "flpr/Lexer.hh"
 #include "flpr/Syntax_Tags.hh"
 #include "flpr/utils.hh"
 
-#include "Smash_Hash.hh"
-#include "scan_fort.hh"
-
-// Defined in scan_toks.l
-extern int curr_line_pos;
-
 namespace FLPR {
 /* ------------------------------------------------------------------------ */
 Logical_Line::Logical_Line() noexcept { clear(); }
 
+/* ------------------------------------------------------------------------ */
+Logical_Line::Logical_Line(Arena *arena) noexcept
+    : fragments_{TT_List::allocator_type{arena}} {
+  clear();
+}
+
 /* ------------------------------------------------------------------------ */
 Logical_Line::Logical_Line(Logical_Line const &src) noexcept
     : file_info{src.file_info}, label{src.label}, cat{src.cat},
@@ -121,6 +123,11 @@ void Logical_Line::clear() noexcept {
 
 /* ------------------------------------------------------------------------ */
 void Logical_Line::init_from_layout() noexcept {
+  init_from_layout(Lexer::thread_instance());
+}
+
+/* ------------------------------------------------------------------------ */
+void Logical_Line::init_from_layout(Lexer &lexer) noexcept {
   Line_Accum la;
 
   for (auto &fl : layout_) {
@@ -129,8 +136,8 @@ void Logical_Line::init_from_layout() noexcept {
 
       /* need to add the left and right space sizes here so that continued lines
          have the correct breaks between lexemes. */
-      la.add_line(fl.linenum, fl.left_space.size(), first_col, fl.main_text,
-                  fl.right_space.size());
+      la.add_line(fl.linenum, fl.left_space.size(), first_col,
+                  fl.main_text.view(), fl.right_space.size());
     }
   }
 
@@ -145,7 +152,7 @@ void Logical_Line::init_from_layout() noexcept {
   } else
     label = 0;
 
-  tokenize(la);
+  tokenize(la, lexer);
 }
 
 namespace {
@@ -194,7 +201,7 @@ continue_fl(Logical_Line::FL_VEC &text, Logical_Line::FL_VEC::iterator curr) {
 } // namespace
 
 /* ------------------------------------------------------------------------ */
-bool Logical_Line::append_tt_if_(std::string &main_text, size_t max_len,
+bool Logical_Line::append_tt_if_(Line_Text &main_text, size_t max_len,
                                  Token_Text const &tt, bool first) {
   size_t len = tt.text().size();
   if (!first && tt.pre_spaces_ > 0)
@@ -318,7 +325,7 @@ void Logical_Line::replace_fragment(typename TT_List::iterator frag,
 
   assert(!frag->is_split_token_());
   int const layout_line = frag->mt_begin_line_;
-  std::string &main_text = layout_[layout_line].main_text;
+  Line_Text &main_text = layout_[layout_line].main_text;
   main_text.replace(frag->mt_begin_col_, old_text_len, new_text);
 
   // Update the mt_begin_col_ for all fragments following on this line
@@ -339,7 +346,7 @@ void Logical_Line::remove_fragment(typename TT_List::iterator frag) {
   /* this isn't setup to do tokens that are split across continuations */
   assert(!frag->is_split_token_());
   int const layout_line = frag->mt_begin_line_;
-  std::string &main_text = layout_[layout_line].main_text;
+  Line_Text &main_text = layout_[layout_line].main_text;
   main_text.erase(frag->mt_begin_col_, old_text_len);
 
   int const len_change = -(int)(old_text_len);
@@ -499,6 +506,30 @@ void Logical_Line::insert_text_after(typename TT_List::iterator frag,
   init_from_layout();
 }
 
+/* ------------------------------------------------------------------------ */
+void Logical_Line::apply_text_edits(std::vector<Text_Edit> edits) {
+  /* Work from the back of the line to the front, so that the positions of the
+     remaining edits aren't disturbed.  A replacement goes before an insertion
+     at the same position, so that the inserted text ends up in front. */
+  auto const goes_first = [](Text_Edit const &a, Text_Edit const &b) {
+    if (a.begin_line != b.begin_line)
+      return a.begin_line > b.begin_line;
+    if (a.begin_col != b.begin_col)
+      return a.begin_col > b.begin_col;
+    return !a.is_insertion() && b.is_insertion();
+  };
+  std::sort(edits.begin(), edits.end(), goes_first);
+  for (Text_Edit const &e : edits) {
+    assert(e.begin_line < static_cast<int>(layout_.size()));
+    if (!e.is_insertion())
+      erase_stmt_text_(e.begin_line, e.begin_col, e.end_line, e.end_col);
+    assert(e.begin_col <=
+           static_cast<int>(layout_[e.begin_line].main_text.size()));
+    layout_[e.begin_line].main_text.insert(e.begin_col, e.text);
+  }
+  init_from_layout();
+}
+
 /* ------------------------------------------------------------------------ */
 bool Logical_Line::split_after(typename TT_List::iterator frag,
                                Logical_Line &new_ll) {
@@ -750,28 +781,30 @@ bool Logical_Line::set_label(int new_label) {
 }
 
 /* ------------------------------------------------------------------------ */
-void Logical_Line::tokenize(Line_Accum const &la) {
-  // Clear out any previous tokens
-  fragments_.clear();
-
-  // The index into la.accum()
-  curr_line_pos = 0;
+void Logical_Line::tokenize(Line_Accum const &la, Lexer &lexer) {
+  // Clear out any previous tokens.  Re-tokenizing is an edit, which may be
+  // repeated, so the new tokens come from the heap rather than an Arena.
+  if (!fragments_.empty())
+    fragments_ = TT_List{};
 
-  // Feed the la.accum() to the flex parser to generate
-  // the Logical_Line token fragment data.
-  YY_BUFFER_STATE bs = yy_scan_string(la.accum().c_str());
+  // Feed the la.accum() to the lexer to generate the Logical_Line token
+  // fragment data.  The lexer position is the index into la.accum().
+  lexer.set_input(la.accum());
   const int N = la.accum().size();
-  int tok_start_col = curr_line_pos;
+  /* The token offsets only increase, so a cursor maps them in linear time */
+  Line_Accum::Cursor positions{la.cursor()};
+  int tok_start_col = lexer.position();
   int next_pre_sp = 0;
   int space_between;
 
-  for (int result_tok = yylex(); result_tok != Syntax_Tags::EOL;
-       result_tok = yylex()) {
+  for (int result_tok = lexer.next(); result_tok != Syntax_Tags::EOL;
+       result_tok = lexer.next()) {
     /* tok_start is an index into la.accum().  Convert this into a file line and
      column number */
     int li, ci, tli, tci;
-    la.linecolno(tok_start_col, li, ci, tli, tci);
-    fragments_.emplace_back(std::string(yytext, yyleng), result_tok, li, ci);
+    positions.linecolno(tok_start_col, li, ci, tli, tci);
+    fragments_.emplace_back(std::string(lexer.text(), lexer.length()),
+                            result_tok, li, ci);
     /* Break up keywords with no space. */
     if (result_tok == Syntax_Tags::TK_NAME)
       unsmash();
@@ -782,13 +815,13 @@ void Logical_Line::tokenize(Line_Accum const &la) {
     int end_file_line_idx, end_file_col_idx, end_text_line_idx,
         end_text_col_idx;
 
-    la.linecolno(curr_line_pos - 1, end_file_line_idx, end_file_col_idx,
-                 end_text_line_idx, end_text_col_idx);
+    positions.linecolno(lexer.position() - 1, end_file_line_idx,
+                        end_file_col_idx, end_text_line_idx, end_text_col_idx);
     end_text_col_idx += 1;
 
-    /* yylex advances curr_line_pos to the end of the last token recognized, but
-       we want where the next token begins */
-    tok_start_col = curr_line_pos;
+    /* the lexer position is the end of the last token recognized, but we want
+       where the next token begins */
+    tok_start_col = lexer.position();
     space_between = 0;
     while (tok_start_col < N && std::isspace(la.accum()[tok_start_col])) {
       tok_start_col += 1;
@@ -805,7 +838,6 @@ void Logical_Line::tokenize(Line_Accum const &la) {
 
     next_pre_sp = space_between;
   }
-  yy_delete_buffer(bs);
   init_stmts();
 }
 
@@ -833,16 +865,16 @@ void Logical_Line::append_comment(std::string const &comment_text) {
 
 /* ------------------------------------------------------------------------ */
 void Logical_Line::unsmash() {
-  using details_::Smash_Hash;
-  using details_::Smashed;
+  using details_::Keyword;
+  using details_::Keyword_Hash;
   if (fragments_.empty())
     return;
   if (fragments_.back().token != Syntax_Tags::TK_NAME)
     return;
 
-  Smashed const *ptr = Smash_Hash::in_word_set(
-      fragments_.back().lower().c_str(), fragments_.back().text().size());
-  if (!ptr)
+  std::string const &name{fragments_.back().text()};
+  Keyword const *ptr = Keyword_Hash::in_word_set(name.data(), name.size());
+  if (!ptr || !ptr->is_smashed())
     return;
   Token_Text new2{fragments_.back()};
 
@@ -29,6 +29,9 @@
 #include <vector>
 
 namespace FLPR {
+class Lexer;
+class Parse_Cache;
+
 //! Specific categorization of a Logical_Line
 enum LineCat {
   INCLUDE, //!< A Fortan include line
@@ -51,6 +54,7 @@ enum LineCat {
 */
 class Logical_Line {
 public:
+  friend class Parse_Cache;
   using iterator = TT_List::iterator;
   using const_iterator = TT_List::const_iterator;
   using FL_VEC = std::vector<File_Line>;
@@ -64,6 +68,8 @@ public:
   bool needs_reformat; //!< true->reformat before output
 
   Logical_Line() noexcept;
+  //! An empty Logical_Line whose first tokens will come from arena
+  explicit Logical_Line(Arena *arena) noexcept;
 
   // We need to update Logical_Line::stmts after copies
   Logical_Line(Logical_Line const &src) noexcept;
@@ -82,6 +88,18 @@ public:
     init_from_layout();
   }
 
+  //! Create a Logical_Line from a range of File_Lines using a given Lexer
+  /*! The tokens come from arena, if there is one.  Those of any later edit
+      come from the heap. */
+  template <typename Iter>
+  Logical_Line(Iter first, Iter last, Lexer &lexer,
+               Arena *arena = nullptr) noexcept
+      : label{0}, cat{LineCat::UNKNOWN}, suppress{false}, needs_reformat{false},
+        num_semicolons_{-1}, fragments_{TT_List::allocator_type{arena}} {
+    std::move(first, last, std::back_inserter(layout_));
+    init_from_layout(lexer);
+  }
+
   //! Make a trivial Logical_Line from a free-format raw string
   explicit Logical_Line(std::string const &raw_text);
 
@@ -100,8 +118,12 @@ public:
   void clear() noexcept;
 
   //! Initialize structure from contents of the layout member.
+  /*! This uses the Lexer::thread_instance() for the calling thread */
   void init_from_layout() noexcept;
 
+  //! Initialize structure from contents of the layout member.
+  void init_from_layout(Lexer &lexer) noexcept;
+
   //! Non-const layout accessor
   constexpr FL_VEC &layout() noexcept { return layout_; }
 
@@ -166,6 +188,24 @@ public:
   void insert_text_after(typename TT_List::iterator frag,
                          std::string const &new_text);
 
+  //! A replacement of the main_text between two layout positions
+  /*! The positions are (layout line, main_text column) pairs, as recorded in
+      Token_Text.  An insertion has the same begin and end position. */
+  struct Text_Edit {
+    int begin_line, begin_col;
+    int end_line, end_col;
+    std::string text;
+    constexpr bool is_insertion() const noexcept {
+      return begin_line == end_line && begin_col == end_col;
+    }
+  };
+
+  //! Apply a set of Text_Edits, and reinitialize once
+  /*! The edits all refer to the current layout.  They may not overlap, and
+      there may only be one insertion at any position, although an insertion
+      may share a position with the beginning or end of a replacement. */
+  void apply_text_edits(std::vector<Text_Edit> edits);
+
   //! Standard output
   std::ostream &print(std::ostream &os) const;
 
@@ -222,7 +262,7 @@ public:
 
 private:
   //! Perform lexical analysis, creating fragments from the combined text
-  void tokenize(Line_Accum const &);
+  void tokenize(Line_Accum const &, Lexer &lexer);
 
   //! If the last token in fragments is actually two (no space), split it
   /*! This handles the exception to the free-format spacing rules found
@@ -230,7 +270,7 @@ private:
   void unsmash();
 
   //! Append a token to main_text if it fits within max_len characters
-  bool append_tt_if_(std::string &main_text, size_t max_len,
+  bool append_tt_if_(Line_Text &main_text, size_t max_len,
                      Token_Text const &tt, bool first);
 
   void erase_stmt_text_(int stln, int stcol, int eln, int ecol);
@@ -0,0 +1,648 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Parse_Cache.cc
+
+  An entry holds a header (see encode_header_), then the Logical_File, then
+  the Prgm_Tree.  Everything is a Byte_Writer integer or string, and all of
+  the cross-references are indices: the Logical_Line of a statement or a
+  Stmt_Tree range is an index into the lines, a token is an index into the
+  fragments of its line, and a statement is an index into ll_stmts.  The
+  LL_Stmts themselves aren't stored, as Logical_File::make_stmts() rebuilds
+  them cheaply from the restored lines.
+*/
+
+#include "flpr/Parse_Cache.hh"
+#include "flpr/Stmt_Parser_Exts.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef FLPR_BUILD_ID
+/* Without the hash of the sources, at least tell builds apart */
+#define FLPR_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+namespace FLPR {
+
+namespace {
+constexpr char const magic[] = "FLPR parse cache\n";
+constexpr char const entry_suffix[] = ".flprc";
+
+std::uint64_t rotl(std::uint64_t const x, int const r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+/* A 64-bit hash of text, consuming eight bytes at a time.  This doesn't need
+   to be cryptographic: an entry also has to match the length of the text. */
+std::uint64_t hash_text(std::string_view const text) noexcept {
+  constexpr std::uint64_t k1 = 0x87c37b91114253d5ULL;
+  constexpr std::uint64_t k2 = 0x4cf5ad432745937fULL;
+  std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ text.size();
+  char const *p = text.data();
+  std::size_t remaining = text.size();
+  for (; remaining >= 8; p += 8, remaining -= 8) {
+    std::uint64_t w;
+    std::memcpy(&w, p, 8);
+    h = rotl(h ^ rotl(w * k1, 31) * k2, 27) * 5 + 0x52dce729;
+  }
+  std::uint64_t w{0};
+  std::memcpy(&w, p, remaining);
+  h ^= rotl(w * k1, 31) * k2;
+  /* Mix the bits */
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/* Call f(path, stat) for each cache entry in directory */
+template <typename F> void for_each_entry(std::string const &directory, F f) {
+  DIR *const dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+  std::size_t const suffix_len = sizeof(entry_suffix) - 1;
+  while (struct dirent const *de = readdir(dir)) {
+    std::string_view const name{de->d_name};
+    if (name.size() <= suffix_len ||
+        name.substr(name.size() - suffix_len) != entry_suffix)
+      continue;
+    std::string path{directory + '/'};
+    path.append(name);
+    struct stat sb;
+    if (stat(path.c_str(), &sb) == 0 && S_ISREG(sb.st_mode))
+      f(path, sb);
+  }
+  closedir(dir);
+}
+
+/* A temporary that hasn't been written to for this long was left by a
+   writer that died */
+constexpr std::time_t stale_temp_seconds = 60 * 60;
+
+/* True if name is a temporary from write_entry_(): an entry name, followed by
+   the ".XXXXXX" that mkstemp filled in */
+bool is_temp_name(std::string_view const name) {
+  std::size_t const suffix_len = sizeof(entry_suffix) - 1;
+  if (name.size() <= suffix_len + 7)
+    return false;
+  std::string_view const tail = name.substr(name.size() - suffix_len - 7);
+  return tail.substr(0, suffix_len) == entry_suffix && tail[suffix_len] == '.';
+}
+
+/* Remove the stale temporaries in directory */
+void remove_stale_temps(std::string const &directory) {
+  DIR *const dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+  std::time_t const cutoff = std::time(nullptr) - stale_temp_seconds;
+  while (struct dirent const *de = readdir(dir)) {
+    std::string_view const name{de->d_name};
+    if (!is_temp_name(name))
+      continue;
+    std::string path{directory + '/'};
+    path.append(name);
+    struct stat sb;
+    if (stat(path.c_str(), &sb) == 0 && S_ISREG(sb.st_mode) &&
+        sb.st_mtime < cutoff)
+      unlink(path.c_str());
+  }
+  closedir(dir);
+}
+} // namespace
+
+/* Information for encoding one Logical_File */
+struct Parse_Cache::Encode_Index {
+  std::unordered_map<Logical_Line const *, std::uint64_t> lines;
+  //! The index of each token in the fragments of its Logical_Line
+  std::unordered_map<Token_Text const *, std::uint64_t> tokens;
+};
+
+/* Information for decoding one Logical_File */
+struct Parse_Cache::Decode_Index {
+  std::vector<LL_List::iterator> lines;
+  //! The tokens of each line, followed by fragments().end()
+  std::vector<std::vector<TT_List::iterator>> tokens;
+};
+
+Parse_Cache::Parse_Cache(std::string directory, std::uintmax_t max_bytes)
+    : directory_{std::move(directory)}, max_bytes_{max_bytes} {
+  if (mkdir(directory_.c_str(), 0777) != 0 && errno != EEXIST) {
+    std::cerr << "Parse_Cache: unable to create directory \"" << directory_
+              << "\": " << std::strerror(errno) << '\n';
+    return;
+  }
+  struct stat sb;
+  if (stat(directory_.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+    std::cerr << "Parse_Cache: \"" << directory_ << "\" is not a directory\n";
+    return;
+  }
+  usable_ = true;
+  remove_stale_temps(directory_);
+  std::uintmax_t total{0};
+  for_each_entry(directory_, [&total](std::string const &,
+                                      struct stat const &esb) {
+    total += esb.st_size;
+  });
+  total_bytes_ = total;
+}
+
+auto Parse_Cache::make_key_(Text_Buffer const &buffer, File_Type file_type,
+                            int last_fixed_col) noexcept -> Key {
+  /* The column limit only matters to fixed-format files */
+  if (file_type != File_Type::FIXEDFMT)
+    last_fixed_col = 0;
+  return Key{hash_text(buffer.text()), parsers_id(), buffer.text().size(),
+             file_type, last_fixed_col};
+}
+
+std::uint64_t Parse_Cache::parsers_id() noexcept {
+  std::string id{FLPR_BUILD_ID};
+  auto const &exts{Stmt::get_parser_exts()};
+  id += ' ' + std::to_string(exts.num_action_stmts()) + ' ' +
+        std::to_string(exts.num_other_specification_stmts());
+  auto const &tags{Syntax_Tags::registered_exts()};
+  for (size_t i = 0; i < tags.size(); ++i) {
+    if (!tags[i].empty())
+      id += ' ' + std::to_string(i) + ':' + std::to_string(tags[i].type) +
+            ':' + tags[i].label;
+  }
+  return hash_text(id);
+}
+
+std::string Parse_Cache::entry_path_(Key const &key) const {
+  char name[64];
+  std::snprintf(name, sizeof(name), "/%016" PRIx64 "-%016" PRIx64 "-%d-%d",
+                key.hash, key.parsers, static_cast<int>(key.file_type),
+                key.last_fixed_col);
+  return directory_ + name + entry_suffix;
+}
+
+/* ------------------------------ Entry I/O ------------------------------- */
+
+std::shared_ptr<Text_Buffer const>
+Parse_Cache::read_entry_(std::string const &path) {
+  auto entry = Text_Buffer::from_file(path);
+  if (entry) {
+    /* Record the use, for eviction */
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  }
+  return entry;
+}
+
+void Parse_Cache::discard_entry_(std::string const &path) {
+  struct stat sb;
+  if (stat(path.c_str(), &sb) == 0 && unlink(path.c_str()) == 0)
+    total_bytes_ -= std::min<std::uintmax_t>(total_bytes_, sb.st_size);
+}
+
+void Parse_Cache::write_entry_(std::string const &path,
+                               std::string const &data) {
+  /* Write to a temporary and rename it, so that readers never see a partial
+     entry.  The temporary doesn't have the entry suffix, so it is invisible
+     to eviction. */
+  std::string tmp_name{path + ".XXXXXX"};
+  int const fd = mkstemp(tmp_name.data());
+  if (fd < 0) {
+    std::cerr << "Parse_Cache: unable to create an entry in \"" << directory_
+              << "\": " << std::strerror(errno) << '\n';
+    return;
+  }
+  char const *curr = data.data();
+  std::size_t remaining = data.size();
+  bool ok{true};
+  while (ok && remaining > 0) {
+    ssize_t const n = ::write(fd, curr, remaining);
+    if (n < 0) {
+      ok = (errno == EINTR);
+      continue;
+    }
+    curr += n;
+    remaining -= n;
+  }
+  ok = (close(fd) == 0) && ok;
+  ok = ok && std::rename(tmp_name.c_str(), path.c_str()) == 0;
+  if (!ok) {
+    std::cerr << "Parse_Cache: unable to write \"" << path
+              << "\": " << std::strerror(errno) << '\n';
+    unlink(tmp_name.c_str());
+    return;
+  }
+  stores_ += 1;
+  if ((total_bytes_ += data.size()) > max_bytes_)
+    evict_();
+}
+
+/* Remove the least recently used entries until they fit in max_bytes_.  This
+   lists the directory, so that it also accounts for entries written by
+   other processes. */
+void Parse_Cache::evict_() {
+  std::lock_guard<std::mutex> lock(evict_mutex_);
+  struct Entry {
+    std::string path;
+    struct timespec mtime;
+    std::uintmax_t size;
+  };
+  std::vector<Entry> entries;
+  std::uintmax_t total{0};
+  for_each_entry(directory_, [&](std::string const &path,
+                                 struct stat const &sb) {
+    entries.push_back(Entry{path, sb.st_mtim,
+                            static_cast<std::uintmax_t>(sb.st_size)});
+    total += sb.st_size;
+  });
+  std::sort(entries.begin(), entries.end(),
+            [](Entry const &a, Entry const &b) {
+              return a.mtime.tv_sec < b.mtime.tv_sec ||
+                     (a.mtime.tv_sec == b.mtime.tv_sec &&
+                      a.mtime.tv_nsec < b.mtime.tv_nsec);
+            });
+  for (auto const &e : entries) {
+    if (total <= max_bytes_)
+      break;
+    if (unlink(e.path.c_str()) == 0) {
+      total -= e.size;
+      evictions_ += 1;
+    }
+  }
+  total_bytes_ = total;
+}
+
+/* ------------------------------- Encoding ------------------------------- */
+
+void Parse_Cache::encode_header_(Byte_Writer &out, Key const &key) {
+  out.put_raw(std::string_view{magic, sizeof(magic) - 1});
+  out.put_uint(format_version);
+  out.put_uint(key.hash);
+  out.put_uint(key.parsers);
+  out.put_uint(key.size);
+  out.put_uint(static_cast<std::uint64_t>(key.file_type));
+  out.put_int(key.last_fixed_col);
+}
+
+bool Parse_Cache::decode_header_(Byte_Reader &in, Key const &key) {
+  return in.get_raw(sizeof(magic) - 1) ==
+             std::string_view{magic, sizeof(magic) - 1} &&
+         in.get_uint() == format_version && in.get_uint() == key.hash &&
+         in.get_uint() == key.parsers && in.get_uint() == key.size &&
+         in.get_uint() == static_cast<std::uint64_t>(key.file_type) &&
+         in.get_int() == key.last_fixed_col && in;
+}
+
+/* A File_Line that still refers to the buffer is stored as the position of
+   its text (relative to the end of the previous one) and the positions of its
+   fields within that text.  Anything else is stored as the field strings. */
+bool Parse_Cache::encode_file_(Byte_Writer &out, Logical_File const &lf,
+                               Text_Buffer const &buffer,
+                               Stmt_Numbers &numbers) {
+  Encode_Index idx;
+  std::string_view const text = buffer.text();
+  char const *prev_end = text.data();
+  int prev_linenum = 0;
+
+  out.put_uint(lf.has_flpr_pp);
+  out.put_uint(lf.num_input_lines);
+  out.put_uint(lf.lines.size());
+  for (auto const &ll : lf.lines) {
+    idx.lines.emplace(&ll, idx.lines.size());
+    out.put_uint(ll.layout_.size());
+    out.put_int(ll.label);
+    out.put_uint(ll.cat);
+    out.put_uint(ll.suppress | (ll.needs_reformat << 1) |
+                 (ll.has_stmts() << 2));
+
+    for (File_Line const &fl : ll.layout_) {
+      out.put_int(fl.linenum - prev_linenum);
+      prev_linenum = fl.linenum;
+      out.put_uint(fl.classification_.to_ulong());
+      out.put_uint(static_cast<unsigned char>(fl.open_delim));
+      std::string_view const raw = fl.raw_;
+      if (fl.source_.get() == &buffer && fl.is_unmodified()) {
+        out.put_uint(0);
+        out.put_int(raw.data() - prev_end);
+        out.put_uint(raw.size());
+        prev_end = raw.data() + raw.size();
+        char const *curr = raw.data();
+        for (Line_Text const *f : {&fl.left_text, &fl.left_space,
+                                   &fl.main_text, &fl.right_space,
+                                   &fl.right_text}) {
+          out.put_uint(f->size());
+          if (!f->empty()) {
+            out.put_uint(f->data() - curr);
+            curr = f->data() + f->size();
+          }
+        }
+      } else {
+        out.put_uint(1);
+        for (Line_Text const *f : {&fl.left_text, &fl.left_space,
+                                   &fl.main_text, &fl.right_space,
+                                   &fl.right_text})
+          out.put_string(f->view());
+      }
+    }
+
+    /* Most token text is a piece of one main_text, so it needn't be stored */
+    out.put_uint(ll.fragments_.size());
+    std::uint64_t tok_num{0};
+    for (Token_Text const &tt : ll.fragments_) {
+      idx.tokens.emplace(&tt, tok_num++);
+      out.put_int(tt.token);
+      out.put_int(tt.start_line - ll.start_line());
+      out.put_int(tt.start_pos);
+      out.put_int(tt.mt_begin_line_);
+      out.put_int(tt.mt_begin_col_);
+      out.put_int(tt.mt_end_line_ - tt.mt_begin_line_);
+      out.put_int(tt.mt_end_col_ - tt.mt_begin_col_);
+      out.put_int(tt.pre_spaces_);
+      out.put_int(tt.post_spaces_);
+      bool in_main_text{false};
+      if (!tt.is_split_token_() && tt.mt_begin_line_ >= 0 &&
+          tt.mt_begin_line_ < static_cast<int>(ll.layout_.size()) &&
+          tt.mt_begin_col_ >= 0 && tt.mt_end_col_ >= tt.mt_begin_col_) {
+        std::string_view const mt =
+            ll.layout_[tt.mt_begin_line_].main_text.view();
+        in_main_text =
+            static_cast<std::size_t>(tt.mt_end_col_) <= mt.size() &&
+            mt.substr(tt.mt_begin_col_, tt.mt_end_col_ - tt.mt_begin_col_) ==
+                tt.text_;
+      }
+      if (in_main_text) {
+        out.put_uint(0);
+      } else {
+        out.put_uint(tt.text_.size() + 1);
+        out.put_raw(tt.text_);
+      }
+    }
+  }
+
+  out.put_uint(lf.ll_stmts.size());
+  std::uint64_t prev_line{0};
+  for (LL_Stmt const &stmt : lf.ll_stmts) {
+    numbers.emplace(&stmt, numbers.size());
+    auto const line = idx.lines.find(&stmt.ll());
+    if (line == idx.lines.end())
+      return false;
+    out.put_int(line->second - prev_line);
+    prev_line = line->second;
+    out.put_int(stmt.stmt_syntag_);
+    out.put_uint(!stmt.stmt_tree_.empty());
+    if (!stmt.stmt_tree_.empty() &&
+        !encode_stmt_tree_(out, *stmt.stmt_tree_, nullptr, line->second,
+                           idx))
+      return false;
+  }
+  return true;
+}
+
+bool Parse_Cache::decode_file_(Byte_Reader &in, Logical_File &lf,
+                               std::shared_ptr<Text_Buffer const> const &buffer,
+                               std::string const &buffer_name, Key const &key,
+                               Stmt_Iters &stmts) {
+  /* The lines are given the Arena for their tokens, and the Stmt_Trees draw
+     from it through the Scope */
+  Arena::Scope arena_scope{lf.arena.get()};
+  Decode_Index idx;
+  std::string_view const text = buffer->text();
+  std::size_t prev_end{0};
+  int linenum{0};
+
+  lf.file_info = std::make_shared<File_Info>(buffer_name, key.file_type);
+  lf.file_info->last_fixed_column = key.last_fixed_col;
+  lf.has_flpr_pp = in.get_uint();
+  lf.num_input_lines = in.get_uint();
+  std::uint64_t const num_lines = in.get_uint();
+  if (num_lines > text.size() + 1)
+    return false;
+  idx.lines.reserve(num_lines);
+  idx.tokens.reserve(num_lines);
+
+  for (std::uint64_t i = 0; in && i < num_lines; ++i) {
+    Logical_Line &ll = lf.lines.emplace_back(lf.arena.get());
+    idx.lines.push_back(std::prev(lf.lines.end()));
+    ll.file_info = lf.file_info;
+    std::uint64_t const num_layout = in.get_uint();
+    ll.label = static_cast<int>(in.get_int());
+    std::uint64_t const cat = in.get_uint();
+    std::uint64_t const flags = in.get_uint();
+    if (cat > LineCat::UNKNOWN || num_layout > num_lines + text.size())
+      return false;
+    ll.cat = static_cast<LineCat>(cat);
+    ll.suppress = flags & 1;
+    ll.needs_reformat = flags & 2;
+
+    ll.layout_.reserve(num_layout);
+    for (std::uint64_t j = 0; in && j < num_layout; ++j) {
+      linenum += static_cast<int>(in.get_int());
+      std::uint64_t const bits = in.get_uint();
+      char const od = static_cast<char>(in.get_uint());
+      if (bits >> static_cast<int>(File_Line::class_flags::zzz_num) ||
+          (od != '\0' && od != '\'' && od != '"'))
+        return false;
+      std::string_view fields[5];
+      if (in.get_uint() == 0) {
+        std::int64_t const begin =
+            static_cast<std::int64_t>(prev_end) + in.get_int();
+        std::uint64_t const size = in.get_uint();
+        if (begin < 0 || static_cast<std::uint64_t>(begin) > text.size() ||
+            size > text.size() - begin)
+          return false;
+        std::string_view const raw = text.substr(begin, size);
+        prev_end = begin + size;
+        std::size_t curr{0};
+        for (auto &f : fields) {
+          std::uint64_t const f_size = in.get_uint();
+          if (f_size) {
+            std::uint64_t const gap = in.get_uint();
+            if (gap > raw.size() - curr || f_size > raw.size() - curr - gap)
+              return false;
+            f = raw.substr(curr + gap, f_size);
+            curr += gap + f_size;
+          }
+        }
+        File_Line fl{linenum,   File_Line::BITS{bits},
+                     buffer,    fields[0],
+                     fields[1], fields[2],
+                     fields[3], fields[4],
+                     od};
+        fl.raw_ = raw;
+        ll.layout_.push_back(std::move(fl));
+      } else {
+        for (auto &f : fields)
+          f = in.get_string();
+        ll.layout_.push_back(File_Line{linenum, File_Line::BITS{bits}, nullptr,
+                                       fields[0], fields[1], fields[2],
+                                       fields[3], fields[4], od});
+      }
+    }
+
+    std::uint64_t const num_tokens = in.get_uint();
+    if (num_tokens > text.size())
+      return false;
+    idx.tokens.emplace_back();
+    auto &tokens = idx.tokens.back();
+    tokens.reserve(num_tokens + 1);
+    for (std::uint64_t j = 0; in && j < num_tokens; ++j) {
+      Token_Text &tt = ll.fragments_.emplace_back();
+      tokens.push_back(std::prev(ll.fragments_.end()));
+      tt.token = static_cast<int>(in.get_int());
+      if (!Syntax_Tags::is_valid(tt.token))
+        return false;
+      tt.start_line = ll.start_line() + static_cast<int>(in.get_int());
+      tt.start_pos = static_cast<int>(in.get_int());
+      tt.mt_begin_line_ = static_cast<int>(in.get_int());
+      tt.mt_begin_col_ = static_cast<int>(in.get_int());
+      tt.mt_end_line_ = tt.mt_begin_line_ + static_cast<int>(in.get_int());
+      tt.mt_end_col_ = tt.mt_begin_col_ + static_cast<int>(in.get_int());
+      tt.pre_spaces_ = static_cast<int>(in.get_int());
+      tt.post_spaces_ = static_cast<int>(in.get_int());
+      std::uint64_t const text_code = in.get_uint();
+      if (text_code) {
+        tt.text_ = in.get_raw(text_code - 1);
+      } else {
+        if (tt.mt_begin_line_ < 0 ||
+            static_cast<std::uint64_t>(tt.mt_begin_line_) >= num_layout ||
+            tt.mt_begin_col_ < 0 || tt.mt_end_col_ < tt.mt_begin_col_)
+          return false;
+        std::string_view const mt =
+            ll.layout_[tt.mt_begin_line_].main_text.view();
+        if (static_cast<std::size_t>(tt.mt_end_col_) > mt.size())
+          return false;
+        tt.text_ =
+            mt.substr(tt.mt_begin_col_, tt.mt_end_col_ - tt.mt_begin_col_);
+      }
+    }
+    tokens.push_back(ll.fragments_.end());
+    if (flags & 4)
+      ll.init_stmts();
+    /* make_stmts() requires that suppressed lines have no statements */
+    if (ll.suppress && !ll.stmts().empty())
+      return false;
+  }
+  if (!in)
+    return false;
+
+  lf.make_stmts();
+  if (in.get_uint() != lf.ll_stmts.size())
+    return false;
+  stmts.reserve(lf.ll_stmts.size());
+  std::uint64_t line{0};
+  for (auto stmt = lf.ll_stmts.begin(); stmt != lf.ll_stmts.end(); ++stmt) {
+    stmts.push_back(stmt);
+    line += in.get_int();
+    if (!in || line >= idx.lines.size() || idx.lines[line] != stmt->it())
+      return false;
+    int const syntag = static_cast<int>(in.get_int());
+    if (!Syntax_Tags::is_valid(syntag))
+      return false;
+    if (in.get_uint()) {
+      Stmt::Stmt_Tree tree;
+      if (!decode_stmt_tree_(in, tree, nullptr, line, idx, 0))
+        return false;
+      stmt->set_stmt_tree(std::move(tree));
+    }
+    if (stmt->syntax_tag() != syntag)
+      stmt->set_stmt_syntag(syntag);
+  }
+  return bool(in);
+}
+
+/* Each Stmt_Tree node is its Node_Code and token_range, followed by the
+   branches.  Unless the Node_Code says that it is the same as its parent's,
+   the token_range is 0 if it has no Logical_Line, otherwise one more than
+   its size, then the line (relative to the statement's line) and, if it
+   isn't empty, the index of its first token. */
+bool Parse_Cache::encode_stmt_tree_(Byte_Writer &out,
+                                    Stmt::Stmt_Tree::node const &n,
+                                    LL_TT_Range const *const parent,
+                                    std::uint64_t const stmt_line,
+                                    Encode_Index const &idx) {
+  LL_TT_Range const &range = n->token_range;
+  bool const same_span =
+      parent && parent->ll_set_ == range.ll_set_ &&
+      (!range.ll_set_ ||
+       (!range.empty() && !parent->empty() && range.equal(*parent)));
+  Node_Code{n->syntag, n.num_branches(), same_span, false}.put(out);
+  if (same_span) {
+    /* Nothing more to say */
+  } else if (!range.ll_set_) {
+    out.put_uint(0);
+  } else {
+    out.put_uint(range.size() + 1);
+    auto const line = idx.lines.find(&range.ll());
+    if (line == idx.lines.end())
+      return false;
+    out.put_int(line->second - stmt_line);
+    if (!range.empty()) {
+      auto const tok = idx.tokens.find(&range.front());
+      if (tok == idx.tokens.end())
+        return false;
+      out.put_uint(tok->second);
+    }
+  }
+  if (n.is_fork()) {
+    for (auto const &b : n.branches())
+      if (!encode_stmt_tree_(out, b, &range, stmt_line, idx))
+        return false;
+  }
+  return true;
+}
+
+bool Parse_Cache::decode_stmt_tree_(Byte_Reader &in, Stmt::Stmt_Tree &t,
+                                    LL_TT_Range const *const parent,
+                                    std::uint64_t const stmt_line,
+                                    Decode_Index const &idx, int const depth) {
+  Node_Code code;
+  if (!code.get(in) || depth > max_depth_ ||
+      !Syntax_Tags::is_valid(code.syntag) || code.is_stmt ||
+      (code.same_span && !parent))
+    return false;
+  std::uint64_t const range_code = (code.same_span) ? 0 : in.get_uint();
+  if (!in)
+    return false;
+  LL_TT_Range range;
+  if (code.same_span) {
+    range = *parent;
+  } else if (range_code) {
+    std::uint64_t const line = stmt_line + in.get_int();
+    if (line >= idx.lines.size())
+      return false;
+    std::uint64_t const size = range_code - 1;
+    if (size == 0) {
+      range = LL_TT_Range{idx.lines[line], TT_Range{}};
+    } else {
+      auto const &tokens = idx.tokens[line];
+      std::uint64_t const begin = in.get_uint();
+      if (begin >= tokens.size() || size > tokens.size() - 1 - begin)
+        return false;
+      range = LL_TT_Range{idx.lines[line], tokens[begin], tokens[begin + size]};
+    }
+  }
+  t = Stmt::Stmt_Tree{Stmt::ST_Node_Data{code.syntag, std::move(range)}};
+  LL_TT_Range const &t_range = (*t)->token_range;
+  for (std::uint64_t i = 0; i < code.num_branches; ++i) {
+    Stmt::Stmt_Tree branch;
+    if (!decode_stmt_tree_(in, branch, &t_range, stmt_line, idx, depth + 1))
+      return false;
+    t.graft_back(std::move(branch));
+  }
+  return true;
+}
+} // namespace FLPR
@@ -0,0 +1,341 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Parse_Cache.hh
+*/
+
+#ifndef FLPR_PARSE_CACHE_HH
+#define FLPR_PARSE_CACHE_HH 1
+
+#include "flpr/Byte_Stream.hh"
+#include "flpr/Parsed_File.hh"
+#include "flpr/Text_Buffer.hh"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FLPR {
+
+//! A persistent, content-addressed cache of parsed files
+/*!
+  Scanning and parsing a file that hasn't changed since the last run gives
+  the same result every time.  A Parse_Cache keeps that result in a directory,
+  in a compact binary form, keyed by a hash of the file contents together with
+  the File_Type and fixed-format column limit.  Loading an unchanged file
+  rebuilds the Parsed_File from its entry, without lexing or parsing: the
+  File_Lines refer into the file's Text_Buffer, exactly as if they had been
+  scanned, and the statement and program trees are restored as they were.
+
+  The entries are independent of the file name, so identical files share an
+  entry.  They are written atomically, so several processes (or threads) can
+  share a directory.  When the entries take up more than max_bytes, the least
+  recently used ones are removed.  A writer that dies can leave a temporary
+  file behind: constructing a Parse_Cache removes those that haven't changed
+  for an hour.
+
+  An entry depends on the scanner and parsers that produced it, so the key
+  also includes parsers_id(): a hash of the library build (see FLPR_BUILD_ID
+  in src/flpr/CMakeLists.txt), the registered Syntax_Tags extensions, and the
+  number of Stmt::Parser_Exts of each kind.  Programs with different
+  extensions can share a directory, as their entries have different names.
+  The format_version covers the encoding itself.
+*/
+class Parse_Cache {
+public:
+  //! Counts of cache activity since construction
+  struct Stats {
+    std::uint64_t hits;      //!< loads that were restored from an entry
+    std::uint64_t misses;    //!< loads that had to scan and parse
+    std::uint64_t stores;    //!< entries written
+    std::uint64_t evictions; //!< entries removed to stay within max_bytes
+  };
+
+  //! Use (and create, if needed) the named directory
+  Parse_Cache(std::string directory, std::uintmax_t max_bytes);
+  Parse_Cache(Parse_Cache const &) = delete;
+  Parse_Cache &operator=(Parse_Cache const &) = delete;
+
+  //! Read a file, and return it with its statements and parse tree built
+  /*! The result is restored from the cache if possible, otherwise the file
+      is scanned and parsed as usual, and stored in the cache if that
+      succeeds.  If the file can't be read or parsed, the result is false
+      (see Parsed_File::operator bool()). */
+  template <typename PG_NODE_DATA = Prgm::Prgm_Node_Data>
+  Parsed_File<PG_NODE_DATA> load(std::string const &filename,
+                                 int const last_fixed_col,
+                                 File_Type file_type = File_Type::UNKNOWN);
+
+  //! Return the parsed contents of a Text_Buffer named buffer_name
+  template <typename PG_NODE_DATA = Prgm::Prgm_Node_Data>
+  Parsed_File<PG_NODE_DATA>
+  load(std::shared_ptr<Text_Buffer const> const &buffer,
+       std::string const &buffer_name, int const last_fixed_col,
+       File_Type file_type = File_Type::UNKNOWN);
+
+  Stats stats() const noexcept {
+    return Stats{hits_, misses_, stores_, evictions_};
+  }
+  std::string const &directory() const noexcept { return directory_; }
+  std::uintmax_t max_bytes() const noexcept { return max_bytes_; }
+  //! False if the directory couldn't be used (everything is a miss)
+  bool usable() const noexcept { return usable_; }
+  //! The threads that a miss may use to scan (see Logical_File)
+  /*! Leave this at 1 if several threads load through this Parse_Cache */
+  void set_scan_threads(int const num_threads) noexcept {
+    scan_threads_ = num_threads;
+  }
+  int scan_threads() const noexcept { return scan_threads_; }
+
+  //! Change this whenever the encoding changes
+  static constexpr std::uint64_t format_version = 3;
+  //! Identify the scanner, parsers and extensions that entries depend on
+  /*! This is computed for every load(), as extensions may be registered at
+      any time. */
+  static std::uint64_t parsers_id() noexcept;
+
+private:
+  //! Everything that an entry depends on
+  struct Key {
+    std::uint64_t hash;
+    std::uint64_t parsers;
+    std::uint64_t size;
+    File_Type file_type;
+    int last_fixed_col;
+  };
+
+  //! The statements of a file, numbered in order
+  using Stmt_Numbers = std::unordered_map<LL_Stmt const *, std::uint64_t>;
+  using Stmt_Iters = std::vector<LL_STMT_SEQ::iterator>;
+  //! The statement numbers [begin, end) that a Prgm_Tree node covers
+  struct Stmt_Span {
+    std::uint64_t begin{0};
+    std::uint64_t end{0};
+  };
+
+  static Key make_key_(Text_Buffer const &buffer, File_Type file_type,
+                       int last_fixed_col) noexcept;
+  std::string entry_path_(Key const &key) const;
+
+  /* Entry I/O, in Parse_Cache.cc */
+  std::shared_ptr<Text_Buffer const> read_entry_(std::string const &path);
+  void discard_entry_(std::string const &path);
+  void write_entry_(std::string const &path, std::string const &data);
+  void evict_();
+
+  /* The encoding of everything but the Prgm_Tree, in Parse_Cache.cc */
+  struct Encode_Index;
+  struct Decode_Index;
+  static void encode_header_(Byte_Writer &out, Key const &key);
+  static bool decode_header_(Byte_Reader &in, Key const &key);
+  static bool encode_file_(Byte_Writer &out, Logical_File const &lf,
+                           Text_Buffer const &buffer, Stmt_Numbers &numbers);
+  static bool decode_file_(Byte_Reader &in, Logical_File &lf,
+                           std::shared_ptr<Text_Buffer const> const &buffer,
+                           std::string const &buffer_name, Key const &key,
+                           Stmt_Iters &stmts);
+  static bool encode_stmt_tree_(Byte_Writer &out,
+                                Stmt::Stmt_Tree::node const &n,
+                                LL_TT_Range const *const parent,
+                                std::uint64_t const stmt_line,
+                                Encode_Index const &idx);
+  static bool decode_stmt_tree_(Byte_Reader &in, Stmt::Stmt_Tree &t,
+                                LL_TT_Range const *const parent,
+                                std::uint64_t const stmt_line,
+                                Decode_Index const &idx, int depth);
+
+  /* The Prgm_Tree encoding, which depends on PG_NODE_DATA */
+  template <typename NODE>
+  static bool encode_prgm_(Byte_Writer &out, NODE const &n,
+                           Stmt_Numbers const &numbers);
+  template <typename PG_NODE_DATA>
+  static bool decode_prgm_(Byte_Reader &in,
+                           typename Parsed_File<PG_NODE_DATA>::Parse_Tree &t,
+                           Stmt_Iters const &stmts, Stmt_Span &span,
+                           int depth);
+
+  template <typename PG_NODE_DATA>
+  bool restore_(Byte_Reader &in, Parsed_File<PG_NODE_DATA> &pf,
+                Stmt_Iters const &stmts);
+  template <typename PG_NODE_DATA>
+  void store_(std::string const &path, Key const &key,
+              Text_Buffer const &buffer, Parsed_File<PG_NODE_DATA> &pf);
+
+private:
+  std::string const directory_;
+  std::uintmax_t const max_bytes_;
+  bool usable_{false};
+  int scan_threads_{1};
+  //! An estimate of the size of the entries, to decide when to evict
+  std::atomic<std::uintmax_t> total_bytes_{0};
+  std::mutex evict_mutex_;
+  std::atomic<std::uint64_t> hits_{0}, misses_{0}, stores_{0}, evictions_{0};
+
+  //! Deeper trees than this are taken to be corrupt
+  static constexpr int max_depth_ = 1000;
+};
+
+template <typename PG_NODE_DATA>
+Parsed_File<PG_NODE_DATA> Parse_Cache::load(std::string const &filename,
+                                            int const last_fixed_col,
+                                            File_Type file_type) {
+  auto buffer = Text_Buffer::from_file(filename);
+  if (!buffer) {
+    std::cerr << "Parse_Cache::load: unable to open file \"" << filename
+              << "\" for reading\n";
+    return Parsed_File<PG_NODE_DATA>{};
+  }
+  return load<PG_NODE_DATA>(buffer, filename, last_fixed_col, file_type);
+}
+
+template <typename PG_NODE_DATA>
+Parsed_File<PG_NODE_DATA>
+Parse_Cache::load(std::shared_ptr<Text_Buffer const> const &buffer,
+                  std::string const &buffer_name, int const last_fixed_col,
+                  File_Type file_type) {
+  /* Resolve the type here, as it is part of the key */
+  file_type = File_Info{buffer_name, file_type}.file_type;
+  Key const key = make_key_(*buffer, file_type, last_fixed_col);
+  std::string const path = entry_path_(key);
+
+  if (usable_) {
+    if (auto entry = read_entry_(path)) {
+      Byte_Reader in{entry->text()};
+      Logical_File lf;
+      Stmt_Iters stmts;
+      if (decode_header_(in, key) &&
+          decode_file_(in, lf, buffer, buffer_name, key, stmts)) {
+        Parsed_File<PG_NODE_DATA> pf{std::move(lf)};
+        if (restore_(in, pf, stmts)) {
+          hits_ += 1;
+          return pf;
+        }
+      }
+      discard_entry_(path);
+    }
+  }
+
+  misses_ += 1;
+  Logical_File lf;
+  lf.set_scan_threads(scan_threads_);
+  if (!lf.scan(buffer, buffer_name, last_fixed_col, file_type))
+    return Parsed_File<PG_NODE_DATA>{};
+  Parsed_File<PG_NODE_DATA> pf{std::move(lf)};
+  if (pf.prefetch_parse_tree() && pf && usable_)
+    store_(path, key, *buffer, pf);
+  return pf;
+}
+
+/* Finish a Parsed_File whose Logical_File has been decoded, by restoring
+   its parse tree */
+template <typename PG_NODE_DATA>
+bool Parse_Cache::restore_(Byte_Reader &in, Parsed_File<PG_NODE_DATA> &pf,
+                           Stmt_Iters const &stmts) {
+  typename Parsed_File<PG_NODE_DATA>::Parse_Tree tree;
+  {
+    Arena::Scope arena_scope{pf.logical_file_.arena.get()};
+    Stmt_Span span;
+    if (in.get_uint() && !decode_prgm_<PG_NODE_DATA>(in, tree, stmts, span, 0))
+      return false;
+  }
+  if (!in || !in.at_end())
+    return false;
+  pf.parse_tree_.swap(tree);
+  if (!pf.parse_tree_.empty())
+    pf.link_stmts_recurse_(*pf.parse_tree_);
+  pf.stmts_ok_ = true;
+  pf.tree_ok_ = true;
+  pf.arena_tree_ = true;
+  pf.tree_edit_count_ = pf.logical_file_.edit_count();
+  return true;
+}
+
+template <typename PG_NODE_DATA>
+void Parse_Cache::store_(std::string const &path, Key const &key,
+                         Text_Buffer const &buffer,
+                         Parsed_File<PG_NODE_DATA> &pf) {
+  Byte_Writer out;
+  Stmt_Numbers numbers;
+  encode_header_(out, key);
+  if (!encode_file_(out, pf.logical_file(), buffer, numbers))
+    return;
+  auto const &tree = pf.parse_tree();
+  out.put_uint(!tree.empty());
+  if (!tree.empty() && !encode_prgm_(out, *tree, numbers))
+    return;
+  write_entry_(path, out.str());
+}
+
+/* Each node is its Node_Code, then, for a statement, its number.  The
+   branches follow in order.  The decoder checks that the statements of each
+   branch follow on from (or end with) those of the branches before it, as
+   cover_branches() requires. */
+template <typename NODE>
+bool Parse_Cache::encode_prgm_(Byte_Writer &out, NODE const &n,
+                               Stmt_Numbers const &numbers) {
+  Node_Code{n->syntag(), n.num_branches(), false, n->is_stmt()}.put(out);
+  if (n->is_stmt()) {
+    auto const num = numbers.find(&n->ll_stmt());
+    if (num == numbers.end())
+      return false;
+    out.put_uint(num->second);
+  }
+  if (n.is_fork()) {
+    for (auto const &b : n.branches())
+      if (!encode_prgm_(out, b, numbers))
+        return false;
+  }
+  return true;
+}
+
+template <typename PG_NODE_DATA>
+bool Parse_Cache::decode_prgm_(
+    Byte_Reader &in, typename Parsed_File<PG_NODE_DATA>::Parse_Tree &t,
+    Stmt_Iters const &stmts, Stmt_Span &span, int const depth) {
+  using Parse_Tree = typename Parsed_File<PG_NODE_DATA>::Parse_Tree;
+  using Parse = typename Parsed_File<PG_NODE_DATA>::Parse;
+  Node_Code code;
+  if (!code.get(in) || depth > max_depth_ ||
+      !Syntax_Tags::is_valid(code.syntag) || code.same_span ||
+      (code.is_stmt && code.num_branches))
+    return false;
+  if (code.is_stmt) {
+    std::uint64_t const stmt_num = in.get_uint();
+    if (!in || stmt_num >= stmts.size())
+      return false;
+    span = Stmt_Span{stmt_num, stmt_num + 1};
+    t = Parse_Tree{code.syntag, stmts[stmt_num]};
+  } else {
+    t = Parse_Tree{code.syntag};
+  }
+  for (std::uint64_t i = 0; i < code.num_branches; ++i) {
+    Parse_Tree branch;
+    Stmt_Span b;
+    if (!decode_prgm_<PG_NODE_DATA>(in, branch, stmts, b, depth + 1))
+      return false;
+    if (span.begin == span.end)
+      span = b;
+    else if (b.begin == span.end)
+      span.end = b.end;
+    else if (b.begin != b.end && b.end != span.end)
+      return false;
+    t.graft_back(std::move(branch));
+  }
+  Parse::cover_branches(*t);
+  return true;
+}
+
+} // namespace FLPR
+#endif
@@ -20,14 +20,23 @@
 #include "flpr/Logical_File.hh"
 #include "flpr/Prgm_Parsers.hh"
 #include "flpr/Prgm_Tree.hh"
+#include "flpr/Stmt_Index.hh"
+#include "flpr/Stmt_Tree_Budget.hh"
+#include "flpr/Work_Stealing_Pool.hh"
+#include "flpr/parse_stmt.hh"
+#include <algorithm>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace FLPR {
+class Parse_Cache;
 
 //! A lazy-evaluation container for all FLPR constructs related to a file
 template <typename PG_NODE_DATA = Prgm::Prgm_Node_Data> class Parsed_File {
 public:
+  friend class Parse_Cache;
   using Parse = FLPR::Prgm::Parsers<PG_NODE_DATA>;
   using Parse_Tree = typename Parse::Prgm_Tree;
   using Prgm_Cursor = typename Parse_Tree::cursor_t;
@@ -54,6 +63,13 @@ public:
                        int const last_fixed_col,
                        File_Type stream_type = File_Type::UNKNOWN);
 
+  //! Take over a Logical_File that has already been scanned
+  /*! Unit_Stream uses this to present each program unit of a file.  The
+      Parsed_File is in a bad state if the scan of lf failed. */
+  explicit Parsed_File(Logical_File &&lf)
+      : logical_file_{std::move(lf)}, bad_state_{!logical_file_.file_info ||
+                                                 logical_file_.scan_failed} {}
+
   Parsed_File() = default;
   Parsed_File(Parsed_File &&) = default;
   Parsed_File(Parsed_File const &) = delete;
@@ -88,9 +104,16 @@ public:
   }
 
   //! Build the parse tree, if needed.
+  /*! If statements have been edited (see Logical_File::mark_edited()) since
+      the tree was built, only the constructs that contain the edits are
+      re-parsed and spliced into the existing tree.  Cursors to nodes outside
+      of those constructs remain valid, as do cursors to the construct nodes
+      themselves, but cursors to their descendants do not. */
   bool prefetch_parse_tree() {
     if (!tree_ok_)
       build_tree_();
+    else if (tree_edit_count_ != logical_file_.edit_count())
+      update_tree_();
     return tree_ok_;
   }
 
@@ -117,13 +140,84 @@ public:
     return Prgm_Cursor();
   }
 
+  //! Build the Stmt_Index (and the parse tree), if needed.
+  bool prefetch_stmt_index() {
+    if (!prefetch_parse_tree())
+      return false;
+    if (!index_ok_) {
+      stmt_index_.build(logical_file_.ll_stmts);
+      index_ok_ = true;
+    }
+    return true;
+  }
+
+  //! Build/return the index of the statements by syntag and by name
+  /*! The index is only built on request.  From then on, each update of the
+      parse tree re-indexes the statements that were edited, so lookups
+      stay cheap across edits.  Use stmt_to_node_cursor() to get from the
+      statements to the Prgm_Tree. */
+  Stmt_Index const &stmt_index() {
+    prefetch_stmt_index();
+    return stmt_index_;
+  }
+
+  //! Limit the memory held in the statements' Stmt_Trees (0 for no limit)
+  /*! Normally every statement keeps the Stmt_Tree that the program parsers
+      built for it.  With a budget, the trees are dropped once the parse
+      tree is built (or updated), leaving just the statement syntags, and
+      stmt_tree() rebuilds them on demand, holding at most max_bytes of the
+      most recently used ones.  See Stmt_Tree_Budget for the caveats.  Set
+      the budget before the parse tree is built, as trees that were built
+      in the Logical_File Arena don't give their memory back. */
+  void set_stmt_tree_budget(size_t const max_bytes);
+  //! Use num_threads to parse the statements ahead of the program parsers
+  /*! With more than one thread, building the parse tree starts by running
+      the statement parsers on every statement, in parallel (see
+      LL_Stmt::prefetch_parses()), so that the program parsers only have to
+      assemble the results.  This does more parsing in total, but it uses
+      the other cores when one large file dominates.  Scan the
+      Logical_File with Logical_File::set_scan_threads() to tokenize in
+      parallel as well. */
+  void set_parse_threads(int const num_threads) noexcept {
+    parse_threads_ = num_threads;
+  }
+  constexpr int parse_threads() const noexcept { return parse_threads_; }
+
+  //! The Stmt_Tree_Budget, or nullptr if there is no limit
+  Stmt_Tree_Budget const *stmt_tree_budget() const noexcept {
+    return tree_budget_.get();
+  }
+
+  //! Return a Prgm_Tree cursor for each of a list of statements
+  std::vector<Prgm_Cursor>
+  stmts_to_node_cursors(Stmt_Index::Stmt_List const &stmts) {
+    std::vector<Prgm_Cursor> result;
+    result.reserve(stmts.size());
+    for (auto const &stmt : stmts)
+      result.push_back(stmt_to_node_cursor(stmt));
+    return result;
+  }
+
 private:
+  /* The statements refer to the budget, so it has to be destroyed after
+     logical_file_ */
+  std::unique_ptr<Stmt_Tree_Budget> tree_budget_;
   mutable Logical_File logical_file_;
   mutable Parse_Tree parse_tree_;
+  Stmt_Index stmt_index_;
   bool from_stream_{false};
   mutable bool bad_state_{true}, stmts_ok_{false}, tree_ok_{false};
+  bool index_ok_{false};
+  int parse_threads_{1};
+  //! The Logical_File::edit_count() that parse_tree_ reflects
+  size_t tree_edit_count_{0};
+  //! True once a parse tree has been built in the Logical_File Arena
+  bool arena_tree_{false};
 
 private:
+  using Node = typename Parse_Tree::node;
+  using Node_Parser = typename Parse::PP_Result (*)(typename Parse::State &);
+
   void link_stmts_recurse_(typename Parse_Tree::node &n);
   void build_stmts_() {
     if (!bad_state_) {
@@ -132,6 +226,13 @@ private:
     }
   }
   void build_tree_();
+  void prefetch_stmt_trees_();
+  void update_tree_();
+  Node *reparse_around_(LL_STMT_SEQ::iterator first,
+                        LL_STMT_SEQ::iterator last);
+  void cover_ancestors_(std::vector<std::vector<Node *>> const &paths);
+  static Node_Parser node_parser_(int const syntag) noexcept;
+  static bool in_label_do_(Node &n);
   bool indent_recurse_(typename Parse_Tree::node &n,
                        Indent_Table const &indents, int curr_spaces);
 };
@@ -175,19 +276,310 @@ template <typename PG_NODE_DATA> void Parsed_File<PG_NODE_DATA>::build_tree_() {
   if (statements().empty()) {
     parse_tree_ = Parse_Tree{};
   } else {
-
+    /* parse_tree_ is destroyed before logical_file_, so the first tree can
+       share the Logical_File Arena.  A tree that replaces it comes from the
+       heap, so that the next replacement gives the memory back. */
+    Arena::Scope arena_scope{arena_tree_ ? nullptr
+                                         : logical_file_.arena.get()};
+    arena_tree_ = true;
+    /* Tag each statement with its leading token, so that the program parsers
+       can skip the statement parsers that can't match it.  Any uplinks are
+       into the tree that is about to be replaced. */
+    for (LL_Stmt &stmt : statements()) {
+      stmt.unhook();
+      stmt.preclassify();
+      stmt.set_tree_budget(tree_budget_.get());
+    }
+    if (parse_threads_ > 1)
+      prefetch_stmt_trees_();
     typename Parse::State state(statements());
     auto result{Parse::program(state)};
     if (!result.match) {
       std::cerr << "\tparsing FAILED" << std::endl;
       bad_state_ = true;
     }
+    for (LL_Stmt &stmt : statements())
+      stmt.end_parses();
     parse_tree_.swap(result.parse_tree);
-    link_stmts_recurse_(*parse_tree_);
+    if (!parse_tree_.empty())
+      link_stmts_recurse_(*parse_tree_);
   }
+  if (tree_budget_)
+    tree_budget_->release_all();
+  tree_edit_count_ = logical_file_.edit_count();
   tree_ok_ = true;
 }
 
+/* Each task prefetches a contiguous run of statements, and there are a few
+   tasks per thread so that the work stealing can even out the load */
+template <typename PG_NODE_DATA>
+void Parsed_File<PG_NODE_DATA>::prefetch_stmt_trees_() {
+  std::vector<LL_Stmt *> stmts;
+  for (LL_Stmt &stmt : statements())
+    stmts.push_back(&stmt);
+  auto const &parsers{Stmt::program_stmt_parsers()};
+  size_t const num_tasks =
+      std::min(stmts.size(), 8 * static_cast<size_t>(parse_threads_));
+  std::vector<Work_Stealing_Pool::Task> tasks;
+  for (size_t t = 0; t < num_tasks; ++t) {
+    size_t const begin = (stmts.size() * t) / num_tasks;
+    size_t const end = (stmts.size() * (t + 1)) / num_tasks;
+    tasks.emplace_back([&stmts, &parsers, begin, end]() {
+      for (size_t i = begin; i < end; ++i)
+        stmts[i]->prefetch_parses(parsers);
+    });
+  }
+  Work_Stealing_Pool pool(parse_threads_);
+  pool.run(std::move(tasks));
+}
+
+/* The edited statements are the ones without an uplink into parse_tree_.
+   Each run of them is handed to reparse_around_(), and if that can't find a
+   construct to re-parse, the whole tree is rebuilt. */
+template <typename PG_NODE_DATA>
+void Parsed_File<PG_NODE_DATA>::update_tree_() {
+  tree_edit_count_ = logical_file_.edit_count();
+  if (bad_state_)
+    return;
+  if (parse_tree_.empty()) {
+    build_tree_();
+    if (index_ok_)
+      stmt_index_.build(logical_file_.ll_stmts);
+    return;
+  }
+
+  LL_STMT_SEQ &stmts{logical_file_.ll_stmts};
+  /* Note the edited statements for the Stmt_Index, which can only look at
+     them once they have been re-parsed */
+  std::vector<LL_STMT_SEQ::iterator> edited;
+  if (index_ok_) {
+    for (auto it = stmts.begin(); it != stmts.end(); ++it)
+      if (!it->has_hook())
+        edited.push_back(it);
+  }
+  /* The ancestors of each re-parsed construct, from its parent up */
+  std::vector<std::vector<Node *>> paths;
+  bool spliced{true};
+  {
+    /* The constructs that these replace may be replaced in turn, so they
+       come from the heap rather than the Logical_File Arena */
+    Arena::Scope arena_scope{nullptr};
+    auto first = stmts.begin();
+    while (spliced && first != stmts.end()) {
+      if (first->has_hook()) {
+        ++first;
+        continue;
+      }
+      auto last = first;
+      while (last != stmts.end() && !last->has_hook()) {
+        last->preclassify();
+        last->set_tree_budget(tree_budget_.get());
+        ++last;
+      }
+      Node *const n = reparse_around_(first, last);
+      spliced = (n != nullptr);
+      if (spliced) {
+        /* n replaces any constructs re-parsed for earlier runs within it */
+        for (auto &p : paths) {
+          auto const it = std::find(p.begin(), p.end(), n);
+          if (it != p.end())
+            p.erase(p.begin(), std::next(it));
+        }
+        paths.emplace_back();
+        for (Node *a = n; !a->is_root();) {
+          a = &(*a->trunk());
+          paths.back().push_back(a);
+        }
+      }
+      first = last;
+    }
+  }
+  if (!spliced)
+    build_tree_();
+  else
+    cover_ancestors_(paths);
+  for (auto const &it : edited)
+    stmt_index_.update(it);
+  if (tree_budget_)
+    tree_budget_->release_all();
+}
+
+template <typename PG_NODE_DATA>
+void Parsed_File<PG_NODE_DATA>::set_stmt_tree_budget(size_t const max_bytes) {
+  if (max_bytes == 0) {
+    if (tree_budget_) {
+      for (LL_Stmt &stmt : logical_file_.ll_stmts)
+        stmt.set_tree_budget(nullptr);
+      tree_budget_.reset();
+    }
+    return;
+  }
+  if (tree_budget_) {
+    tree_budget_->set_max_bytes(max_bytes);
+    return;
+  }
+  tree_budget_ = std::make_unique<Stmt_Tree_Budget>(max_bytes);
+  for (LL_Stmt &stmt : logical_file_.ll_stmts)
+    stmt.set_tree_budget(tree_budget_.get());
+}
+
+/* Update the stmt_ranges of the ancestors of the re-parsed constructs.  This
+   waits until every run has been re-parsed, as until then a construct that
+   has had statements inserted into it has the wrong size, and it goes from
+   the deepest ancestors up, so that each is covered after its branches. */
+template <typename PG_NODE_DATA>
+void Parsed_File<PG_NODE_DATA>::cover_ancestors_(
+    std::vector<std::vector<Node *>> const &paths) {
+  std::vector<std::pair<size_t, Node *>> stale;
+  for (auto const &p : paths)
+    for (size_t i = 0; i < p.size(); ++i)
+      stale.emplace_back(p.size() - i, p[i]);
+  std::sort(stale.begin(), stale.end(),
+            [](auto const &a, auto const &b) { return a.first > b.first; });
+  stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+  for (auto const &depth_node : stale)
+    Parse::cover_branches(*depth_node.second);
+}
+
+/* Re-parse the smallest construct that contains the edited statements
+   [first, last) and the (unedited) statements on either side of them.  The
+   new subtree replaces the contents of the construct node, which is
+   returned.  The stmt_ranges of its ancestors are left for
+   cover_ancestors_().  Returns nullptr if nothing short of the whole program
+   would do. */
+template <typename PG_NODE_DATA>
+auto Parsed_File<PG_NODE_DATA>::reparse_around_(LL_STMT_SEQ::iterator first,
+                                                LL_STMT_SEQ::iterator last)
+    -> Node * {
+  LL_STMT_SEQ &stmts{logical_file_.ll_stmts};
+  if (first == stmts.begin() || last == stmts.end())
+    return nullptr;
+
+  /* Find the lowest common ancestor of the neighboring statements */
+  std::vector<Node *> before_path;
+  for (Node *n = static_cast<Node *>(std::prev(first)->get_hook());;
+       n = &(*n->trunk())) {
+    before_path.push_back(n);
+    if (n->is_root())
+      break;
+  }
+  Node *n = static_cast<Node *>(last->get_hook());
+  while (std::find(before_path.begin(), before_path.end(), n) ==
+         before_path.end())
+    n = &(*n->trunk());
+
+  for (; !n->is_root(); n = &(*n->trunk())) {
+    Node_Parser const parser = node_parser_((*n)->syntag());
+    if (!parser || in_label_do_(*n))
+      continue;
+    /* The stmt_range of n doesn't know about any inserted statements, but
+       its begin and end iterators still bracket them. */
+    auto const range_begin{(*n)->stmt_range().begin()};
+    auto const range_end{(*n)->stmt_range().end()};
+    typename Parse::State state(SL_Range<LL_Stmt>(range_begin, range_end));
+    state.quiet = true;
+    auto result{parser(state)};
+    for (auto it = range_begin; it != range_end; ++it)
+      it->end_parses();
+    if (!result.match || state.ss || result.parse_tree.empty() ||
+        (*result.parse_tree)->syntag() == Syntax_Tags::HOIST)
+      continue;
+
+    n->swap(*result.parse_tree);
+    link_stmts_recurse_(*n);
+    return n;
+  }
+  return nullptr;
+}
+
+/* The parsers that can rebuild a node with the given syntag on their own */
+template <typename PG_NODE_DATA>
+auto Parsed_File<PG_NODE_DATA>::node_parser_(int const syntag) noexcept
+    -> Node_Parser {
+  switch (syntag) {
+  case Syntax_Tags::PG_ASSOCIATE_CONSTRUCT:
+    return Parse::associate_construct;
+  case Syntax_Tags::PG_BLOCK:
+    return Parse::block;
+  case Syntax_Tags::PG_BLOCK_CONSTRUCT:
+    return Parse::block_construct;
+  case Syntax_Tags::PG_CASE_CONSTRUCT:
+    return Parse::case_construct;
+  case Syntax_Tags::PG_DERIVED_TYPE_DEF:
+    return Parse::derived_type_def;
+  case Syntax_Tags::PG_DO_CONSTRUCT:
+  case Syntax_Tags::PG_NONBLOCK_DO_CONSTRUCT:
+    return Parse::do_construct;
+  case Syntax_Tags::PG_ENUM_DEF:
+    return Parse::enum_def;
+  case Syntax_Tags::PG_EXECUTABLE_CONSTRUCT:
+    return Parse::executable_construct;
+  case Syntax_Tags::PG_EXECUTION_PART:
+    return Parse::execution_part;
+  case Syntax_Tags::PG_EXECUTION_PART_CONSTRUCT:
+    return Parse::execution_part_construct;
+  case Syntax_Tags::PG_EXTERNAL_SUBPROGRAM:
+    return Parse::external_subprogram;
+  case Syntax_Tags::PG_FORALL_CONSTRUCT:
+    return Parse::forall_construct;
+  case Syntax_Tags::PG_FUNCTION_SUBPROGRAM:
+    return Parse::function_subprogram;
+  case Syntax_Tags::PG_IF_CONSTRUCT:
+    return Parse::if_construct;
+  case Syntax_Tags::PG_INTERFACE_BLOCK:
+    return Parse::interface_block;
+  case Syntax_Tags::PG_INTERNAL_SUBPROGRAM:
+    return Parse::internal_subprogram;
+  case Syntax_Tags::PG_INTERNAL_SUBPROGRAM_PART:
+    return Parse::internal_subprogram_part;
+  case Syntax_Tags::PG_MAIN_PROGRAM:
+    return Parse::main_program;
+  case Syntax_Tags::PG_MODULE:
+    return Parse::module;
+  case Syntax_Tags::PG_MODULE_SUBPROGRAM:
+    return Parse::module_subprogram;
+  case Syntax_Tags::PG_MODULE_SUBPROGRAM_PART:
+    return Parse::module_subprogram_part;
+  case Syntax_Tags::PG_PROGRAM_UNIT:
+    return Parse::program_unit;
+  case Syntax_Tags::PG_SELECT_RANK_CONSTRUCT:
+    return Parse::select_rank_construct;
+  case Syntax_Tags::PG_SELECT_TYPE_CONSTRUCT:
+    return Parse::select_type_construct;
+  case Syntax_Tags::PG_SEPARATE_MODULE_SUBPROGRAM:
+    return Parse::separate_module_subprogram;
+  case Syntax_Tags::PG_SPECIFICATION_PART:
+    return Parse::specification_part;
+  case Syntax_Tags::PG_SUBROUTINE_SUBPROGRAM:
+    return Parse::subroutine_subprogram;
+  case Syntax_Tags::PG_WHERE_CONSTRUCT:
+    return Parse::where_construct;
+  }
+  return nullptr;
+}
+
+/* True if n is inside of a do-construct that begins with a label-do-stmt.
+   How those parse depends on the labels of all of the enclosing loops, so
+   they can't be re-parsed in isolation. */
+template <typename PG_NODE_DATA>
+bool Parsed_File<PG_NODE_DATA>::in_label_do_(Node &n) {
+  for (Node *a = &n; !a->is_root();) {
+    a = &(*a->trunk());
+    int const tag = (*a)->syntag();
+    if (tag == Syntax_Tags::PG_NONBLOCK_DO_CONSTRUCT)
+      return true;
+    if (tag == Syntax_Tags::PG_DO_CONSTRUCT) {
+      Node *do_stmt = a;
+      while (!do_stmt->is_leaf())
+        do_stmt = &do_stmt->branches().front();
+      if ((*do_stmt)->is_stmt() &&
+          Stmt::get_label_do_label((*do_stmt)->ll_stmt().stmt_tree()) > 0)
+        return true;
+    }
+  }
+  return false;
+}
+
 template <typename PG_NODE_DATA>
 void Parsed_File<PG_NODE_DATA>::link_stmts_recurse_(
     typename Parse_Tree::node &n) {
@@ -50,6 +50,8 @@ template <typename Node_Data = Prgm_Node_Data> struct Parsers {
         : stmt_range_(ll_stmt_range), ss{stmt_range_} {}
     SL_Range_Iterator<LL_Stmt> ss;
     Label_Stack do_label_stack;
+    //! Don't report unrecognized statements on std::cerr
+    bool quiet{false};
   };
 
   static PP_Result associate_construct(State &state);
@@ -130,9 +130,11 @@ class End_Of_Stream_Parser {
 public:
   PP_Result operator()(State &state) const noexcept {
     if (state.ss) {
-      std::cerr << "Unrecognized statement\n";
-      state.ss->print_me(std::cerr, false)
-          << "\nwhen expecting end-of-stream " << std::endl;
+      if (!state.quiet) {
+        std::cerr << "Unrecognized statement\n";
+        state.ss->print_me(std::cerr, false)
+            << "\nwhen expecting end-of-stream " << std::endl;
+      }
       return PP_Result{Prgm_Tree{}, false};
     }
     return PP_Result{Prgm_Tree{}, true};
@@ -267,9 +269,11 @@ public:
     };
     bool const match = std::apply(fold, parsers_);
     if (!match) {
-      std::cerr << "Unrecognized statement\n";
-      state.ss->print_me(std::cerr, false) << "\nwhile parsing ";
-      FLPR::Syntax_Tags::print(std::cerr, syntag_) << std::endl;
+      if (!state.quiet) {
+        std::cerr << "Unrecognized statement\n";
+        state.ss->print_me(std::cerr, false) << "\nwhile parsing ";
+        FLPR::Syntax_Tags::print(std::cerr, syntag_) << std::endl;
+      }
       return PP_Result{};
     }
     if (root)
@@ -323,9 +327,11 @@ public:
     if (attach_if(parser0_)) {
       bool const match = std::apply(fold, rest_);
       if (!match) {
-        std::cerr << "Unrecognized statement\n";
-        state.ss->print_me(std::cerr, false) << "\nwhile parsing ";
-        FLPR::Syntax_Tags::print(std::cerr, syntag_) << std::endl;
+        if (!state.quiet) {
+          std::cerr << "Unrecognized statement\n";
+          state.ss->print_me(std::cerr, false) << "\nwhile parsing ";
+          FLPR::Syntax_Tags::print(std::cerr, syntag_) << std::endl;
+        }
         return PP_Result{};
       }
       if (root)
@@ -393,14 +399,12 @@ public:
   Statement_Parser(Statement_Parser const &) = default;
   constexpr explicit Statement_Parser(parser_function f) noexcept : f_{f} {}
   PP_Result operator()(State &state) const noexcept {
-    FLPR::TT_Stream tts(*(state.ss));
-    FLPR::Stmt::Stmt_Tree st = f_(tts);
-    if (!st)
+    /* The LL_Stmt remembers earlier attempts, so backtracking is cheap */
+    if (!state.ss->parse_with(f_))
       return PP_Result{};
-    int const tag = (*st)->syntag;
+    int const tag = (*state.ss->stmt_tree())->syntag;
     FLPR::LL_STMT_SEQ::iterator ll_stmt_it{state.ss};
     state.ss.advance();
-    ll_stmt_it->set_stmt_tree(std::move(st));
     return PP_Result{Prgm_Tree{tag, ll_stmt_it}, true};
   }
 
@@ -497,13 +501,11 @@ public:
   PP_Result operator()(State &state) const noexcept {
 
     /****************************** DO-STMT ***********************************/
-    FLPR::Stmt::Stmt_Tree do_stmt_tree;
-    {
-      FLPR::TT_Stream tts(*(state.ss));
-      do_stmt_tree = FLPR::Stmt::do_stmt(tts);
-    }
-    if (!do_stmt_tree)
+    /* on a match, this attaches the Stmt_Tree to the LL_Stmt */
+    if (!state.ss->parse_with(FLPR::Stmt::do_stmt))
       return PP_Result{}; // nope
+    FLPR::LL_STMT_SEQ::iterator do_stmt_it{state.ss};
+    FLPR::Stmt::Stmt_Tree const &do_stmt_tree = do_stmt_it->stmt_tree();
 
     int do_construct_tag{TAG(UNKNOWN)};
     int do_stmt_tag = (*do_stmt_tree)->syntag;
@@ -513,10 +515,6 @@ public:
     if (label > 0)
       state.do_label_stack.push(label);
 
-    /* attach the Stmt_Tree to the LL_Stmt */
-    FLPR::LL_STMT_SEQ::iterator do_stmt_it{state.ss};
-    do_stmt_it->set_stmt_tree(std::move(do_stmt_tree));
-
     state.ss.advance();
 
     /************************** BLOCK or DO-BLOCK *****************************/
@@ -543,20 +541,17 @@ public:
 
     /*********************** TERMINATING STATEMENT ****************************/
 
-    FLPR::TT_Stream tts(*(state.ss));
     FLPR::LL_STMT_SEQ::iterator end_stmt_it{state.ss};
     int end_stmt_pg_tag{TAG(UNKNOWN)};
     int end_stmt_sg_tag{TAG(UNKNOWN)};
 
     /* Without a label, the only end-do this can be is a end-do-statment */
     if (!state.ss->has_label()) {
-      FLPR::Stmt::Stmt_Tree end_stmt_tree{FLPR::Stmt::end_do_stmt(tts)};
-      if (!end_stmt_tree)
+      if (!end_stmt_it->parse_with(FLPR::Stmt::end_do_stmt))
         return PP_Result{}; // wasn't end-do-stmt, so match fails
-      end_stmt_sg_tag = (*end_stmt_tree)->syntag;
+      end_stmt_sg_tag = (*end_stmt_it->stmt_tree())->syntag;
       end_stmt_pg_tag = TAG(HOIST);
       do_construct_tag = TAG(PG_DO_CONSTRUCT);
-      end_stmt_it->set_stmt_tree(std::move(end_stmt_tree));
       state.ss.advance();
     } else {
       /* So, we've got a label. Let NL be the number of instances of this
@@ -581,11 +576,10 @@ public:
         /* this is a do-term-shared-stmt, and the first N-1 label-do-stmts that
            we are closing off are inner-shared-do-constructs and the last one is
            an outer-shared-do-construct form of a nonblock-do-construct. */
-        FLPR::Stmt::Stmt_Tree end_stmt_tree{FLPR::Stmt::action_stmt(tts)};
-        if (!end_stmt_tree)
+        if (!end_stmt_it->parse_with(FLPR::Stmt::action_stmt))
           return PP_Result{};
 
-        end_stmt_sg_tag = (*end_stmt_tree)->syntag;
+        end_stmt_sg_tag = (*end_stmt_it->stmt_tree())->syntag;
         end_stmt_pg_tag = TAG(PG_DO_TERM_SHARED_STMT);
 
         /* We don't advance the stream until we reach the do-stmt of the
@@ -593,8 +587,6 @@ public:
            the same label, as this statement will still be in the stream for the
            next do-construct termination.  */
         if (level == 1) {
-          /* just attach the statement tree once, on the outer end_stmt */
-          end_stmt_it->set_stmt_tree(std::move(end_stmt_tree));
           do_construct_tag = TAG(PG_OUTER_SHARED_DO_CONSTRUCT);
           state.ss.advance();
         } else {
@@ -604,21 +596,20 @@ public:
         /* we're left with this being either a label-do-stmt form of
            block-do-construct, or an action-term-do-construct form of a
            nonblock-do-construct. */
-        FLPR::Stmt::Stmt_Tree end_stmt_tree{FLPR::Stmt::end_do(tts)};
-        if (!end_stmt_tree) {
+        bool matched = end_stmt_it->parse_with(FLPR::Stmt::end_do);
+        if (!matched) {
           /* It isn't end-do-stmt or continue-stmt, so this should be an
              do-term-action-stmt, which closes an action-term-do-construct */
-          end_stmt_tree = FLPR::Stmt::action_stmt(tts);
+          matched = end_stmt_it->parse_with(FLPR::Stmt::action_stmt);
           do_construct_tag = TAG(PG_ACTION_TERM_DO_CONSTRUCT);
           end_stmt_pg_tag = TAG(PG_DO_TERM_ACTION_STMT);
         } else {
           do_construct_tag = TAG(PG_DO_CONSTRUCT);
           end_stmt_pg_tag = TAG(HOIST);
         }
-        if (!end_stmt_tree)
+        if (!matched)
           return PP_Result{};
-        end_stmt_sg_tag = (*end_stmt_tree)->syntag;
-        end_stmt_it->set_stmt_tree(std::move(end_stmt_tree));
+        end_stmt_sg_tag = (*end_stmt_it->stmt_tree())->syntag;
         state.ss.advance();
       }
       state.do_label_stack.pop();
@@ -74,10 +74,9 @@ private:
     FLPR::LL_STMT_SEQ::iterator ll_stmt_iter() const noexcept {
       return ll_stmt_iter_;
     }
-    Stmt_Tree const &stmt_tree() const noexcept {
-      return ll_stmt_iter_->stmt_tree();
-    }
-    Stmt_Tree &stmt_tree() noexcept { return ll_stmt_iter_->stmt_tree(); }
+    //! See LL_Stmt::stmt_tree() for how long the reference is good
+    Stmt_Tree const &stmt_tree() const { return ll_stmt_iter_->stmt_tree(); }
+    Stmt_Tree &stmt_tree() { return ll_stmt_iter_->stmt_tree(); }
 
   private:
     FLPR::LL_STMT_SEQ::iterator ll_stmt_iter_;
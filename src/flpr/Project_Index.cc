@@ -0,0 +1,458 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Project_Index.cc
+*/
+
+#include "flpr/Project_Index.hh"
+#include "flpr/Parse_Cache.hh"
+#include "flpr/Work_Stealing_Pool.hh"
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace FLPR {
+
+namespace {
+
+using TT_Iter = TT_Range::const_iterator;
+
+/* Return the lowercase text of the name that follows the first token of stmt
+   with the given tag, or "" */
+std::string name_after(LL_Stmt const &stmt, int const tag) {
+  TT_Iter const end = stmt.cend();
+  TT_Iter it = std::find_if(stmt.cbegin(), end, [tag](Token_Text const &tt) {
+    return tt.token == tag;
+  });
+  if (it == end || ++it == end || !Syntax_Tags::is_name(it->token))
+    return std::string{};
+  return it->lower();
+}
+
+template <typename T> void push_unique(std::vector<T> &v, T &&val) {
+  if (std::find(v.begin(), v.end(), val) == v.end())
+    v.emplace_back(std::move(val));
+}
+
+} // namespace
+
+std::string Project_Index::Program_Unit::module_key() const {
+  if (kind == Unit_Kind::MODULE)
+    return name;
+  if (kind == Unit_Kind::SUBMODULE)
+    return parent.substr(0, parent.find(':')) + ':' + name;
+  return std::string{};
+}
+
+/* Parse each file on a pool of threads, then merge the summaries */
+bool Project_Index::update_files(std::vector<std::string> const &filenames,
+                                 int const num_threads,
+                                 int const last_fixed_col,
+                                 File_Type const file_type,
+                                 Parse_Cache *cache) {
+  std::vector<File_Summary> summaries(filenames.size());
+  std::vector<Work_Stealing_Pool::Task> tasks;
+  tasks.reserve(filenames.size());
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    File_Summary &fs{summaries[i]};
+    fs.filename = filenames[i];
+    fs.last_fixed_col = last_fixed_col;
+    fs.file_type = file_type;
+    tasks.emplace_back([&fs, cache]() {
+      if (!stat_(fs))
+        return;
+      Parsed_File<> file = (cache) ? cache->load(fs.filename,
+                                                 fs.last_fixed_col,
+                                                 fs.file_type)
+                                   : Parsed_File<>(fs.filename,
+                                                   fs.last_fixed_col,
+                                                   fs.file_type);
+      if (file && file.prefetch_parse_tree() && file) {
+        fs.units = summarize(file.parse_tree());
+        fs.ok = true;
+      }
+    });
+  }
+  Work_Stealing_Pool pool(num_threads);
+  pool.run(std::move(tasks));
+
+  bool all_ok{true};
+  for (File_Summary &fs : summaries) {
+    if (!fs.ok) {
+      std::cerr << "Project_Index: unable to read or parse \"" << fs.filename
+                << "\"\n";
+      all_ok = false;
+    }
+    add_(std::move(fs));
+  }
+  return all_ok;
+}
+
+bool Project_Index::remove_file(std::string const &filename) {
+  auto const it = files_.find(filename);
+  if (it == files_.end())
+    return false;
+  remove_(it->second);
+  files_.erase(it);
+  return true;
+}
+
+size_t Project_Index::refresh(int const num_threads, Parse_Cache *cache) {
+  /* Group the changed files by how they are to be parsed */
+  std::map<std::pair<int, File_Type>, std::vector<std::string>> changed;
+  std::vector<std::string> missing;
+  for (auto const &[filename, fs] : files_) {
+    File_Summary now;
+    now.filename = filename;
+    if (!stat_(now)) {
+      missing.push_back(filename);
+    } else if (!fs.ok || now.size != fs.size ||
+               now.mtime.tv_sec != fs.mtime.tv_sec ||
+               now.mtime.tv_nsec != fs.mtime.tv_nsec) {
+      changed[{fs.last_fixed_col, fs.file_type}].push_back(filename);
+    }
+  }
+  size_t count{missing.size()};
+  for (auto const &filename : missing)
+    remove_file(filename);
+  for (auto const &[args, filenames] : changed) {
+    update_files(filenames, num_threads, args.first, args.second, cache);
+    count += filenames.size();
+  }
+  return count;
+}
+
+void Project_Index::clear() {
+  files_.clear();
+  definers_.clear();
+  users_.clear();
+}
+
+std::vector<std::string> Project_Index::files() const {
+  std::vector<std::string> result;
+  result.reserve(files_.size());
+  for (auto const &entry : files_)
+    result.push_back(entry.first);
+  return result;
+}
+
+Project_Index::File_Summary const *
+Project_Index::summary(std::string const &filename) const {
+  auto const it = files_.find(filename);
+  return (it == files_.end()) ? nullptr : &it->second;
+}
+
+std::string Project_Index::defining_file(std::string const &module) const {
+  auto const it = definers_.find(module);
+  if (it == definers_.end() || it->second.empty())
+    return std::string{};
+  return *it->second.begin();
+}
+
+std::vector<std::string>
+Project_Index::module_dependencies(std::string const &module) const {
+  std::set<std::string> result;
+  File_Summary const *const fs = summary(defining_file(module));
+  if (fs) {
+    for (auto const &unit : fs->units) {
+      if (unit.module_key() != module)
+        continue;
+      for (auto &need : needs_(unit))
+        if (need != module && !defining_file(need).empty())
+          result.insert(std::move(need));
+    }
+  }
+  return std::vector<std::string>(result.begin(), result.end());
+}
+
+std::vector<std::string>
+Project_Index::module_dependents(std::string const &module) const {
+  std::set<std::string> result;
+  auto const it = users_.find(module);
+  if (it != users_.end()) {
+    for (auto const &filename : it->second) {
+      for (auto const &unit : files_.at(filename).units) {
+        std::string key{unit.module_key()};
+        if (key.empty() || key == module)
+          continue;
+        auto const needs = needs_(unit);
+        if (std::find(needs.begin(), needs.end(), module) != needs.end())
+          result.insert(std::move(key));
+      }
+    }
+  }
+  return std::vector<std::string>(result.begin(), result.end());
+}
+
+std::vector<std::string>
+Project_Index::files_using(std::string const &module) const {
+  auto const it = users_.find(module);
+  if (it == users_.end())
+    return std::vector<std::string>{};
+  return std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+std::vector<std::string>
+Project_Index::file_dependencies(std::string const &filename) const {
+  File_Summary const *const fs = summary(filename);
+  if (!fs)
+    return std::vector<std::string>{};
+  auto const deps = file_deps_(*fs);
+  return std::vector<std::string>(deps.begin(), deps.end());
+}
+
+/* Follow the modules defined by each file to the files that use them */
+std::vector<std::string>
+Project_Index::dependent_files(std::string const &filename) const {
+  std::set<std::string> result;
+  std::vector<std::string> work{filename};
+  while (!work.empty()) {
+    File_Summary const *const fs = summary(work.back());
+    work.pop_back();
+    if (!fs)
+      continue;
+    for (auto const &unit : fs->units) {
+      std::string const key{unit.module_key()};
+      if (key.empty() || defining_file(key) != fs->filename)
+        continue;
+      auto const it = users_.find(key);
+      if (it == users_.end())
+        continue;
+      for (auto const &user : it->second)
+        if (user != filename && result.insert(user).second)
+          work.push_back(user);
+    }
+  }
+  return std::vector<std::string>(result.begin(), result.end());
+}
+
+std::vector<std::string> Project_Index::unresolved_modules() const {
+  std::vector<std::string> result;
+  for (auto const &[module, files] : users_)
+    if (!files.empty() && defining_file(module).empty())
+      result.push_back(module);
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+/* Kahn's algorithm, taking the ready files in name order */
+bool Project_Index::build_order(std::vector<std::string> &order) const {
+  bool ok{true};
+  for (auto const &[module, files] : definers_) {
+    if (files.size() > 1) {
+      std::cerr << "Project_Index: module \"" << module
+                << "\" is defined in several files:";
+      for (auto const &f : files)
+        std::cerr << " \"" << f << '"';
+      std::cerr << '\n';
+      ok = false;
+    }
+  }
+
+  std::map<std::string, size_t> num_deps;
+  std::map<std::string, std::vector<std::string>> dependents;
+  std::set<std::string> ready;
+  for (auto const &[filename, fs] : files_) {
+    auto const deps = file_deps_(fs);
+    num_deps[filename] = deps.size();
+    for (auto const &d : deps)
+      dependents[d].push_back(filename);
+    if (deps.empty())
+      ready.insert(filename);
+  }
+  order.clear();
+  order.reserve(files_.size());
+  while (!ready.empty()) {
+    order.push_back(*ready.begin());
+    ready.erase(ready.begin());
+    for (auto const &d : dependents[order.back()])
+      if (--num_deps[d] == 0)
+        ready.insert(d);
+  }
+  if (order.size() != files_.size()) {
+    std::cerr << "Project_Index: module dependency cycle among:";
+    for (auto const &[filename, count] : num_deps)
+      if (count > 0)
+        std::cerr << " \"" << filename << '"';
+    std::cerr << '\n';
+    ok = false;
+  }
+  return ok;
+}
+
+std::vector<std::string> Project_Index::needs_(Program_Unit const &unit) {
+  std::vector<std::string> result;
+  for (auto const &use : unit.uses)
+    if (!use.intrinsic)
+      result.push_back(use.module);
+  if (unit.kind == Unit_Kind::SUBMODULE) {
+    auto const colon = unit.parent.find(':');
+    result.push_back(unit.parent.substr(0, colon));
+    if (colon != std::string::npos)
+      result.push_back(unit.parent);
+  }
+  return result;
+}
+
+/* Record what one statement of a unit tells us */
+void Project_Index::summarize_stmt_(LL_Stmt const &stmt, Program_Unit &unit,
+                                    bool const provides) {
+  /* The program parsers don't distinguish the specification statements
+     that don't start constructs, so look at the keyword */
+  int tag = stmt.syntax_tag();
+  if (tag == Syntax_Tags::SG_OTHER_SPECIFICATION_STMT &&
+      stmt.cbegin() != stmt.cend() &&
+      stmt.cbegin()->token == Syntax_Tags::KW_COMMON)
+    tag = Syntax_Tags::SG_COMMON_STMT;
+  switch (tag) {
+  case Syntax_Tags::SG_MODULE_STMT:
+    unit.name = name_after(stmt, Syntax_Tags::KW_MODULE);
+    break;
+  case Syntax_Tags::SG_PROGRAM_STMT:
+    unit.name = name_after(stmt, Syntax_Tags::KW_PROGRAM);
+    break;
+  case Syntax_Tags::SG_SUBMODULE_STMT: {
+    /* submodule ( ancestor [: parent] ) name */
+    unit.parent = name_after(stmt, Syntax_Tags::TK_PARENL);
+    std::string const parent = name_after(stmt, Syntax_Tags::TK_COLON);
+    if (!parent.empty())
+      unit.parent += ':' + parent;
+    unit.name = name_after(stmt, Syntax_Tags::TK_PARENR);
+  } break;
+  case Syntax_Tags::SG_FUNCTION_STMT:
+  case Syntax_Tags::SG_SUBROUTINE_STMT: {
+    if (!provides)
+      break;
+    std::string name =
+        name_after(stmt, (tag == Syntax_Tags::SG_FUNCTION_STMT)
+                             ? Syntax_Tags::KW_FUNCTION
+                             : Syntax_Tags::KW_SUBROUTINE);
+    if (name.empty())
+      break;
+    if (unit.kind == Unit_Kind::EXTERNAL_SUBPROGRAM && unit.name.empty())
+      unit.name = name;
+    push_unique(unit.procedures, std::move(name));
+  } break;
+  case Syntax_Tags::SG_INTERFACE_STMT: {
+    /* The generic-spec, if any, is everything after the keyword.  Its
+       operators and punctuation are folded without being interned. */
+    if (!provides)
+      break;
+    std::string spec;
+    bool in_spec{false};
+    for (auto const &tt : stmt) {
+      if (in_spec)
+        spec += tt.lower();
+      else
+        in_spec = (tt.token == Syntax_Tags::KW_INTERFACE);
+    }
+    if (!spec.empty())
+      push_unique(unit.interfaces, std::move(spec));
+  } break;
+  case Syntax_Tags::SG_COMMON_STMT: {
+    /* Each "/ name /" names a common block; a blank one is "//" */
+    std::vector<Token_Text const *> toks;
+    for (auto const &tt : stmt)
+      toks.push_back(&tt);
+    for (size_t i = 0; i + 2 < toks.size(); ++i) {
+      if (toks[i]->token == Syntax_Tags::TK_SLASHF &&
+          Syntax_Tags::is_name(toks[i + 1]->token) &&
+          toks[i + 2]->token == Syntax_Tags::TK_SLASHF) {
+        push_unique(unit.common_blocks, std::string{toks[i + 1]->lower()});
+        i += 2;
+      }
+    }
+  } break;
+  case Syntax_Tags::SG_USE_STMT: {
+    /* use [[, module-nature] ::] name [...] */
+    TT_Iter const end = stmt.cend();
+    TT_Iter it = std::find_if(stmt.cbegin(), end, [](Token_Text const &tt) {
+      return tt.token == Syntax_Tags::KW_USE;
+    });
+    Use use;
+    if (it != end)
+      ++it;
+    if (it != end && it->token == Syntax_Tags::TK_COMMA) {
+      if (++it == end)
+        break;
+      use.intrinsic = (it->token == Syntax_Tags::KW_INTRINSIC);
+      ++it;
+    }
+    if (it != end && it->token == Syntax_Tags::TK_DBL_COLON)
+      ++it;
+    if (it == end || !Syntax_Tags::is_name(it->token))
+      break;
+    use.module = it->lower();
+    push_unique(unit.uses, std::move(use));
+  } break;
+  }
+}
+
+/* Record the modification time and size of a file, returning false if it
+   doesn't exist */
+bool Project_Index::stat_(File_Summary &fs) {
+  struct stat sb;
+  if (stat(fs.filename.c_str(), &sb) != 0)
+    return false;
+  fs.mtime = sb.st_mtim;
+  fs.size = static_cast<long long>(sb.st_size);
+  return true;
+}
+
+void Project_Index::add_(File_Summary &&fs) {
+  auto const it = files_.find(fs.filename);
+  if (it != files_.end()) {
+    remove_(it->second);
+    files_.erase(it);
+  }
+  std::string const &filename =
+      files_.emplace(fs.filename, std::move(fs)).first->first;
+  for (auto const &unit : files_.at(filename).units) {
+    std::string const key{unit.module_key()};
+    if (!key.empty())
+      definers_[key].insert(filename);
+    for (auto &need : needs_(unit))
+      users_[std::move(need)].insert(filename);
+  }
+}
+
+void Project_Index::remove_(File_Summary const &fs) {
+  auto const drop = [&fs](auto &map, std::string const &key) {
+    auto const it = map.find(key);
+    if (it == map.end())
+      return;
+    it->second.erase(fs.filename);
+    if (it->second.empty())
+      map.erase(it);
+  };
+  for (auto const &unit : fs.units) {
+    std::string const key{unit.module_key()};
+    if (!key.empty())
+      drop(definers_, key);
+    for (auto const &need : needs_(unit))
+      drop(users_, need);
+  }
+}
+
+std::set<std::string>
+Project_Index::file_deps_(File_Summary const &fs) const {
+  std::set<std::string> result;
+  for (auto const &unit : fs.units) {
+    for (auto const &need : needs_(unit)) {
+      std::string dep{defining_file(need)};
+      if (!dep.empty() && dep != fs.filename)
+        result.insert(std::move(dep));
+    }
+  }
+  return result;
+}
+
+} // namespace FLPR
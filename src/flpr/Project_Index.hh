@@ -0,0 +1,262 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Project_Index.hh
+*/
+
+#ifndef FLPR_PROJECT_INDEX_HH
+#define FLPR_PROJECT_INDEX_HH 1
+
+#include "flpr/Parsed_File.hh"
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FLPR {
+class Parse_Cache;
+
+//! The modules and global names that each file of a project provides and uses
+/*!
+  A Parsed_File knows nothing of the other files of a project.  A
+  Project_Index summarizes each file of a set: the program units that it
+  contains, the modules that each unit USEs, and the external or module
+  procedures, generic interfaces and common blocks that it provides.  From
+  the summaries it answers the cross-file questions: which file defines a
+  module, which modules a module depends on, which files use a module, and
+  the order in which the files have to be compiled so that every module is
+  built before it is used.
+
+  Files can be added by name, in which case they are parsed on a pool of
+  threads (optionally through a Parse_Cache), or as an already-parsed
+  Parsed_File.  Changing a file only re-summarizes that file: refresh()
+  finds the files that have changed on disk.  The dependency queries work
+  from maps that are kept up to date as files are added and removed.
+
+  Names are kept in lowercase.  A submodule is known as "ancestor:name", and
+  depends on its ancestor module and on its parent submodule, if any (the
+  program parsers don't yet recognize submodules, though).  Uses
+  of intrinsic modules, and of modules that aren't defined in the project,
+  don't make dependencies.
+*/
+class Project_Index {
+public:
+  enum class Unit_Kind { MAIN_PROGRAM, MODULE, SUBMODULE, EXTERNAL_SUBPROGRAM };
+
+  //! A use-stmt
+  struct Use {
+    std::string module;
+    bool intrinsic{false};
+    bool operator==(Use const &other) const {
+      return module == other.module && intrinsic == other.intrinsic;
+    }
+  };
+
+  //! What a program unit provides and needs
+  struct Program_Unit {
+    Unit_Kind kind{Unit_Kind::MAIN_PROGRAM};
+    //! The unit name, which may be empty for a main program
+    std::string name;
+    //! For a submodule, its parent ("ancestor" or "ancestor:parent")
+    std::string parent;
+    //! The modules used anywhere in the unit, in the order first used
+    std::vector<Use> uses;
+    //! External or module procedures
+    std::vector<std::string> procedures;
+    //! Generic interface names (or "operator(...)" and "assignment(=)")
+    std::vector<std::string> interfaces;
+    //! Named common blocks
+    std::vector<std::string> common_blocks;
+    //! The name that the unit is known by in the module maps
+    std::string module_key() const;
+  };
+
+  //! The summary of one file
+  struct File_Summary {
+    std::string filename;
+    std::vector<Program_Unit> units;
+    //! False if the file couldn't be read or parsed
+    bool ok{false};
+    //! The modification time and size when it was summarized
+    std::timespec mtime{0, 0};
+    long long size{-1};
+    //! The arguments used to parse it
+    int last_fixed_col{0};
+    File_Type file_type{File_Type::UNKNOWN};
+  };
+
+  //! Parse and summarize some files, num_threads at a time
+  /*! Any earlier summaries of these files are replaced.  Returns false if
+      any of them couldn't be read or parsed: those are recorded, with no
+      units, so that refresh() will try them again. */
+  bool update_files(std::vector<std::string> const &filenames,
+                    int const num_threads, int const last_fixed_col = 0,
+                    File_Type const file_type = File_Type::UNKNOWN,
+                    Parse_Cache *cache = nullptr);
+  //! Parse and summarize one file
+  bool update_file(std::string const &filename, int const last_fixed_col = 0,
+                   File_Type const file_type = File_Type::UNKNOWN,
+                   Parse_Cache *cache = nullptr) {
+    return update_files({filename}, 1, last_fixed_col, file_type, cache);
+  }
+  //! Summarize a file that has already been parsed
+  /*! This reads the file's parse tree (building it if need be) as it is
+      now, so it can be called again after the file has been edited. */
+  template <typename PG_NODE_DATA>
+  bool update_file(std::string const &filename,
+                   Parsed_File<PG_NODE_DATA> &file);
+  //! Forget a file
+  bool remove_file(std::string const &filename);
+  //! Re-summarize the files that have changed on disk, and drop missing ones
+  /*! Returns the number of files that were re-summarized or dropped. */
+  size_t refresh(int const num_threads, Parse_Cache *cache = nullptr);
+  void clear();
+
+  //! The number of files
+  size_t size() const noexcept { return files_.size(); }
+  bool empty() const noexcept { return files_.empty(); }
+  //! The names of the files, in sorted order
+  std::vector<std::string> files() const;
+  //! The summary of a file, or nullptr
+  File_Summary const *summary(std::string const &filename) const;
+
+  //! The file that defines a module (or "ancestor:submodule"), or ""
+  /*! If several files define the same module, the first in sorted order is
+      chosen, and build_order() reports the conflict. */
+  std::string defining_file(std::string const &module) const;
+  //! The modules of the project that module uses directly, sorted
+  std::vector<std::string> module_dependencies(std::string const &module) const;
+  //! The modules of the project that use module directly, sorted
+  std::vector<std::string> module_dependents(std::string const &module) const;
+  //! The files that use module, sorted
+  std::vector<std::string> files_using(std::string const &module) const;
+  //! The files that must be compiled before filename, directly
+  std::vector<std::string> file_dependencies(std::string const &filename) const;
+  //! The files that need recompiling when filename changes, sorted
+  /*! This follows the module dependencies transitively, and doesn't
+      include filename itself. */
+  std::vector<std::string>
+  dependent_files(std::string const &filename) const;
+  //! Modules that are used, but not defined in the project or intrinsic
+  std::vector<std::string> unresolved_modules() const;
+
+  //! Order the files so that each comes after the files that it depends on
+  /*! Among files that are ready at the same time, the order is by name.
+      Returns false if there is a dependency cycle, or a module is defined
+      more than once, with a report on std::cerr.  The files on a cycle are
+      left off of the end of order. */
+  bool build_order(std::vector<std::string> &order) const;
+
+  //! Summarize the program units of a parse tree
+  template <typename PG_NODE_DATA, typename ALLOC>
+  static std::vector<Program_Unit>
+  summarize(Tree<PG_NODE_DATA, ALLOC> const &parse_tree);
+
+private:
+  //! The modules that a unit needs (project-defined or not)
+  static std::vector<std::string> needs_(Program_Unit const &unit);
+  template <typename NODE>
+  static void summarize_(NODE const &n, std::vector<Program_Unit> &units,
+                         bool const provides);
+  static void summarize_stmt_(LL_Stmt const &stmt, Program_Unit &unit,
+                              bool const provides);
+  static bool stat_(File_Summary &fs);
+  void add_(File_Summary &&fs);
+  void remove_(File_Summary const &fs);
+  //! The files (other than filename) that define the modules it needs
+  std::set<std::string> file_deps_(File_Summary const &fs) const;
+
+private:
+  std::map<std::string, File_Summary> files_;
+  //! The files that define each module
+  std::unordered_map<std::string, std::set<std::string>> definers_;
+  //! The files that need each module
+  std::unordered_map<std::string, std::set<std::string>> users_;
+};
+
+template <typename PG_NODE_DATA>
+bool Project_Index::update_file(std::string const &filename,
+                                Parsed_File<PG_NODE_DATA> &file) {
+  File_Summary fs;
+  fs.filename = filename;
+  stat_(fs);
+  if (file && file.prefetch_parse_tree() && file) {
+    fs.units = summarize(file.parse_tree());
+    fs.ok = true;
+    fs.file_type = file.logical_file().file_type();
+  }
+  bool const ok = fs.ok;
+  add_(std::move(fs));
+  return ok;
+}
+
+template <typename PG_NODE_DATA, typename ALLOC>
+std::vector<Project_Index::Program_Unit>
+Project_Index::summarize(Tree<PG_NODE_DATA, ALLOC> const &parse_tree) {
+  std::vector<Program_Unit> units;
+  if (!parse_tree.empty())
+    summarize_(*parse_tree, units, true);
+  return units;
+}
+
+/* Each program-unit starts a new Program_Unit.  Only the statements at the
+   top level of a unit (and its module subprograms) provide names: the
+   contents of a subprogram or an interface-block are local. */
+template <typename NODE>
+void Project_Index::summarize_(NODE const &n, std::vector<Program_Unit> &units,
+                               bool const provides) {
+  if (n->is_stmt()) {
+    if (!units.empty())
+      summarize_stmt_(n->ll_stmt(), units.back(), provides);
+    return;
+  }
+  bool provides_below{provides};
+  auto const set_kind = [&units](Unit_Kind const kind) {
+    if (!units.empty())
+      units.back().kind = kind;
+  };
+  switch (n->syntag()) {
+  case Syntax_Tags::PG_PROGRAM_UNIT:
+    units.emplace_back();
+    break;
+  case Syntax_Tags::PG_MAIN_PROGRAM:
+    set_kind(Unit_Kind::MAIN_PROGRAM);
+    break;
+  case Syntax_Tags::PG_MODULE:
+    set_kind(Unit_Kind::MODULE);
+    break;
+  case Syntax_Tags::PG_SUBMODULE:
+    set_kind(Unit_Kind::SUBMODULE);
+    break;
+  case Syntax_Tags::PG_EXTERNAL_SUBPROGRAM:
+    set_kind(Unit_Kind::EXTERNAL_SUBPROGRAM);
+    break;
+  case Syntax_Tags::PG_FUNCTION_SUBPROGRAM:
+  case Syntax_Tags::PG_SUBROUTINE_SUBPROGRAM:
+  case Syntax_Tags::PG_SEPARATE_MODULE_SUBPROGRAM:
+  case Syntax_Tags::PG_INTERFACE_BLOCK:
+    /* The first statement names the subprogram or interface */
+    provides_below = false;
+    break;
+  }
+  if (n.is_leaf())
+    return;
+  bool first{true};
+  for (auto const &b : n.branches()) {
+    summarize_(b, units, first ? provides : provides_below);
+    first = false;
+  }
+}
+
+} // namespace FLPR
+#endif
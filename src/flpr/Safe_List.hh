@@ -17,6 +17,7 @@
 
 #define DEBUG_SL_RANGE 0
 
+#include "flpr/Arena.hh"
 #include <cassert>
 #include <initializer_list>
 #include <iterator>
@@ -45,8 +46,11 @@ namespace FLPR {
   updated to refer to the new Safe_List.
 
   *** NOTE *** NOTE *** NOTE *** NOTE *** NOTE *** NOTE *** NOTE ***
+
+  The default Arena_Allocator draws from the heap.  Construct the Safe_List
+  with an Arena_Allocator for an Arena to draw from that instead.
 */
-template <class T, class Alloc = std::allocator<T>> class Safe_List {
+template <class T, class Alloc = Arena_Allocator<T>> class Safe_List {
 public:
   using base_type = std::list<T, Alloc>;
   using value_type = typename base_type::value_type;
@@ -57,9 +61,13 @@ public:
   using pointer = typename base_type::pointer;
   using const_pointer = typename base_type::const_pointer;
   using size_type = typename base_type::size_type;
+  using allocator_type = typename base_type::allocator_type;
 
   /*********************** Altered functions *************************/
   constexpr Safe_List() : list_{} { append_sentry_(); }
+  constexpr explicit Safe_List(allocator_type const &alloc) : list_{alloc} {
+    append_sentry_();
+  }
   constexpr Safe_List(size_type count, const T &value) : list_(count, value) {
     append_sentry_();
   }
@@ -115,6 +123,7 @@ public:
   }
 
   /*********************** Pass-thru functions ***********************/
+  allocator_type get_allocator() const { return list_.get_allocator(); }
   constexpr reference front() { return list_.front(); }
   constexpr const_reference front() const { return list_.front(); }
   constexpr iterator begin() noexcept { return list_.begin(); }
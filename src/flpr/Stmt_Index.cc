@@ -0,0 +1,198 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Index.cc
+*/
+
+#include "flpr/Stmt_Index.hh"
+#include <algorithm>
+
+namespace FLPR {
+
+namespace {
+Stmt_Index::Stmt_List const empty_list;
+}
+
+void Stmt_Index::build(LL_STMT_SEQ &stmts) {
+  clear();
+  stmts_ = &stmts;
+  Position position{0};
+  for (auto it = stmts.begin(); it != stmts.end(); ++it) {
+    Entry &entry{entries_[&(*it)]};
+    entry.stmt = it;
+    entry.position = (position += spacing_);
+    add_(entry);
+  }
+}
+
+void Stmt_Index::update(LL_STMT_SEQ::iterator stmt) {
+  auto const [it, added] = entries_.try_emplace(&(*stmt));
+  Entry &entry{it->second};
+  entry.stmt = stmt;
+  if (added) {
+    place_(entry);
+  } else {
+    remove_(entry);
+    entry.syntags.clear();
+    entry.names.clear();
+  }
+  add_(entry);
+}
+
+void Stmt_Index::clear() {
+  stmts_ = nullptr;
+  entries_.clear();
+  by_syntag_.clear();
+  by_name_.clear();
+}
+
+Stmt_Index::Stmt_List const &Stmt_Index::with_syntag(int const syntag) const {
+  auto const it = by_syntag_.find(syntag);
+  return (it == by_syntag_.end()) ? empty_list : it->second.stmts;
+}
+
+Stmt_Index::Stmt_List const &
+Stmt_Index::with_name(std::string_view const name) const {
+  /* A name that was never interned can't be in any statement */
+  return with_symbol(Symbol_Table::global().find(name));
+}
+
+Stmt_Index::Stmt_List const &
+Stmt_Index::with_symbol(Symbol_Table::Symbol const sym) const {
+  auto const it = by_name_.find(sym);
+  return (it == by_name_.end()) ? empty_list : it->second.stmts;
+}
+
+Stmt_Index::Stmt_List
+Stmt_Index::with_syntag_and_name(int const syntag,
+                                 std::string_view const name_text) const {
+  Stmt_List result;
+  Symbol_Table::Symbol const name = Symbol_Table::global().find(name_text);
+  auto const name_it = by_name_.find(name);
+  if (name_it == by_name_.end())
+    return result;
+  Stmt_List const &tagged{with_syntag(syntag)};
+  Stmt_List const &named{name_it->second.stmts};
+  /* Check the shorter list against the entries of its statements */
+  if (tagged.size() <= named.size()) {
+    for (auto const &stmt : tagged) {
+      auto const &names = entries_.at(&(*stmt)).names;
+      if (std::find(names.begin(), names.end(), name) != names.end())
+        result.push_back(stmt);
+    }
+  } else {
+    for (auto const &stmt : named) {
+      auto const &syntags = entries_.at(&(*stmt)).syntags;
+      if (std::find(syntags.begin(), syntags.end(), syntag) != syntags.end())
+        result.push_back(stmt);
+    }
+  }
+  return result;
+}
+
+void Stmt_Index::Posting::insert(Entry const &entry) {
+  auto const pos = std::upper_bound(positions.begin(), positions.end(),
+                                    entry.position);
+  stmts.insert(stmts.begin() + (pos - positions.begin()), entry.stmt);
+  positions.insert(pos, entry.position);
+}
+
+void Stmt_Index::Posting::erase(Entry const &entry) {
+  auto const pos = std::lower_bound(positions.begin(), positions.end(),
+                                    entry.position);
+  if (pos == positions.end() || *pos != entry.position)
+    return;
+  stmts.erase(stmts.begin() + (pos - positions.begin()));
+  positions.erase(pos);
+}
+
+/* Give a new entry a position between those of the indexed statements on
+   either side of it */
+void Stmt_Index::place_(Entry &entry) {
+  if (!stmts_) {
+    entry.position = entries_.size() * spacing_;
+    return;
+  }
+  Position before{0};
+  for (auto it = entry.stmt; it != stmts_->begin();) {
+    auto const e = entries_.find(&(*--it));
+    if (e != entries_.end()) {
+      before = e->second.position;
+      break;
+    }
+  }
+  Position after{before + 2 * spacing_};
+  for (auto it = std::next(entry.stmt); it != stmts_->end(); ++it) {
+    auto const e = entries_.find(&(*it));
+    if (e != entries_.end()) {
+      after = e->second.position;
+      break;
+    }
+  }
+  if (after - before < 2) {
+    renumber_();
+    return;
+  }
+  entry.position = before + (after - before) / 2;
+}
+
+/* Space the positions out again, which doesn't change their order */
+void Stmt_Index::renumber_() {
+  Position position{0};
+  for (auto it = stmts_->begin(); it != stmts_->end(); ++it) {
+    auto const e = entries_.find(&(*it));
+    if (e != entries_.end())
+      e->second.position = (position += spacing_);
+  }
+  auto const reposition = [this](Posting &posting) {
+    for (size_t i = 0; i < posting.stmts.size(); ++i)
+      posting.positions[i] = entries_.at(&(*posting.stmts[i])).position;
+  };
+  for (auto &p : by_syntag_)
+    reposition(p.second);
+  for (auto &p : by_name_)
+    reposition(p.second);
+}
+
+/* Work out the keys of entry.stmt, and list it under each of them */
+void Stmt_Index::add_(Entry &entry) {
+  LL_Stmt const &stmt{*entry.stmt};
+  int const syntag = stmt.syntax_tag();
+  entry.syntags.push_back(syntag);
+  if (Syntax_Tags::SG_IF_STMT == syntag) {
+    int const action = -stmt.stmt_tag(true);
+    if (action > 0 && action != syntag)
+      entry.syntags.push_back(action);
+  }
+  for (int const tag : entry.syntags)
+    by_syntag_[tag].insert(entry);
+
+  for (auto const &tt : stmt) {
+    if (Syntax_Tags::TK_NAME != tt.token)
+      continue;
+    Symbol_Table::Symbol const name = tt.symbol();
+    if (std::find(entry.names.begin(), entry.names.end(), name) !=
+        entry.names.end())
+      continue;
+    entry.names.push_back(name);
+    by_name_[name].insert(entry);
+  }
+}
+
+/* Take entry.stmt off of the lists it is in */
+void Stmt_Index::remove_(Entry const &entry) {
+  for (int const tag : entry.syntags)
+    by_syntag_[tag].erase(entry);
+  for (Symbol_Table::Symbol const name : entry.names)
+    by_name_[name].erase(entry);
+}
+
+} // namespace FLPR
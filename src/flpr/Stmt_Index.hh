@@ -0,0 +1,113 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Index.hh
+*/
+
+#ifndef FLPR_STMT_INDEX_HH
+#define FLPR_STMT_INDEX_HH 1
+
+#include "flpr/LL_Stmt.hh"
+#include "flpr/Symbol_Table.hh"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace FLPR {
+
+//! An inverted index over the statements of a Logical_File
+/*!
+  Finding "every call to X" or "every use of module M" by walking all of the
+  LL_Stmts, and the Stmt_Tree of each, costs a pass over the file per
+  question.  A Stmt_Index answers them with a lookup: it maps each statement
+  syntag, and the Symbol_Table symbol of each TK_NAME token, to the
+  statements that have it.
+
+  An if-stmt is also listed under the syntag of its action-stmt, so that
+  `if (x) call f` is found with the other call-stmts.  Keyword tokens are not
+  indexed, so a name that the lexer classifies as a keyword (such as a
+  variable called `data`) can't be looked up.
+
+  The index is usually kept by a Parsed_File (see
+  Parsed_File::stmt_index()), which calls update() for each edited statement.
+  Statements must not be removed from the LL_STMT_SEQ while they are indexed.
+
+  Each statement is given a position, spaced out in file order, and each
+  list is kept sorted by position, so that update() finds a statement in a
+  list by binary search, and a statement inserted between two others is
+  listed between them.  When there is no room left between two positions,
+  the statements of the LL_STMT_SEQ given to build() are renumbered.
+*/
+class Stmt_Index {
+public:
+  using Stmt_List = std::vector<LL_STMT_SEQ::iterator>;
+
+  //! Index every statement of stmts, replacing the current contents
+  /*! The index keeps a reference to stmts, to place later updates */
+  void build(LL_STMT_SEQ &stmts);
+  //! Add a statement, or replace its entries if it is already indexed
+  void update(LL_STMT_SEQ::iterator stmt);
+  void clear();
+
+  //! The number of statements indexed
+  size_t size() const noexcept { return entries_.size(); }
+  bool empty() const noexcept { return entries_.empty(); }
+
+  //! The statements with a syntag
+  /*! The lists returned here are in file order (or, for statements added
+      by update() without a build(), in the order of the updates). */
+  Stmt_List const &with_syntag(int const syntag) const;
+  //! The statements containing a TK_NAME, in any case
+  Stmt_List const &with_name(std::string_view const name) const;
+  //! The statements containing a TK_NAME with a Token_Text::symbol()
+  Stmt_List const &with_symbol(Symbol_Table::Symbol const sym) const;
+  //! The statements with a syntag that also contain a TK_NAME
+  Stmt_List with_syntag_and_name(int const syntag,
+                                 std::string_view const name) const;
+
+private:
+  using Position = std::uint64_t;
+
+  //! The keys that a statement is listed under
+  struct Entry {
+    LL_STMT_SEQ::iterator stmt;
+    Position position{0};
+    std::vector<int> syntags;
+    std::vector<Symbol_Table::Symbol> names;
+  };
+
+  //! The statements under one key, and their positions, in file order
+  struct Posting {
+    std::vector<Position> positions;
+    Stmt_List stmts;
+    void insert(Entry const &entry);
+    void erase(Entry const &entry);
+  };
+
+  //! The spacing of the positions given by build() and renumber_()
+  static constexpr Position spacing_ = Position{1} << 32;
+
+  void place_(Entry &entry);
+  void renumber_();
+  void add_(Entry &entry);
+  void remove_(Entry const &entry);
+
+private:
+  LL_STMT_SEQ *stmts_{nullptr};
+  std::unordered_map<LL_Stmt const *, Entry> entries_;
+  std::unordered_map<int, Posting> by_syntag_;
+  std::unordered_map<Symbol_Table::Symbol, Posting> by_name_;
+};
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,34 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Memo.cc
+*/
+
+#include "flpr/Stmt_Memo.hh"
+#include <atomic>
+
+namespace FLPR {
+namespace Stmt {
+
+namespace {
+std::atomic<bool> memo_enabled{false};
+}
+
+void Stmt_Memo::set_enabled(bool const enable) noexcept {
+  memo_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool Stmt_Memo::enabled() noexcept {
+  return memo_enabled.load(std::memory_order_relaxed);
+}
+
+} // namespace Stmt
+} // namespace FLPR
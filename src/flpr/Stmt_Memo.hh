@@ -0,0 +1,89 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Memo.hh
+*/
+
+#ifndef FLPR_STMT_MEMO_HH
+#define FLPR_STMT_MEMO_HH 1
+
+#include "flpr/Stmt_Tree.hh"
+#include "flpr/TT_Stream.hh"
+#include <cstdint>
+#include <unordered_map>
+
+namespace FLPR {
+namespace Stmt {
+
+//! A packrat memo table for the sub-rules of one statement parse
+/*!
+  When an alternative fails, the statement parsers rewind the TT_Stream and
+  try the next one, which often re-parses the same sub-rule (e.g. an expr or
+  variable) starting at the same token.  A Stmt_Memo records the outcome of a
+  rule at a TT_Stream position so that the repeated attempts can reuse it.
+
+  The positions are TT_Stream::Marks, so a Stmt_Memo is only meaningful for
+  the one TT_Stream that it is attached to (see TT_Stream::set_memo()).
+*/
+class Stmt_Memo {
+public:
+  //! The recorded outcome of a rule
+  struct Entry {
+    //! Where the stream was left after the rule
+    TT_Stream::Mark end;
+    //! The result of the rule (empty on failure)
+    Stmt_Tree tree;
+  };
+
+  //! Return the entry for rule_tag at pos, or nullptr if there isn't one
+  Entry const *find(int const rule_tag, TT_Stream::Mark const pos) const {
+    auto it = table_.find(key_(rule_tag, pos));
+    if (it == table_.end()) {
+      misses_ += 1;
+      return nullptr;
+    }
+    hits_ += 1;
+    return &(it->second);
+  }
+
+  //! Record the outcome of rule_tag starting at pos (keeps a copy of tree)
+  void insert(int const rule_tag, TT_Stream::Mark const pos,
+              TT_Stream::Mark const end, Stmt_Tree const &tree) {
+    table_[key_(rule_tag, pos)] = Entry{end, tree.clone()};
+  }
+
+  void clear() noexcept { table_.clear(); }
+  std::size_t size() const noexcept { return table_.size(); }
+  std::size_t hits() const noexcept { return hits_; }
+  std::size_t misses() const noexcept { return misses_; }
+
+  //! Turn memoization on or off for LL_Stmt and Statement_Parser parses
+  static void set_enabled(bool const enable) noexcept;
+  //! True if statement parses should attach a Stmt_Memo to their stream
+  static bool enabled() noexcept;
+
+private:
+  static constexpr std::uint64_t key_(int const rule_tag,
+                                      TT_Stream::Mark const pos) noexcept {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(rule_tag))
+            << 32) |
+           static_cast<std::uint32_t>(pos);
+  }
+
+private:
+  std::unordered_map<std::uint64_t, Entry> table_;
+  mutable std::size_t hits_{0};
+  mutable std::size_t misses_{0};
+};
+
+} // namespace Stmt
+} // namespace FLPR
+#endif
@@ -38,6 +38,11 @@ public:
   void register_other_specification_stmt(stmt_parser ext) noexcept;
   //! Clear all registered extensions
   void clear() noexcept;
+  //! The number of registered extensions of each kind
+  size_t num_action_stmts() const noexcept { return action_exts_.size(); }
+  size_t num_other_specification_stmts() const noexcept {
+    return other_specification_exts_.size();
+  }
 
   //@{
   /*! This is called by a driver routine in parse_stmt.cc and is not intended
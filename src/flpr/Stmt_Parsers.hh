@@ -18,7 +18,11 @@
 #include "flpr/Stmt_Tree.hh"
 #include "flpr/TT_Stream.hh"
 #include "flpr/utils.hh"
+#include <array>
+#include <cstdint>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 #define TRACE_TOKEN_PARSER 0
 
@@ -80,13 +84,135 @@ inline constexpr Alternatives_Parser<Ps...> h_alts(Ps &&... ps) noexcept {
                                     std::forward<Ps>(ps)...};
 }
 
+//! Forwards to a parser that can only match if it starts with one of Tags
+/*! This doesn't change what the parser matches: it just records the FIRST
+    set of the parser in the type, so that a Dispatch_Parser can skip it
+    without calling it. */
+template <typename P, int... Tags> class First_Parser {
+  static_assert(sizeof...(Tags) > 0, "First_Parser needs a FIRST set");
+  static_assert(((Tags >= 0 && Tags < Syntax_Tags::TK_ZZZ_UB) && ...),
+                "First_Parser tags must be grammar tokens");
+
+public:
+  First_Parser(First_Parser const &) = default;
+  constexpr explicit First_Parser(P &&p) noexcept
+      : parser_{std::forward<P>(p)} {}
+  SP_Result operator()(TT_Stream &ts) const noexcept { return parser_(ts); }
+
+private:
+  P const parser_;
+};
+
+//! Generate a First_Parser
+template <int... Tags, typename P>
+inline constexpr First_Parser<P, Tags...> starts_with(P &&p) noexcept {
+  return First_Parser<P, Tags...>{std::forward<P>(p)};
+}
+
+namespace details_ {
+//! The tokens that can start a match of P (empty means any token)
+template <typename P> struct First_Set {
+  static constexpr std::array<int, 0> tags{};
+};
+template <typename P, int... Tags> struct First_Set<First_Parser<P, Tags...>> {
+  static constexpr std::array<int, sizeof...(Tags)> tags{{Tags...}};
+};
+} // namespace details_
+
+//! An Alternatives_Parser that only tries the alternatives that can match
+/*! The alternatives wrapped with starts_with() are only tried if the next
+    token is in their FIRST set, while those that are not wrapped are always
+    tried.  A table, built at compile time from the types of the
+    alternatives, maps each token to the set of candidate alternatives.  The
+    candidates are tried in their original order, so the result is the same
+    as an Alternatives_Parser with the same arguments. */
+template <typename... Ps> class Dispatch_Parser {
+  static_assert(sizeof...(Ps) <= 64, "Dispatch_Parser uses a 64-bit mask");
+  using mask_type = std::uint64_t;
+  /* One entry for each grammar token, plus one for everything else */
+  static constexpr std::size_t other_idx_ = Syntax_Tags::TK_ZZZ_UB;
+  using table_type = std::array<mask_type, other_idx_ + 1>;
+
+public:
+  Dispatch_Parser(Dispatch_Parser const &) = default;
+  constexpr explicit Dispatch_Parser(int const syntag, Ps &&... ps) noexcept
+      : syntag_{syntag}, parsers_{std::forward<Ps>(ps)...} {}
+  SP_Result operator()(TT_Stream &ts) const noexcept {
+    int const next = ts.peek();
+    std::size_t const idx = (next >= 0 && next < Syntax_Tags::TK_ZZZ_UB)
+                                ? static_cast<std::size_t>(next)
+                                : other_idx_;
+    Stmt_Tree root;
+    bool const match = try_candidates_(table_[idx], ts, root,
+                                       std::index_sequence_for<Ps...>{});
+    if (match) {
+      Stmt_Tree new_root{this->syntag_};
+      hoist_back(new_root, std::move(root));
+      cover_branches(*new_root);
+      return SP_Result{std::move(new_root), true};
+    }
+    return SP_Result{std::move(root), false};
+  }
+
+private:
+  template <std::size_t... Is>
+  bool try_candidates_(mask_type const candidates, TT_Stream &ts,
+                       Stmt_Tree &root, std::index_sequence<Is...>) const
+      noexcept {
+    auto assign_if = [&ts, &root](auto const &p) {
+      auto [st, match] = p(ts);
+      if (match) {
+        root = std::move(st);
+      }
+      return match;
+    };
+    return ((((candidates >> Is) & 1) && assign_if(std::get<Is>(parsers_))) ||
+            ...);
+  }
+
+  template <std::size_t N>
+  static constexpr void
+  add_candidate_(table_type &table, std::size_t const i,
+                 std::array<int, N> const &tags) noexcept {
+    mask_type const bit = mask_type{1} << i;
+    if (N == 0) {
+      for (auto &entry : table)
+        entry |= bit;
+    } else {
+      for (int const tag : tags)
+        table[static_cast<std::size_t>(tag)] |= bit;
+    }
+  }
+
+  static constexpr table_type make_table_() noexcept {
+    table_type table{};
+    std::size_t i = 0;
+    (add_candidate_(table, i++, details_::First_Set<std::decay_t<Ps>>::tags),
+     ...);
+    return table;
+  }
+
+private:
+  int const syntag_;
+  std::tuple<Ps...> const parsers_;
+  /* This depends only on the types of the alternatives, so it is shared */
+  static constexpr table_type table_ = make_table_();
+};
+
+//! Generate a Dispatch_Parser
+template <typename... Ps>
+inline constexpr Dispatch_Parser<Ps...> dispatch_alts(int const syntag,
+                                                      Ps &&... ps) noexcept {
+  return Dispatch_Parser<Ps...>{syntag, std::forward<Ps>(ps)...};
+}
+
 //! Match a TK_NAME that is one character long
 class Letter_Parser {
 public:
   SP_Result operator()(TT_Stream &ts) const noexcept {
     if (!Syntax_Tags::is_name(ts.peek()))
       return SP_Result{Stmt_Tree{}, false};
-    if (ts.peek_tt().text().size() != 1)
+    if (ts.peek_length() != 1)
       return SP_Result{Stmt_Tree{}, false};
     return SP_Result{Stmt_Tree{Syntax_Tags::TK_NAME, ts.digest(1)}, true};
   }
@@ -99,17 +225,23 @@ inline constexpr Letter_Parser letter() noexcept { return Letter_Parser{}; }
 class Literal_Parser {
 public:
   Literal_Parser(Literal_Parser const &) = default;
-  Literal_Parser(char const *const s) : lc_text_{s} { tolower(lc_text_); }
-  SP_Result operator()(TT_Stream &ts) const noexcept {
+  Literal_Parser(char const *const s)
+      : lc_symbol_{Symbol_Table::global().intern(s)},
+        lc_hash_{TT_Array::fold_hash(s)} {}
+  //! May throw std::bad_alloc when it interns the token text
+  SP_Result operator()(TT_Stream &ts) const {
     if (!Syntax_Tags::is_name(ts.peek()))
       return SP_Result{Stmt_Tree{}, false};
-    if (ts.peek_tt().lower() != lc_text_)
+    /* Most candidates are rejected by the hash, without interning the
+       token text */
+    if (ts.peek_fold_hash() != lc_hash_ || ts.peek_tt().symbol() != lc_symbol_)
       return SP_Result{Stmt_Tree{}, false};
     return SP_Result{Stmt_Tree{Syntax_Tags::TK_NAME, ts.digest(1)}, true};
   }
 
 private:
-  std::string lc_text_;
+  Symbol_Table::Symbol lc_symbol_;
+  std::uint32_t lc_hash_;
 };
 
 //! Generate a Literal_Parser
@@ -0,0 +1,99 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Tree_Budget.cc
+*/
+
+#include "flpr/Stmt_Tree_Budget.hh"
+#include "flpr/LL_Stmt.hh"
+
+namespace FLPR {
+
+namespace {
+using Node = Stmt::Stmt_Tree::node;
+
+/* Each node lives in a list (two links), and a fork has a list of its own
+   for its branches */
+std::size_t subtree_bytes(Node const &n) noexcept {
+  std::size_t bytes{sizeof(Node) + 2 * sizeof(void *)};
+  if (n.is_fork()) {
+    bytes += sizeof(Node::node_list);
+    for (auto const &b : n.branches())
+      bytes += subtree_bytes(b);
+  }
+  return bytes;
+}
+} // namespace
+
+void Stmt_Tree_Budget::set_max_bytes(std::size_t const max_bytes) {
+  max_bytes_ = max_bytes;
+  evict_(nullptr);
+}
+
+void Stmt_Tree_Budget::note_use(LL_Stmt const &stmt) {
+  auto const it = where_.find(&stmt);
+  if (it != where_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return;
+  }
+  std::size_t const bytes = tree_bytes(stmt.stmt_tree_);
+  lru_.push_front(Entry{&stmt, bytes});
+  where_.emplace(&stmt, lru_.begin());
+  bytes_ += bytes;
+  evict_(&stmt);
+}
+
+void Stmt_Tree_Budget::forget(LL_Stmt const &stmt) noexcept {
+  auto const it = where_.find(&stmt);
+  if (it == where_.end())
+    return;
+  bytes_ -= it->second->bytes;
+  lru_.erase(it->second);
+  where_.erase(it);
+}
+
+void Stmt_Tree_Budget::release_all() noexcept {
+  for (auto it = lru_.begin(); it != lru_.end();)
+    if (it->stmt->tree_pinned())
+      ++it;
+    else
+      drop_(it++);
+}
+
+std::size_t
+Stmt_Tree_Budget::tree_bytes(Stmt::Stmt_Tree const &tree) noexcept {
+  if (tree.empty())
+    return 0;
+  return sizeof(Node::node_list) + subtree_bytes(*tree);
+}
+
+void Stmt_Tree_Budget::evict_(LL_Stmt const *const keep) noexcept {
+  auto end = lru_.end();
+  while (bytes_ > max_bytes_ && end != lru_.begin()) {
+    auto const last = std::prev(end);
+    if (last->stmt == keep || last->stmt->tree_pinned()) {
+      end = last;
+      continue;
+    }
+    drop_(last);
+    evictions_ += 1;
+  }
+}
+
+void Stmt_Tree_Budget::drop_(Entry_List::iterator const it) noexcept {
+  LL_Stmt const *const stmt = it->stmt;
+  bytes_ -= it->bytes;
+  where_.erase(stmt);
+  lru_.erase(it);
+  stmt->stmt_tree_.clear();
+}
+
+} // namespace FLPR
@@ -0,0 +1,96 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Stmt_Tree_Budget.hh
+*/
+
+#ifndef FLPR_STMT_TREE_BUDGET_HH
+#define FLPR_STMT_TREE_BUDGET_HH 1
+
+#include "flpr/Stmt_Tree.hh"
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+namespace FLPR {
+class LL_Stmt;
+
+//! A least-recently-used limit on the memory held in LL_Stmt Stmt_Trees
+/*!
+  A Stmt_Tree has a node for every token of its statement, and a file keeps
+  one for every statement unless told otherwise, although most passes only
+  look at a few of them.  Each LL_Stmt that is attached to a Stmt_Tree_Budget
+  (see LL_Stmt::set_tree_budget()) reports its tree here whenever the tree is
+  built or used.  When the trees that are held come to more than max_bytes(),
+  the least recently used ones are dropped, to be rebuilt from the statement
+  syntag by the next LL_Stmt::stmt_tree().  The statement that is being used
+  is never dropped, nor is one with a LL_Stmt::Tree_Pin, so a budget that is
+  too small still works, it just rebuilds a lot.
+
+  The trees of attached statements are allocated from the heap rather than
+  the Logical_File Arena, so that dropping them releases the memory.
+
+  This means that, once a budget is attached, a reference returned by
+  stmt_tree() is only good until the next stmt_tree() call on another
+  statement.  Use LL_Stmt::pinned_tree() to hold on to more than one.  A Stmt_Tree_Budget is not thread-safe, and it has to outlive
+  the statements that are attached to it (or they must be detached).
+*/
+class Stmt_Tree_Budget {
+public:
+  explicit Stmt_Tree_Budget(std::size_t const max_bytes) noexcept
+      : max_bytes_{max_bytes} {}
+  Stmt_Tree_Budget(Stmt_Tree_Budget const &) = delete;
+  Stmt_Tree_Budget &operator=(Stmt_Tree_Budget const &) = delete;
+
+  constexpr std::size_t max_bytes() const noexcept { return max_bytes_; }
+  //! Change the limit, dropping trees if need be
+  void set_max_bytes(std::size_t const max_bytes);
+
+  //! The estimated size of the trees that are held
+  constexpr std::size_t bytes() const noexcept { return bytes_; }
+  //! The number of trees that are held
+  std::size_t size() const noexcept { return where_.size(); }
+  //! The number of trees that have been dropped to stay within the budget
+  constexpr std::size_t evictions() const noexcept { return evictions_; }
+
+  //! Record that the (non-empty) tree of stmt was just built or used
+  void note_use(LL_Stmt const &stmt);
+  //! Stop tracking stmt, whose tree has been cleared or replaced
+  void forget(LL_Stmt const &stmt) noexcept;
+  //! Drop every tree that is held, other than the pinned ones
+  void release_all() noexcept;
+
+  //! The estimated heap footprint of a Stmt_Tree
+  static std::size_t tree_bytes(Stmt::Stmt_Tree const &tree) noexcept;
+
+private:
+  struct Entry {
+    LL_Stmt const *stmt;
+    std::size_t bytes;
+  };
+  using Entry_List = std::list<Entry>;
+
+  //! Drop unpinned trees, least recently used first, except keep's, to fit
+  void evict_(LL_Stmt const *keep) noexcept;
+  //! Drop the tree of an entry, and remove the entry
+  void drop_(Entry_List::iterator it) noexcept;
+
+private:
+  std::size_t max_bytes_;
+  std::size_t bytes_{0};
+  std::size_t evictions_{0};
+  //! The trees that are held, most recently used first
+  Entry_List lru_;
+  std::unordered_map<LL_Stmt const *, Entry_List::iterator> where_;
+};
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,77 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Symbol_Table.cc
+*/
+
+#include "flpr/Symbol_Table.hh"
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+namespace FLPR {
+
+namespace {
+/* Fold text into a per-thread buffer, to avoid an allocation per lookup.
+   This folds the ASCII letters only, like TT_Array::fold_hash(). */
+std::string_view fold(std::string_view const text) {
+  thread_local std::string buf;
+  buf.resize(text.size());
+  std::transform(text.begin(), text.end(), buf.begin(), [](char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+  });
+  return buf;
+}
+} // namespace
+
+Symbol_Table &Symbol_Table::global() {
+  static Symbol_Table table;
+  return table;
+}
+
+Symbol_Table::Symbol Symbol_Table::intern(std::string_view const text) {
+  std::string_view const key = fold(text);
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto const it = ids_.find(key);
+    if (it != ids_.end())
+      return it->second;
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  /* Another thread may have added it while the lock was released */
+  auto const it = ids_.find(key);
+  if (it != ids_.end())
+    return it->second;
+  Symbol const sym = static_cast<Symbol>(spellings_.size());
+  spellings_.emplace_back(key);
+  ids_.emplace(spellings_.back(), sym);
+  return sym;
+}
+
+Symbol_Table::Symbol Symbol_Table::find(std::string_view const text) const {
+  std::string_view const key = fold(text);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto const it = ids_.find(key);
+  return (it == ids_.end()) ? none : it->second;
+}
+
+std::string const &Symbol_Table::spelling(Symbol const sym) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  assert(sym >= 0 && static_cast<std::size_t>(sym) < spellings_.size());
+  return spellings_[sym];
+}
+
+std::size_t Symbol_Table::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return spellings_.size();
+}
+
+} // namespace FLPR
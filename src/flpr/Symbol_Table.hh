@@ -0,0 +1,73 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Symbol_Table.hh
+*/
+
+#ifndef FLPR_SYMBOL_TABLE_HH
+#define FLPR_SYMBOL_TABLE_HH 1
+
+#include <cstddef>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace FLPR {
+
+//! Interns the case-folded spellings of Fortran names
+/*!
+  Fortran names are case-insensitive, so comparing two of them means
+  comparing their lowercase text.  A Symbol_Table gives each distinct
+  lowercase spelling a small integer Symbol, so that the comparison becomes
+  an integer compare, and each spelling is stored once no matter how many
+  tokens have it.
+
+  Symbols are never released, and are the same for every file that is
+  processed, so they may be kept in indices that outlive a Parsed_File.
+  Token_Text only interns names and keywords, so the table grows with the
+  number of distinct identifiers seen, not with the text processed.  The
+  global() table is shared by all threads: lookups take a shared lock, and
+  only the first sighting of a spelling takes the exclusive one.
+*/
+class Symbol_Table {
+public:
+  using Symbol = int;
+  //! The Symbol returned by find() for a spelling that was never interned
+  static constexpr Symbol none = -1;
+
+  Symbol_Table() = default;
+  Symbol_Table(Symbol_Table const &) = delete;
+  Symbol_Table &operator=(Symbol_Table const &) = delete;
+
+  //! The table used by Token_Text
+  static Symbol_Table &global();
+
+  //! Return the Symbol for the lowercase version of text, adding it if needed
+  Symbol intern(std::string_view text);
+  //! Return the Symbol for the lowercase version of text, or none
+  Symbol find(std::string_view text) const;
+  //! The lowercase spelling of sym (the reference stays valid)
+  std::string const &spelling(Symbol const sym) const;
+  //! The number of distinct spellings
+  std::size_t size() const;
+
+private:
+  //! The spellings, indexed by Symbol: a deque never moves its elements
+  std::deque<std::string> spellings_;
+  //! Maps views of the spellings_ to their Symbol
+  std::unordered_map<std::string_view, Symbol> ids_;
+  mutable std::shared_mutex mutex_;
+};
+
+} // namespace FLPR
+#endif
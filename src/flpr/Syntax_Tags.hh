@@ -34,6 +34,12 @@ public:
   static std::string label(int const syntag);
   static constexpr int pg_begin_tag() { return PG_000_LB + 1; }
   static constexpr int pg_end_tag() { return PG_ZZZ_UB; }
+  static constexpr int kw_begin_tag() { return KW_000_LB + 1; }
+  static constexpr int kw_end_tag() { return KW_ZZZ_UB; }
+  //! The label of a tag that isn't a client extension, at compile time
+  static constexpr char const *builtin_label(int const syntag) {
+    return strings_[syntag];
+  }
   static constexpr bool is_name(int const tag) {
     return tag == TK_NAME || types_[tag] == 4;
   }
@@ -43,6 +49,10 @@ public:
     return os << label(syntag);
   }
   static bool is_keyword(int const syntag) { return type(syntag) == 4; }
+  //! True for a builtin tag, or a client extension that has been registered
+  static bool is_valid(int const syntag) {
+    return syntag >= 0 && get_ext_idx_(syntag) != -1;
+  }
   static bool register_ext(int const tag_idx, char const *const label,
                            int const type);
 
@@ -52,6 +62,10 @@ public:
     int type{-1};
     constexpr bool empty() const { return type == -1; }
   };
+  //! The extensions, indexed by tag - CLIENT_EXTENSION (some may be empty())
+  static std::vector<Ext_Record> const &registered_exts() {
+    return extensions_;
+  }
 
 private:
   static constexpr char const *const strings_[] = {MAP(STRINGIZE)};
@@ -0,0 +1,66 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file TT_Array.cc
+*/
+
+#include "flpr/TT_Array.hh"
+#include <cassert>
+
+namespace FLPR {
+
+TT_Array::TT_Array(TT_Range &range) : end_{range.end()} {
+  std::size_t const N = range.size();
+  entries_.reserve(N);
+  handle it = range.begin();
+  for (std::size_t i = 0; i < N; ++i, ++it) {
+    std::string const &text = it->text();
+    entries_.push_back(Entry{it->token, fold_hash(text),
+                             static_cast<std::uint32_t>(text.size()), it});
+  }
+  assert(N == 0 || it == end_);
+}
+
+std::size_t TT_Array::index_of(handle h) const {
+  if (h == end_)
+    return entries_.size();
+  if (index_.empty()) {
+    index_.reserve(entries_.size());
+    for (std::size_t i = 0; i < entries_.size(); ++i)
+      index_.emplace(&*entries_[i].tt, i);
+  }
+  auto const found = index_.find(&*h);
+  return (found == index_.end()) ? entries_.size() : found->second;
+}
+
+void TT_Array::refresh(std::size_t first) {
+  for (std::size_t i = first; i < entries_.size(); ++i) {
+    Entry &e = entries_[i];
+    std::string const &text = e.tt->text();
+    e.token = e.tt->token;
+    e.fold_hash = fold_hash(text);
+    e.length = static_cast<std::uint32_t>(text.size());
+  }
+}
+
+/* FNV-1a over the ASCII-lowercased characters.  Fortran is case-insensitive
+   only in the ASCII letters, so we don't use the locale. */
+std::uint32_t TT_Array::fold_hash(std::string_view text) noexcept {
+  std::uint32_t h = 2166136261u;
+  for (unsigned char c : text) {
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    h = (h ^ c) * 16777619u;
+  }
+  return h;
+}
+
+} // namespace FLPR
@@ -0,0 +1,90 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file TT_Array.hh
+*/
+
+#ifndef FLPR_TT_ARRAY_HH
+#define FLPR_TT_ARRAY_HH 1
+
+#include "flpr/Token_Text.hh"
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace FLPR {
+
+//! A contiguous, compact copy of a range of Token_Text
+/*!
+  Walking a TT_List means chasing a pointer for every token, which is slow
+  when a parser repeatedly peeks and backtracks over the same few tokens.  A
+  TT_Array captures the parts of each token that the parsers look at most
+  often (the token value, the length of the text, and a hash of the lowercase
+  text) in one contiguous array, along with a handle to the Token_Text itself.
+
+  The handles are TT_List iterators, so they stay valid across edits to other
+  parts of the list, and they are what gets stored in LL_TT_Ranges.  The array
+  is a snapshot: if the tokens in the range are changed, call refresh().
+*/
+class TT_Array {
+public:
+  using handle = TT_Range::iterator;
+
+  //! The compact representation of one Token_Text
+  struct Entry {
+    int token;                //!< Copy of Token_Text::token
+    std::uint32_t fold_hash;  //!< fold_hash() of Token_Text::text()
+    std::uint32_t length;     //!< The length of Token_Text::text()
+    handle tt;                //!< The Token_Text this came from
+  };
+
+  TT_Array() = default;
+  //! Capture the tokens in range
+  explicit TT_Array(TT_Range &range);
+
+  std::size_t size() const noexcept { return entries_.size(); }
+  bool empty() const noexcept { return entries_.empty(); }
+  Entry const &operator[](std::size_t i) const noexcept {
+    assert(i < entries_.size());
+    return entries_[i];
+  }
+  Entry const &back() const noexcept {
+    assert(!entries_.empty());
+    return entries_.back();
+  }
+
+  //! The handle to token i, or the end handle if i == size()
+  handle at(std::size_t i) const noexcept {
+    assert(i <= entries_.size());
+    return (i < entries_.size()) ? entries_[i].tt : end_;
+  }
+  //! Return the index of a handle, or size() if it isn't in the array
+  /*! The first call builds a table of the handles, so that this is a
+      constant-time lookup. */
+  std::size_t index_of(handle h) const;
+
+  //! Re-capture the token values of entries [first, size())
+  void refresh(std::size_t first = 0);
+
+  //! A hash of the lowercase version of text
+  static std::uint32_t fold_hash(std::string_view text) noexcept;
+
+private:
+  std::vector<Entry> entries_;
+  handle end_;
+  //! The index of each Token_Text, for index_of()
+  mutable std::unordered_map<Token_Text const *, std::size_t> index_;
+};
+
+} // namespace FLPR
+#endif
@@ -13,6 +13,7 @@
 */
 
 #include "flpr/TT_Stream.hh"
+#include "flpr/Stmt_Memo.hh"
 #include <iostream>
 #include <stdexcept>
 
@@ -104,6 +105,14 @@ void TT_Stream::w_general(char const *const warnmsg) const {
   std::cerr << ll_;
 }
 
+void TT_Stream::unkeyword(const int num_toks) {
+  unkeyworded_ +=
+      FLPR::unkeyword(toks_.at(next_), ll_tt_range_.end(), num_toks);
+  toks_.refresh(next_);
+  if (memo_)
+    memo_->clear();
+}
+
 // This is a utility function used to burn through a substring
 // delimited by parens, but perhaps containing nested paren
 // substrings.
@@ -17,23 +17,39 @@
 
 #include "flpr/LL_TT_Range.hh"
 #include "flpr/Syntax_Tags.hh"
+#include "flpr/TT_Array.hh"
+#include <algorithm>
 #include <string>
 
 namespace FLPR {
 
+namespace Stmt {
+class Stmt_Memo;
+}
+
 //! Represent a stream of Token_Text
+/*!
+  The stream keeps a TT_Array of the tokens in its range, so moving around in
+  the stream is just index arithmetic.  The TT_List iterators are only used
+  when building LL_TT_Ranges (e.g. digest()) and Captures.
+*/
 class TT_Stream {
 public:
+  //! A position in the stream that can be returned to with rewind()
+  using Mark = std::size_t;
+
   //! Represent a range of Token_Text in a stream
   struct Capture {
     using iterator = TT_Range::iterator;
     using const_iterator = TT_Range::const_iterator;
 
     Capture() : complete_{false} {}
-    explicit Capture(iterator beg) : complete_(false), beg_(beg) {}
-    void close(iterator end) {
+    Capture(iterator beg, Mark beg_idx)
+        : complete_(false), beg_(beg), beg_idx_{beg_idx} {}
+    void close(iterator end, Mark end_idx) {
       complete_ = true;
       end_ = end;
+      end_idx_ = end_idx;
     }
     constexpr bool empty() const { return (!complete_ || (beg_ == end_)); }
     constexpr int size() const {
@@ -49,13 +65,33 @@ public:
   private:
     bool complete_;
     iterator beg_, end_;
+    //! The stream positions of beg_ and end_
+    Mark beg_idx_{0}, end_idx_{0};
   };
 
 public:
   explicit TT_Stream(LL_TT_Range &ll_tt)
-      : ll_tt_range_{ll_tt}, next_tok_{ll_tt_range_.begin()} {}
+      : ll_tt_range_{ll_tt}, own_toks_{ll_tt_range_}, toks_{own_toks_},
+        next_{0}, memo_{nullptr} {}
   explicit TT_Stream(LL_TT_Range &&ll_tt)
-      : ll_tt_range_{std::move(ll_tt)}, next_tok_{ll_tt_range_.begin()} {}
+      : ll_tt_range_{std::move(ll_tt)}, own_toks_{ll_tt_range_},
+        toks_{own_toks_}, next_{0}, memo_{nullptr} {}
+  //! Stream over ll_tt using toks, a TT_Array of its tokens
+  /*! This lets the streams that parse the same tokens share one TT_Array,
+      which must outlive them.  unkeyword() refreshes toks. */
+  TT_Stream(LL_TT_Range &ll_tt, TT_Array &toks)
+      : ll_tt_range_{ll_tt}, toks_{toks}, next_{0}, memo_{nullptr} {
+    assert(toks.size() == ll_tt_range_.size());
+  }
+  TT_Stream(TT_Stream &&src)
+      : ll_tt_range_{std::move(src.ll_tt_range_)},
+        own_toks_{std::move(src.own_toks_)},
+        toks_{&src.toks_ == &src.own_toks_ ? own_toks_ : src.toks_},
+        next_{src.next_}, memo_{src.memo_},
+        unkeyworded_{src.unkeyworded_} {}
+  TT_Stream(TT_Stream const &) = delete;
+  TT_Stream &operator=(TT_Stream const &) = delete;
+  TT_Stream &operator=(TT_Stream &&) = delete;
 
   /* ---------  Token stream query manipulation functions ---------- */
 
@@ -71,6 +107,10 @@ public:
   inline int peek_back() const;
   //! The curr+offset token_text or one with token==Syntax_Tags::BAD if EOL
   inline Token_Text const &peek_tt(int const offset = 1) const;
+  //! The length of the curr+1 token text (0 if EOL)
+  inline std::size_t peek_length() const;
+  //! The TT_Array::fold_hash of the curr+1 token text (0 if EOL)
+  inline std::uint32_t peek_fold_hash() const;
   //! Advance to next token
   inline void consume(int const advance = 1);
   //! Advance to the last token
@@ -81,16 +121,18 @@ public:
   inline void put_back();
   //! seek back to before the first token
   inline void rewind();
+  //! seek back to a point returned by mark()
+  inline void rewind(Mark m);
   //! seek back to a specified token
   inline void rewind(TT_Range::iterator it);
   //! mark a point that can be returned to with rewind()
-  inline TT_Range::iterator mark();
+  inline Mark mark() const;
   //! returns true if there are no more tokens in the line
   inline bool is_eol();
   //! returns the number of tokens that have been consumed
   inline int num_consumed() const;
   //! return the iterator to the next token
-  inline TT_Range::iterator next_iterator() const { return next_tok_; }
+  inline TT_Range::iterator next_iterator() const { return toks_.at(next_); }
   /* ------------ Expect a particular token in the stream ----------- */
 
   //! Consume tok or fail with an error message
@@ -123,7 +165,10 @@ public:
   //! General warning message formatted the same as "expect" errors
   void w_general(char const *const errmsg) const;
   //! Convert keyword tokens in the rest of the line (or num_toks) to IDs
-  inline void unkeyword(const int num_toks = -1);
+  /*! This clears any memo table, as the earlier results may no longer hold */
+  void unkeyword(const int num_toks = -1);
+  //! The number of tokens that unkeyword() has changed on this stream
+  constexpr int unkeyworded() const noexcept { return unkeyworded_; }
 
   //! Start capturing token indices with the next consumed token
   Capture capture_begin() const;
@@ -136,6 +181,12 @@ public:
   void debug_print(std::ostream &os) const;
   constexpr LL_TT_Range const &source() const { return ll_tt_range_; }
 
+  //! Use a packrat memo table (nullptr to disable) for sub-rule results
+  /*! The caller owns the table, which must outlive its use by this stream. */
+  void set_memo(Stmt::Stmt_Memo *memo) noexcept { memo_ = memo; }
+  //! The memo table in use, or nullptr if none
+  Stmt::Stmt_Memo *memo() const noexcept { return memo_; }
+
 private:
   /* ------------  Error reporting functions ----------------------- */
   void e_expect_tok(int tok_found, int tok_expect) const;
@@ -144,15 +195,23 @@ private:
 
 private:
   LL_TT_Range ll_tt_range_;
-  TT_Range::iterator next_tok_;
+  //! The TT_Array built for this stream, if it doesn't share one
+  TT_Array own_toks_;
+  //! The compact copy of the tokens in ll_tt_range_
+  TT_Array &toks_;
+  //! The index in toks_ of the next token to be consumed
+  std::size_t next_;
+  //! Optional packrat memo table for the statement parsers
+  Stmt::Stmt_Memo *memo_;
+  int unkeyworded_{0};
 };
 
 inline TT_Stream::Capture TT_Stream::capture_begin() const {
-  return Capture(next_tok_);
+  return Capture(toks_.at(next_), next_);
 }
 
 inline void TT_Stream::capture_end(TT_Stream::Capture &cap_rec) const {
-  cap_rec.close(next_tok_);
+  cap_rec.close(toks_.at(next_), next_);
 }
 
 inline void TT_Stream::capture_text(TT_Stream::Capture const &cap,
@@ -162,63 +221,70 @@ inline void TT_Stream::capture_text(TT_Stream::Capture const &cap,
 }
 
 inline LL_TT_Range TT_Stream::capture_to_range(TT_Stream::Capture const &cap) {
+  /* A capture that was closed after backing up past its start covers no
+     tokens (walking from beg_ to end_ would run off the end of the list) */
+  if (cap.end_idx_ < cap.beg_idx_)
+    return LL_TT_Range(ll_tt_range_.it(), cap.beg_, cap.beg_);
   return LL_TT_Range(ll_tt_range_.it(), cap.beg_, cap.end_);
 }
 
-inline void TT_Stream::unkeyword(const int num_toks) {
-  FLPR::unkeyword(next_tok_, ll_tt_range_.end(), num_toks);
-}
-
 inline Token_Text const &TT_Stream::curr_tt() const {
   static const Token_Text bad_tt;
-  if (next_tok_ != ll_tt_range_.begin())
-    return *(std::prev(next_tok_));
+  if (next_ > 0)
+    return *toks_[next_ - 1].tt;
   else
     return bad_tt;
 }
 
 // FRAGS[curr_tok_].token or Syntax_Tags::BAD
-inline int TT_Stream::curr() const { return curr_tt().token; }
+inline int TT_Stream::curr() const {
+  return (next_ > 0) ? toks_[next_ - 1].token : Syntax_Tags::BAD;
+}
 
 // FRAGS[curr_tok_+1].token or Syntax_Tags::BAD
 inline Token_Text const &TT_Stream::peek_tt(int const offset) const {
   static const Token_Text bad_tt;
-  // the -1 is because next_token_ is already advanced one.
-  auto tmp = std::next(next_tok_, offset - 1);
-  if (tmp != ll_tt_range_.end())
-    return *tmp;
+  // the -1 is because next_ is already advanced one.
+  std::size_t const pos = next_ + offset - 1;
+  if (pos < toks_.size())
+    return *toks_[pos].tt;
   else
     return bad_tt;
 }
 
+inline std::size_t TT_Stream::peek_length() const {
+  return (next_ < toks_.size()) ? toks_[next_].length : 0;
+}
+
+inline std::uint32_t TT_Stream::peek_fold_hash() const {
+  return (next_ < toks_.size()) ? toks_[next_].fold_hash : 0;
+}
+
 // FRAGS[curr_tok_+1].token or Syntax_Tags::BAD
 inline int TT_Stream::peek() const {
-  return (next_tok_ == ll_tt_range_.end()) ? Syntax_Tags::BAD
-                                           : next_tok_->token;
+  return (next_ < toks_.size()) ? toks_[next_].token : Syntax_Tags::BAD;
 }
 
-// FRAGS[curr_tok_+1].token or Syntax_Tags::BAD
+// FRAGS[curr_tok_+offset].token or Syntax_Tags::BAD
 inline int TT_Stream::peek(int const offset) const {
-  return peek_tt(offset).token;
+  std::size_t const pos = next_ + offset - 1;
+  return (pos < toks_.size()) ? toks_[pos].token : Syntax_Tags::BAD;
 }
 
-// FRAGS[curr_tok_+1].token or Syntax_Tags::BAD
+// FRAGS[last].token or Syntax_Tags::BAD
 inline int TT_Stream::peek_back() const {
-  if (ll_tt_range_.empty())
+  if (toks_.empty())
     return Syntax_Tags::BAD;
-  return ll_tt_range_.back().token;
+  return toks_.back().token;
 }
 
-inline int TT_Stream::num_consumed() const {
-  return static_cast<int>(
-      std::distance(ll_tt_range_.begin(), TT_Range::const_iterator(next_tok_)));
-}
+inline int TT_Stream::num_consumed() const { return static_cast<int>(next_); }
 
 // Note that this will consume a semicolon
 inline bool TT_Stream::is_eol() {
-  if (next_tok_ != ll_tt_range_.end()) {
-    if (Syntax_Tags::TK_SEMICOLON == next_tok_->token) {
-      next_tok_++;
+  if (next_ < toks_.size()) {
+    if (Syntax_Tags::TK_SEMICOLON == toks_[next_].token) {
+      next_ += 1;
       return true;
     } else
       return false;
@@ -227,28 +293,36 @@ inline bool TT_Stream::is_eol() {
 }
 
 inline void TT_Stream::consume(int const advance) {
-  std::advance(next_tok_, advance);
+  assert(advance >= 0 || static_cast<std::size_t>(-advance) <= next_);
+  next_ = std::min(next_ + advance, toks_.size());
 }
 
-inline void TT_Stream::consume_until_eol() { next_tok_ = ll_tt_range_.end(); }
+inline void TT_Stream::consume_until_eol() { next_ = toks_.size(); }
 
 inline LL_TT_Range TT_Stream::digest(int const advance) {
-  TT_Range::iterator beg = next_tok_;
-  std::advance(next_tok_, advance);
-  return LL_TT_Range{ll_tt_range_.it(), beg, next_tok_};
+  TT_Range::iterator beg = toks_.at(next_);
+  consume(advance);
+  return LL_TT_Range{ll_tt_range_.it(), beg, toks_.at(next_)};
 }
 
 // curr_ = max(-1, curr_tok_ - 1)
 inline void TT_Stream::put_back() {
-  if (next_tok_ != ll_tt_range_.begin())
-    next_tok_--;
+  if (next_ > 0)
+    next_ -= 1;
 }
 
-inline void TT_Stream::rewind() { next_tok_ = ll_tt_range_.begin(); }
+inline void TT_Stream::rewind() { next_ = 0; }
 
-inline void TT_Stream::rewind(TT_Range::iterator it) { next_tok_ = it; }
+inline void TT_Stream::rewind(Mark m) {
+  assert(m <= toks_.size());
+  next_ = m;
+}
+
+inline void TT_Stream::rewind(TT_Range::iterator it) {
+  next_ = toks_.index_of(it);
+}
 
-inline TT_Range::iterator TT_Stream::mark() { return next_tok_; }
+inline TT_Stream::Mark TT_Stream::mark() const { return next_; }
 
 inline void TT_Stream::expect_tok(const int tok) {
   const int next_tok = peek();
@@ -287,7 +361,7 @@ inline std::string const &TT_Stream::expect_id_low() {
     e_expect_id(next_tok);
   }
   consume();
-  return curr_tt().lower();
+  return Symbol_Table::global().spelling(curr_tt().symbol());
 }
 } // namespace FLPR
 #endif
@@ -0,0 +1,93 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Text_Buffer.cc
+*/
+
+#include "flpr/Text_Buffer.hh"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FLPR {
+
+Text_Buffer::~Text_Buffer() {
+  if (mapped_)
+    munmap(const_cast<char *>(data_), size_);
+}
+
+std::shared_ptr<Text_Buffer const>
+Text_Buffer::from_file(std::string const &fname) {
+  int const fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat sb;
+  if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+    void *const addr =
+        mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      close(fd);
+      std::shared_ptr<Text_Buffer> result{new Text_Buffer};
+      result->data_ = static_cast<char const *>(addr);
+      result->size_ = sb.st_size;
+      result->mapped_ = true;
+      /* The scanner makes a single sequential pass */
+      madvise(addr, sb.st_size, MADV_SEQUENTIAL);
+      return result;
+    }
+  }
+  close(fd);
+
+  /* Couldn't map it: fall back to reading */
+  std::ifstream is(fname);
+  if (!is)
+    return nullptr;
+  return from_stream(is);
+}
+
+std::shared_ptr<Text_Buffer const> Text_Buffer::from_stream(std::istream &is) {
+  std::string text{std::istreambuf_iterator<char>(is),
+                   std::istreambuf_iterator<char>()};
+  return from_string(std::move(text));
+}
+
+std::shared_ptr<Text_Buffer const>
+Text_Buffer::from_string(std::string &&text) {
+  std::shared_ptr<Text_Buffer> result{new Text_Buffer};
+  result->str_.swap(text);
+  result->data_ = result->str_.data();
+  result->size_ = result->str_.size();
+  return result;
+}
+
+Text_Buffer::Line_Views Text_Buffer::lines() const {
+  Line_Views result;
+  char const *curr = data_;
+  char const *const end = data_ + size_;
+  /* Guess at an average line length of 40 to avoid most reallocation */
+  result.reserve(size_ / 40 + 1);
+  while (curr < end) {
+    char const *nl =
+        static_cast<char const *>(std::memchr(curr, '\n', end - curr));
+    if (!nl)
+      nl = end;
+    result.emplace_back(curr, nl - curr);
+    curr = nl + 1;
+  }
+  return result;
+}
+
+} // namespace FLPR
@@ -0,0 +1,72 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Text_Buffer.hh
+*/
+
+#ifndef FLPR_TEXT_BUFFER_HH
+#define FLPR_TEXT_BUFFER_HH 1
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FLPR {
+
+//! An immutable buffer holding the complete text of an input file
+/*!
+  Regular files are memory-mapped read-only, so that the scanner can refer to
+  the text in place rather than copying each line.  Anything that can't be
+  mapped (pipes, empty files, or systems without mmap) is read into a private
+  string instead.  Text_Buffers are shared by the File_Lines that refer into
+  them, and are released when the last of those goes away.
+*/
+class Text_Buffer {
+public:
+  using Line_Views = std::vector<std::string_view>;
+
+  Text_Buffer(Text_Buffer const &) = delete;
+  Text_Buffer &operator=(Text_Buffer const &) = delete;
+  ~Text_Buffer();
+
+  //! Map (or read) the named file.  Returns nullptr if it can't be opened.
+  static std::shared_ptr<Text_Buffer const> from_file(std::string const &fname);
+
+  //! Read the remaining contents of a stream
+  static std::shared_ptr<Text_Buffer const> from_stream(std::istream &is);
+
+  //! Take over the contents of a string
+  static std::shared_ptr<Text_Buffer const> from_string(std::string &&text);
+
+  //! The complete text
+  std::string_view text() const noexcept { return {data_, size_}; }
+
+  //! True if the text is memory-mapped
+  bool is_mapped() const noexcept { return mapped_; }
+
+  //! Split the text into lines, with the same conventions as std::getline
+  /*! The newlines are not part of the lines, and a final newline does not
+      start an empty line. */
+  Line_Views lines() const;
+
+private:
+  Text_Buffer() = default;
+
+  char const *data_{nullptr};
+  std::size_t size_{0};
+  bool mapped_{false};
+  std::string str_;
+};
+
+} // namespace FLPR
+#endif
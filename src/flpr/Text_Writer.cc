@@ -0,0 +1,150 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Text_Writer.cc
+*/
+
+#include "flpr/Text_Writer.hh"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FLPR {
+
+namespace {
+/* Write all of text to fd, retrying after partial writes and interrupts */
+bool write_all(int fd, std::string_view text) {
+  char const *curr = text.data();
+  std::size_t remaining = text.size();
+  while (remaining > 0) {
+    ssize_t const n = ::write(fd, curr, remaining);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    curr += n;
+    remaining -= n;
+  }
+  return true;
+}
+
+/* Return the name of the file that fname refers to, so that replacing a
+   symbolic link replaces its target */
+std::string resolve_links(std::string const &fname) {
+  struct stat sb;
+  if (lstat(fname.c_str(), &sb) == 0 && S_ISLNK(sb.st_mode)) {
+    char target[PATH_MAX];
+    if (realpath(fname.c_str(), target))
+      return target;
+  }
+  return fname;
+}
+} // namespace
+
+void Text_Writer::append_(File_Line const &fl) {
+  if (fl.is_unmodified()) {
+    std::string_view const raw = fl.raw_text();
+    /* Text_Buffer lines are separated by single newlines, so extend the run
+       if this line follows it in the buffer */
+    if (span_begin_ && raw.data() == span_end_ + 1 && *span_end_ == '\n') {
+      span_end_ = raw.data() + raw.size();
+    } else {
+      flush_span_();
+      span_begin_ = raw.data();
+      span_end_ = raw.data() + raw.size();
+    }
+    span_newline_ = !fl.ends_without_newline();
+    return;
+  }
+  flush_span_();
+  std::string_view const left = fl.left_text.view();
+  buf_.append(left);
+  /* Match the column alignment of operator<<(std::ostream&, File_Line) */
+  if (fl.is_fortran() && fl.is_fixed_format() && left.size() < 6)
+    buf_.append(6 - left.size(), ' ');
+  buf_.append(fl.left_space.view());
+  buf_.append(fl.main_text.view());
+  buf_.append(fl.right_space.view());
+  buf_.append(fl.right_text.view());
+  if (!fl.ends_without_newline())
+    buf_.push_back('\n');
+}
+
+void Text_Writer::append_(Logical_Line const &ll) {
+  if (ll.suppress)
+    return;
+  for (auto const &fl : ll.layout())
+    append_(fl);
+}
+
+void Text_Writer::flush_span_() {
+  if (span_begin_) {
+    buf_.append(span_begin_, span_end_ - span_begin_);
+    if (span_newline_)
+      buf_.push_back('\n');
+    span_begin_ = span_end_ = nullptr;
+  }
+}
+
+bool Text_Writer::write(int fd) {
+  if (!write_all(fd, buf_)) {
+    std::cerr << "Text_Writer::write: " << std::strerror(errno) << '\n';
+    return false;
+  }
+  clear();
+  return true;
+}
+
+bool Text_Writer::replace_file(std::string const &fname,
+                               std::string_view original) {
+  if (text() == original) {
+    clear();
+    return true;
+  }
+
+  std::string const target = resolve_links(fname);
+  struct stat sb;
+  if (stat(target.c_str(), &sb) != 0) {
+    std::cerr << "Text_Writer::replace_file: unable to stat \"" << fname
+              << "\": " << std::strerror(errno) << '\n';
+    return false;
+  }
+
+  /* The temporary has to be in the same directory (so the same filesystem)
+     for the rename to be atomic */
+  std::string tmp_name{target + ".flpr.XXXXXX"};
+  int const fd = mkstemp(tmp_name.data());
+  if (fd < 0) {
+    std::cerr << "Text_Writer::replace_file: unable to create a temporary "
+                 "file for \""
+              << fname << "\": " << std::strerror(errno) << '\n';
+    return false;
+  }
+  bool ok = write_all(fd, buf_) && fchmod(fd, sb.st_mode & 07777) == 0;
+  ok = (close(fd) == 0) && ok;
+  ok = ok && std::rename(tmp_name.c_str(), target.c_str()) == 0;
+  if (!ok) {
+    std::cerr << "Text_Writer::replace_file: unable to replace \"" << fname
+              << "\": " << std::strerror(errno) << '\n';
+    unlink(tmp_name.c_str());
+    return false;
+  }
+  clear();
+  return true;
+}
+
+} // namespace FLPR
@@ -0,0 +1,98 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Text_Writer.hh
+*/
+
+#ifndef FLPR_TEXT_WRITER_HH
+#define FLPR_TEXT_WRITER_HH 1
+
+#include "flpr/Logical_Line.hh"
+#include <string>
+#include <string_view>
+
+namespace FLPR {
+
+//! Render Logical_Lines into a buffer, and write it out with one system call
+/*!
+  This copies the File_Line fields straight into a std::string, avoiding the
+  per-field overhead of iostreams.  Lines that haven't been changed since they
+  were scanned (see File_Line::is_unmodified()) are not rendered at all:
+  consecutive runs of them are copied verbatim from their Text_Buffer, so
+  untouched code is reproduced byte-for-byte, and the cost of writing a file
+  mostly depends on how much of it was edited.  Otherwise, the text is the
+  same as printing the lines to a std::ostream.
+
+  The buffer keeps its capacity when it is cleared, so one Text_Writer can be
+  reused for many files without reallocating.
+*/
+class Text_Writer {
+public:
+  Text_Writer() = default;
+  //! Reserve space for capacity characters
+  explicit Text_Writer(std::size_t capacity) { buf_.reserve(capacity); }
+
+  //! Render a File_Line, followed by a newline
+  /*! The newline is left off the last line of a Text_Buffer that didn't
+      end in one, so that the file is reproduced exactly. */
+  void append(File_Line const &fl) {
+    append_(fl);
+    flush_span_();
+  }
+  //! Render each File_Line of ll, unless it is suppressed
+  void append(Logical_Line const &ll) {
+    append_(ll);
+    flush_span_();
+  }
+  //! Render a sequence of Logical_Lines
+  void append(LL_List const &lines) {
+    for (auto const &ll : lines)
+      append_(ll);
+    flush_span_();
+  }
+
+  //! The text rendered so far
+  std::string_view text() const noexcept { return buf_; }
+  std::size_t size() const noexcept { return buf_.size(); }
+  bool empty() const noexcept { return buf_.empty(); }
+
+  //! Discard the text, but keep the storage
+  void clear() noexcept { buf_.clear(); }
+
+  //! Write the text to a file descriptor, then clear it
+  /*! Returns false if the write fails, in which case the text is kept. */
+  bool write(int fd);
+
+  //! Atomically replace the contents of a file with the text, then clear it
+  /*! The text is written to a temporary file in the same directory, which is
+      then renamed over fname, so that readers see either the old or the new
+      contents.  The file is left alone (but the text is still cleared) if
+      original, the current contents of the file, is the same as the text.
+      Returns false, leaving fname untouched, if anything fails. */
+  bool replace_file(std::string const &fname, std::string_view original);
+
+private:
+  void append_(File_Line const &fl);
+  void append_(Logical_Line const &ll);
+  void flush_span_();
+
+private:
+  std::string buf_;
+  //! A run of unmodified source text that hasn't been copied to buf_ yet
+  /*! This doesn't include the newline at the end of the run. */
+  char const *span_begin_{nullptr};
+  char const *span_end_{nullptr};
+  //! False if the run ends a Text_Buffer that has no final newline
+  bool span_newline_{true};
+};
+
+} // namespace FLPR
+#endif
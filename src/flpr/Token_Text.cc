@@ -23,14 +23,14 @@ namespace FLPR {
 Token_Text::Token_Text()
     : token(Syntax_Tags::BAD), start_line(-1), start_pos(-1) {}
 
-std::string const &Token_Text::lower() const {
-  // Lazy construction
-  if (lower_.empty()) {
-    lower_.resize(text_.size());
-    std::transform(text_.begin(), text_.end(), lower_.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-  }
-  return lower_;
+std::string Token_Text::lower() const {
+  Symbol_Table::Symbol const sym = symbol();
+  if (Symbol_Table::none != sym)
+    return Symbol_Table::global().spelling(sym);
+  std::string result(text_.size(), '\0');
+  std::transform(text_.begin(), text_.end(), result.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return result;
 }
 
 std::ostream &operator<<(std::ostream &os, Token_Text const &tt) {
@@ -53,13 +53,17 @@ void render(std::ostream &os, TT_List::const_iterator beg,
   os << beg->text();
 }
 
-void unkeyword(TT_List::iterator beg, const TT_List::iterator end,
-               int first_N) {
+int unkeyword(TT_List::iterator beg, const TT_List::iterator end,
+              int first_N) {
+  int changed{0};
   while (beg != end && first_N--) {
-    if (Syntax_Tags::is_keyword(beg->token))
+    if (Syntax_Tags::is_keyword(beg->token)) {
       beg->token = Syntax_Tags::TK_NAME;
+      changed += 1;
+    }
     beg++;
   }
+  return changed;
 }
 
 } // namespace FLPR
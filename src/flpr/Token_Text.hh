@@ -16,6 +16,7 @@
 #define FLPR_TOKEN_TEXT_HH 1
 
 #include "flpr/Safe_List.hh"
+#include "flpr/Symbol_Table.hh"
 #include "flpr/Syntax_Tags.hh"
 #include <ostream>
 #include <string>
@@ -23,6 +24,7 @@
 namespace FLPR {
 class Logical_Line;
 class Logical_File;
+class Parse_Cache;
 
 //! A token, and it's corresponding text, as discovered by the lexer.
 /*!
@@ -39,6 +41,7 @@ class Token_Text {
 public:
   friend class Logical_Line;
   friend class Logical_File;
+  friend class Parse_Cache;
   Token_Text();
   Token_Text(std::string &&txti, int toki, int sli, int spi)
       : token(toki), start_line(sli), start_pos(spi), text_(std::move(txti)) {}
@@ -49,13 +52,25 @@ public:
 
   //! Const access to the text
   std::string const &text() const noexcept { return text_; }
-  //! Provide a modifiable reference to text: clears lower_
+  //! Provide a modifiable reference to text: forgets symbol_
   std::string &mod_text() noexcept {
-    lower_.clear();
+    symbol_ = Symbol_Table::none;
     return text_;
   }
-  //! Access the lowercase version of text
-  std::string const &lower() const;
+  //! The Symbol_Table::global() symbol for the lowercase version of text
+  /*! Two names have the same symbol iff their text is the same, ignoring
+      case, so this is the fast way to compare names.  Only names and
+      keywords are interned: other tokens (literals, operators) return
+      Symbol_Table::none, so that they never grow the table. */
+  Symbol_Table::Symbol symbol() const {
+    // Lazy construction
+    if (Symbol_Table::none == symbol_ && Syntax_Tags::is_name(token))
+      symbol_ = Symbol_Table::global().intern(text_);
+    return symbol_;
+  }
+  //! The lowercase version of text
+  /*! For a name, this is a copy of its Symbol_Table spelling */
+  std::string lower() const;
 
   int pre_spaces() const noexcept { return pre_spaces_; }
   int post_spaces() const noexcept { return post_spaces_; }
@@ -68,7 +83,8 @@ public:
 
 private:
   std::string text_;          //!< The matched text (lexeme)
-  mutable std::string lower_; //!< Lowercase version of the text
+  //! The interned lowercase text, or Symbol_Table::none until needed
+  mutable Symbol_Table::Symbol symbol_{Symbol_Table::none};
 
   /*********************************************************************/
   /*                   For use by Logical_Line friend                  */
@@ -104,8 +120,10 @@ using TT_List = FLPR::Safe_List<Token_Text>;
 //! A range of Token_Text
 using TT_Range = FLPR::SL_Range<Token_Text>;
 
-void unkeyword(TT_List::iterator beg, const TT_List::iterator end,
-               int first_N = -1);
+//! Make the keywords in [beg, end) (or the first_N tokens) into names
+/*! Returns the number of tokens that were changed */
+int unkeyword(TT_List::iterator beg, const TT_List::iterator end,
+              int first_N = -1);
 std::ostream &operator<<(std::ostream &os, Token_Text const &tt);
 
 void render(std::ostream &os, TT_List::const_iterator beg,
@@ -22,6 +22,7 @@
 #include <ostream>
 #include <type_traits>
 
+#include "flpr/Arena.hh"
 #include "flpr/Safe_List.hh"
 
 namespace FLPR {
@@ -31,6 +32,40 @@ template <class Tp, class Alloc> class Tree;
 //! FLPR internal implementation details
 namespace details_ {
 
+//! A std::unique_ptr deleter that returns the memory to an allocator
+template <class Alloc> struct Alloc_Delete {
+  using traits = std::allocator_traits<Alloc>;
+  Alloc alloc;
+  void operator()(typename traits::value_type *p) noexcept {
+    traits::destroy(alloc, p);
+    traits::deallocate(alloc, p, 1);
+  }
+};
+
+//! A std::unique_ptr to a T that was allocated from (a rebound) Alloc
+template <class T, class Alloc>
+using alloc_unique_ptr = std::unique_ptr<
+    T, Alloc_Delete<
+           typename std::allocator_traits<Alloc>::template rebind_alloc<T>>>;
+
+//! Similar to std::make_unique, but allocating from alloc
+template <class T, class Alloc, class... Args>
+alloc_unique_ptr<T, Alloc> allocate_unique(Alloc const &alloc,
+                                           Args &&... args) {
+  using T_Alloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using traits = std::allocator_traits<T_Alloc>;
+  T_Alloc a{alloc};
+  T *const p = traits::allocate(a, 1);
+  try {
+    traits::construct(a, p, std::forward<Args>(args)...);
+  } catch (...) {
+    traits::deallocate(a, p, 1);
+    throw;
+  }
+  return alloc_unique_ptr<T, Alloc>{p, Alloc_Delete<T_Alloc>{a}};
+}
+
 template <class Tp, class Alloc> class TN_Cursor;
 template <class Tp, class Alloc> class TN_Const_Cursor;
 
@@ -63,15 +98,17 @@ public:
   // You must call link to finish constructing this class!
   template <class... Args>
   explicit constexpr Tree_Node(Args &&... args)
-      : contents_{std::make_unique<Contents_>(std::forward<Args>(args)...)},
+      : contents_{allocate_unique<Contents_>(allocator{},
+                                             std::forward<Args>(args)...)},
         linked_{false} {}
 
   explicit constexpr Tree_Node(value_type &&src)
-      : contents_{std::make_unique<Contents_>(std::move(src))}, linked_{false} {
-  }
+      : contents_{allocate_unique<Contents_>(allocator{}, std::move(src))},
+        linked_{false} {}
 
   explicit constexpr Tree_Node(value_type const &src)
-      : contents_{std::make_unique<Contents_>(src)}, linked_{false} {}
+      : contents_{allocate_unique<Contents_>(allocator{}, src)},
+        linked_{false} {}
 
   constexpr void link(iterator self) noexcept {
     linked_ = true;
@@ -168,12 +205,11 @@ public:
   }
 
 private:
-  /*  NOTE NOTE NOTE FIX
-     The use of std::unique_ptr in this implementation section is bad because
-     the memory is NOT allocated from any supplied \c allocator (that's just how
-     std::unique_ptr works).  This needs to switch to \c
-     std::allocator_traits::construct.
-  */
+  /* The contents and branch lists are allocated from (rebound copies of) a
+     default-constructed \c allocator, and each unique_ptr deleter carries the
+     allocator that the memory came from.  For a Scope_Allocator, this means
+     that the whole node is allocated from the Arena that was current when the
+     node was constructed. */
 
   //! Bundle up the value and branches to make for easy swapping
   class Contents_ {
@@ -201,12 +237,15 @@ private:
     //! Pointer to node_list of branches
     /*! We use a pointer here because there are (often) many leaf nodes, and we
       don't want to pay the overhead for unused branch lists in these nodes.  */
-    std::unique_ptr<node_list> branch_p_;
+    alloc_unique_ptr<node_list, allocator> branch_p_;
 
     //! Create branch list, if needed
+    /*! This uses the allocator that was captured when the Contents_ were
+        constructed, so a lazily-created list comes from the same place. */
     constexpr void init_branches_() {
       if (!branch_p_) {
-        branch_p_ = std::make_unique<node_list>();
+        auto const &alloc = branch_p_.get_deleter().alloc;
+        branch_p_ = allocate_unique<node_list>(alloc, alloc);
       }
     }
   }; // Contents_
@@ -216,7 +255,7 @@ private:
       nodes without needing Tp to be swappable. It also cleans up the notion of
       disconnecting the contents from a tree, in which case it no longer has a
       self_itr_ or parent_. */
-  std::unique_ptr<Contents_> contents_;
+  alloc_unique_ptr<Contents_, allocator> contents_;
 
   /*! @name treenode_links Tree_Node Link Variables
     In addition to branches/children, each Tree_Node contains a link up to its
@@ -559,7 +598,7 @@ private:
 /*! Each node can have an arbitrary number of branches (children), and user data
  *  of type \c Tp is stored at each node.
  */
-template <class Tp, class Alloc = std::allocator<Tp>> class Tree {
+template <class Tp, class Alloc = Scope_Allocator<Tp>> class Tree {
 public:
   using node = details_::Tree_Node<Tp, Alloc>;
   using node_list = typename node::node_list;
@@ -583,19 +622,22 @@ public:
 
   template <class... Args>
   constexpr explicit Tree(Args &&... args)
-      : root_list_p_{std::make_unique<node_list>()} {
+      : root_list_p_{details_::allocate_unique<node_list>(
+            typename node::allocator{})} {
     root_list_p_->emplace_front(std::forward<Args>(args)...);
     root_list_p_->front().link(root_list_p_->begin());
   }
 
   constexpr explicit Tree(value const &src)
-      : root_list_p_{std::make_unique<node_list>()} {
-    root_list_p_->push_front(node(src));
+      : root_list_p_{details_::allocate_unique<node_list>(
+            typename node::allocator{})} {
+    root_list_p_->emplace_front(src);
     root_list_p_->front().link(root_list_p_->begin());
   }
 
   constexpr explicit Tree(value &&src)
-      : root_list_p_{std::make_unique<node_list>()} {
+      : root_list_p_{details_::allocate_unique<node_list>(
+            typename node::allocator{})} {
     root_list_p_->emplace_front(std::move(src));
     root_list_p_->front().link(root_list_p_->begin());
   }
@@ -604,7 +646,8 @@ public:
   /*! Note that this differs from Tree(), which does NOT allocate a root_list.
       Here, we have a valid root_node which can be altered later. */
   constexpr explicit Tree(bool val)
-      : root_list_p_{std::make_unique<node_list>()} {
+      : root_list_p_{details_::allocate_unique<node_list>(
+            typename node::allocator{})} {
     if (val) {
       root_list_p_->emplace_front(value{});
       root_list_p_->front().link(root_list_p_->begin());
@@ -682,6 +725,18 @@ public:
     return graft(root_node().branches().end(), std::move(donor));
   }
 
+  //! Return a deep copy of this tree
+  /*! This requires that \c Tp be copy-constructible. */
+  Tree clone() const {
+    if (!tree_initialized())
+      return Tree{};
+    if (root_list_p_->empty())
+      return Tree{false};
+    Tree result{*root_node()};
+    clone_branches_(root_node(), *result);
+    return result;
+  }
+
   void swap(Tree &other) {
     /* exchanging the root_list_p_ pointers doesn't invalidate the self_itr_ or
        parent_ members of the nodes because this swap doesn't change the
@@ -700,7 +755,7 @@ private:
    *  - We're using a std::unique_ptr here for the root node list because we
    *    want very lightweight copies of empty trees. Could use std::optional.
    */
-  std::unique_ptr<node_list> root_list_p_;
+  details_::alloc_unique_ptr<node_list, typename node::allocator> root_list_p_;
 
   //! Return a reference to the single root node in the root_list
   constexpr node &root_node() {
@@ -715,6 +770,16 @@ private:
     assert(!root_list_p_->empty());
     return root_list_p_->front();
   }
+
+  //! Append copies of the branches of src to dst
+  static void clone_branches_(node const &src, node &dst) {
+    if (src.is_fork()) {
+      for (auto const &b : src.branches()) {
+        auto new_branch = dst.emplace_back(node{*b});
+        clone_branches_(b, *new_branch);
+      }
+    }
+  }
 };
 
 template <class Tp, class Alloc> void Tree<Tp, Alloc>::check() const {
@@ -0,0 +1,152 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Tree_Image.cc
+*/
+
+#include "flpr/Tree_Image.hh"
+#include <iostream>
+#include <limits>
+
+namespace FLPR {
+
+namespace {
+/* Token fields that don't fit in an int are taken to be corrupt */
+bool fits_int(std::uint64_t const val) {
+  return val <= static_cast<std::uint64_t>(std::numeric_limits<int>::max());
+}
+} // namespace
+
+Tree_Image::Tree_Image(std::shared_ptr<Text_Buffer const> data) {
+  if (!data)
+    return;
+  std::string_view const text = data->text();
+  Byte_Reader in{text};
+  bool ok = in.get_raw(magic.size()) == magic &&
+            in.get_uint() == format_version;
+  std::uint64_t const kind = in.get_uint();
+  source_name_ = in.get_string();
+  std::uint64_t const num_tokens = in.get_uint();
+  /* Each token takes at least four bytes */
+  ok = ok && in && kind <= 1 && num_tokens <= in.remaining() / 4;
+  if (!ok) {
+    std::cerr << "Tree_Image: not a tree image, or not version "
+              << format_version << '\n';
+    return;
+  }
+  kind_ = static_cast<Kind>(kind);
+
+  /* Index the token table, checking that each entry can be decoded */
+  tokens_.reserve(num_tokens);
+  std::int64_t line{0};
+  for (std::uint64_t i = 0; i < num_tokens && ok; ++i) {
+    std::size_t const offset = text.size() - in.remaining();
+    ok = fits_int(in.get_uint());
+    line += in.get_int();
+    ok = ok && line >= 0 && fits_int(static_cast<std::uint64_t>(line));
+    ok = ok && fits_int(in.get_uint());
+    in.get_string();
+    tokens_.push_back(Token_Entry{offset, static_cast<int>(line)});
+  }
+  std::uint64_t const has_root = in.get_uint();
+  std::size_t const root_offset = text.size() - in.remaining();
+  ok = ok && in && has_root <= 1;
+  if (ok && has_root) {
+    root_offset_ = root_offset;
+    data_ = data;
+    /* The tree has to take up the rest of the image */
+    Node const r = root();
+    ok = r && r.end_ == text.size();
+  } else {
+    ok = ok && in.at_end();
+  }
+  if (!ok) {
+    std::cerr << "Tree_Image: corrupt tree image\n";
+    data_.reset();
+    tokens_.clear();
+    root_offset_ = 0;
+    return;
+  }
+  data_ = std::move(data);
+}
+
+Tree_Image Tree_Image::from_file(std::string const &fname) {
+  auto data = Text_Buffer::from_file(fname);
+  if (!data) {
+    std::cerr << "Tree_Image: unable to open file \"" << fname
+              << "\" for reading\n";
+    return Tree_Image{};
+  }
+  return Tree_Image{std::move(data)};
+}
+
+Tree_Image Tree_Image::from_string(std::string image) {
+  return Tree_Image{Text_Buffer::from_string(std::move(image))};
+}
+
+Tree_Image::Token Tree_Image::token(std::size_t const idx) const {
+  Token_Entry const &entry = tokens_.at(idx);
+  Byte_Reader in{text_().substr(entry.offset)};
+  Token result;
+  result.token = static_cast<int>(in.get_uint());
+  in.get_int();
+  result.line = entry.line;
+  result.col = static_cast<int>(in.get_uint());
+  result.text = in.get_string();
+  return result;
+}
+
+Tree_Image::Node Tree_Image::root() const {
+  if (!data_ || !root_offset_)
+    return Node{};
+  return decode_(root_offset_, text_().size(), 0, 0, 0);
+}
+
+Tree_Image::Node Tree_Image::decode_(std::size_t const offset,
+                                     std::size_t const limit,
+                                     std::size_t const parent_begin,
+                                     std::size_t const parent_tokens,
+                                     std::size_t const siblings) const {
+  if (offset >= limit)
+    return Node{};
+  Byte_Reader in{text_().substr(offset, limit - offset)};
+  Node_Code code;
+  if (!code.get(in))
+    return Node{};
+  std::uint64_t const num_branches = code.num_branches;
+  std::uint64_t begin{parent_begin}, span{parent_tokens};
+  if (!code.same_span) {
+    span = in.get_uint();
+    if (span)
+      begin += in.get_int();
+  }
+  std::uint64_t const child_bytes = num_branches ? in.get_uint() : 0;
+  if (!in || begin > num_tokens() ||
+      span > num_tokens() - begin || child_bytes > in.remaining() ||
+      num_branches > child_bytes)
+    return Node{};
+  Node n;
+  n.image_ = this;
+  n.syntag_ = code.syntag;
+  n.is_stmt_ = code.is_stmt;
+  n.num_branches_ = static_cast<std::size_t>(num_branches);
+  n.token_begin_ = static_cast<std::size_t>(begin);
+  n.num_tokens_ = static_cast<std::size_t>(span);
+  n.children_ = limit - in.remaining();
+  n.end_ = n.children_ + static_cast<std::size_t>(child_bytes);
+  n.siblings_ = siblings;
+  n.parent_begin_ = parent_begin;
+  n.parent_tokens_ = parent_tokens;
+  n.parent_end_ = limit;
+  return n;
+}
+
+} // namespace FLPR
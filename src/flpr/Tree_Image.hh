@@ -0,0 +1,253 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Tree_Image.hh
+
+  Read-only access to the binary images written by a Tree_Image_Writer.
+*/
+
+#ifndef FLPR_TREE_IMAGE_HH
+#define FLPR_TREE_IMAGE_HH 1
+
+#include "flpr/Byte_Stream.hh"
+#include "flpr/Text_Buffer.hh"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FLPR {
+
+//! A compact, serialized Prgm_Tree or Stmt_Tree
+/*!
+  A tree image is a self-contained binary encoding of a parse tree, meant for
+  tools that want FLPR's results without running (or linking) the scanner and
+  parsers.  It is read in place: opening an image memory-maps the file (see
+  Text_Buffer) and indexes its token table, and the nodes are decoded from the
+  bytes as they are visited, so walking part of a large tree costs only as
+  much as the part that is walked.
+
+  The image starts with the magic string and format_version, the Kind of
+  tree, and the name of the source file.  Then comes a table of the tokens
+  that the tree covers, in file order, each of which is its token id (from
+  scan_toks.h), line (relative to that of the previous token), column, and
+  text.  Then the nodes follow, in preorder.  Each node is:
+
+    - its Node_Code: the syntag (see Syntax_Tags), and its shape, which is
+      the number of branches, shifted left two bits, with bit 1 set if it
+      covers the same tokens as its parent, and bit 0 set if it is a
+      statement of a Prgm_Tree
+    - unless bit 1 is set, the number of tokens that it covers, and, if that
+      is nonzero, the index of the first one, relative to that of its parent
+      (or to zero, for the root)
+    - if it has branches, the number of bytes that they take up
+
+  after which come its branches.  Integers are variable-length (see
+  Byte_Writer), so most fields take a single byte, and the byte count lets a
+  reader step over a whole subtree without decoding it.  In a Prgm_Tree
+  image, the branch of a statement node (if it has one) is the root of the
+  statement's Stmt_Tree.
+
+  A Tree_Image and its Nodes refer into the image data, so the Tree_Image must
+  outlive them.  Corrupt data is detected as it is read: a Node that can't be
+  decoded is returned as a null Node.
+*/
+class Tree_Image {
+public:
+  //! The kind of tree held in an image
+  enum class Kind { STMT_TREE = 0, PRGM_TREE = 1 };
+
+  //! One entry of the token table
+  struct Token {
+    int token;             //!< A token identifier from scan_toks.h
+    int line;              //!< The file line number of its start
+    int col;               //!< The file character position of its start
+    std::string_view text; //!< The text, as scanned
+  };
+
+  class Node;
+  class Branch_Iterator;
+
+  //! Identifies the start of an image
+  static constexpr std::string_view magic{"FLPR tree image\n"};
+  //! Change this whenever the encoding changes
+  static constexpr std::uint64_t format_version = 1;
+
+  //! An invalid image
+  Tree_Image() = default;
+  //! Use the image held in data.  The result is false if it isn't valid.
+  explicit Tree_Image(std::shared_ptr<Text_Buffer const> data);
+  //! Map (or read) the named image file
+  static Tree_Image from_file(std::string const &fname);
+  //! Use an image held in a string (such as Tree_Image_Writer::image())
+  static Tree_Image from_string(std::string image);
+
+  //! True if the header and token table are valid
+  explicit operator bool() const noexcept { return data_ != nullptr; }
+
+  Kind kind() const noexcept { return kind_; }
+  //! The name of the file that the tree was parsed from
+  std::string_view source_name() const noexcept { return source_name_; }
+
+  std::size_t num_tokens() const noexcept { return tokens_.size(); }
+  //! Decode entry idx of the token table
+  Token token(std::size_t const idx) const;
+
+  //! True if the image holds an empty tree
+  bool empty() const noexcept { return root_offset_ == 0; }
+  //! The root of the tree, or a null Node if the image is empty or invalid
+  Node root() const;
+
+private:
+  //! Where to find each token, and its (absolute) line number
+  struct Token_Entry {
+    std::size_t offset;
+    int line;
+  };
+
+  /* Decode the node starting at offset, which has to end by limit.  The
+     parent_ arguments describe the span of its parent. */
+  Node decode_(std::size_t offset, std::size_t limit,
+               std::size_t parent_begin, std::size_t parent_tokens,
+               std::size_t siblings) const;
+
+  std::string_view text_() const noexcept { return data_->text(); }
+
+private:
+  std::shared_ptr<Text_Buffer const> data_;
+  Kind kind_{Kind::STMT_TREE};
+  std::string_view source_name_;
+  std::vector<Token_Entry> tokens_;
+  std::size_t root_offset_{0};
+};
+
+//! A lightweight reference to a node of a Tree_Image
+/*!
+  A Node holds the decoded fields of one node, and the position of its
+  branches in the image.  It is cheap to copy, and nothing else is decoded
+  until first_branch() or next_sibling() is called.
+*/
+class Tree_Image::Node {
+public:
+  //! A null Node
+  Node() = default;
+
+  //! False for a null Node
+  explicit operator bool() const noexcept { return image_ != nullptr; }
+
+  int syntag() const noexcept { return syntag_; }
+  std::size_t num_branches() const noexcept { return num_branches_; }
+  bool is_leaf() const noexcept { return num_branches_ == 0; }
+  bool is_fork() const noexcept { return num_branches_ != 0; }
+  //! True for the statement nodes of a Prgm_Tree
+  /*! The branch of a statement, if it has one, is its Stmt_Tree. */
+  bool is_stmt() const noexcept { return is_stmt_; }
+
+  //! The index of the first token covered by this node
+  std::size_t token_begin() const noexcept { return token_begin_; }
+  //! One past the index of the last token covered by this node
+  std::size_t token_end() const noexcept { return token_begin_ + num_tokens_; }
+  std::size_t num_tokens() const noexcept { return num_tokens_; }
+
+  //! The first branch, or a null Node for a leaf
+  Node first_branch() const {
+    if (!num_branches_)
+      return Node{};
+    return image_->decode_(children_, end_, token_begin_, num_tokens_,
+                           num_branches_ - 1);
+  }
+  //! The next branch of the parent, or a null Node for the last one
+  Node next_sibling() const {
+    if (!siblings_)
+      return Node{};
+    return image_->decode_(end_, parent_end_, parent_begin_, parent_tokens_,
+                           siblings_ - 1);
+  }
+
+  //! A range over the branches of this node
+  class Branches;
+  Branches branches() const noexcept;
+
+private:
+  friend class Tree_Image;
+  friend class Branch_Iterator;
+  Tree_Image const *image_{nullptr};
+  int syntag_{0};
+  bool is_stmt_{false};
+  std::size_t num_branches_{0};
+  std::size_t token_begin_{0};
+  std::size_t num_tokens_{0};
+  //! The offsets of the branches, and of the end of the subtree
+  std::size_t children_{0}, end_{0};
+  //! The number of branches of the parent that follow this one
+  std::size_t siblings_{0};
+  //! What is needed to decode the next sibling
+  std::size_t parent_begin_{0};
+  std::size_t parent_tokens_{0};
+  std::size_t parent_end_{0};
+};
+
+//! A forward iterator over the branches of a Tree_Image::Node
+class Tree_Image::Branch_Iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = Node;
+  using difference_type = std::ptrdiff_t;
+  using pointer = Node const *;
+  using reference = Node const &;
+
+  Branch_Iterator() = default;
+  explicit Branch_Iterator(Node const &n) : node_{n} {}
+
+  reference operator*() const noexcept { return node_; }
+  pointer operator->() const noexcept { return &node_; }
+  Branch_Iterator &operator++() {
+    node_ = node_.next_sibling();
+    return *this;
+  }
+  Branch_Iterator operator++(int) {
+    Branch_Iterator const tmp{*this};
+    ++(*this);
+    return tmp;
+  }
+  /* Only the end iterator holds a null Node */
+  bool operator==(Branch_Iterator const &rhs) const noexcept {
+    return node_.image_ == rhs.node_.image_ &&
+           (!node_ || node_.end_ == rhs.node_.end_);
+  }
+  bool operator!=(Branch_Iterator const &rhs) const noexcept {
+    return !(*this == rhs);
+  }
+
+private:
+  Node node_;
+};
+
+class Tree_Image::Node::Branches {
+public:
+  explicit Branches(Node const &parent) noexcept : parent_{parent} {}
+  Branch_Iterator begin() const {
+    return Branch_Iterator{parent_.first_branch()};
+  }
+  Branch_Iterator end() const noexcept { return Branch_Iterator{}; }
+
+private:
+  Node parent_;
+};
+
+inline Tree_Image::Node::Branches Tree_Image::Node::branches() const noexcept {
+  return Branches{*this};
+}
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,116 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Tree_Image_Writer.cc
+*/
+
+#include "flpr/Tree_Image_Writer.hh"
+#include <fstream>
+
+namespace FLPR {
+
+bool Tree_Image_Writer::encode(Stmt::Stmt_Tree const &t,
+                               std::string_view const source_name) {
+  out_.str().clear();
+  if (!frozen_.freeze(t)) {
+    std::cerr << "Tree_Image_Writer: unable to encode a Stmt_Tree of \""
+              << source_name << "\"\n";
+    return false;
+  }
+  encode(frozen_, source_name);
+  frozen_.clear();
+  return true;
+}
+
+/* A node that covers the same tokens as its parent (as is usual for nodes
+   with one branch) doesn't record its span */
+void Tree_Image_Writer::encode(Frozen_Tree const &ft,
+                               std::string_view const source_name) {
+  using index_type = Frozen_Tree::index_type;
+  index_type const N = ft.size();
+  auto const same_span = [&ft](index_type const n) {
+    index_type const p = ft.parent(n);
+    return p != Frozen_Tree::npos &&
+           ft.token_begin(n) == ft.token_begin(p) &&
+           ft.num_tokens(n) == ft.num_tokens(p);
+  };
+  auto const code = [&](index_type const n) {
+    return Node_Code{ft.syntag(n), ft.num_branches(n), same_span(n),
+                     ft.is_stmt(n)};
+  };
+  auto const span_delta = [&ft](index_type const n) {
+    index_type const p = ft.parent(n);
+    std::int64_t const parent_begin =
+        (p == Frozen_Tree::npos) ? 0 : ft.token_begin(p);
+    return std::int64_t{ft.token_begin(n)} - parent_begin;
+  };
+
+  /* The size of each subtree, from the leaves up.  The branches of a node
+     follow it in preorder, so they are all done before it is. */
+  child_bytes_.assign(N, 0);
+  for (index_type n = N; n-- > 1;) {
+    std::uint64_t size = code(n).size() + child_bytes_[n];
+    if (!same_span(n)) {
+      size += Byte_Writer::uint_size(ft.num_tokens(n));
+      if (ft.num_tokens(n))
+        size += Byte_Writer::int_size(span_delta(n));
+    }
+    if (!ft.is_leaf(n))
+      size += Byte_Writer::uint_size(child_bytes_[n]);
+    child_bytes_[ft.parent(n)] += size;
+  }
+
+  out_.str().clear();
+  out_.put_raw(Tree_Image::magic);
+  out_.put_uint(Tree_Image::format_version);
+  out_.put_uint(static_cast<std::uint64_t>(ft.is_prgm_tree()
+                                               ? Tree_Image::Kind::PRGM_TREE
+                                               : Tree_Image::Kind::STMT_TREE));
+  out_.put_string(source_name);
+  out_.put_uint(ft.tokens().size());
+  int line{0};
+  for (Token_Text const *tt : ft.tokens()) {
+    out_.put_uint(static_cast<std::uint64_t>(tt->token));
+    out_.put_int(tt->start_line - line);
+    out_.put_uint(static_cast<std::uint64_t>(tt->start_pos));
+    out_.put_string(tt->text());
+    line = tt->start_line;
+  }
+  out_.put_uint(N != 0);
+  for (index_type n = 0; n < N; ++n) {
+    code(n).put(out_);
+    if (!same_span(n)) {
+      out_.put_uint(ft.num_tokens(n));
+      if (ft.num_tokens(n))
+        out_.put_int(span_delta(n));
+    }
+    if (!ft.is_leaf(n))
+      out_.put_uint(child_bytes_[n]);
+  }
+  child_bytes_.clear();
+}
+
+bool Tree_Image_Writer::write(std::ostream &os) const {
+  os.write(image().data(), static_cast<std::streamsize>(image().size()));
+  return static_cast<bool>(os);
+}
+
+bool Tree_Image_Writer::save(std::string const &fname) const {
+  std::ofstream os(fname, std::ios::binary);
+  if (!os) {
+    std::cerr << "Tree_Image_Writer: unable to open file \"" << fname
+              << "\" for writing\n";
+    return false;
+  }
+  return write(os);
+}
+
+} // namespace FLPR
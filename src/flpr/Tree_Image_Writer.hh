@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Tree_Image_Writer.hh
+*/
+
+#ifndef FLPR_TREE_IMAGE_WRITER_HH
+#define FLPR_TREE_IMAGE_WRITER_HH 1
+
+#include "flpr/Byte_Stream.hh"
+#include "flpr/Frozen_Tree.hh"
+#include "flpr/Tree_Image.hh"
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FLPR {
+
+//! Encode a parse tree as a Tree_Image
+/*!
+  The tree is frozen first (see Frozen_Tree), which numbers the nodes in
+  preorder and collects the tokens into a table.  Then the number of bytes
+  under each node is computed, from the leaves up, and everything is written
+  out.  A writer can be reused for any number of trees.
+*/
+class Tree_Image_Writer {
+public:
+  //! Encode a Stmt_Tree, which was parsed from the named file
+  bool encode(Stmt::Stmt_Tree const &t, std::string_view source_name = {});
+
+  //! Encode a Prgm_Tree, optionally including the Stmt_Tree of each statement
+  template <typename PG_NODE_DATA, typename ALLOC>
+  bool encode(Tree<PG_NODE_DATA, ALLOC> const &t,
+              std::string_view source_name = {},
+              bool const with_stmt_trees = true);
+
+  //! Encode a tree that has already been frozen
+  void encode(Frozen_Tree const &ft, std::string_view source_name = {});
+
+  //! The most recent image (empty if encoding failed)
+  std::string const &image() const noexcept { return out_.str(); }
+
+  //! Write the image to a stream
+  bool write(std::ostream &os) const;
+  //! Write the image to the named file
+  bool save(std::string const &fname) const;
+
+private:
+  Frozen_Tree frozen_;
+  std::vector<std::uint64_t> child_bytes_;
+  Byte_Writer out_;
+};
+
+template <typename PG_NODE_DATA, typename ALLOC>
+bool Tree_Image_Writer::encode(Tree<PG_NODE_DATA, ALLOC> const &t,
+                               std::string_view const source_name,
+                               bool const with_stmt_trees) {
+  out_.str().clear();
+  if (!frozen_.freeze(t, with_stmt_trees)) {
+    std::cerr << "Tree_Image_Writer: unable to encode the Prgm_Tree of \""
+              << source_name << "\"\n";
+    return false;
+  }
+  encode(frozen_, source_name);
+  frozen_.clear();
+  return true;
+}
+
+} // namespace FLPR
+#endif
@@ -0,0 +1,155 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Unit_Stream.cc
+*/
+
+#include "flpr/Unit_Stream.hh"
+#include "flpr/parse_stmt.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace FLPR {
+
+namespace {
+/* The statements that matter when looking for the end of a program unit */
+enum class Unit_Stmt { OTHER, START, END, INTERFACE, END_INTERFACE };
+
+Unit_Stmt classify(LL_Stmt &stmt, bool const in_interface) {
+  /* All of the interesting statements begin with a keyword, so don't bother
+     with the parsers for the (many) statements that don't */
+  if (!Syntax_Tags::is_keyword(stmt.lead_tag()))
+    return Unit_Stmt::OTHER;
+  if (stmt.parse_with(Stmt::interface_stmt))
+    return Unit_Stmt::INTERFACE;
+  if (stmt.parse_with(Stmt::end_interface_stmt))
+    return Unit_Stmt::END_INTERFACE;
+  for (auto f : {Stmt::program_stmt, Stmt::module_stmt, Stmt::submodule_stmt,
+                 Stmt::subroutine_stmt, Stmt::function_stmt})
+    if (stmt.parse_with(f))
+      return Unit_Stmt::START;
+  /* In an interface block, MODULE PROCEDURE is a procedure-stmt */
+  if (!in_interface && stmt.parse_with(Stmt::mp_subprogram_stmt))
+    return Unit_Stmt::START;
+  for (auto f : {Stmt::end_program_stmt, Stmt::end_module_stmt,
+                 Stmt::end_submodule_stmt, Stmt::end_subroutine_stmt,
+                 Stmt::end_function_stmt, Stmt::end_mp_subprogram_stmt})
+    if (stmt.parse_with(f))
+      return Unit_Stmt::END;
+  return Unit_Stmt::OTHER;
+}
+} // namespace
+
+Unit_Splitter::Unit_Splitter(std::shared_ptr<Text_Buffer const> buffer,
+                             std::string const &buffer_name,
+                             int const last_fixed_col, File_Type file_type)
+    : buffer_{std::move(buffer)}, buffer_name_{buffer_name},
+      last_fixed_col_{last_fixed_col},
+      file_type_{File_Info{buffer_name, file_type}.file_type} {
+  if (buffer_)
+    raw_lines_ = buffer_->lines();
+  else
+    bad_ = true;
+}
+
+bool Unit_Splitter::next(Logical_File &lf) {
+  if (!*this)
+    return false;
+  if (cuts_.empty() && !find_cuts_()) {
+    bad_ = true;
+    return false;
+  }
+  std::size_t const first = next_line_;
+  std::size_t const cut = cuts_.front();
+  cuts_.pop_front();
+  assert(cut > first && cut <= raw_lines_.size());
+  next_line_ = cut;
+  Text_Buffer::Line_Views const unit_lines(raw_lines_.begin() + first,
+                                           raw_lines_.begin() + cut);
+  if (!lf.scan(buffer_, unit_lines, first, buffer_name_, last_fixed_col_,
+               file_type_)) {
+    bad_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool Unit_Splitter::find_cuts_() {
+  std::size_t const N = raw_lines_.size();
+  std::size_t window = initial_window;
+  while (cuts_.empty()) {
+    std::size_t const end = std::min(N, next_line_ + window);
+    if (!cut_window_(end))
+      return false;
+    window *= 2;
+  }
+  return true;
+}
+
+bool Unit_Splitter::cut_window_(std::size_t const end) {
+  std::size_t const N = raw_lines_.size();
+  bool const at_eof = (end == N);
+  Logical_File lf;
+  Text_Buffer::Line_Views const window(raw_lines_.begin() + next_line_,
+                                       raw_lines_.begin() + end);
+  if (!lf.scan(buffer_, window, next_line_, buffer_name_, last_fixed_col_,
+               file_type_))
+    return false;
+  lf.make_stmts();
+
+  LL_STMT_SEQ &stmts = lf.ll_stmts;
+  int depth = 0;
+  int interfaces = 0;
+  bool stmts_after_cut = false;
+  for (auto it = stmts.begin(); it != stmts.end(); ++it) {
+    stmts_after_cut = true;
+    switch (classify(*it, interfaces > 0)) {
+    case Unit_Stmt::INTERFACE:
+      interfaces += 1;
+      break;
+    case Unit_Stmt::END_INTERFACE:
+      if (interfaces > 0)
+        interfaces -= 1;
+      break;
+    case Unit_Stmt::START:
+      depth += 1;
+      break;
+    case Unit_Stmt::END: {
+      /* An END without a matching start closes a main program */
+      depth = std::max(0, depth - 1);
+      if (depth > 0)
+        break;
+      auto const next = std::next(it);
+      /* Don't cut a compound line, and don't trust the last statement in
+         the window: it may be continued on lines that we haven't scanned. */
+      if (next == stmts.end() ? !at_eof : next->stmt_ll() == it->stmt_ll())
+        break;
+      cuts_.push_back(it->stmt_ll()->layout().back().linenum);
+      stmts_after_cut = false;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  if (at_eof) {
+    /* Whatever follows the last unit end becomes part of the last unit, or
+       is a unit of its own if it contains any statements */
+    if (cuts_.empty() || stmts_after_cut)
+      cuts_.push_back(N);
+    else
+      cuts_.back() = N;
+  }
+  return true;
+}
+
+} // namespace FLPR
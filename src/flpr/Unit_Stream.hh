@@ -0,0 +1,154 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Unit_Stream.hh
+*/
+
+#ifndef FLPR_UNIT_STREAM_HH
+#define FLPR_UNIT_STREAM_HH 1
+
+#include "flpr/Logical_File.hh"
+#include "flpr/Parsed_File.hh"
+#include "flpr/Text_Buffer.hh"
+#include <deque>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <string>
+
+namespace FLPR {
+
+//! Break the text of a file into top-level program units
+/*!
+  Each call to next() scans the lines of one program unit (main program,
+  module, submodule, or external subprogram) into a Logical_File.  Comments
+  and other non-statement lines go with the unit that follows them, and any
+  trailing ones go with the last unit.
+
+  To find where a unit ends, the splitter scans a window of raw lines and
+  classifies the unit start and end statements in it, growing the window
+  until it holds at least one complete unit.  The lines of each unit are then
+  scanned again on their own, so memory use is bounded by the window and the
+  largest unit rather than by the whole file.
+*/
+class Unit_Splitter {
+public:
+  //! The number of raw lines in the first window
+  static constexpr std::size_t initial_window = 4096;
+
+  Unit_Splitter(std::shared_ptr<Text_Buffer const> buffer,
+                std::string const &buffer_name, int const last_fixed_col,
+                File_Type file_type = File_Type::UNKNOWN);
+
+  //! True if there are more lines, and nothing has gone wrong
+  explicit operator bool() const noexcept {
+    return !bad_ && next_line_ < raw_lines_.size();
+  }
+
+  //! True if a scan failed, so that the units don't cover the whole buffer
+  bool failed() const noexcept { return bad_; }
+
+  //! Scan the next program unit into lf, which should be empty
+  /*! \returns false if there are no more units, or the scan failed */
+  bool next(Logical_File &lf);
+
+  //! The (index origin = 0) raw line where the next unit begins
+  std::size_t next_line() const noexcept { return next_line_; }
+
+private:
+  //! Find the ends of the units that begin at or after next_line_
+  bool find_cuts_();
+  //! Scan [next_line_, end) and record any unit ends found in it
+  bool cut_window_(std::size_t const end);
+
+private:
+  std::shared_ptr<Text_Buffer const> buffer_;
+  Text_Buffer::Line_Views raw_lines_;
+  std::string buffer_name_;
+  int last_fixed_col_;
+  File_Type file_type_;
+  //! Where the next unit starts
+  std::size_t next_line_{0};
+  //! Known unit ends (exclusive raw line indices) past next_line_
+  std::deque<std::size_t> cuts_;
+  bool bad_{false};
+};
+
+//! Present a file as a sequence of Parsed_Files, one per program unit
+/*!
+  This is for files too large to hold in memory all at once.  Each unit has
+  its own Logical_File and parse tree, and is released when the caller lets
+  go of it:
+  \code
+    FLPR::Unit_Stream<> units{filename, 0};
+    while (auto unit = units.next()) {
+      transform(*unit);
+      for (auto const &ll : unit->logical_lines())
+        os << ll;
+    }
+  \endcode
+  File_Line numbers are those of the whole file.
+*/
+template <typename PG_NODE_DATA = Prgm::Prgm_Node_Data> class Unit_Stream {
+public:
+  using Unit = Parsed_File<PG_NODE_DATA>;
+
+  //! Open the named file
+  Unit_Stream(std::string const &filename, int const last_fixed_col,
+              File_Type file_type = File_Type::UNKNOWN)
+      : Unit_Stream(open_(filename), filename, last_fixed_col, file_type) {}
+
+  //! Read the remaining contents of a stream
+  Unit_Stream(std::istream &is, std::string const &stream_name,
+              int const last_fixed_col,
+              File_Type stream_type = File_Type::UNKNOWN)
+      : Unit_Stream(Text_Buffer::from_stream(is), stream_name, last_fixed_col,
+                    stream_type) {}
+
+  //! Split an existing Text_Buffer
+  Unit_Stream(std::shared_ptr<Text_Buffer const> buffer,
+              std::string const &buffer_name, int const last_fixed_col,
+              File_Type buffer_type = File_Type::UNKNOWN)
+      : splitter_{std::move(buffer), buffer_name, last_fixed_col,
+                  buffer_type} {}
+
+  //! True if there may be more units
+  explicit operator bool() const noexcept { return bool(splitter_); }
+
+  //! True if a scan failed before the end of the text was reached
+  bool failed() const noexcept { return splitter_.failed(); }
+
+  //! Scan the next program unit, or return nullptr if there are no more
+  /*! The statements and parse tree of the unit are built lazily, as for any
+      other Parsed_File. */
+  std::unique_ptr<Unit> next() {
+    Logical_File lf;
+    if (!splitter_.next(lf))
+      return nullptr;
+    return std::make_unique<Unit>(std::move(lf));
+  }
+
+private:
+  static std::shared_ptr<Text_Buffer const> open_(std::string const &fname) {
+    auto buffer = Text_Buffer::from_file(fname);
+    if (!buffer) {
+      std::cerr << "Unit_Stream: unable to open file \"" << fname
+                << "\" for reading\n";
+    }
+    return buffer;
+  }
+
+private:
+  Unit_Splitter splitter_;
+};
+
+} // namespace FLPR
+#endif
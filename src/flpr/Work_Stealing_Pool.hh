@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*!
+  \file Work_Stealing_Pool.hh
+*/
+
+#ifndef FLPR_WORK_STEALING_POOL_HH
+#define FLPR_WORK_STEALING_POOL_HH 1
+
+#include <cassert>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FLPR {
+
+//! Run a fixed batch of independent tasks on a set of worker threads
+/*!
+  The tasks are dealt round-robin, in the order given, onto one deque per
+  worker.  Each worker takes tasks from the front of its own deque, so if the
+  caller sorts the batch from most to least expensive, every worker starts on
+  the most expensive work.  A worker with an empty deque steals from the back
+  of another worker's deque.  No tasks are added during run(), so a worker
+  exits once every deque is empty.
+*/
+class Work_Stealing_Pool {
+public:
+  using Task = std::function<void()>;
+
+  explicit Work_Stealing_Pool(int const num_threads)
+      : queues_(num_threads > 0 ? num_threads : 1) {}
+
+  //! Number of worker threads used by run()
+  int num_threads() const { return static_cast<int>(queues_.size()); }
+
+  //! Execute all of the tasks, returning when they have all completed
+  void run(std::vector<Task> tasks) {
+    int const N = num_threads();
+    for (size_t i = 0; i < tasks.size(); ++i)
+      queues_[i % N].tasks.emplace_back(std::move(tasks[i]));
+    if (N == 1) {
+      worker_(0);
+      return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(N);
+    for (int w = 0; w < N; ++w)
+      workers.emplace_back(&Work_Stealing_Pool::worker_, this, w);
+    for (auto &t : workers)
+      t.join();
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  //! Take the next task from the front of worker w's own deque
+  bool pop_(int const w, Task &task) {
+    Queue &q{queues_[w]};
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+      return false;
+    task = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    return true;
+  }
+
+  //! Take a task from the back of some other worker's deque
+  bool steal_(int const w, Task &task) {
+    int const N = num_threads();
+    for (int i = 1; i < N; ++i) {
+      Queue &q{queues_[(w + i) % N]};
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void worker_(int const w) {
+    Task task;
+    while (pop_(w, task) || steal_(w, task)) {
+      assert(task);
+      task();
+    }
+  }
+
+private:
+  std::vector<Queue> queues_;
+};
+
+} // namespace FLPR
+#endif
@@ -16,10 +16,18 @@ The master high-level include file for FLPR applications
 #ifndef FLPR_FLPR_HH
 #define FLPR_FLPR_HH 1
 
+#include "flpr/Edit_Transaction.hh"
+#include "flpr/Frozen_Tree.hh"
+#include "flpr/Parse_Cache.hh"
 #include "flpr/Parsed_File.hh"
 #include "flpr/Procedure.hh"
 #include "flpr/Procedure_Visitor.hh"
+#include "flpr/Project_Index.hh"
 #include "flpr/Stmt_Parser_Exts.hh"
+#include "flpr/Symbol_Table.hh"
+#include "flpr/Text_Writer.hh"
+#include "flpr/Tree_Image_Writer.hh"
+#include "flpr/Unit_Stream.hh"
 #include "flpr/utils.hh"
 
 #endif
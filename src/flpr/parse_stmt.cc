@@ -13,12 +13,16 @@
 */
 
 #include "flpr/parse_stmt.hh"
+#include "flpr/Stmt_Memo.hh"
 #include "flpr/Stmt_Parser_Exts.hh"
 #include "flpr/Stmt_Parsers.hh"
 
 #define TRACE_SG 0
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 namespace FLPR {
 namespace Stmt {
@@ -52,6 +56,24 @@ namespace Stmt {
 #define TAG(X) Syntax_Tags::X
 #define TOK(X) tok(Syntax_Tags::X)
 
+//! Evaluate parser p, reusing an earlier result for this rule and position
+/*! This only does anything if ts has a Stmt_Memo.  It is used for the
+    sub-rules that the alternatives end up re-parsing from the same token. */
+template <typename P>
+Stmt_Tree memoize(TT_Stream &ts, int const rule_tag, P const &p) {
+  Stmt_Memo *const memo = ts.memo();
+  if (!memo)
+    return p(ts);
+  TT_Stream::Mark const start = ts.mark();
+  if (auto const *prev = memo->find(rule_tag, start)) {
+    ts.rewind(prev->end);
+    return prev->tree.clone();
+  }
+  Stmt_Tree result = p(ts);
+  memo->insert(rule_tag, start, ts.mark(), result);
+  return result;
+}
+
 //! Subparser to consume until the end of an expression
 Stmt_Tree consume_until_break(TT_Stream &ts, int const rule_tag) {
   INIT_FAIL;
@@ -194,46 +216,46 @@ Stmt_Tree access_stmt(TT_Stream &ts) {
 Stmt_Tree action_stmt(TT_Stream &ts) {
   RULE(SG_ACTION_STMT);
   constexpr auto p =
-    alts(rule_tag,
-         rule(allocate_stmt),
+    dispatch_alts(rule_tag,
+         starts_with<TAG(KW_ALLOCATE)>(rule(allocate_stmt)),
          rule(assignment_stmt),
-         rule(backspace_stmt),
-         rule(call_stmt),
-         rule(close_stmt),
-         rule(continue_stmt),
-         rule(cycle_stmt),
-         rule(deallocate_stmt),
-         rule(endfile_stmt),
-         rule(error_stop_stmt),
-         rule(event_post_stmt),
-         rule(event_wait_stmt),
-         rule(exit_stmt),
-         rule(fail_image_stmt),
-         rule(flush_stmt),
-         rule(form_team_stmt),
-         rule(goto_stmt),
-         rule(if_stmt),
-         rule(inquire_stmt),
-         rule(lock_stmt),
-         rule(nullify_stmt),
-         rule(open_stmt),
+         starts_with<TAG(KW_BACKSPACE)>(rule(backspace_stmt)),
+         starts_with<TAG(KW_CALL)>(rule(call_stmt)),
+         starts_with<TAG(KW_CLOSE)>(rule(close_stmt)),
+         starts_with<TAG(KW_CONTINUE)>(rule(continue_stmt)),
+         starts_with<TAG(KW_CYCLE)>(rule(cycle_stmt)),
+         starts_with<TAG(KW_DEALLOCATE)>(rule(deallocate_stmt)),
+         starts_with<TAG(KW_END)>(rule(endfile_stmt)),
+         starts_with<TAG(KW_ERROR)>(rule(error_stop_stmt)),
+         starts_with<TAG(KW_EVENT)>(rule(event_post_stmt)),
+         starts_with<TAG(KW_EVENT)>(rule(event_wait_stmt)),
+         starts_with<TAG(KW_EXIT)>(rule(exit_stmt)),
+         starts_with<TAG(KW_FAIL)>(rule(fail_image_stmt)),
+         starts_with<TAG(KW_FLUSH)>(rule(flush_stmt)),
+         starts_with<TAG(KW_FORM)>(rule(form_team_stmt)),
+         starts_with<TAG(KW_GO)>(rule(goto_stmt)),
+         starts_with<TAG(KW_IF)>(rule(if_stmt)),
+         starts_with<TAG(KW_INQUIRE)>(rule(inquire_stmt)),
+         starts_with<TAG(KW_LOCK)>(rule(lock_stmt)),
+         starts_with<TAG(KW_NULLIFY)>(rule(nullify_stmt)),
+         starts_with<TAG(KW_OPEN)>(rule(open_stmt)),
          rule(pointer_assignment_stmt),
-         rule(print_stmt),
-         rule(read_stmt),
-         rule(return_stmt),
-         rule(rewind_stmt),
-         rule(stop_stmt),
-         rule(sync_all_stmt),
-         rule(sync_images_stmt),
-         rule(sync_memory_stmt),
-         rule(sync_team_stmt),
-         rule(unlock_stmt),
-         rule(wait_stmt),
-         rule(where_stmt),
-         rule(write_stmt),
-         rule(computed_goto_stmt),
-         rule(arithmetic_if_stmt),
-         rule(forall_stmt),
+         starts_with<TAG(KW_PRINT)>(rule(print_stmt)),
+         starts_with<TAG(KW_READ)>(rule(read_stmt)),
+         starts_with<TAG(KW_RETURN)>(rule(return_stmt)),
+         starts_with<TAG(KW_REWIND)>(rule(rewind_stmt)),
+         starts_with<TAG(KW_STOP)>(rule(stop_stmt)),
+         starts_with<TAG(KW_SYNC)>(rule(sync_all_stmt)),
+         starts_with<TAG(KW_SYNC)>(rule(sync_images_stmt)),
+         starts_with<TAG(KW_SYNC)>(rule(sync_memory_stmt)),
+         starts_with<TAG(KW_SYNC)>(rule(sync_team_stmt)),
+         starts_with<TAG(KW_UNLOCK)>(rule(unlock_stmt)),
+         starts_with<TAG(KW_WAIT)>(rule(wait_stmt)),
+         starts_with<TAG(KW_WHERE)>(rule(where_stmt)),
+         starts_with<TAG(KW_WRITE)>(rule(write_stmt)),
+         starts_with<TAG(KW_GO)>(rule(computed_goto_stmt)),
+         starts_with<TAG(KW_IF)>(rule(arithmetic_if_stmt)),
+         starts_with<TAG(KW_FORALL)>(rule(forall_stmt)),
          rule(macro_stmt));
   auto res = p(ts);
   if(!res.match) {
@@ -1028,7 +1050,7 @@ Stmt_Tree data_ref(TT_Stream &ts) {
         rule(part_ref),
         star(h_seq(TOK(TK_PERCENT), rule(part_ref)))
         );
-  EVAL(SG_DATA_REF, p(ts));
+  EVAL(SG_DATA_REF, memoize(ts, rule_tag, p));
 }
 
 //! R837: data-stmt (8.6.7)
@@ -1246,7 +1268,7 @@ Stmt_Tree designator(TT_Stream &ts) {
         rule(data_ref),
         opt(h_parens(rule(substring_range)))
         );
-  EVAL(SG_DESIGNATOR, p(ts));
+  EVAL(SG_DESIGNATOR, memoize(ts, rule_tag, p));
 }
 
 //! R848: dimension-stmt (8.6.8)
@@ -1734,7 +1756,9 @@ Stmt_Tree expr(TT_Stream &ts) {
   if(TAG(TK_ASTERISK) == ts.peek() ||
      TAG(TK_SLASHF) == ts.peek())
     return Stmt_Tree{};
-  EVAL(SG_EXPR, consume_until_break(ts, rule_tag));
+  EVAL(SG_EXPR, memoize(ts, rule_tag, [](TT_Stream &ts) {
+         return consume_until_break(ts, rule_tag);
+       }));
 }
 
 //! R610: extended-intrinsic-op (6.2.4)
@@ -2599,26 +2623,26 @@ Stmt_Tree optional_stmt(TT_Stream &ts) {
 Stmt_Tree other_specification_stmt(TT_Stream &ts) {
   RULE(SG_OTHER_SPECIFICATION_STMT);
   constexpr auto p =
-    alts(rule_tag,
-         rule(access_stmt),
-         rule(allocatable_stmt),
-         rule(asynchronous_stmt),
-         rule(bind_stmt),
-         rule(codimension_stmt),
-         rule(dimension_stmt),
-         rule(external_stmt),
-         rule(intent_stmt),
-         rule(intrinsic_stmt),
-         rule(namelist_stmt),
-         rule(optional_stmt),
-         rule(pointer_stmt),
-         rule(protected_stmt),
-         rule(save_stmt),
-         rule(target_stmt),
-         rule(volatile_stmt),
-         rule(value_stmt),
-         rule(common_stmt),
-         rule(equivalence_stmt)
+    dispatch_alts(rule_tag,
+         starts_with<TAG(KW_PUBLIC), TAG(KW_PRIVATE)>(rule(access_stmt)),
+         starts_with<TAG(KW_ALLOCATABLE)>(rule(allocatable_stmt)),
+         starts_with<TAG(KW_ASYNCHRONOUS)>(rule(asynchronous_stmt)),
+         starts_with<TAG(KW_BIND)>(rule(bind_stmt)),
+         starts_with<TAG(KW_CODIMENSION)>(rule(codimension_stmt)),
+         starts_with<TAG(KW_DIMENSION)>(rule(dimension_stmt)),
+         starts_with<TAG(KW_EXTERNAL)>(rule(external_stmt)),
+         starts_with<TAG(KW_INTENT)>(rule(intent_stmt)),
+         starts_with<TAG(KW_INTRINSIC)>(rule(intrinsic_stmt)),
+         starts_with<TAG(KW_NAMELIST)>(rule(namelist_stmt)),
+         starts_with<TAG(KW_OPTIONAL)>(rule(optional_stmt)),
+         starts_with<TAG(KW_POINTER)>(rule(pointer_stmt)),
+         starts_with<TAG(KW_PROTECTED)>(rule(protected_stmt)),
+         starts_with<TAG(KW_SAVE)>(rule(save_stmt)),
+         starts_with<TAG(KW_TARGET)>(rule(target_stmt)),
+         starts_with<TAG(KW_VOLATILE)>(rule(volatile_stmt)),
+         starts_with<TAG(KW_VALUE)>(rule(value_stmt)),
+         starts_with<TAG(KW_COMMON)>(rule(common_stmt)),
+         starts_with<TAG(KW_EQUIVALENCE)>(rule(equivalence_stmt))
          );
   auto res = p(ts);
   if(!res.match) {
@@ -3727,7 +3751,7 @@ Stmt_Tree variable(TT_Stream &ts) {
          rule(function_reference),
          rule(designator)
          );
-  EVAL(SG_VARIABLE, p(ts));
+  EVAL(SG_VARIABLE, memoize(ts, rule_tag, p));
 }
 
 
@@ -4275,6 +4299,148 @@ bool is_action_stmt(int const syntag) {
   return res;
 }
 
+bool may_lead(parser_function const f, int const lead_tag) {
+  /* The possible lead tags for the parsers that the program parsers use.
+     A parser that isn't listed here (e.g. one that starts with a type-spec
+     or a variable) can match any lead tag. */
+  static std::unordered_map<parser_function, std::vector<int>> const leads{
+      {associate_stmt, {TAG(KW_ASSOCIATE)}},
+      {binding_private_stmt, {TAG(KW_PRIVATE)}},
+      {block_stmt, {TAG(KW_BLOCK)}},
+      {case_stmt, {TAG(KW_CASE)}},
+      {contains_stmt, {TAG(KW_CONTAINS)}},
+      {continue_stmt, {TAG(KW_CONTINUE)}},
+      {data_stmt, {TAG(KW_DATA)}},
+      {derived_type_stmt, {TAG(KW_TYPE)}},
+      {do_stmt, {TAG(KW_DO)}},
+      {else_if_stmt, {TAG(KW_ELSE)}},
+      {else_stmt, {TAG(KW_ELSE)}},
+      {elsewhere_stmt, {TAG(KW_ELSE)}},
+      {end_associate_stmt, {TAG(KW_END)}},
+      {end_block_stmt, {TAG(KW_END)}},
+      {end_do, {TAG(KW_END), TAG(KW_CONTINUE)}},
+      {end_do_stmt, {TAG(KW_END)}},
+      {end_enum_stmt, {TAG(KW_END)}},
+      {end_forall_stmt, {TAG(KW_END)}},
+      {end_function_stmt, {TAG(KW_END)}},
+      {end_if_stmt, {TAG(KW_END)}},
+      {end_interface_stmt, {TAG(KW_END)}},
+      {end_module_stmt, {TAG(KW_END)}},
+      {end_mp_subprogram_stmt, {TAG(KW_END)}},
+      {end_program_stmt, {TAG(KW_END)}},
+      {end_select_rank_stmt, {TAG(KW_END)}},
+      {end_select_stmt, {TAG(KW_END)}},
+      {end_select_type_stmt, {TAG(KW_END)}},
+      {end_subroutine_stmt, {TAG(KW_END)}},
+      {end_type_stmt, {TAG(KW_END)}},
+      {end_where_stmt, {TAG(KW_END)}},
+      {entry_stmt, {TAG(KW_ENTRY)}},
+      {enum_def_stmt, {TAG(KW_ENUM)}},
+      {enumerator_def_stmt, {TAG(KW_ENUMERATOR)}},
+      {forall_construct_stmt, {TAG(KW_FORALL)}},
+      {forall_stmt, {TAG(KW_FORALL)}},
+      {format_stmt, {TAG(KW_FORMAT)}},
+      {generic_stmt, {TAG(KW_GENERIC)}},
+      {if_then_stmt, {TAG(KW_IF)}},
+      {implicit_stmt, {TAG(KW_IMPLICIT)}},
+      {import_stmt, {TAG(KW_IMPORT)}},
+      {interface_stmt, {TAG(KW_INTERFACE), TAG(KW_ABSTRACT)}},
+      {masked_elsewhere_stmt, {TAG(KW_ELSE)}},
+      {module_stmt, {TAG(KW_MODULE)}},
+      {mp_subprogram_stmt, {TAG(KW_MODULE)}},
+      {parameter_stmt, {TAG(KW_PARAMETER)}},
+      {private_or_sequence, {TAG(KW_PRIVATE), TAG(KW_SEQUENCE)}},
+      {procedure_declaration_stmt, {TAG(KW_PROCEDURE)}},
+      {procedure_stmt, {TAG(KW_MODULE), TAG(KW_PROCEDURE)}},
+      {program_stmt, {TAG(KW_PROGRAM)}},
+      {select_case_stmt, {TAG(KW_SELECT)}},
+      {select_rank_case_stmt, {TAG(KW_RANK)}},
+      {select_rank_stmt, {TAG(KW_SELECT)}},
+      {select_type_stmt, {TAG(KW_SELECT)}},
+      {type_guard_stmt, {TAG(KW_TYPE), TAG(KW_CLASS)}},
+      {use_stmt, {TAG(KW_USE)}},
+      {where_construct_stmt, {TAG(KW_WHERE)}},
+      {where_stmt, {TAG(KW_WHERE)}}};
+  auto const it = leads.find(f);
+  if (it == leads.end())
+    return true;
+  return std::find(it->second.begin(), it->second.end(), lead_tag) !=
+         it->second.end();
+}
+
+std::vector<parser_function> const &program_stmt_parsers() {
+  /* Each STMT() in Prgm_Parsers_impl.hh, and the parse_with() calls in
+     Prgm_Parsers_utils.hh.  These are ordered roughly as the program parsers
+     try them, so that a statement's likely match comes early. */
+  static std::vector<parser_function> const parsers{
+      program_stmt,
+      module_stmt,
+      function_stmt,
+      subroutine_stmt,
+      mp_subprogram_stmt,
+      use_stmt,
+      import_stmt,
+      implicit_stmt,
+      parameter_stmt,
+      format_stmt,
+      entry_stmt,
+      data_stmt,
+      derived_type_stmt,
+      private_or_sequence,
+      component_def_stmt,
+      contains_stmt,
+      binding_private_stmt,
+      type_bound_proc_binding,
+      end_type_stmt,
+      enum_def_stmt,
+      enumerator_def_stmt,
+      end_enum_stmt,
+      interface_stmt,
+      procedure_stmt,
+      end_interface_stmt,
+      generic_stmt,
+      procedure_declaration_stmt,
+      type_declaration_stmt,
+      other_specification_stmt,
+      action_stmt,
+      assignment_stmt,
+      associate_stmt,
+      end_associate_stmt,
+      block_stmt,
+      end_block_stmt,
+      select_case_stmt,
+      case_stmt,
+      end_select_stmt,
+      select_rank_stmt,
+      select_rank_case_stmt,
+      end_select_rank_stmt,
+      select_type_stmt,
+      type_guard_stmt,
+      end_select_type_stmt,
+      do_stmt,
+      end_do_stmt,
+      end_do,
+      if_then_stmt,
+      else_if_stmt,
+      else_stmt,
+      end_if_stmt,
+      forall_construct_stmt,
+      forall_assignment_stmt,
+      forall_stmt,
+      end_forall_stmt,
+      where_construct_stmt,
+      where_stmt,
+      masked_elsewhere_stmt,
+      elsewhere_stmt,
+      end_where_stmt,
+      end_function_stmt,
+      end_subroutine_stmt,
+      end_mp_subprogram_stmt,
+      end_module_stmt,
+      end_program_stmt};
+  return parsers;
+}
+
 #undef FAIL
 #undef INIT_FAIL
 #undef RULE
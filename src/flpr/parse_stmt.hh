@@ -17,6 +17,7 @@
 
 #include "flpr/Stmt_Tree.hh"
 #include "flpr/TT_Stream.hh"
+#include <vector>
 
 namespace FLPR {
 
@@ -29,6 +30,19 @@ Stmt_Tree parse_stmt_dispatch(int stmt_tag, TT_Stream &ts);
 //! Return true if this syntag is considered an action-stmt
 bool is_action_stmt(int const syntag);
 
+//! The signature of the statement parsers
+using parser_function = Stmt_Tree (*)(TT_Stream &ts);
+
+//! Return false if parser f can't match a statement led by lead_tag
+/*! The lead tag is the first token of the statement, after any
+    construct-name (see LL_Stmt::lead_tag()).  A true result just means that
+    f might match. */
+bool may_lead(parser_function const f, int const lead_tag);
+
+//! The statement parsers that the program parsers (Prgm::Parsers) use
+/*! LL_Stmt::prefetch_parses() runs these ahead of the program parsers. */
+std::vector<parser_function> const &program_stmt_parsers();
+
 /*! \defgroup StmtParsers Parsers for complete Fortran statements
   @{ */
 Stmt_Tree access_stmt(TT_Stream &ts);
@@ -19,6 +19,7 @@
 #include <cctype>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace FLPR {
@@ -63,8 +64,8 @@ inline void trim_back(std::string &s) {
 }
 
 //! return the last non-blank character in s, or '\0'
-inline char last_non_blank_char(std::string const &s) {
-  std::string::size_type back = s.find_last_not_of(" \t");
+inline char last_non_blank_char(std::string_view s) {
+  std::string_view::size_type back = s.find_last_not_of(" \t");
   if (back == std::string::npos)
     return '\0';
   return s[back];
@@ -0,0 +1,189 @@
+! Fortran source for comparing the Hand_Lexer to the flex Lexer.  Between
+! them, these lines use every keyword, and every smashed keyword, that the
+! scanners know about, along with the awkward literal and operator forms.
+! Full-line comments are skipped by the test.
+include 'constants.inc'
+module shapes
+  use, intrinsic :: iso_fortran_env, only : real64, int32
+  use, non_intrinsic :: helpers
+  implicit none
+  private
+  public :: shape, circle, area, operator(.cross.), assignment(=)
+  protected :: count_shapes
+  integer(kind=int32), save :: count_shapes = 0
+  integer, parameter :: dp = selected_real_kind(15, 307)
+  enum, bind(c)
+    enumerator :: red = 1, green, blue
+  endenum
+  type, abstract :: shape
+    real(dp) :: x = 0.0_dp, y = 1.5d-3
+  contains
+    procedure(area_if), deferred, pass(self) :: area
+    procedure, non_overridable, nopass :: kind_name
+    generic :: write(formatted) => write_shape
+    generic :: read(unformatted) => read_shape
+    final :: cleanup
+  end type shape
+  type, extends(shape) :: circle
+    sequence
+    real(dp), allocatable, dimension(:) :: radii
+    real(dp), pointer, contiguous :: view(:, :) => null()
+    character(len=:), allocatable :: label
+  endtype circle
+  abstract interface
+    pure real(dp) function area_if(self) result(a)
+      import :: shape, dp
+      class(shape), intent(in) :: self
+    end function area_if
+  endinterface
+  interface operator(.cross.)
+    module procedure cross
+  end interface
+  interface assignment(=)
+    module procedure assign_shape
+  end interface
+contains
+  elemental impure function cross(a, b)
+    real(dp), intent(in), value :: a, b
+    real(dp) :: cross
+    cross = a*b - b**2 + 1.e5_dp + .5 + 1. + 4.e+2
+  endfunction cross
+  recursive subroutine assign_shape(lhs, rhs)
+    type(circle), intent(inout) :: lhs
+    type(circle), intent(out), target, volatile, asynchronous :: rhs
+    optional :: rhs
+    lhs%x = rhs%x
+  endsubroutine
+  non_recursive subroutine kind_name(c)
+    character(len=*), intent(out) :: c
+    c = 'don''t' // "say ""no""" // k_'wide'
+  end subroutine kind_name
+endmodule shapes
+
+submodule (shapes) shapes_impl
+contains
+  module procedure cleanup
+    external :: exit_hook
+    intrinsic :: sqrt
+    continue
+  endprocedure cleanup
+endsubmodule shapes_impl
+
+blockdata init_common
+  common /coords/ xc, yc, zc
+  data xc, yc, zc / 3*0.0 /
+  equivalence (xc, xd)
+end block data init_common
+
+program driver
+  use shapes
+  implicit double precision (a-h, o-z)
+  doubleprecision :: w
+  logical :: t = .TRUE._lk, f = .false.
+  complex :: z = (1.0, -2.0)
+  integer :: i, j, k, n, ios, stat_code
+  integer, codimension[*] :: counter
+  type(event_type) :: ev[*]
+  type(lock_type) :: lck[*]
+  type(team_type) :: team
+  real, allocatable :: a(:), b(:)
+  character(len=80) :: msg
+  namelist /config/ i, j, k
+  allocate (a(10), b, mold=a, stat=stat_code, errmsg=msg)
+  allocate (b, source=a)
+  associate (m => size(a))
+    print *, m
+  endassociate
+  block
+    integer :: local_i
+    local_i = 1
+  endblock
+  critical
+    counter = counter + 1
+  endcritical
+  select case (i)
+  case (1:3)
+    i = 0
+  case default
+    i = -1
+  endselect
+  selectcase (j)
+  case (2)
+    j = 1
+  end select
+  selecttype (p => shape_ptr)
+  type is (circle)
+    print *, 'circle'
+  class is (shape)
+    print *, 'shape'
+  class default
+    continue
+  end select
+  select rank (a)
+  rank (1)
+    print *, 'vector'
+  end select
+  do i = 1, 10
+    if (i > 5) then
+      exit
+    elseif (i == 3) then
+      cycle
+    else if (i.lt.2 .and. j.ge.0 .or. .not. t .neqv. f) then
+      j = j + 1
+    else
+      k = k + 1
+    endif
+  enddo
+  do while (j < 3)
+    j = j + 1
+  end do
+  dowhile (k /= 0)
+    k = k - 1
+  enddo
+  do concurrent (i = 1:n) local(w) local_init(z) shared(a)
+    a(i) = 0
+  end do
+  forall (i = 1:n) a(i) = b(i)
+  forall (i = 1:n)
+    a(i) = 2*a(i)
+  endforall
+  where (a > 0)
+    a = 1
+  elsewhere
+    a = -1
+  endwhere
+  where (b < 0) b = 0
+  p => q%r(1:n:2); print *, [1, 2]**2, x<=y, x>=y, x<y, x>y, x==y, x/=y
+  open (unit=10, file='data.txt', form='formatted', iostat=ios, iomsg=msg)
+  read (10, nml=config, err=100, end=200, eor=300)
+  write (10, '(a)', advance='no', id=k, asynchronous='yes') 'text'
+  wait (10, id=k)
+  inquire (unit=10, name=msg)
+  flush (10)
+  backspace (10)
+  rewind 10
+  endfile 10
+  close (10)
+100 format (i5, 2x, f10.3, a)
+  sync all
+  sync images (*)
+  sync memory
+  event post (ev[2])
+  event wait (ev, until_count=2)
+  lock (lck, acquired_lock=t)
+  unlock (lck)
+  form team (1, team, new_index=2)
+  change team (team)
+    print *, team_number()
+  endteam
+  fail image
+  entry other_entry
+  call kind_name(msg)
+  deallocate (a, b)
+  nullify (p)
+  goto 100
+  go to 200
+  if (n > 100) error stop 'too big', quiet=.true.
+200 stop
+  return
+endprogram driver
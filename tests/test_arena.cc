@@ -0,0 +1,186 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for the Arena and Arena_Allocator classes
+*/
+#include "flpr/Arena.hh"
+#include "flpr/Logical_File.hh"
+#include "flpr/Safe_List.hh"
+#include "flpr/Tree.hh"
+#include "test_helpers.hh"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using FLPR::Arena;
+using FLPR::Arena_Allocator;
+using FLPR::Safe_List;
+using FLPR::Tree;
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool alignment() {
+  Arena a(256);
+  for (std::size_t align : {1, 2, 4, 8, 16, 64}) {
+    a.allocate(1, 1);
+    void *p = a.allocate(3, align);
+    TEST_INT(reinterpret_cast<std::uintptr_t>(p) % align, 0);
+  }
+  TEST_INT(a.bytes_allocated(), 6 * 4);
+  return true;
+}
+
+bool block_growth() {
+  Arena a(1024);
+  TEST_INT(a.num_blocks(), 0);
+  char *prev = static_cast<char *>(a.allocate(8, 8));
+  TEST_INT(a.num_blocks(), 1);
+  for (int i = 0; i < 200; ++i) {
+    char *p = static_cast<char *>(a.allocate(8, 8));
+    TEST_TRUE(p != prev);
+    prev = p;
+  }
+  TEST_TRUE(a.num_blocks() > 1);
+  TEST_TRUE(a.bytes_reserved() >= a.bytes_allocated());
+  return true;
+}
+
+bool oversize() {
+  Arena a(1024);
+  char *small = static_cast<char *>(a.allocate(16, 8));
+  void *big = a.allocate(100000, 16);
+  TEST_INT(reinterpret_cast<std::uintptr_t>(big) % 16, 0);
+  TEST_INT(a.num_blocks(), 2);
+  /* the oversize block shouldn't have displaced the current block */
+  char *next = static_cast<char *>(a.allocate(16, 8));
+  TEST_TRUE(next == small + 16);
+  TEST_INT(a.num_blocks(), 2);
+  return true;
+}
+
+bool scope_nesting() {
+  TEST_TRUE(Arena::current() == nullptr);
+  Arena a, b;
+  {
+    Arena::Scope sa{&a};
+    TEST_TRUE(Arena::current() == &a);
+    {
+      Arena::Scope sb{&b};
+      TEST_TRUE(Arena::current() == &b);
+    }
+    TEST_TRUE(Arena::current() == &a);
+  }
+  TEST_TRUE(Arena::current() == nullptr);
+  return true;
+}
+
+bool allocator_heap_fallback() {
+  Arena_Allocator<int> alloc;
+  TEST_TRUE(alloc.arena() == nullptr);
+  int *p = alloc.allocate(4);
+  p[3] = 7;
+  alloc.deallocate(p, 4);
+  Safe_List<std::string> sl;
+  sl.emplace_back("heap");
+  TEST_TRUE(sl.get_allocator().arena() == nullptr);
+  return true;
+}
+
+bool safe_list_in_arena() {
+  Arena a;
+  using List = Safe_List<std::string>;
+  List outside;
+  {
+    /* a Scope doesn't change where other containers come from... */
+    Arena::Scope s{&a};
+    List heap;
+    TEST_TRUE(heap.get_allocator().arena() == nullptr);
+    /* ...they have to be given the Arena */
+    List sl{List::allocator_type{&a}};
+    TEST_TRUE(sl.get_allocator().arena() == &a);
+    sl.emplace_back("one");
+    std::size_t const used = a.bytes_allocated();
+    TEST_TRUE(used > 0);
+    outside = std::move(sl);
+  }
+  /* the list keeps using the arena after it is moved */
+  TEST_TRUE(outside.get_allocator().arena() == &a);
+  std::size_t const used = a.bytes_allocated();
+  outside.emplace_back("two");
+  TEST_TRUE(a.bytes_allocated() > used);
+  TEST_INT(outside.size(), 2);
+  TEST_STR("one", outside.front());
+  TEST_STR("two", outside.back());
+
+  /* a copy comes from the heap, even inside of a Scope */
+  Arena::Scope s{&a};
+  List copy{outside};
+  TEST_TRUE(copy.get_allocator().arena() == nullptr);
+  TEST_INT(copy.size(), 2);
+  return true;
+}
+
+bool tree_in_arena() {
+  auto p = std::make_shared<int>(3);
+  Arena a;
+  Tree<std::shared_ptr<int>> t;
+  {
+    Arena::Scope s{&a};
+    Tree<std::shared_ptr<int>> n(p);
+    TEST_TRUE(a.bytes_allocated() > 0);
+    t.swap(n);
+  }
+  TEST_INT(p.use_count(), 2);
+  /* a branch list created outside of the Scope still comes from the arena */
+  std::size_t const used = a.bytes_allocated();
+  t->emplace_back(Tree<std::shared_ptr<int>>::node(p));
+  TEST_TRUE(a.bytes_allocated() > used);
+  TEST_INT(p.use_count(), 3);
+  t.clear();
+  /* destructors still run, even though the memory isn't released */
+  TEST_INT(p.use_count(), 1);
+  return true;
+}
+
+bool logical_file_arena() {
+  FLPR::Logical_File lf;
+  TEST_TRUE(lf.arena != nullptr);
+  TEST_TRUE(lf.lines.get_allocator().arena() == lf.arena.get());
+  TEST_TRUE(lf.ll_stmts.get_allocator().arena() == lf.arena.get());
+  FLPR::Logical_File::Line_Buf buf{"program foo", "  x = 1", "end program"};
+  TEST_TRUE(lf.scan(buf, "arena.f90", 0));
+  TEST_INT(lf.lines.size(), 3);
+  TEST_TRUE(lf.lines.front().fragments().get_allocator().arena() ==
+            lf.arena.get());
+  TEST_TRUE(lf.arena->bytes_allocated() > 0);
+  /* an edited line comes from the heap, so that it can be edited again */
+  lf.make_stmts();
+  lf.replace_stmt_text(std::next(lf.ll_stmts.begin()), {"x = 2"},
+                       FLPR::Syntax_Tags::SG_ASSIGNMENT_STMT);
+  TEST_TRUE(std::next(lf.lines.begin())->fragments().get_allocator().arena() ==
+            nullptr);
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(alignment);
+  TEST(block_growth);
+  TEST(oversize);
+  TEST(scope_nesting);
+  TEST(allocator_heap_fallback);
+  TEST(safe_list_in_arena);
+  TEST(tree_in_arena);
+  TEST(logical_file_arena);
+
+  TEST_MAIN_REPORT;
+}
@@ -0,0 +1,102 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+#include "flpr/Char_Scan.hh"
+#include "flpr/File_Line.hh"
+#include "test_helpers.hh"
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using FLPR::Char_Scan_Impl;
+
+/* Random lines built from the characters that matter to the classifier,
+   with lengths that straddle the 16- and 32-byte vector widths */
+std::vector<std::string> random_lines() {
+  std::mt19937 gen(19);
+  std::string const alphabet{"    \t\r!&'\"#abcXYZ019_=(),."};
+  std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+  std::uniform_int_distribution<int> blank_run(0, 80);
+  std::vector<std::string> result;
+  for (size_t len = 0; len < 100; ++len) {
+    for (int rep = 0; rep < 8; ++rep) {
+      std::string line(blank_run(gen) % (len + 1), ' ');
+      while (line.size() < len)
+        line.push_back(alphabet[pick(gen)]);
+      result.emplace_back(std::move(line));
+    }
+  }
+  return result;
+}
+
+bool impl_matches_std(Char_Scan_Impl impl) {
+  if (!FLPR::set_char_scan_impl(impl))
+    return true; // not available on this CPU
+  TEST_TRUE(FLPR::char_scan_impl() == impl);
+  std::vector<std::string_view> const sets{"'\"!&", "'\"!", "'&", "\"&", "!"};
+  for (auto const &line : random_lines()) {
+    std::string_view const txt{line};
+    for (size_t pos = 0; pos <= txt.size() + 1; ++pos) {
+      TEST_INT_LABEL(line, FLPR::scan_for_nonblank(txt, pos),
+                     txt.find_first_not_of(" \t\r", pos));
+      for (auto const &set : sets) {
+        TEST_INT_LABEL(line, FLPR::scan_for_any(txt, pos, set),
+                       txt.find_first_of(set, pos));
+      }
+    }
+  }
+  return true;
+}
+
+bool scalar() { return impl_matches_std(Char_Scan_Impl::scalar); }
+bool sse2() { return impl_matches_std(Char_Scan_Impl::sse2); }
+bool avx2() { return impl_matches_std(Char_Scan_Impl::avx2); }
+
+/* Every implementation should classify lines identically */
+bool same_file_lines() {
+  std::vector<Char_Scan_Impl> const impls{
+      Char_Scan_Impl::scalar, Char_Scan_Impl::sse2, Char_Scan_Impl::avx2};
+  std::vector<std::string> const lines{
+      "                                                   ! just a comment",
+      "      x = 'a long string with a ! inside of it, and more' ! real one",
+      "   call foo(\"an open string that continues on the next line        &",
+      "  y = z                                                            &",
+      "123 format('abc', \"def\")                                          "};
+  std::vector<std::string> ref;
+  for (auto impl : impls) {
+    if (!FLPR::set_char_scan_impl(impl))
+      continue;
+    std::vector<std::string> dumps;
+    for (auto const &l : lines) {
+      bool in_lit{false};
+      std::ostringstream os;
+      FLPR::File_Line::analyze_free(1, l, '\0', false, in_lit).dump(os);
+      FLPR::File_Line::analyze_fixed(1, l, '\0', 72).dump(os);
+      dumps.emplace_back(os.str());
+    }
+    if (ref.empty())
+      ref = dumps;
+    for (size_t i = 0; i < lines.size(); ++i) {
+      TEST_STR(ref[i].c_str(), dumps[i]);
+    }
+  }
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+  TEST(scalar);
+  TEST(sse2);
+  TEST(avx2);
+  TEST(same_file_lines);
+  TEST_MAIN_REPORT;
+}
@@ -9,6 +9,7 @@
 */
 
 #include "flpr/File_Line.hh"
+#include "flpr/Text_Buffer.hh"
 #include "test_helpers.hh"
 #include <iostream>
 #include <string>
@@ -435,6 +436,129 @@ bool free_trailing_blank() {
   return true;
 }
 
+bool buffer_lines() {
+  auto buf = FLPR::Text_Buffer::from_string("a\n\n  b\nc");
+  auto lines = buf->lines();
+  TEST_INT(lines.size(), 4);
+  TEST_STR("a", std::string{lines[0]});
+  TEST_STR("", std::string{lines[1]});
+  TEST_STR("  b", std::string{lines[2]});
+  TEST_STR("c", std::string{lines[3]});
+  /* a trailing newline doesn't start a new line */
+  TEST_INT(FLPR::Text_Buffer::from_string("a\nb\n")->lines().size(), 2);
+  TEST_INT(FLPR::Text_Buffer::from_string("")->lines().size(), 0);
+  return true;
+}
+
+bool buffer_borrowed_fields() {
+  auto buf = FLPR::Text_Buffer::from_string("100    call foo() & ! okay\n");
+  auto lines = buf->lines();
+  TEST_INT(lines.size(), 1);
+  bool in_literal{false};
+  File_Line fl =
+      File_Line::analyze_free(1, lines[0], '\0', false, in_literal, buf);
+  TEST_TRUE(fl.is_continued());
+  TEST_TRUE(fl.left_text.is_borrowed());
+  TEST_TRUE(fl.main_text.is_borrowed());
+  TEST_TRUE(fl.right_text.is_borrowed());
+  TEST_TRUE(fl.main_text.data() == lines[0].data() + 7);
+  TEST_STR("call foo()", fl.main_text);
+
+  /* Modification makes a private copy of just that field */
+  File_Line copy{fl};
+  fl.make_uncontinued();
+  TEST_FALSE(fl.right_text.is_borrowed());
+  TEST_TRUE(fl.main_text.is_borrowed());
+  TEST_STR("! okay", fl.right_text);
+  TEST_STR("& ! okay", copy.right_text);
+
+  /* The File_Line keeps the buffer alive */
+  buf.reset();
+  TEST_STR("call foo()", copy.main_text);
+  return true;
+}
+
+bool buffer_unmodified() {
+  // clang-format off
+  auto buf = FLPR::Text_Buffer::from_string(
+    "100    call foo() & ! okay\n"
+    "   10 continue\n"
+    "      x = 1\n"
+    "     &  + 2\n"
+    "      y = 2                                                         "
+    "          \n"
+    "\tz = 3\n");
+  // clang-format on
+  auto lines = buf->lines();
+  TEST_INT(lines.size(), 6);
+  bool in_literal{false};
+  File_Line fl =
+      File_Line::analyze_free(1, lines[0], '\0', false, in_literal, buf);
+  TEST_TRUE(fl.is_unmodified());
+  TEST_TRUE(fl.raw_text() == lines[0]);
+  File_Line copy{fl};
+  TEST_TRUE(copy.is_unmodified());
+  fl.make_uncontinued();
+  TEST_FALSE(fl.is_unmodified());
+  copy.main_text.clear();
+  TEST_FALSE(copy.is_unmodified());
+
+  /* The label and control columns are not part of any field */
+  for (int i = 1; i < 5; ++i) {
+    fl = File_Line::analyze_fixed(i + 1, lines[i], '\0', 72, buf);
+    TEST_TRUE(fl.is_unmodified());
+  }
+  /* ...but other holes are edits */
+  fl = File_Line::analyze_fixed(3, lines[2], '\0', 72, buf);
+  fl.set_leading_spaces(2);
+  TEST_FALSE(fl.is_unmodified());
+  fl = File_Line::analyze_fixed(2, lines[1], '\0', 72, buf);
+  fl.left_text.clear();
+  TEST_FALSE(fl.is_unmodified());
+
+  /* Lines that were rewritten, or not scanned from a buffer, don't have any
+     raw text */
+  fl = File_Line::analyze_fixed(6, lines[5], '\0', 72, buf);
+  TEST_TRUE(fl.raw_text().empty());
+  TEST_FALSE(fl.is_unmodified());
+  fl = File_Line::analyze_free("x = 1");
+  TEST_FALSE(fl.is_unmodified());
+  return true;
+}
+
+/* Copies and moves of an owned Line_Text refer to their own storage, for
+   short strings (kept inside the std::string) as well as long ones */
+bool line_text_copies() {
+  using FLPR::Line_Text;
+  for (std::string const text : {"x", "a much longer line of text than fits in "
+                                      "a short string buffer"}) {
+    Line_Text owned{text};
+    TEST_FALSE(owned.is_borrowed());
+    Line_Text copy{owned};
+    TEST_TRUE(copy.view() == text);
+    TEST_FALSE(copy.data() == owned.data());
+    Line_Text moved{std::move(copy)};
+    TEST_TRUE(moved.view() == text);
+    TEST_TRUE(copy.empty());
+    moved += '!';
+    TEST_TRUE(moved.view() == text + '!');
+    TEST_TRUE(owned.view() == text);
+
+    Line_Text assigned = Line_Text::borrow(text);
+    TEST_TRUE(assigned.is_borrowed());
+    assigned = std::move(moved);
+    TEST_FALSE(assigned.is_borrowed());
+    TEST_TRUE(assigned.view() == text + '!');
+    assigned = Line_Text::borrow(text);
+    TEST_TRUE(assigned.is_borrowed());
+    TEST_TRUE(assigned.data() == text.data());
+    assigned = owned;
+    TEST_TRUE(assigned.view() == text);
+    TEST_FALSE(assigned.data() == owned.data());
+  }
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
 
@@ -472,5 +596,9 @@ int main() {
   TEST(free_trailing_comment);
   TEST(free_trailing_blank);
 
+  TEST(buffer_lines);
+  TEST(buffer_borrowed_fields);
+  TEST(buffer_unmodified);
+  TEST(line_text_copies);
   TEST_MAIN_REPORT;
 }
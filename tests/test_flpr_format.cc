@@ -0,0 +1,113 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for the in-place rewriting of flpr-format (flpr_format_named_file)
+*/
+#include "flpr_format_base.hh"
+#include "test_helpers.hh"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// clang-format off
+std::string const program_text{
+  "program p\n"
+  "integer :: i\n"
+  "do i = 1, 2\n"
+  "print *, i\n"
+  "end do\n"
+  "end program p\n"};
+// clang-format on
+
+void select_indents(FLPR::Indent_Table &indents, File const &,
+                    Options const &) {
+  indents.apply_emacs_indent();
+}
+
+/* Return the contents of a file */
+std::string read_text(std::string const &fname) {
+  std::ifstream is(fname);
+  std::ostringstream os;
+  os << is.rdbuf();
+  return os.str();
+}
+
+/* The options for "flpr-format -w -r", optionally with -u */
+Options inplace_options(bool const by_unit) {
+  Options options;
+  options.enable_all_filters();
+  options[OPT(COL72)] = false;
+  options[OPT(FIXED_TO_FREE)] = false;
+  options.set_write_inplace(true);
+  options.set_by_unit(by_unit);
+  return options;
+}
+
+bool rewrites_good_file() {
+  for (bool const by_unit : {false, true}) {
+    Temp_Dir dir;
+    TEST_TRUE(bool(dir));
+    std::string const fname = dir.write("p.f90", program_text);
+    FLPR::Indent_Table indents;
+    FLPR::Text_Writer out;
+    TEST_TRUE(flpr_format_named_file(fname, inplace_options(by_unit),
+                                     select_indents, indents, out));
+    std::string const text = read_text(fname);
+    TEST_TRUE(text != program_text);
+    TEST_TRUE(text.find("\n  do i = 1, 2\n     print *, i\n") !=
+              std::string::npos);
+  }
+  return true;
+}
+
+/* A file that can't be scanned is reported, and left alone */
+bool failed_scan_keeps_file() {
+  for (bool const by_unit : {false, true}) {
+    Temp_Dir dir;
+    TEST_TRUE(bool(dir));
+    std::string const fname = dir.write("p.txt", program_text);
+    FLPR::Indent_Table indents;
+    FLPR::Text_Writer out;
+    TEST_FALSE(flpr_format_named_file(fname, inplace_options(by_unit),
+                                      select_indents, indents, out));
+    TEST_EQ_NODISPLAY(program_text, read_text(fname));
+    TEST_TRUE(out.text().empty());
+  }
+  return true;
+}
+
+/* A Parsed_File made from a failed scan is in a bad state */
+bool failed_scan_is_bad() {
+  std::istringstream is{program_text};
+  auto buffer = FLPR::Text_Buffer::from_stream(is);
+  FLPR::Logical_File lf;
+  TEST_FALSE(lf.scan(buffer, "p.txt", 0));
+  TEST_TRUE(lf.scan_failed);
+  TEST_TRUE(lf.file_info != nullptr);
+  File file{std::move(lf)};
+  TEST_FALSE(bool(file));
+
+  FLPR::Logical_File good;
+  TEST_TRUE(good.scan(buffer, "p.f90", 0));
+  TEST_FALSE(good.scan_failed);
+  TEST_TRUE(bool(File{std::move(good)}));
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(rewrites_good_file);
+  TEST(failed_scan_keeps_file);
+  TEST(failed_scan_is_bad);
+
+  TEST_MAIN_REPORT;
+}
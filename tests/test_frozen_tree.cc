@@ -0,0 +1,252 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Frozen_Tree
+*/
+#include "flpr/Frozen_Tree.hh"
+#include "flpr/Parsed_File.hh"
+#include "test_helpers.hh"
+#include <sstream>
+#include <string>
+
+using FLPR::Frozen_Tree;
+using FLPR::Syntax_Tags;
+using File = FLPR::Parsed_File<>;
+using Node = File::Parse_Tree::node;
+using ST_Node = FLPR::Stmt::Stmt_Tree::node;
+using index_type = Frozen_Tree::index_type;
+
+// clang-format off
+std::string const free_text{
+  "module m\n"
+  "  use iso_c_binding\n"
+  "  integer :: n = 3\n"
+  "contains\n"
+  "  subroutine a(x)\n"
+  "    use other, only : f\n"
+  "    real :: x(n)\n"
+  "    integer :: i, j\n"
+  "    do 10 i = 1, n\n"
+  "    do 10 j = 1, n\n"
+  "10  x(i) = x(i) + j\n"
+  "    if (x(1) > 0) then\n"
+  "      x(1) = 0; call f(x(2))\n"
+  "    end if\n"
+  "    call f(x(1))\n"
+  "  end subroutine a\n"
+  "end module m\n"};
+// clang-format on
+
+/* A frozen Stmt_Tree must match the original node for node */
+bool same_stmt_tree(Frozen_Tree const &ft, index_type const n,
+                    ST_Node const &orig) {
+  TEST_INT(ft.syntag(n), orig->syntag);
+  TEST_FALSE(ft.is_stmt(n));
+  TEST_INT(ft.num_branches(n), orig.num_branches());
+  TEST_EQ(range_text(orig->token_range, true), span_text(ft, n, true));
+  /* The descendants immediately follow in preorder */
+  index_type b = ft.first_child(n), end = n + 1;
+  if (orig.is_fork()) {
+    for (auto const &ob : orig.branches()) {
+      TEST_INT(b, end);
+      TEST_INT(ft.parent(b), n);
+      TEST_TRUE(same_stmt_tree(ft, b, ob));
+      end = ft.subtree_end(b);
+      b = ft.next_sibling(b);
+    }
+  }
+  TEST_INT(b, Frozen_Tree::npos);
+  TEST_INT(ft.subtree_end(n), end);
+  return true;
+}
+
+/* ... and so must a frozen Prgm_Tree */
+bool same_prgm_tree(Frozen_Tree const &ft, index_type const n,
+                    Node const &orig, bool const with_stmt_trees) {
+  TEST_INT(ft.syntag(n), orig->syntag());
+  TEST_INT(ft.is_stmt(n), orig->is_stmt());
+  if (orig->is_stmt()) {
+    TEST_TRUE(ft.ll_stmt(n) == &orig->ll_stmt());
+    TEST_EQ(range_text(orig->ll_stmt(), true), span_text(ft, n, true));
+    if (!with_stmt_trees) {
+      TEST_TRUE(ft.is_leaf(n));
+      TEST_INT(ft.subtree_end(n), n + 1);
+      return true;
+    }
+    TEST_INT(ft.num_branches(n), 1u);
+    return same_stmt_tree(ft, ft.first_child(n),
+                          *orig->ll_stmt().stmt_tree());
+  }
+  TEST_INT(ft.num_branches(n), orig.num_branches());
+  index_type b = ft.first_child(n), end = n + 1;
+  if (orig.is_fork()) {
+    for (auto const &ob : orig.branches()) {
+      TEST_INT(b, end);
+      TEST_INT(ft.parent(b), n);
+      TEST_TRUE(same_prgm_tree(ft, b, ob, with_stmt_trees));
+      TEST_TRUE(ft.token_begin(b) >= ft.token_begin(n));
+      TEST_TRUE(ft.token_end(b) <= ft.token_end(n));
+      end = ft.subtree_end(b);
+      b = ft.next_sibling(b);
+    }
+  }
+  TEST_INT(b, Frozen_Tree::npos);
+  TEST_INT(ft.subtree_end(n), end);
+  return true;
+}
+
+/* Count the nodes with a syntag in the original trees */
+int count_syntag(ST_Node const &n, int const syntag) {
+  int count = (n->syntag == syntag);
+  if (n.is_fork())
+    for (auto const &b : n.branches())
+      count += count_syntag(b, syntag);
+  return count;
+}
+
+int count_syntag(Node const &n, int const syntag) {
+  int count = (n->syntag() == syntag);
+  if (n->is_stmt())
+    return count + count_syntag(*n->ll_stmt().stmt_tree(), syntag);
+  if (n.is_fork())
+    for (auto const &b : n.branches())
+      count += count_syntag(b, syntag);
+  return count;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool freeze_prgm_tree() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  Frozen_Tree ft;
+  TEST_TRUE(ft.freeze(file.parse_tree()));
+  TEST_TRUE(ft.is_prgm_tree());
+  TEST_FALSE(ft.empty());
+  TEST_TRUE(same_prgm_tree(ft, 0, *file.parse_tree(), true));
+  TEST_INT(ft.subtree_end(0), ft.size());
+  TEST_INT(ft.token_end(0), ft.tokens().size());
+  TEST_EQ(std::string{"module"}, ft.tokens().front()->text());
+
+  /* Without the statement trees, statements are leaves */
+  Frozen_Tree shallow;
+  TEST_TRUE(shallow.freeze(file.parse_tree(), false));
+  TEST_TRUE(same_prgm_tree(shallow, 0, *file.parse_tree(), false));
+  TEST_TRUE(shallow.size() < ft.size());
+  TEST_INT(shallow.tokens().size(), ft.tokens().size());
+  return true;
+}
+
+bool find_syntags() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  Frozen_Tree ft;
+  TEST_TRUE(ft.freeze(file.parse_tree()));
+  Node const &root = *file.parse_tree();
+
+  for (int const tag : {int{Syntax_Tags::SG_CALL_STMT},
+                        int{Syntax_Tags::SG_USE_STMT},
+                        int{Syntax_Tags::SG_ASSIGNMENT_STMT},
+                        int{Syntax_Tags::PG_MODULE}}) {
+    auto const found = ft.find(tag);
+    TEST_INT(found.size(), static_cast<std::size_t>(count_syntag(root, tag)));
+    TEST_INT(ft.count(tag), found.size());
+    for (index_type const n : found)
+      TEST_INT(ft.syntag(n), tag);
+  }
+  /* A use-stmt is tagged both as a statement and as the root of its
+     Stmt_Tree */
+  TEST_INT(ft.count(Syntax_Tags::SG_USE_STMT), 4u);
+
+  /* Search within the subroutine */
+  auto const subs = ft.find(Syntax_Tags::PG_SUBROUTINE_SUBPROGRAM);
+  TEST_INT(subs.size(), 1u);
+  auto const uses = ft.find(Syntax_Tags::SG_USE_STMT, subs.front());
+  TEST_INT(uses.size(), 2u);
+  TEST_TRUE(ft.is_stmt(uses.front()));
+  TEST_INT(uses.back(), ft.first_child(uses.front()));
+  TEST_EQ(std::string{"use other , only : f "}, span_text(ft, uses.front()));
+  TEST_TRUE(uses.front() > subs.front());
+  TEST_TRUE(uses.front() < ft.subtree_end(subs.front()));
+  return true;
+}
+
+bool cursor() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  Frozen_Tree ft;
+  TEST_TRUE(ft.freeze(file.parse_tree()));
+
+  /* Follow the same path with both kinds of cursor */
+  auto c = ft.cursor();
+  auto tc = file.parse_tree().ccursor();
+  TEST_TRUE(c.is_root());
+  TEST_FALSE(c.has_up());
+  TEST_FALSE(c.has_next());
+  c.down(2);
+  tc.down(2);
+  TEST_INT(c.syntag(), Syntax_Tags::PG_MODULE);
+  TEST_INT(c.num_branches(), tc.num_branches());
+  c.down();
+  tc.down();
+  TEST_TRUE(c.is_stmt());
+  TEST_FALSE(c.has_prev());
+  TEST_TRUE(c.try_next(2));
+  tc.next(2);
+  TEST_INT(c.syntag(), tc->syntag());
+  TEST_TRUE(c.has_prev());
+  c.prev();
+  tc.prev();
+  TEST_INT(c.syntag(), tc->syntag());
+  TEST_FALSE(c.try_next(10));
+  TEST_FALSE(c.has_next());
+  TEST_TRUE(c.is_stmt());
+  TEST_EQ(std::string{"end module m "}, span_text(ft, c.index()));
+  c.up();
+  TEST_INT(c.syntag(), Syntax_Tags::PG_MODULE);
+  c.up(2);
+  TEST_TRUE(c.is_root());
+  TEST_FALSE(c.try_down(1000));
+  TEST_TRUE(c.is_leaf());
+  return true;
+}
+
+bool freeze_stmt_tree() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  Frozen_Tree ft;
+  for (auto const &stmt : file.statements()) {
+    auto const &st = stmt.stmt_tree();
+    TEST_TRUE(ft.freeze(st));
+    TEST_FALSE(ft.is_prgm_tree());
+    TEST_INT(ft.tokens().size(), (*st)->token_range.size());
+    TEST_TRUE(same_stmt_tree(ft, 0, *st));
+  }
+
+  TEST_TRUE(ft.freeze(FLPR::Stmt::Stmt_Tree{}));
+  TEST_TRUE(ft.empty());
+  TEST_INT(ft.count(Syntax_Tags::SG_CALL_STMT), 0u);
+  TEST_TRUE(ft.find(Syntax_Tags::SG_CALL_STMT).empty());
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(freeze_prgm_tree);
+  TEST(find_syntags);
+  TEST(cursor);
+  TEST(freeze_stmt_tree);
+
+  TEST_MAIN_REPORT;
+}
@@ -0,0 +1,342 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Keyword_Hash and Hand_Lexer, including a comparison of the
+   Hand_Lexer to the flex scanner over a Fortran corpus (lexer_corpus.f90).
+   That comparison needs flex: either FLPR is configured with
+   FLPR_HAND_LEXER=OFF, or the scanner is built into this test (see
+   tests/CMakeLists.txt).
+*/
+#include "flpr/Hand_Lexer.hh"
+#include "flpr/Keyword_Hash.hh"
+#include "flpr/Lexer.hh"
+#include "test_helpers.hh"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using FLPR::Hand_Lexer;
+using FLPR::Lexer;
+using FLPR::Syntax_Tags;
+using FLPR::details_::Keyword;
+using FLPR::details_::Keyword_Hash;
+
+#ifndef FLPR_TEST_DIR
+#define FLPR_TEST_DIR "."
+#endif
+
+#if FLPR_TEST_FLEX
+#include "test_scan_fort.hh"
+
+/* The flex scanner from scan_fort.l, which the library doesn't have when it
+   uses the Hand_Lexer.  This is a copy of the flex side of Lexer. */
+class Flex_Scanner {
+public:
+  Flex_Scanner() {
+    if (yylex_init_extra(0, &scanner_) != 0)
+      scanner_ = nullptr;
+  }
+  ~Flex_Scanner() {
+    if (buffer_)
+      yy_delete_buffer(buffer_, scanner_);
+    if (scanner_)
+      yylex_destroy(scanner_);
+  }
+  Flex_Scanner(Flex_Scanner const &) = delete;
+  Flex_Scanner &operator=(Flex_Scanner const &) = delete;
+
+  bool ok() const noexcept { return scanner_ != nullptr; }
+  void set_input(std::string const &text) {
+    if (buffer_)
+      yy_delete_buffer(buffer_, scanner_);
+    buffer_ = yy_scan_string(text.c_str(), scanner_);
+    yyset_extra(0, scanner_);
+  }
+  int next() { return yylex(scanner_); }
+  char const *text() const { return yyget_text(scanner_); }
+  int length() const { return yyget_leng(scanner_); }
+  int position() const { return yyget_extra(scanner_); }
+
+private:
+  yyscan_t scanner_{nullptr};
+  YY_BUFFER_STATE buffer_{nullptr};
+};
+
+bool have_flex() { return true; }
+#else
+/* The flex scanner is the Lexer, if the library was built with it */
+class Flex_Scanner : public Lexer {
+public:
+  bool ok() const noexcept { return true; }
+};
+
+bool have_flex() { return Lexer::is_flex(); }
+#endif
+
+// clang-format off
+/* Lines that exercise the corners of scan_fort.l */
+std::vector<std::string> const tricky_lines{
+  "x = 1.0e5_dp + 2.eq.3 .and. .true._k",
+  "if(a.lt.b) call f(kind_\"str\", 3_'x''y')",
+  "y = .5 + 1. + 1d0 + 12_ik + 1.5D-3_8 + 4.e+2 .ne. 0",
+  "z = 'don''t' // \"say \"\"no\"\"\" // 'unclosed",
+  "enddo; ElseIf (.not. x .neqv. y) then; END IF",
+  "a = b .mine. c .EQ. 1.and.d == 2 .and. e /= 3",
+  "real(kind=dp), dimension(:,:), allocatable :: arr  ! comment",
+  "p => q%r(1:n:2); print *, [1, 2]**2, x<=y, x>=y, x<y, x>y",
+  "1.eq.2 .or. 1.e5.and. 3.5.5 _ 7_ '' \"\" ''' \"\"\"",
+  "a_'x' b__'y' 1_'z' 1__'w' x_ 'v'",
+  "logical :: t = .TRUE._lk, f = .false.; c = a.b. .. @ $ & ? \\",
+};
+// clang-format on
+
+std::string lower(std::string s) {
+  for (char &c : s)
+    c = std::tolower(static_cast<unsigned char>(c));
+  return s;
+}
+
+/* Append the lines of a file, other than full-line comments, to lines */
+bool read_lines(std::string const &fname, std::vector<std::string> &lines) {
+  std::ifstream is(fname);
+  if (!is)
+    return false;
+  std::string line;
+  while (std::getline(is, line)) {
+    auto const first = line.find_first_not_of(' ');
+    if (first == std::string::npos || line[first] != '!')
+      lines.push_back(line);
+  }
+  return true;
+}
+
+/* The lines of lexer_corpus.f90, and the tricky_lines */
+std::vector<std::string> corpus_lines() {
+  std::vector<std::string> lines{tricky_lines};
+  std::string const fname{std::string{FLPR_TEST_DIR} + "/lexer_corpus.f90"};
+  if (!read_lines(fname, lines))
+    std::cerr << "unable to read \"" << fname << "\"\n";
+  return lines;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool keywords() {
+  int count = 0;
+  for (int tag = Syntax_Tags::kw_begin_tag(); tag < Syntax_Tags::kw_end_tag();
+       ++tag) {
+    std::string const upper{Syntax_Tags::label(tag)};
+    for (std::string const &name : {upper, lower(upper)}) {
+      Keyword const *k = Keyword_Hash::in_word_set(name.data(), name.size());
+      TEST_TRUE(k != nullptr);
+      TEST_INT_LABEL(name, k->tag, tag);
+      TEST_FALSE(k->is_smashed());
+    }
+    count += 1;
+  }
+  TEST_INT(count, 148);
+
+  std::string const mixed{"LoCaL_InIt"};
+  Keyword const *k = Keyword_Hash::in_word_set(mixed.data(), mixed.size());
+  TEST_TRUE(k != nullptr);
+  TEST_TOK(KW_LOCAL_INIT, k->tag);
+
+  for (std::string const name :
+       {"x", "endd", "enddo_", "goto1", "doubleprecisio", "non_overridablex",
+        "local init", "ends", "real8", "ifthen", "a_very_long_name_indeed"}) {
+    TEST_TRUE(Keyword_Hash::in_word_set(name.data(), name.size()) == nullptr);
+  }
+  return true;
+}
+
+bool smashed() {
+  int count = 0;
+  for (auto const &s : FLPR::details_::smashed_keywords) {
+    std::string const name{s.name};
+    Keyword const *k = Keyword_Hash::in_word_set(name.data(), name.size());
+    TEST_TRUE(k != nullptr);
+    TEST_STR(s.name, lower(k->name));
+    TEST_TOK(TK_NAME, k->tag);
+    TEST_TRUE(k->is_smashed());
+    /* The two halves are the keywords that they are split into */
+    std::string const first{name.substr(0, k->splitpos)};
+    std::string const second{name.substr(k->splitpos)};
+    Keyword const *k1 = Keyword_Hash::in_word_set(first.data(), first.size());
+    Keyword const *k2 = Keyword_Hash::in_word_set(second.data(), second.size());
+    TEST_TRUE(k1 && k2);
+    TEST_INT_LABEL(name, k1->tag, k->tok1);
+    TEST_INT_LABEL(name, k2->tag, k->tok2);
+    count += 1;
+  }
+  TEST_INT(count, 25);
+
+  std::string const upper{"ENDSUBROUTINE"};
+  Keyword const *k = Keyword_Hash::in_word_set(upper.data(), upper.size());
+  TEST_TRUE(k != nullptr);
+  TEST_TOK(KW_END, k->tok1);
+  TEST_TOK(KW_SUBROUTINE, k->tok2);
+  TEST_INT(k->splitpos, 3);
+
+  /* DOUBLEPRECISION is a keyword of its own, not a split */
+  std::string const dp{"doublePrecision"};
+  k = Keyword_Hash::in_word_set(dp.data(), dp.size());
+  TEST_TRUE(k != nullptr);
+  TEST_TOK(KW_DOUBLEPRECISION, k->tag);
+  TEST_FALSE(k->is_smashed());
+  return true;
+}
+
+bool real_literal() {
+  Hand_Lexer lex;
+  std::string const text{"x=1.5D-3_dp.and.2.eq.y"};
+  lex.set_input(text);
+  struct Expect {
+    int tag;
+    char const *text;
+  };
+  Expect const expect[] = {
+      {Syntax_Tags::TK_NAME, "x"},
+      {Syntax_Tags::TK_EQUAL, "="},
+      {Syntax_Tags::SG_SIGNIFICAND, "1.5"},
+      {Syntax_Tags::SG_EXPONENT_LETTER, "D"},
+      {Syntax_Tags::SG_EXPONENT, "-3"},
+      {Syntax_Tags::TK_UNDERSCORE, "_"},
+      {Syntax_Tags::SG_KIND_PARAM, "dp"},
+      {Syntax_Tags::TK_AND_OP, ".and."},
+      {Syntax_Tags::SG_INT_LITERAL_CONSTANT, "2"},
+      {Syntax_Tags::TK_REL_EQ, ".eq."},
+      {Syntax_Tags::TK_NAME, "y"},
+  };
+  for (Expect const &e : expect) {
+    int const tag = lex.next();
+    TEST_INT_LABEL(e.text, tag, e.tag);
+    TEST_STR(e.text, std::string(lex.text(), lex.length()));
+  }
+  TEST_TOK(EOL, lex.next());
+  TEST_INT(lex.position(), static_cast<int>(text.size()));
+  return true;
+}
+
+bool char_literal() {
+  Hand_Lexer lex;
+  std::string const text{"c = k_'it''s' // 'a''' // 'open"};
+  lex.set_input(text);
+  int const tags[] = {Syntax_Tags::TK_NAME,
+                      Syntax_Tags::TK_EQUAL,
+                      Syntax_Tags::SG_CHAR_LITERAL_CONSTANT,
+                      Syntax_Tags::TK_CONCAT,
+                      Syntax_Tags::SG_CHAR_LITERAL_CONSTANT,
+                      Syntax_Tags::TK_CONCAT,
+                      Syntax_Tags::UNKNOWN,
+                      Syntax_Tags::KW_OPEN,
+                      Syntax_Tags::EOL};
+  for (int const tag : tags) {
+    int const got = lex.next();
+    TEST_INT(got, tag);
+  }
+  /* The longest string that is closed */
+  std::string const longest{"'a'' ' ' // x"};
+  lex.set_input(longest);
+  TEST_TOK(SG_CHAR_LITERAL_CONSTANT, lex.next());
+  TEST_STR("'a'' '", std::string(lex.text(), lex.length()));
+  TEST_TOK(UNKNOWN, lex.next());
+  return true;
+}
+
+bool smashed_is_name() {
+  /* Splitting smashed keywords is left to Logical_Line::unsmash() */
+  Hand_Lexer lex;
+  std::string const text{"EndDo goto"};
+  lex.set_input(text);
+  TEST_TOK(TK_NAME, lex.next());
+  TEST_STR("EndDo", std::string(lex.text(), lex.length()));
+  TEST_TOK(TK_NAME, lex.next());
+  TEST_TOK(EOL, lex.next());
+  return true;
+}
+
+/* The corpus uses every keyword, and every smashed keyword, so that the
+   comparison with the flex Lexer covers all of them */
+bool corpus_coverage() {
+  std::vector<std::string> const lines{corpus_lines()};
+  TEST_TRUE(lines.size() > 150);
+  std::vector<bool> seen(Syntax_Tags::kw_end_tag(), false);
+  std::vector<std::string> names;
+  Hand_Lexer hand;
+  for (std::string const &line : lines) {
+    hand.set_input(line);
+    for (int tag = hand.next(); tag != Syntax_Tags::EOL; tag = hand.next()) {
+      if (tag >= Syntax_Tags::kw_begin_tag() && tag < Syntax_Tags::kw_end_tag())
+        seen[tag] = true;
+      else if (tag == Syntax_Tags::TK_NAME)
+        names.push_back(lower(std::string(hand.text(), hand.length())));
+    }
+  }
+  for (int tag = Syntax_Tags::kw_begin_tag(); tag < Syntax_Tags::kw_end_tag();
+       ++tag) {
+    TEST_INT_LABEL(Syntax_Tags::label(tag), seen[tag], true);
+  }
+  for (auto const &s : FLPR::details_::smashed_keywords) {
+    bool const found =
+        std::find(names.begin(), names.end(), s.name) != names.end();
+    TEST_INT_LABEL(s.name, found, true);
+  }
+  return true;
+}
+
+/* The Hand_Lexer and the flex scanner see the same tokens in every line of
+   the corpus */
+bool matches_lexer() {
+  if (!have_flex()) {
+    std::cerr << "SKIPPED: flex wasn't found when FLPR was configured, so "
+                 "there is no flex scanner to compare with";
+    return true;
+  }
+  std::vector<std::string> const lines{corpus_lines()};
+  TEST_TRUE(lines.size() > 150);
+  Flex_Scanner lexer;
+  TEST_TRUE(lexer.ok());
+  Hand_Lexer hand;
+  int tokens = 0;
+  for (std::string const &line : lines) {
+    lexer.set_input(line);
+    hand.set_input(line);
+    for (;;) {
+      int const tag = lexer.next();
+      int const hand_tag = hand.next();
+      TEST_INT_LABEL(line, hand_tag, tag);
+      TEST_INT_LABEL(line, hand.position(), lexer.position());
+      if (Syntax_Tags::EOL == tag)
+        break;
+      TEST_EQ(std::string(lexer.text(), lexer.length()),
+              std::string(hand.text(), hand.length()));
+      tokens += 1;
+    }
+  }
+  TEST_TRUE(tokens > 1000);
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(keywords);
+  TEST(smashed);
+  TEST(real_literal);
+  TEST(char_literal);
+  TEST(smashed_is_name);
+  TEST(corpus_coverage);
+  TEST(matches_lexer);
+
+  TEST_MAIN_REPORT;
+}
@@ -12,8 +12,16 @@
 #define TEST_HELPERS_HH 1
 
 #include "flpr/Syntax_Tags.hh"
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 /* ---------------------- Some helper functions ------------------------ */
 
@@ -60,6 +68,130 @@ inline bool expect_token(int const expected_val, int const test_val,
   return true;
 }
 
+/* ------------------ Scratch directories and files -------------------- */
+
+/* Return the names of the entries in a directory */
+inline std::vector<std::string> list_dir(std::string const &path) {
+  std::vector<std::string> result;
+  if (DIR *dir = opendir(path.c_str())) {
+    while (struct dirent const *de = readdir(dir)) {
+      std::string const name{de->d_name};
+      if (name != "." && name != "..")
+        result.push_back(name);
+    }
+    closedir(dir);
+  }
+  return result;
+}
+
+/* Remove a directory and everything in it */
+inline void remove_dir(std::string const &path) {
+  for (auto const &f : list_dir(path)) {
+    std::string const fname{path + '/' + f};
+    struct stat sb;
+    if (lstat(fname.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode))
+      remove_dir(fname);
+    else
+      unlink(fname.c_str());
+  }
+  rmdir(path.c_str());
+}
+
+/* A scratch directory that is removed, with its contents, at the end of a
+   test.  It is false if the directory couldn't be made, in which case path is
+   empty and nothing is written. */
+class Temp_Dir {
+public:
+  Temp_Dir() {
+    char name[] = "/tmp/flpr_test.XXXXXX";
+    if (mkdtemp(name))
+      path = name;
+    else
+      std::cerr << "Temp_Dir: unable to make a scratch directory\n";
+  }
+  ~Temp_Dir() {
+    if (!path.empty())
+      remove_dir(path);
+  }
+  Temp_Dir(Temp_Dir const &) = delete;
+  Temp_Dir &operator=(Temp_Dir const &) = delete;
+
+  explicit operator bool() const noexcept { return !path.empty(); }
+
+  /* The path of a name in the directory */
+  std::string file(std::string const &name) const {
+    return path + '/' + name;
+  }
+  /* Write a file in the directory, returning its path (or an empty string) */
+  std::string write(std::string const &name, std::string const &text) const {
+    if (path.empty())
+      return std::string{};
+    std::string const fname{file(name)};
+    std::ofstream os(fname);
+    os << text;
+    return fname;
+  }
+  std::string path;
+};
+
+/* ---------------------- Parsed_File printouts ------------------------ */
+
+/* Return the text of the logical lines of a Parsed_File */
+template <typename FILE> std::string file_text(FILE &file) {
+  std::ostringstream os;
+  for (auto const &ll : file.logical_lines())
+    os << ll;
+  return os.str();
+}
+
+/* Return a printout of the parse tree of a Parsed_File */
+template <typename FILE> std::string tree_text(FILE &file) {
+  std::ostringstream os;
+  os << file.parse_tree();
+  return os.str();
+}
+
+/* Append a token to result as "text ", or as "line:col text " */
+inline void append_token(std::string &result, int const line, int const col,
+                         std::string_view const text, bool const with_pos) {
+  if (with_pos)
+    result += std::to_string(line) + ':' + std::to_string(col) + ' ';
+  result += text;
+  result += ' ';
+}
+
+/* Return the text of a sequence of Token_Texts */
+template <typename RANGE>
+std::string range_text(RANGE const &r, bool const with_pos = false) {
+  std::string result;
+  for (auto const &tt : r)
+    append_token(result, tt.start_line, tt.start_pos, tt.text(), with_pos);
+  return result;
+}
+
+/* Return the text of the tokens covered by node n of a Frozen_Tree */
+template <typename FROZEN>
+std::string span_text(FROZEN const &ft, typename FROZEN::index_type const n,
+                      bool const with_pos = false) {
+  std::string result;
+  for (auto i = ft.token_begin(n); i < ft.token_end(n); ++i) {
+    auto const &tt = *ft.tokens()[i];
+    append_token(result, tt.start_line, tt.start_pos, tt.text(), with_pos);
+  }
+  return result;
+}
+
+/* Return the text of the tokens of a Tree_Image node, with positions */
+template <typename IMAGE>
+std::string span_text(IMAGE const &image, typename IMAGE::Node const &n) {
+  std::string result;
+  for (std::size_t i = n.token_begin(); i < n.token_end(); ++i) {
+    auto const tok = image.token(i);
+    append_token(result, tok.line, tok.col, tok.text, true);
+  }
+  return result;
+}
+
 // Use these generic macros in the individual tests
 #define TEST_FALSE(A)                                                          \
   if ((A) != false) {                                                          \
@@ -114,6 +246,29 @@ inline bool expect_token(int const expected_val, int const test_val,
     return false;                                                              \
   }
 
+/* Check that the stmt_ranges of a Parse_Tree node agree with the list, and
+   that its statements link back to the tree */
+template <typename NODE> bool check_links(NODE &n) {
+  auto &range = n->stmt_range();
+  if (range.size() > 0) {
+    TEST_INT(range.size(),
+             static_cast<size_t>(std::distance(range.begin(), range.end())));
+  }
+  if (n.is_leaf()) {
+    if (n->is_stmt()) {
+      /* A shared do termination is in several leaves, so just make sure
+         that the hook refers to a leaf for the same statement */
+      auto hook = static_cast<NODE *>(n->ll_stmt().get_hook());
+      TEST_TRUE(hook != nullptr);
+      TEST_TRUE(&((*hook)->ll_stmt()) == &(n->ll_stmt()));
+    }
+  } else {
+    for (auto &b : n.branches())
+      TEST_TRUE(check_links(b));
+  }
+  return true;
+}
+
 // Put this at the begining of main()
 #define TEST_MAIN_DECL                                                         \
   bool res{true};                                                              \
@@ -10,6 +10,7 @@
 
 #include "flpr/Line_Accum.hh"
 #include "test_helpers.hh"
+#include <chrono>
 #include <iostream>
 
 using FLPR::Line_Accum;
@@ -122,6 +123,101 @@ bool continued_string() {
   return true;
 }
 
+// A Cursor agrees with the binary search, going forward or back
+bool cursor() {
+  Line_Accum la;
+  la.add_line(3, 0, 2, "foo", 1);
+  la.add_line(4, 2, 5, "", 0);
+  la.add_line(5, 2, 7, "bar", 1);
+  la.add_line(7, 1, 1, "bazz", 0);
+  TEST_STR("foo   bar  bazz", la.accum());
+  int const N = la.accum().size();
+  Line_Accum::Cursor c{la.cursor()};
+  auto const same = [&la, &c](int const offset) {
+    int ln, cn, tln, tcn, c_ln, c_cn, c_tln, c_tcn;
+    TEST_TRUE(la.linecolno(offset, ln, cn, tln, tcn));
+    TEST_TRUE(c.linecolno(offset, c_ln, c_cn, c_tln, c_tcn));
+    TEST_INT_LABEL(offset, c_ln, ln);
+    TEST_INT_LABEL(offset, c_cn, cn);
+    TEST_INT_LABEL(offset, c_tln, tln);
+    TEST_INT_LABEL(offset, c_tcn, tcn);
+    return true;
+  };
+  for (int offset = 0; offset < N; ++offset)
+    TEST_TRUE(same(offset));
+  for (int offset = N - 1; offset >= 0; offset -= 3)
+    TEST_TRUE(same(offset));
+
+  int ln, cn;
+  la.linecolno(6, ln, cn);
+  TEST_EQ(ln, 5);
+  TEST_EQ(cn, 7);
+  la.linecolno(11, ln, cn);
+  TEST_EQ(ln, 7);
+  TEST_EQ(cn, 1);
+  return true;
+}
+
+/* A Line_Accum of num_lines continuation lines of four words each */
+Line_Accum word_lines(int const num_lines) {
+  Line_Accum la;
+  for (int i = 0; i < num_lines; ++i)
+    la.add_line(i + 1, 4, 5, "x1, x2, x3, x4", 1);
+  return la;
+}
+
+/* Map an offset in every word of la through a Cursor, repeats times, and
+   return the best time of a few tries (or a negative time on a mismatch) */
+double cursor_seconds(Line_Accum const &la, int const repeats) {
+  int const N = la.accum().size();
+  double best{-1};
+  for (int trial = 0; trial < 5; ++trial) {
+    auto const start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+      Line_Accum::Cursor c{la.cursor()};
+      int ln, cn, tln, tcn;
+      for (int offset = 0; offset < N; offset += 4) {
+        if (!c.linecolno(offset, ln, cn, tln, tcn))
+          return -1;
+        int const line = offset / 16;
+        if (ln != line + 1 || cn != 5 + (offset - 16 * line))
+          return -1;
+      }
+    }
+    std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (best < 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+/* Mapping the offsets of a logical line in order takes time linear in its
+   length, so mapping a line eight times as long once takes about as long as
+   mapping the short one eight times.  Rescanning the earlier lines for each
+   offset, as the mapping once did, makes the long line eight times slower
+   than that. */
+bool cursor_is_linear() {
+  int const small{2000}, large{8 * small};
+  Line_Accum const small_la{word_lines(small)};
+  Line_Accum const large_la{word_lines(large)};
+  double const small_time = cursor_seconds(small_la, large / small);
+  double const large_time = cursor_seconds(large_la, 1);
+  TEST_TRUE(small_time >= 0);
+  TEST_TRUE(large_time >= 0);
+  TEST_TRUE(large_time <= 3 * small_time + 1e-4);
+
+  /* Going backwards falls back on a binary search */
+  Line_Accum::Cursor c{large_la.cursor()};
+  int ln, cn, tln, tcn;
+  TEST_TRUE(c.linecolno(16 * (large - 1), ln, cn, tln, tcn));
+  TEST_INT(ln, large);
+  TEST_TRUE(c.linecolno(17, ln, cn, tln, tcn));
+  TEST_INT(ln, 2);
+  TEST_INT(cn, 6);
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
   TEST(simple);
@@ -130,5 +226,7 @@ int main() {
   TEST(subname);
   TEST(twoline1);
   TEST(continued_string);
+  TEST(cursor);
+  TEST(cursor_is_linear);
   TEST_MAIN_REPORT;
 }
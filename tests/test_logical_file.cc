@@ -9,14 +9,34 @@
 */
 
 #include "LL_Helper.hh"
+#include "flpr/Edit_Transaction.hh"
 #include "flpr/Logical_File.hh"
 #include "test_helpers.hh"
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
+using FLPR::Edit_Transaction;
 using FLPR::LL_List;
 using FLPR::LL_STMT_SEQ;
+using FLPR::LL_TT_Range;
 using FLPR::Logical_File;
+using FLPR::Logical_Line;
+
+/* Return the text of all of the lines in file */
+std::string file_text(Logical_File &file) {
+  std::ostringstream os;
+  for (auto const &ll : file.lines)
+    os << ll;
+  return os.str();
+}
+
+/* Return the range holding token n of stmt */
+LL_TT_Range nth_token(LL_STMT_SEQ::iterator stmt, int n) {
+  auto tok = std::next(stmt->begin(), n);
+  return LL_TT_Range{stmt->it(), tok, std::next(tok)};
+}
 
 bool replace_stmt_text_1() {
   // clang-format off
@@ -37,8 +57,232 @@ bool replace_stmt_text_1() {
   return true;
 }
 
+bool transaction_one_stmt() {
+  LL_Helper helper({"  x = a + b"});
+  Logical_File &file = helper.logical_file();
+  LL_STMT_SEQ::iterator stmt = file.ll_stmts.begin();
+  size_t const edits_before = file.edit_count();
+
+  Edit_Transaction edits{file};
+  TEST_TRUE(edits.replace_stmt_substr(stmt, nth_token(stmt, 2), "c"));
+  TEST_TRUE(edits.insert_text_after(stmt, nth_token(stmt, 4).begin(), " * 2"));
+  /* This is at the same place as the insertion, so it follows it */
+  TEST_TRUE(edits.append_stmt_text(stmt, " + 1"));
+  TEST_INT(edits.size(), 1);
+  /* Nothing happens until the commit */
+  TEST_EQ(file_text(file), std::string{"  x = a + b\n"});
+
+  TEST_TRUE(edits.commit());
+  TEST_TRUE(edits.empty());
+  TEST_EQ(file_text(file), std::string{"  x = c + b * 2 + 1\n"});
+  TEST_INT(file.ll_stmts.size(), 1);
+  TEST_TRUE(file.ll_stmts.begin() == stmt);
+  TEST_INT(stmt->size(), 9);
+  TEST_EQ(std::next(stmt->begin(), 2)->text(), std::string{"c"});
+  TEST_INT(file.edit_count(), edits_before + 1);
+  return true;
+}
+
+bool transaction_overlaps() {
+  LL_Helper helper({"  x = a + b"});
+  Logical_File &file = helper.logical_file();
+  LL_STMT_SEQ::iterator stmt = file.ll_stmts.begin();
+
+  Edit_Transaction edits{file};
+  TEST_TRUE(edits.replace_stmt_substr(stmt, nth_token(stmt, 2), "c"));
+  /* A later edit that covers an earlier one replaces it... */
+  TEST_TRUE(edits.replace_stmt_text(stmt, "call f(a)",
+                                    FLPR::Syntax_Tags::SG_CALL_STMT));
+  /* ...but an edit inside of an earlier replacement is refused */
+  TEST_FALSE(edits.insert_text_after(stmt, nth_token(stmt, 2).begin(), "d"));
+  TEST_TRUE(edits.commit());
+  TEST_EQ(file_text(file), std::string{"  call f(a)\n"});
+  TEST_INT(stmt->syntax_tag(), FLPR::Syntax_Tags::SG_CALL_STMT);
+  return true;
+}
+
+bool transaction_compound() {
+  LL_Helper helper({"  a = 1; b = 2", "  c = 3"});
+  Logical_File &file = helper.logical_file();
+  TEST_INT(file.ll_stmts.size(), 3);
+  auto a = file.ll_stmts.begin();
+  auto b = std::next(a);
+  auto c = std::next(b);
+
+  Edit_Transaction edits{file};
+  TEST_TRUE(edits.replace_stmt_substr(a, nth_token(a, 2), "10"));
+  TEST_TRUE(edits.replace_stmt_substr(b, nth_token(b, 2), "20"));
+  TEST_TRUE(edits.replace_stmt_substr(c, nth_token(c, 2), "30"));
+  TEST_TRUE(edits.set_stmt_label(c, 100));
+  TEST_INT(edits.size(), 3);
+  TEST_TRUE(edits.commit());
+  TEST_EQ(file_text(file), std::string{"  a = 10; b = 20\n100 c = 30\n"});
+  TEST_INT(file.ll_stmts.size(), 3);
+  TEST_TRUE(a->stmt_ll() == b->stmt_ll());
+  TEST_EQ(std::next(b->begin(), 2)->text(), std::string{"20"});
+  TEST_INT(c->label(), 100);
+  return true;
+}
+
+bool transaction_labels() {
+  LL_Helper helper({"  a = 1; b = 2", "  c = 3"});
+  Logical_File &file = helper.logical_file();
+  auto a = file.ll_stmts.begin();
+  auto b = std::next(a);
+  auto c = std::next(b);
+
+  Edit_Transaction edits{file};
+  /* b can't be labelled without splitting its line */
+  TEST_FALSE(edits.set_stmt_label(b, 10));
+  TEST_TRUE(edits.set_stmt_label(b, 0));
+  TEST_TRUE(edits.empty());
+  TEST_TRUE(edits.set_stmt_label(a, 10));
+  TEST_TRUE(edits.set_stmt_label(c, 30));
+  TEST_TRUE(edits.set_stmt_label(a, 20));
+  TEST_INT(edits.size(), 2);
+  TEST_TRUE(edits.commit());
+  TEST_EQ(file_text(file), std::string{"20 a = 1; b = 2\n30 c = 3\n"});
+  TEST_INT(a->label(), 20);
+  TEST_INT(b->label(), 0);
+  TEST_INT(c->label(), 30);
+  return true;
+}
+
+bool transaction_resets_stmts() {
+  LL_Helper helper({"  a = 1; if = 2"});
+  Logical_File &file = helper.logical_file();
+  auto a = file.ll_stmts.begin();
+  auto b = std::next(a);
+  /* As if a parser had made a name of the keyword */
+  b->begin()->token = FLPR::Syntax_Tags::TK_NAME;
+  b->preclassify();
+  TEST_INT(b->lead_tag(), FLPR::Syntax_Tags::TK_NAME);
+
+  Edit_Transaction edits{file};
+  TEST_TRUE(edits.replace_stmt_substr(a, nth_token(a, 2), "10"));
+  TEST_TRUE(edits.commit());
+  TEST_EQ(file_text(file), std::string{"  a = 10; if = 2\n"});
+  /* b wasn't edited, but its tokens are new, so nothing that it worked out
+     about the old ones survives */
+  TEST_INT(b->begin()->token, FLPR::Syntax_Tags::KW_IF);
+  TEST_INT(b->lead_tag(), FLPR::Syntax_Tags::KW_IF);
+  return true;
+}
+
+bool transaction_rollback() {
+  LL_Helper helper({"  a = 1; b = 2", "  c = 3"});
+  Logical_File &file = helper.logical_file();
+  auto a = file.ll_stmts.begin();
+  auto c = std::next(a, 2);
+  auto const c_first_token = c->begin();
+
+  Edit_Transaction edits{file};
+  TEST_TRUE(edits.replace_stmt_substr(c, nth_token(c, 2), "4"));
+  /* This would change the number of statements on the first line */
+  TEST_TRUE(edits.replace_stmt_substr(a, nth_token(a, 2), "1; d = 5"));
+  TEST_FALSE(edits.commit());
+  TEST_TRUE(edits.empty());
+  TEST_EQ(file_text(file), std::string{"  a = 1; b = 2\n  c = 3\n"});
+  TEST_TRUE(c->begin() == c_first_token);
+  TEST_INT(c->size(), 3);
+  return true;
+}
+
+/* Scan lines serially and with several thread counts, which puts the chunk
+   boundaries in different places, and check that the results agree */
+bool scans_agree(Logical_File::Line_Buf const &buf,
+                 FLPR::File_Type const type) {
+  Logical_File serial;
+  TEST_INT(serial.scan_threads(), 1);
+  TEST_TRUE(serial.scan(buf, "serial", 72, type));
+  TEST_TRUE(serial.scan_arenas.empty());
+  for (int const threads : {2, 3, 4, 7}) {
+    Logical_File parallel;
+    parallel.set_scan_threads(threads);
+    TEST_TRUE(parallel.scan(buf, "parallel", 72, type));
+    TEST_FALSE(parallel.scan_arenas.empty());
+    TEST_INT(parallel.lines.size(), serial.lines.size());
+    TEST_EQ(file_text(parallel), file_text(serial));
+    auto s = serial.lines.begin();
+    for (Logical_Line const &p : parallel.lines) {
+      TEST_TRUE(p.cat == s->cat);
+      TEST_INT(p.needs_reformat, s->needs_reformat);
+      TEST_INT(p.layout().size(), s->layout().size());
+      for (size_t i = 0; i < p.layout().size(); ++i) {
+        TEST_INT(p.layout()[i].open_delim, s->layout()[i].open_delim);
+        TEST_INT(p.layout()[i].is_continued(), s->layout()[i].is_continued());
+      }
+      TEST_INT(p.fragments().size(), s->fragments().size());
+      auto st = s->fragments().begin();
+      for (auto const &pt : p.fragments()) {
+        TEST_INT(pt.token, st->token);
+        TEST_EQ(pt.text(), st->text());
+        ++st;
+      }
+      ++s;
+    }
+    /* The lines tokenized by the tasks can still be edited */
+    parallel.make_stmts();
+    auto last = std::prev(parallel.ll_stmts.end());
+    parallel.append_stmt_text(last, " done");
+    TEST_EQ(last->it()->fragments().back().text(), std::string{"done"});
+  }
+  return true;
+}
+
+bool parallel_scan_free() {
+  /* Continued character contexts, interspersed comments, and literal blocks
+     are the state that crosses lines */
+  Logical_File::Line_Buf buf;
+  for (int i = 0; i < 600; ++i) {
+    std::string const n{std::to_string(i)};
+    for (std::string const &l :
+         {"subroutine s" + n + "(a, b)",
+          std::string{"  integer :: a, b ! comment"},
+          std::string{"  character(len=40) :: c = 'a long &"},
+          std::string{"      &string ! with a bang'"},
+          std::string{"  x = a + &"}, std::string{"! interspersed comment"},
+          std::string{""}, std::string{"      & b"},
+          std::string{"  !#flpr on literal"},
+          std::string{"  this is 'not Fortran"},
+          std::string{"  !#flpr on literal"},
+          std::string{"100 continue; y = \"it's &"},
+          std::string{"  &\"; z = 1"}, "end subroutine s" + n}) {
+      buf.push_back(l);
+    }
+  }
+  return scans_agree(buf, FLPR::File_Type::FREEFMT);
+}
+
+bool parallel_scan_fixed() {
+  Logical_File::Line_Buf buf;
+  for (int i = 0; i < 800; ++i) {
+    std::string const n{std::to_string(i)};
+    for (std::string const &l : {"      subroutine s" + n + "(a)",
+                                 std::string{"c comment"},
+                                 std::string{"      x = 'abc"},
+                                 std::string{"     &def'"},
+                                 std::string{"  100 continue"},
+                                 std::string{"      y = a +"},
+                                 std::string{"* comment"},
+                                 std::string{"     1    b"},
+                                 std::string{"      end subroutine s"}}) {
+      buf.push_back(l);
+    }
+  }
+  return scans_agree(buf, FLPR::File_Type::FIXEDFMT);
+}
+
 int main() {
   TEST_MAIN_DECL;
   TEST(replace_stmt_text_1);
+  TEST(transaction_one_stmt);
+  TEST(transaction_overlaps);
+  TEST(transaction_compound);
+  TEST(transaction_labels);
+  TEST(transaction_resets_stmts);
+  TEST(transaction_rollback);
+  TEST(parallel_scan_free);
+  TEST(parallel_scan_fixed);
   TEST_MAIN_REPORT;
 }
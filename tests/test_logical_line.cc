@@ -9,6 +9,7 @@
 */
 
 #include "LL_Helper.hh"
+#include "flpr/Lexer.hh"
 #include "flpr/Logical_Line.hh"
 #include "test_helpers.hh"
 #include <iostream>
@@ -615,6 +616,76 @@ bool continued_if_fixed_trunc_string() {
   return true;
 }
 
+bool interleaved_lexers() {
+  // Two Lexers must not share any scanner state
+  FLPR::Lexer lex_a, lex_b;
+  std::string const a{"x = 1.5e3_dp"};
+  std::string const b{"call foo(2)"};
+  lex_a.set_input(a);
+  lex_b.set_input(b);
+  TEST_TOK(TK_NAME, lex_a.next());
+  TEST_TOK(KW_CALL, lex_b.next());
+  TEST_INT(lex_a.position(), 1);
+  TEST_INT(lex_b.position(), 4);
+  TEST_TOK(TK_EQUAL, lex_a.next());
+  TEST_TOK(TK_NAME, lex_b.next());
+  TEST_STR("foo", std::string(lex_b.text(), lex_b.length()));
+  TEST_TOK(SG_SIGNIFICAND, lex_a.next());
+  TEST_TOK(TK_PARENL, lex_b.next());
+  TEST_TOK(SG_EXPONENT_LETTER, lex_a.next());
+  TEST_TOK(SG_INT_LITERAL_CONSTANT, lex_b.next());
+  TEST_TOK(SG_EXPONENT, lex_a.next());
+  TEST_TOK(TK_PARENR, lex_b.next());
+  TEST_TOK(TK_UNDERSCORE, lex_a.next());
+  TEST_TOK(EOL, lex_b.next());
+  TEST_TOK(SG_KIND_PARAM, lex_a.next());
+  TEST_INT(lex_a.position(), static_cast<int>(a.size()));
+  TEST_TOK(EOL, lex_a.next());
+
+  // A Logical_Line built with an explicit Lexer matches the default one
+  std::vector<FLPR::File_Line> fl{FLPR::File_Line::analyze_free("a = b", 1)};
+  Logical_Line ll(fl.begin(), fl.end(), lex_a);
+  Logical_Line ll_ref("a = b");
+  TEST_INT(ll.fragments().size(), ll_ref.fragments().size());
+  TEST_STR("b", ll.fragments().back().text());
+  return true;
+}
+
+/* A generated table with a thousand continuation lines.  Each token is
+   mapped back to its file line and column as the line is tokenized, which
+   must not rescan the earlier lines for each token (cursor_is_linear in
+   test_line_accum bounds that work). */
+bool thousand_line_continuation() {
+  int const num_lines{1000}, per_line{10};
+  std::vector<std::string> lines{"data table / &"};
+  std::vector<int> columns; // of each value
+  for (int i = 0; i < num_lines; ++i) {
+    std::string line{"    "};
+    for (int k = 0; k < per_line; ++k) {
+      if (k > 0)
+        line += ", ";
+      columns.push_back(line.size() + 1);
+      line += std::to_string(i * per_line + k);
+    }
+    line += (i + 1 < num_lines) ? ", &" : " /";
+    lines.push_back(line);
+  }
+  Logical_Line ll(lines);
+  TEST_INT(ll.fragments().size(), 3 + 2 * num_lines * per_line);
+
+  /* Check the values, skipping the commas */
+  int const first_line = ll.fragments().front().start_line;
+  auto curr = std::next(ll.cfragments().begin(), 3);
+  for (int v = 0; v < num_lines * per_line; ++v) {
+    TEST_STR(std::to_string(v).c_str(), curr->text());
+    TEST_INT_LABEL(v, curr->start_line, first_line + 1 + v / per_line);
+    TEST_INT_LABEL(v, curr->start_pos, columns[v]);
+    std::advance(curr, 2);
+  }
+  TEST_TOK(TK_SLASHF, ll.fragments().back().token);
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
   TEST(test_default_ctor);
@@ -642,5 +713,7 @@ int main() {
   TEST(continued_if);
   TEST(continued_if_fixed_string);
   TEST(continued_if_fixed_trunc_string);
+  TEST(interleaved_lexers);
+  TEST(thousand_line_continuation);
   TEST_MAIN_REPORT;
 }
@@ -0,0 +1,367 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Parse_Cache
+*/
+#include "flpr/Parse_Cache.hh"
+#include "flpr/Stmt_Parser_Exts.hh"
+#include "flpr/Text_Writer.hh"
+#include "flpr/parse_stmt.hh"
+#include "test_helpers.hh"
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using FLPR::Parse_Cache;
+using FLPR::Syntax_Tags;
+using File = FLPR::Parsed_File<>;
+using Node = File::Parse_Tree::node;
+
+// clang-format off
+std::string const free_text{
+  "! a module\n"
+  "module m\n"
+  "  integer :: n = 3 ! trailing\n"
+  "contains\n"
+  "  subroutine a(x)\n"
+  "    real :: x(n)\n"
+  "    integer :: i, j\n"
+  "    do 10 i = 1, n\n"
+  "    do 10 j = 1, &\n"
+  "         & n\n"
+  "10  x(i) = x(i) + j\n"
+  "    if (x(1) > 0) then\n"
+  "      x(1) = 0; x(2) = 1\n"
+  "    end if\n"
+  "  end subroutine a\n"
+  "end module m\n"};
+
+std::string const fixed_text{
+  "c     a program\n"
+  "      program p\n"
+  "      integer i, k\n"
+  "      k = 1 +\n"
+  "     &    2\n"
+  "      do 20 i = 1, k\n"
+  "   20 continue\n"
+  "      end\n"};
+// clang-format on
+
+/* Describe the tokens covered by each node of a Stmt_Tree */
+void print_ranges(std::ostream &os, FLPR::Stmt::Stmt_Tree::node const &n) {
+  Syntax_Tags::print(os, n->syntag) << ' ' << n->token_range.size();
+  if (!n->token_range.empty())
+    os << " @" << n->token_range.linenum() << ':'
+       << n->token_range.colnum();
+  os << '\n';
+  if (n.is_fork())
+    for (auto const &b : n.branches())
+      print_ranges(os, b);
+}
+
+/* Return the Stmt_Tree ranges of all of the statements */
+std::string stmt_ranges(File &file) {
+  std::ostringstream os;
+  for (auto const &stmt : file.statements())
+    print_ranges(os, *stmt.stmt_tree());
+  return os.str();
+}
+
+/* A restored file must be the same as a freshly parsed one */
+bool matches_fresh(File &restored, std::string const &fname, int col) {
+  TEST_TRUE(bool(restored));
+  File fresh(fname, col);
+  TEST_TRUE(fresh.prefetch_parse_tree());
+  TEST_EQ_NODISPLAY(file_text(fresh), file_text(restored));
+  TEST_EQ_NODISPLAY(tree_text(fresh), tree_text(restored));
+  TEST_EQ_NODISPLAY(stmt_ranges(fresh), stmt_ranges(restored));
+  TEST_TRUE(check_links(*restored.parse_tree()));
+  return true;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool store_and_hit() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("m.f90", free_text);
+  Parse_Cache cache(cache_dir, 1 << 20);
+  TEST_TRUE(cache.usable());
+
+  File first = cache.load(fname, 0);
+  TEST_TRUE(matches_fresh(first, fname, 0));
+  TEST_INT(cache.stats().misses, 1u);
+  TEST_INT(cache.stats().stores, 1u);
+
+  File second = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+  TEST_INT(cache.stats().misses, 1u);
+  TEST_TRUE(matches_fresh(second, fname, 0));
+  TEST_EQ(std::string{"m.f90"},
+          second.logical_file().file_info->filename.substr(dir.path.size() +
+                                                           1));
+
+  /* The restored lines still refer to the file text */
+  FLPR::Text_Writer out;
+  out.append(second.logical_lines());
+  TEST_EQ_NODISPLAY(free_text, std::string{out.text()});
+
+  /* A copy of the file, under another name, shares the entry */
+  std::string const copy = dir.write("copy.f90", free_text);
+  File third = cache.load(copy, 0);
+  TEST_INT(cache.stats().hits, 2u);
+  TEST_EQ(copy, third.logical_file().file_info->filename);
+  return true;
+}
+
+bool fixed_format() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("p.f", fixed_text);
+  Parse_Cache cache(cache_dir, 1 << 20);
+  File first = cache.load(fname, 72);
+  TEST_TRUE(matches_fresh(first, fname, 72));
+  File second = cache.load(fname, 72);
+  TEST_INT(cache.stats().hits, 1u);
+  TEST_TRUE(matches_fresh(second, fname, 72));
+
+  /* The column limit is part of the key */
+  File third = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+  TEST_INT(cache.stats().misses, 2u);
+  return true;
+}
+
+bool edit_after_restore() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("m.f90", free_text);
+  Parse_Cache cache(cache_dir, 1 << 20);
+  cache.load(fname, 0);
+  File file = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+
+  /* Change the declaration of i into an assignment */
+  auto stmt = std::next(file.statements().begin(), 5);
+  file.logical_file().replace_stmt_text(stmt, {"n = 2"},
+                                        Syntax_Tags::SG_ASSIGNMENT_STMT);
+  TEST_TRUE(file.prefetch_parse_tree());
+  std::string const edited = dir.write("edited.f90", file_text(file));
+  TEST_TRUE(matches_fresh(file, edited, 0));
+  return true;
+}
+
+bool eviction() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::uintmax_t entry_size{0};
+  {
+    Parse_Cache sizer(cache_dir, 1 << 20);
+    sizer.load(dir.write("m.f90", free_text), 0);
+    auto const entries = list_dir(cache_dir);
+    TEST_INT(entries.size(), 1u);
+    std::ifstream is(cache_dir + '/' + entries.front());
+    is.seekg(0, std::ios::end);
+    entry_size = is.tellg();
+  }
+
+  /* Room for two entries: each load after the second pushes out the oldest,
+     starting with the one that sized them */
+  Parse_Cache cache(cache_dir, 2 * entry_size + entry_size / 2);
+  for (int i = 0; i < 3; ++i) {
+    std::string const text = free_text + "! " + std::to_string(i) + '\n';
+    File f = cache.load(dir.write("f" + std::to_string(i) + ".f90", text), 0);
+    TEST_TRUE(bool(f));
+  }
+  TEST_INT(cache.stats().stores, 3u);
+  TEST_INT(cache.stats().evictions, 2u);
+  TEST_INT(list_dir(cache_dir).size(), 2u);
+
+  /* The most recently used entries are kept */
+  File f = cache.load(dir.path + "/f2.f90", 0);
+  TEST_INT(cache.stats().hits, 1u);
+  return true;
+}
+
+bool corrupt_entry() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("m.f90", free_text);
+  Parse_Cache cache(cache_dir, 1 << 20);
+  cache.load(fname, 0);
+
+  /* Truncate the entry */
+  std::string const entry{cache_dir + '/' + list_dir(cache_dir).front()};
+  TEST_INT(truncate(entry.c_str(), 100), 0);
+
+  File file = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 0u);
+  TEST_INT(cache.stats().misses, 2u);
+  TEST_INT(cache.stats().stores, 2u);
+  TEST_TRUE(matches_fresh(file, fname, 0));
+
+  /* ... and it has been replaced */
+  File again = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+  TEST_TRUE(matches_fresh(again, fname, 0));
+  return true;
+}
+
+/* No extensions are registered here, so only the builtin tags are valid */
+bool known_tag(int const tag) {
+  return tag >= 0 && tag < Syntax_Tags::CLIENT_EXTENSION;
+}
+
+/* True if every tag in a Stmt_Tree is known */
+bool valid_tags(FLPR::Stmt::Stmt_Tree::node const &n) {
+  TEST_TRUE(known_tag(n->syntag));
+  if (n.is_fork())
+    for (auto const &b : n.branches())
+      TEST_TRUE(valid_tags(b));
+  return true;
+}
+
+/* True if every tag in a Parse_Tree is known */
+bool valid_tags(Node const &n) {
+  TEST_TRUE(known_tag(n->syntag()));
+  if (n.is_fork())
+    for (auto const &b : n.branches())
+      TEST_TRUE(valid_tags(b));
+  return true;
+}
+
+/* An entry that decodes to tags that don't exist is a miss, whichever byte
+   of it is damaged */
+bool corrupt_tags() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("p.f", fixed_text);
+  std::string entry_name, original;
+  {
+    Parse_Cache cache(cache_dir, 1 << 20);
+    cache.load(fname, 0);
+    entry_name = cache_dir + '/' + list_dir(cache_dir).front();
+    std::ifstream is(entry_name);
+    std::ostringstream os;
+    os << is.rdbuf();
+    original = os.str();
+  }
+  TEST_TRUE(original.size() > 100);
+
+  int hits{0};
+  for (std::size_t i = 0; i < original.size(); ++i) {
+    std::string damaged{original};
+    damaged[i] = static_cast<char>(0x7f);
+    {
+      std::ofstream os(entry_name, std::ios::binary | std::ios::trunc);
+      os << damaged;
+    }
+    Parse_Cache cache(cache_dir, 1 << 20);
+    File file = cache.load(fname, 0);
+    TEST_TRUE(bool(file));
+    if (!cache.stats().hits)
+      continue;
+    hits += 1;
+    for (auto const &ll : file.logical_lines())
+      for (auto const &tt : ll.fragments())
+        TEST_TRUE(known_tag(tt.token));
+    for (auto const &stmt : file.statements()) {
+      TEST_TRUE(known_tag(stmt.syntax_tag()));
+      if (stmt.has_stmt_tree())
+        TEST_TRUE(valid_tags(*stmt.stmt_tree()));
+    }
+    TEST_TRUE(valid_tags(*file.parse_tree()));
+  }
+  /* Some bytes (like the text of a comment) don't matter */
+  TEST_TRUE(hits > 0);
+  return true;
+}
+
+/* Temporaries left behind by writers are removed once they are stale */
+bool stale_temps() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  { Parse_Cache cache(cache_dir, 1 << 20); }
+  std::string const stale =
+      dir.write("cache/0123456789abcdef-1-0.flprc.AbC123", "partial");
+  std::string const fresh =
+      dir.write("cache/fedcba9876543210-1-0.flprc.XyZ789", "partial");
+  std::string const other = dir.write("cache/notes.txt.AbC123", "keep");
+  struct timespec const old_times[2] = {{0, UTIME_OMIT}, {1000, 0}};
+  TEST_INT(utimensat(AT_FDCWD, stale.c_str(), old_times, 0), 0);
+  TEST_INT(utimensat(AT_FDCWD, other.c_str(), old_times, 0), 0);
+
+  Parse_Cache cache(cache_dir, 1 << 20);
+  TEST_TRUE(cache.usable());
+  TEST_FALSE(access(stale.c_str(), F_OK) == 0);
+  TEST_TRUE(access(fresh.c_str(), F_OK) == 0);
+  TEST_TRUE(access(other.c_str(), F_OK) == 0);
+  return true;
+}
+
+/* Entries written with other extensions registered are not used.  A
+   registered syntag can't be removed, so this runs last. */
+bool extensions_change_key() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const cache_dir = dir.file("cache");
+  std::string const fname = dir.write("m.f90", free_text);
+  Parse_Cache cache(cache_dir, 1 << 20);
+  std::uint64_t const plain = Parse_Cache::parsers_id();
+  TEST_INT(Parse_Cache::parsers_id(), plain);
+  File first = cache.load(fname, 0);
+  TEST_INT(cache.stats().stores, 1u);
+
+  auto &exts = FLPR::Stmt::get_parser_exts();
+  exts.register_action_stmt(FLPR::Stmt::continue_stmt);
+  std::uint64_t const extended = Parse_Cache::parsers_id();
+  TEST_TRUE(extended != plain);
+  File second = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 0u);
+  TEST_INT(cache.stats().stores, 2u);
+  exts.clear();
+  TEST_INT(Parse_Cache::parsers_id(), plain);
+  File third = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+
+  Syntax_Tags::register_ext(Syntax_Tags::CLIENT_EXTENSION + 3,
+                            "test-ext-stmt", 5);
+  TEST_TRUE(Parse_Cache::parsers_id() != plain);
+  TEST_TRUE(Parse_Cache::parsers_id() != extended);
+  File fourth = cache.load(fname, 0);
+  TEST_INT(cache.stats().hits, 1u);
+  TEST_INT(cache.stats().stores, 3u);
+  TEST_TRUE(matches_fresh(fourth, fname, 0));
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(store_and_hit);
+  TEST(fixed_format);
+  TEST(edit_after_restore);
+  TEST(eviction);
+  TEST(corrupt_entry);
+  TEST(corrupt_tags);
+  TEST(stale_temps);
+  TEST(extensions_change_key);
+
+  TEST_MAIN_REPORT;
+}
@@ -11,6 +11,7 @@
 #include "LL_Helper.hh"
 #include "flpr/Prgm_Parsers.hh"
 #include "flpr/Prgm_Tree.hh"
+#include "flpr/parse_stmt.hh"
 #include "test_helpers.hh"
 #include <iostream>
 
@@ -214,6 +215,114 @@ bool module_program() {
 
 // clang-format on
 
+/* The program parsers should reuse the statement parses, and the lead tags
+   should let them skip the parsers that can't match */
+bool stmt_parse_cache() {
+  LL_Helper ls({"function foo", "integer i", "scan: do i=1,5", "i = i + 1",
+                "end do scan", "end function"});
+  for (LL_Stmt &stmt : ls.ll_stmts())
+    stmt.preclassify();
+  auto stmt = ls.ll_stmts().begin();
+  TEST_EQ(Syntax_Tags::KW_FUNCTION, stmt->lead_tag());
+  std::advance(stmt, 2);
+  TEST_EQ(Syntax_Tags::KW_DO, stmt->lead_tag());
+  TEST_EQ(Syntax_Tags::TK_NAME, std::next(stmt)->lead_tag());
+
+  PS::State state(ls.ll_stmts());
+  auto res = PS::program(state);
+  TEST_TRUE(res.match);
+  TEST_EQ(Syntax_Tags::SG_DO_STMT, stmt->syntax_tag());
+  TEST_TRUE(stmt->parse_with(FLPR::Stmt::do_stmt));
+  TEST_FALSE(stmt->parse_with(FLPR::Stmt::end_do_stmt));
+  ++stmt;
+  TEST_EQ(Syntax_Tags::SG_ASSIGNMENT_STMT, stmt->syntax_tag());
+  TEST_FALSE(FLPR::Stmt::may_lead(FLPR::Stmt::end_do_stmt, stmt->lead_tag()));
+  TEST_TRUE(FLPR::Stmt::may_lead(FLPR::Stmt::action_stmt, stmt->lead_tag()));
+
+  /* dropping the tree forgets the cached results */
+  stmt->drop_stmt_tree();
+  TEST_FALSE(stmt->parse_with(FLPR::Stmt::do_stmt));
+  TEST_TRUE(stmt->parse_with(FLPR::Stmt::action_stmt));
+  TEST_EQ(Syntax_Tags::SG_ASSIGNMENT_STMT, stmt->syntax_tag());
+  return true;
+}
+
+/* A statement parser that unkeywords the whole statement and then fails,
+   like an alternative that gives up after reinterpreting the keywords */
+FLPR::Stmt::Stmt_Tree unkeyword_and_fail(TT_Stream &ts) {
+  ts.unkeyword();
+  return FLPR::Stmt::Stmt_Tree{};
+}
+
+/* A statement parser that only matches a statement that starts with a name */
+FLPR::Stmt::Stmt_Tree name_lead(TT_Stream &ts) {
+  if (ts.peek() != Syntax_Tags::TK_NAME)
+    return FLPR::Stmt::Stmt_Tree{};
+  return FLPR::Stmt::Stmt_Tree{Syntax_Tags::SG_ASSIGNMENT_STMT,
+                               ts.digest(ts.source().size())};
+}
+
+/* An alternative that unkeywords the statement changes which parsers can
+   match it, so the recorded failures and the lead tag are recomputed */
+bool unkeyword_resets_cache() {
+  LL_Helper ls({"do i=1,5"});
+  LL_Stmt &stmt = ls.ll_stmts().front();
+  stmt.preclassify();
+  TEST_EQ(Syntax_Tags::KW_DO, stmt.lead_tag());
+  TEST_FALSE(stmt.parse_with(name_lead));
+  TEST_FALSE(stmt.parse_with(unkeyword_and_fail));
+  TEST_EQ(Syntax_Tags::TK_NAME, stmt.lead_tag());
+  TEST_FALSE(FLPR::Stmt::may_lead(FLPR::Stmt::do_stmt, stmt.lead_tag()));
+  TEST_FALSE(stmt.parse_with(FLPR::Stmt::do_stmt));
+  TEST_TRUE(stmt.parse_with(name_lead));
+  TEST_EQ(Syntax_Tags::SG_ASSIGNMENT_STMT, stmt.syntax_tag());
+
+  /* The same holds when the outcomes came from prefetch_parses() */
+  LL_Helper pre({"do i=1,5"});
+  LL_Stmt &pstmt = pre.ll_stmts().front();
+  pstmt.preclassify();
+  pstmt.prefetch_parses({name_lead, unkeyword_and_fail});
+  TEST_FALSE(pstmt.parse_with(name_lead));
+  TEST_FALSE(pstmt.parse_with(unkeyword_and_fail));
+  TEST_EQ(Syntax_Tags::TK_NAME, pstmt.lead_tag());
+  TEST_TRUE(pstmt.parse_with(name_lead));
+  return true;
+}
+
+std::vector<int> token_kinds(LL_Stmt const &stmt) {
+  std::vector<int> kinds;
+  for (auto tt = stmt.begin(); tt != stmt.end(); ++tt)
+    kinds.push_back(tt->token);
+  return kinds;
+}
+
+/* parse_with() after prefetch_parses() gives the same results, and leaves
+   the same token kinds, as parse_with() alone, even when the prefetch ran
+   the parsers in another order */
+bool prefetch_parses() {
+  std::vector<LL_Stmt::parser_function> const orders[] = {
+      {FLPR::Stmt::do_stmt, unkeyword_and_fail},
+      {unkeyword_and_fail, FLPR::Stmt::do_stmt}};
+  for (auto const &order : orders) {
+    LL_Helper serial({"do i=1,5"});
+    LL_Helper prefetched({"do i=1,5"});
+    LL_Stmt &ss = serial.ll_stmts().front();
+    LL_Stmt &ps = prefetched.ll_stmts().front();
+    ss.preclassify();
+    ps.preclassify();
+    ps.prefetch_parses({FLPR::Stmt::do_stmt, unkeyword_and_fail});
+    TEST_EQ_NODISPLAY(token_kinds(ss), token_kinds(ps));
+    for (LL_Stmt::parser_function const f : order) {
+      bool const matched = ss.parse_with(f);
+      TEST_EQ(matched, ps.parse_with(f));
+      TEST_EQ_NODISPLAY(token_kinds(ss), token_kinds(ps));
+      if (matched)
+        TEST_EQ(ss.syntax_tag(), ps.syntax_tag());
+    }
+  }
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
   TEST(test_instantiate);
@@ -230,5 +339,8 @@ int main() {
   TEST(derived_type_def);
   TEST(do_select_construct);
   TEST(module_program);
+  TEST(stmt_parse_cache);
+  TEST(prefetch_parses);
+  TEST(unkeyword_resets_cache);
   TEST_MAIN_REPORT;
 }
@@ -12,12 +12,29 @@
   Tests for full statement parsers.
 */
 
+#include "flpr/Stmt_Memo.hh"
 #include "flpr/parse_stmt.hh"
 #include "parse_helpers.hh"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace FLPR;
 using FLPR::Stmt::Stmt_Tree;
 
+#ifndef FLPR_SOURCE_DIR
+#define FLPR_SOURCE_DIR "."
+#endif
+#ifndef FLPR_TEST_DIR
+#define FLPR_TEST_DIR "."
+#endif
+
 bool allocatable_stmt() {
   TSS(allocatable_stmt, "allocatable a");
   TSS(allocatable_stmt, "allocatable a(1)");
@@ -451,6 +468,75 @@ bool pointer_assignment_stmt() {
   return true;
 }
 
+/* action_stmt tries assignment-stmt before pointer-assignment-stmt, so the
+   leading variable is parsed twice at the same position */
+bool memoized_action_stmt() {
+  char const *const stmts[] = {"a(i)%b => c", "x(1:n) = y(2:n+1) + z",
+                               "p%q%r => s(3)"};
+  for (char const *s : stmts) {
+    LL_Helper l({s});
+    TT_Stream ts = l.stream1();
+    Stmt_Tree plain = FLPR::Stmt::action_stmt(ts);
+    TEST_TREE(plain, action_stmt, l);
+    TEST_TOK_EQ(Syntax_Tags::BAD, ts.peek(), l);
+
+    FLPR::Stmt::Stmt_Memo memo;
+    TT_Stream mts = l.stream1();
+    mts.set_memo(&memo);
+    Stmt_Tree memoized = FLPR::Stmt::action_stmt(mts);
+    TEST_TREE(memoized, action_stmt, l);
+    TEST_TOK_EQ(Syntax_Tags::BAD, mts.peek(), l);
+    TEST_TRUE(memo.size() > 0);
+    TEST_INT(memoized.size(), plain.size());
+
+    /* the trees should be identical */
+    auto pc = plain.ccursor();
+    auto mc = memoized.ccursor();
+    TEST_EQ(pc->syntag, mc->syntag);
+    TEST_TRUE(pc->token_range.equal(mc->token_range));
+  }
+
+  /* the pointer-assignment re-parses the variable */
+  LL_Helper l({"a(i)%b => c"});
+  FLPR::Stmt::Stmt_Memo memo;
+  TT_Stream ts = l.stream1();
+  ts.set_memo(&memo);
+  Stmt_Tree st = FLPR::Stmt::action_stmt(ts);
+  TEST_TREE(st, action_stmt, l);
+  TEST_TRUE(memo.hits() > 0);
+  return true;
+}
+
+/* action_stmt dispatches on the first token, but a keyword can also be the
+   name of a variable, so the assignments have to be tried for any token */
+bool dispatched_action_stmt() {
+  struct {
+    char const *text;
+    int syntag;
+  } const cases[] = {{"call foo(a)", Syntax_Tags::SG_CALL_STMT},
+                     {"call = 3", Syntax_Tags::SG_ASSIGNMENT_STMT},
+                     {"stop", Syntax_Tags::SG_STOP_STMT},
+                     {"stop(1) = 2", Syntax_Tags::SG_ASSIGNMENT_STMT},
+                     {"go to 10", Syntax_Tags::SG_GOTO_STMT},
+                     {"go to (10, 20) i", Syntax_Tags::SG_COMPUTED_GOTO_STMT},
+                     {"if (x) return", Syntax_Tags::SG_IF_STMT},
+                     {"if (x) 10, 20, 30", Syntax_Tags::SG_ARITHMETIC_IF_STMT},
+                     {"read => p", Syntax_Tags::SG_POINTER_ASSIGNMENT_STMT},
+                     {"foo(bar)", Syntax_Tags::SG_MACRO_STMT}};
+  for (auto const &c : cases) {
+    LL_Helper l({c.text});
+    TT_Stream ts = l.stream1();
+    Stmt_Tree st = FLPR::Stmt::action_stmt(ts);
+    TEST_TREE(st, action_stmt, l);
+    TEST_TOK_EQ(Syntax_Tags::BAD, ts.peek(), l);
+    auto c1 = st.ccursor();
+    TEST_EQ(c1->syntag, Syntax_Tags::SG_ACTION_STMT);
+    c1.down();
+    TEST_EQ(c1->syntag, c.syntag);
+  }
+  return true;
+}
+
 bool pointer_stmt() {
   TSS(pointer_stmt, "pointer a");
   TSS(pointer_stmt, "pointer a,b");
@@ -627,6 +713,166 @@ bool write_stmt() {
   return true;
 }
 
+/* An alternative that parse_stmt.cc wraps with starts_with<...>() */
+struct First_Annotation {
+  std::string name;
+  Stmt_Tree (*parser)(TT_Stream &);
+  std::vector<int> tags;
+};
+
+/* The keyword with the given Syntax_Tags name, or UNKNOWN */
+int keyword_tag(std::string const &name) {
+  if (name.compare(0, 3, "KW_") != 0)
+    return Syntax_Tags::UNKNOWN;
+  for (int tag = Syntax_Tags::kw_begin_tag(); tag < Syntax_Tags::kw_end_tag();
+       ++tag)
+    if (Syntax_Tags::label(tag) == name.substr(3))
+      return tag;
+  return Syntax_Tags::UNKNOWN;
+}
+
+/* Read every starts_with<...>(rule(...)) in parse_stmt.cc, so that a new
+   annotation is checked as soon as it is written */
+bool read_annotations(std::vector<First_Annotation> &annotations) {
+#define STMT(F)                                                                \
+  { #F, FLPR::Stmt::F }
+  std::map<std::string, Stmt_Tree (*)(TT_Stream &)> const parsers{
+      STMT(access_stmt),        STMT(allocatable_stmt),
+      STMT(allocate_stmt),      STMT(arithmetic_if_stmt),
+      STMT(asynchronous_stmt),  STMT(backspace_stmt),
+      STMT(bind_stmt),          STMT(call_stmt),
+      STMT(close_stmt),         STMT(codimension_stmt),
+      STMT(common_stmt),        STMT(computed_goto_stmt),
+      STMT(continue_stmt),      STMT(cycle_stmt),
+      STMT(deallocate_stmt),    STMT(dimension_stmt),
+      STMT(endfile_stmt),       STMT(equivalence_stmt),
+      STMT(error_stop_stmt),    STMT(event_post_stmt),
+      STMT(event_wait_stmt),    STMT(exit_stmt),
+      STMT(external_stmt),      STMT(fail_image_stmt),
+      STMT(flush_stmt),         STMT(forall_stmt),
+      STMT(form_team_stmt),     STMT(goto_stmt),
+      STMT(if_stmt),            STMT(inquire_stmt),
+      STMT(intent_stmt),        STMT(intrinsic_stmt),
+      STMT(lock_stmt),          STMT(namelist_stmt),
+      STMT(nullify_stmt),       STMT(open_stmt),
+      STMT(optional_stmt),      STMT(pointer_stmt),
+      STMT(print_stmt),         STMT(protected_stmt),
+      STMT(read_stmt),          STMT(return_stmt),
+      STMT(rewind_stmt),        STMT(save_stmt),
+      STMT(stop_stmt),          STMT(sync_all_stmt),
+      STMT(sync_images_stmt),   STMT(sync_memory_stmt),
+      STMT(sync_team_stmt),     STMT(target_stmt),
+      STMT(unlock_stmt),        STMT(value_stmt),
+      STMT(volatile_stmt),      STMT(wait_stmt),
+      STMT(where_stmt),         STMT(write_stmt)};
+#undef STMT
+
+  std::string const fname{std::string{FLPR_SOURCE_DIR} +
+                          "/src/flpr/parse_stmt.cc"};
+  std::ifstream is(fname);
+  TEST_TRUE(is.good());
+  std::string const text{std::istreambuf_iterator<char>{is},
+                         std::istreambuf_iterator<char>{}};
+  std::regex const annotation{
+      R"(starts_with<([^>]*)>\(\s*rule\((\w+)\)\s*\))"};
+  std::regex const tag{R"(TAG\((\w+)\))"};
+  for (std::sregex_iterator m{text.begin(), text.end(), annotation}, end;
+       m != end; ++m) {
+    std::string const name{(*m)[2]};
+    auto const p = parsers.find(name);
+    TEST_INT_LABEL(name, (p != parsers.end()), true);
+    First_Annotation a{name, p->second, {}};
+    std::string const tags{(*m)[1]};
+    for (std::sregex_iterator t{tags.begin(), tags.end(), tag}; t != end;
+         ++t) {
+      a.tags.push_back(keyword_tag((*t)[1]));
+      TEST_INT_LABEL((*t)[1], (a.tags.back() != Syntax_Tags::UNKNOWN), true);
+    }
+    TEST_INT_LABEL(name, a.tags.empty(), false);
+    annotations.push_back(std::move(a));
+  }
+  return true;
+}
+
+// clang-format off
+/* At least one statement for each annotated alternative, and some that
+   start with a keyword used as a name */
+std::vector<std::string> const first_corpus{
+  "allocate(a(n), stat=s)", "backspace 10", "call f(x)", "close(10)",
+  "continue", "cycle outer", "deallocate(a)", "endfile 10", "end file 10",
+  "error stop 'no'", "event post(ev)", "event wait(ev)", "exit",
+  "fail image", "flush(10)", "form team(2, t)", "go to 10", "goto 10",
+  "if (x > 0) y = 1", "inquire(unit=10, opened=o)", "lock(l)",
+  "nullify(p)", "open(10, file='f')", "print *, x", "read(5, *) x",
+  "read *, x", "return", "rewind 10", "stop", "sync all", "sync images(*)",
+  "sync memory", "sync team(t)", "unlock(l)", "wait(10)",
+  "where (a > 0) b = 1", "write(6, *) x", "go to (10, 20), i",
+  "if (x) 10, 20, 30", "forall (i = 1:n) a(i) = 0",
+  "public :: a", "private", "allocatable :: a(:)", "asynchronous :: a",
+  "bind(c) :: f", "codimension :: a[*]", "dimension a(10)",
+  "external f", "intent(in) :: x", "intrinsic sin", "namelist /n/ a, b",
+  "optional :: x", "pointer :: p", "protected :: x", "save",
+  "target :: t", "volatile :: v", "value :: x", "common /c/ a, b",
+  "equivalence (a, b)",
+  "if = 1", "call = 2", "print = 3", "read(1) = 4", "stop%x = 5",
+  "sync = 6", "go = 7", "where(1) = 8", "data = 9", "save(2) = 10",
+  "public = 11", "value => p", "exit = .true.", "error = 12",
+  "call%f = 13", "event(1)%x = 14"};
+// clang-format on
+
+/* The statements of first_corpus and lexer_corpus.f90 */
+bool first_corpus_stmts(LL_Helper::Raw_Lines &lines) {
+  std::copy(first_corpus.begin(), first_corpus.end(),
+            std::back_inserter(lines));
+  std::ifstream is(std::string{FLPR_TEST_DIR} + "/lexer_corpus.f90");
+  TEST_TRUE(is.good());
+  std::string line;
+  while (std::getline(is, line))
+    lines.push_back(line);
+  return true;
+}
+
+/* A Dispatch_Parser only tries a starts_with<...>() alternative when the
+   statement starts with one of the tags, so the alternative must not be
+   able to match anything else */
+bool first_annotations() {
+  std::vector<First_Annotation> annotations;
+  TEST_TRUE(read_annotations(annotations));
+  TEST_INT(annotations.size(), 56);
+  LL_Helper::Raw_Lines lines;
+  TEST_TRUE(first_corpus_stmts(lines));
+  LL_Helper helper{std::move(lines)};
+  TEST_TRUE(helper.ll_stmts().size() > 250);
+
+  for (First_Annotation const &a : annotations) {
+    int matches{0};
+    for (LL_Stmt &stmt : helper.ll_stmts()) {
+      Token_Text const &first = stmt.front();
+      int const first_tag = first.token;
+      std::string const first_text{first.text()};
+      TT_Stream ts{stmt};
+      if (!a.parser(ts))
+        continue;
+      matches += 1;
+      bool allowed =
+          std::find(a.tags.begin(), a.tags.end(), first_tag) != a.tags.end();
+      /* ...or a keyword that had been turned into a name */
+      std::string upper{first_text};
+      for (char &c : upper)
+        c = std::toupper(static_cast<unsigned char>(c));
+      for (int const tag : a.tags)
+        if (first_tag == Syntax_Tags::TK_NAME &&
+            Syntax_Tags::label(tag) == upper)
+          allowed = true;
+      std::ostringstream where;
+      where << a.name << " matched \"" << stmt << '"';
+      TEST_INT_LABEL(where.str(), allowed, true);
+    }
+    TEST_INT_LABEL(a.name, (matches > 0), true);
+  }
+  return true;
+}
+
 // For one-keyword statements
 bool easy() {
   TSS(contains_stmt, "contains");
@@ -637,6 +883,7 @@ bool easy() {
 int main() {
   TEST_MAIN_DECL;
   TEST(easy);
+  TEST(first_annotations);
   TEST(allocatable_stmt);
   TEST(allocate_stmt);
   TEST(arithmetic_if_stmt);
@@ -710,5 +957,7 @@ int main() {
   TEST(where_stmt);
   TEST(write_stmt);
 
+  TEST(memoized_action_stmt);
+  TEST(dispatched_action_stmt);
   TEST_MAIN_REPORT;
 }
@@ -0,0 +1,498 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Parsed_File, in particular the incremental parse tree updates
+*/
+#include "flpr/Edit_Transaction.hh"
+#include "flpr/Parsed_File.hh"
+#include "test_helpers.hh"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using FLPR::LL_STMT_SEQ;
+using FLPR::LL_TT_Range;
+using FLPR::Logical_Line;
+using FLPR::Stmt_Index;
+using FLPR::Symbol_Table;
+using FLPR::Syntax_Tags;
+using File = FLPR::Parsed_File<>;
+using Node = File::Parse_Tree::node;
+
+/* Return the nth statement of file */
+LL_STMT_SEQ::iterator nth_stmt(File &file, int n) {
+  return std::next(file.statements().begin(), n);
+}
+
+/* Return the nth token of a statement */
+LL_TT_Range nth_token(LL_STMT_SEQ::iterator stmt, int n) {
+  auto tok = std::next(stmt->begin(), n);
+  return LL_TT_Range{stmt->it(), tok, std::next(tok)};
+}
+
+/* The updated tree must match the tree of a freshly parsed copy */
+bool matches_full_parse(File &file) {
+  TEST_TRUE(file.prefetch_parse_tree());
+  TEST_TRUE(bool(file));
+  TEST_TRUE(check_links(*file.parse_tree()));
+  std::istringstream is{file_text(file)};
+  File fresh(is, "fresh.f90", 0);
+  TEST_TRUE(fresh.prefetch_parse_tree());
+  TEST_EQ_NODISPLAY(tree_text(fresh), tree_text(file));
+  return true;
+}
+
+// clang-format off
+std::string const two_subroutines{
+  "subroutine a(x, n)\n"
+  "  integer :: n, i\n"
+  "  real :: x(n)\n"
+  "  do i = 1, n\n"
+  "    x(i) = 0\n"
+  "  end do\n"
+  "  x(1) = 1\n"
+  "end subroutine a\n"
+  "subroutine b(x)\n"
+  "  real :: x\n"
+  "  if (x > 0) then\n"
+  "    x = 1\n"
+  "  end if\n"
+  "end subroutine b\n"};
+// clang-format on
+
+bool edit_in_do_loop() {
+  std::istringstream is{two_subroutines};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+
+  /* Remember a node in the other subroutine */
+  auto other = file.stmt_to_node_cursor(nth_stmt(file, 10));
+  TEST_TRUE(other);
+  other.up();
+  TEST_INT(other->syntag(), Syntax_Tags::PG_IF_CONSTRUCT);
+  Node *other_node = &other.node();
+  std::string const other_text = [&other] {
+    std::ostringstream os;
+    os << other.node();
+    return os.str();
+  }();
+
+  /* Replace the body of the loop, and add a statement after it */
+  auto body = nth_stmt(file, 4);
+  file.logical_file().replace_stmt_text(body, {"x(i) = i"},
+                                        Syntax_Tags::SG_ASSIGNMENT_STMT);
+  file.logical_file().emplace_ll_stmt(body, Logical_Line{"call f(x(i))"},
+                                      Syntax_Tags::SG_CALL_STMT);
+  TEST_FALSE(body->has_hook());
+  TEST_TRUE(matches_full_parse(file));
+
+  /* The untouched construct is the same node, with the same contents */
+  auto still = file.stmt_to_node_cursor(nth_stmt(file, 11));
+  still.up();
+  TEST_TRUE(&still.node() == other_node);
+  std::ostringstream os;
+  os << still.node();
+  TEST_EQ_NODISPLAY(other_text, os.str());
+  return true;
+}
+
+bool edit_changes_construct() {
+  std::istringstream is{two_subroutines};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  /* Turn two adjacent assignments into an if-construct */
+  file.logical_file().replace_stmt_text(nth_stmt(file, 6), {"if (n > 1) then"},
+                                        Syntax_Tags::SG_IF_THEN_STMT);
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 7),
+                                      Logical_Line{"end if"},
+                                      Syntax_Tags::SG_END_IF_STMT);
+  TEST_TRUE(matches_full_parse(file));
+  auto c = file.stmt_to_node_cursor(nth_stmt(file, 6));
+  c.up();
+  TEST_INT(c->syntag(), Syntax_Tags::PG_IF_CONSTRUCT);
+  return true;
+}
+
+bool edit_in_shared_do() {
+  // clang-format off
+  std::istringstream is{
+    "program p\n"
+    "  integer :: i, j, k\n"
+    "  do 10 i = 1, 2\n"
+    "  do 10 j = 1, 2\n"
+    "  k = i\n"
+    "10 k = k + j\n"
+    "end program p\n"};
+  // clang-format on
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  file.logical_file().replace_stmt_text(nth_stmt(file, 4), {"k = j"},
+                                        Syntax_Tags::SG_ASSIGNMENT_STMT);
+  TEST_TRUE(matches_full_parse(file));
+  /* Relabelling the terminal statement changes the loop structure */
+  file.logical_file().set_stmt_label(nth_stmt(file, 5), 20);
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 6),
+                                      Logical_Line{"10 continue"},
+                                      Syntax_Tags::SG_CONTINUE_STMT);
+  TEST_TRUE(matches_full_parse(file));
+  return true;
+}
+
+bool edits_in_two_constructs() {
+  std::istringstream is{two_subroutines};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  /* Two separate runs of edits, both of which add statements, so neither
+     construct has the right size until both have been re-parsed */
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 4),
+                                      Logical_Line{"call f(x(i))"},
+                                      Syntax_Tags::SG_CALL_STMT);
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 12),
+                                      Logical_Line{"call g(x)"},
+                                      Syntax_Tags::SG_CALL_STMT);
+  TEST_TRUE(matches_full_parse(file));
+  /* ...and where the second construct contains the first */
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 5),
+                                      Logical_Line{"call h(x(i))"},
+                                      Syntax_Tags::SG_CALL_STMT);
+  file.logical_file().replace_stmt_text(nth_stmt(file, 8), {"if (n > 1) then"},
+                                        Syntax_Tags::SG_IF_THEN_STMT);
+  file.logical_file().emplace_ll_stmt(nth_stmt(file, 9),
+                                      Logical_Line{"end if"},
+                                      Syntax_Tags::SG_END_IF_STMT);
+  TEST_TRUE(matches_full_parse(file));
+  return true;
+}
+
+/* Re-parse, and check that the Logical_File Arena didn't grow */
+bool reparse_outside_arena(File &file) {
+  FLPR::Arena const &arena{*file.logical_file().arena};
+  size_t const arena_bytes{arena.bytes_allocated()};
+  TEST_TRUE(file.prefetch_parse_tree());
+  TEST_INT(arena.bytes_allocated(), arena_bytes);
+  return true;
+}
+
+bool edit_cycles_stay_flat() {
+  std::istringstream is{two_subroutines};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  FLPR::Arena const &arena{*file.logical_file().arena};
+  /* The lines, and the trees that re-parses replace, would be lost in the
+     Arena */
+  size_t arena_bytes{0};
+  for (int cycle = 0; cycle < 10; ++cycle) {
+    /* One construct is re-parsed, and then the whole tree is rebuilt */
+    file.logical_file().replace_stmt_text(nth_stmt(file, 4), {"x(i) = i"},
+                                          Syntax_Tags::SG_ASSIGNMENT_STMT);
+    TEST_TRUE(reparse_outside_arena(file));
+    file.logical_file().replace_stmt_text(
+        nth_stmt(file, 0), {"subroutine a(x, n)"},
+        Syntax_Tags::SG_SUBROUTINE_STMT);
+    TEST_TRUE(reparse_outside_arena(file));
+    if (cycle == 0)
+      arena_bytes = arena.bytes_allocated();
+    TEST_INT(arena.bytes_allocated(), arena_bytes);
+  }
+  TEST_TRUE(matches_full_parse(file));
+  return true;
+}
+
+// clang-format off
+std::string const calls_and_uses{
+  "module m\n"
+  "contains\n"
+  "  subroutine a(x)\n"
+  "    use other, only : f\n"
+  "    real :: x\n"
+  "    call f(x)\n"
+  "    if (x > 0) call F(x)\n"
+  "    x = f2(x)\n"
+  "  end subroutine a\n"
+  "  subroutine b(x)\n"
+  "    use another\n"
+  "    real :: x\n"
+  "    call g(x)\n"
+  "  end subroutine b\n"
+  "end module m\n"};
+// clang-format on
+
+/* An updated index must agree with one built from scratch, in order */
+bool matches_full_index(File &file) {
+  Stmt_Index const &index{file.stmt_index()};
+  Stmt_Index fresh;
+  fresh.build(file.statements());
+  TEST_INT(index.size(), fresh.size());
+  for (int const tag : {int{Syntax_Tags::SG_CALL_STMT},
+                        int{Syntax_Tags::SG_USE_STMT},
+                        int{Syntax_Tags::SG_IF_STMT},
+                        int{Syntax_Tags::SG_ASSIGNMENT_STMT}}) {
+    TEST_TRUE(index.with_syntag(tag) == fresh.with_syntag(tag));
+  }
+  for (std::string const name : {"f", "g", "h", "x", "other", "another"}) {
+    TEST_TRUE(index.with_name(name) == fresh.with_name(name));
+  }
+  return true;
+}
+
+bool stmt_index_lookups() {
+  std::istringstream is{calls_and_uses};
+  File file(is, "test.f90", 0);
+  Stmt_Index const &index{file.stmt_index()};
+  TEST_INT(index.size(), file.statements().size());
+
+  /* The if-stmt is listed with the call-stmts, in file order */
+  auto const &calls = index.with_syntag(Syntax_Tags::SG_CALL_STMT);
+  TEST_INT(calls.size(), 3u);
+  TEST_TRUE(calls[0] == nth_stmt(file, 5));
+  TEST_TRUE(calls[1] == nth_stmt(file, 6));
+  TEST_TRUE(calls[2] == nth_stmt(file, 12));
+  TEST_INT(index.with_syntag(Syntax_Tags::SG_IF_STMT).size(), 1u);
+
+  /* Names are matched ignoring case, and only whole names */
+  auto const f_calls = index.with_syntag_and_name(Syntax_Tags::SG_CALL_STMT,
+                                                  "f");
+  TEST_INT(f_calls.size(), 2u);
+  TEST_INT(index.with_name("f").size(), 3u);
+  TEST_INT(index.with_name("f2").size(), 1u);
+  TEST_TRUE(index.with_name("F") == index.with_name("f"));
+  TEST_TRUE(index.with_symbol(Symbol_Table::global().intern("f")) ==
+            index.with_name("f"));
+  TEST_TRUE(index.with_name("never_seen_anywhere").empty());
+  TEST_TRUE(index.with_syntag(Syntax_Tags::SG_STOP_STMT).empty());
+
+  /* From the use-stmts to the Prgm_Tree */
+  auto const uses = file.stmts_to_node_cursors(
+      index.with_syntag_and_name(Syntax_Tags::SG_USE_STMT, "another"));
+  TEST_INT(uses.size(), 1u);
+  auto c = uses.front();
+  TEST_TRUE(c);
+  TEST_INT(c->syntag(), Syntax_Tags::SG_USE_STMT);
+  while (c->syntag() != Syntax_Tags::PG_SUBROUTINE_SUBPROGRAM)
+    c.up();
+  c.down();
+  TEST_EQ(std::string{"b"}, std::next(c->ll_stmt().begin())->text());
+  TEST_TRUE(matches_full_index(file));
+  return true;
+}
+
+bool stmt_index_after_edits() {
+  std::istringstream is{calls_and_uses};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_stmt_index());
+  auto &lf = file.logical_file();
+
+  /* Rename a call, turn an assignment into one, and add another */
+  lf.replace_stmt_substr(nth_stmt(file, 5), nth_token(nth_stmt(file, 5), 1),
+                         "h");
+  lf.replace_stmt_text(nth_stmt(file, 7), {"call g(x)"},
+                       Syntax_Tags::SG_CALL_STMT);
+  lf.emplace_ll_stmt(nth_stmt(file, 12), Logical_Line{"call h(x)"},
+                     Syntax_Tags::SG_CALL_STMT);
+  TEST_TRUE(matches_full_index(file));
+  TEST_TRUE(matches_full_parse(file));
+  Stmt_Index const &index{file.stmt_index()};
+  TEST_INT(index.with_syntag(Syntax_Tags::SG_CALL_STMT).size(), 5u);
+  TEST_INT(index.with_syntag(Syntax_Tags::SG_ASSIGNMENT_STMT).size(), 0u);
+  TEST_INT(index.with_syntag_and_name(Syntax_Tags::SG_CALL_STMT, "h").size(),
+           2u);
+  TEST_INT(index.with_syntag_and_name(Syntax_Tags::SG_CALL_STMT, "f").size(),
+           1u);
+  TEST_TRUE(index.with_name("f2").empty());
+
+  /* Edits made through an Edit_Transaction are picked up too */
+  FLPR::Edit_Transaction edits{lf};
+  auto const last_call = nth_stmt(file, 13);
+  TEST_TRUE(edits.replace_stmt_substr(last_call, nth_token(last_call, 1), "h"));
+  TEST_TRUE(edits.commit());
+  TEST_TRUE(matches_full_index(file));
+  auto const &g_stmts = file.stmt_index().with_name("g");
+  TEST_INT(g_stmts.size(), 1u);
+  TEST_TRUE(g_stmts.front() == nth_stmt(file, 7));
+  auto const c = file.stmt_to_node_cursor(g_stmts.front());
+  TEST_TRUE(c);
+  TEST_TRUE(&c->ll_stmt() == &(*g_stmts.front()));
+  return true;
+}
+
+/* Statements inserted one at a time at the same place use up the positions
+   between their neighbours, which makes the index renumber them */
+bool stmt_index_many_inserts() {
+  std::istringstream is{calls_and_uses};
+  File file(is, "test.f90", 0);
+  TEST_TRUE(file.prefetch_stmt_index());
+  auto const g_call = nth_stmt(file, 12);
+  for (size_t i = 1; i <= 40; ++i) {
+    file.logical_file().emplace_ll_stmt(g_call, Logical_Line{"call h(x)"},
+                                        Syntax_Tags::SG_CALL_STMT);
+    TEST_INT(file.stmt_index().with_name("h").size(), i);
+  }
+  TEST_TRUE(matches_full_index(file));
+  auto const &calls = file.stmt_index().with_syntag(Syntax_Tags::SG_CALL_STMT);
+  TEST_INT(calls.size(), 43u);
+  TEST_TRUE(calls.back() == g_call);
+  TEST_TRUE(calls[2] == nth_stmt(file, 12));
+  return true;
+}
+
+/* Return a printout of the Stmt_Tree of each statement */
+std::string stmt_trees_text(File &file) {
+  std::ostringstream os;
+  for (auto const &stmt : file.statements())
+    os << stmt.stmt_tree() << '\n';
+  return os.str();
+}
+
+/* The rebuilt Stmt_Trees must match those of a freshly parsed copy */
+bool matches_fresh_stmt_trees(File &file) {
+  std::istringstream is{file_text(file)};
+  File fresh(is, "fresh.f90", 0);
+  TEST_TRUE(fresh.prefetch_parse_tree());
+  TEST_EQ_NODISPLAY(stmt_trees_text(fresh), stmt_trees_text(file));
+  return true;
+}
+
+bool stmt_tree_budget() {
+  std::istringstream is{two_subroutines};
+  File file(is, "test.f90", 0);
+  file.set_stmt_tree_budget(1);
+  TEST_TRUE(file.prefetch_parse_tree());
+  auto const *budget = file.stmt_tree_budget();
+  TEST_TRUE(budget != nullptr);
+
+  /* The parse leaves only the syntags */
+  TEST_INT(budget->size(), 0u);
+  TEST_INT(budget->bytes(), 0u);
+  TEST_TRUE(budget->evictions() > 0);
+  for (auto const &stmt : file.statements()) {
+    TEST_FALSE(stmt.has_stmt_tree());
+    TEST_TRUE(stmt.tree_budget() == budget);
+  }
+
+  /* Only the most recently used tree fits */
+  TEST_TRUE(matches_fresh_stmt_trees(file));
+  TEST_INT(budget->size(), 1u);
+  TEST_TRUE(nth_stmt(file, 13)->has_stmt_tree());
+  TEST_FALSE(nth_stmt(file, 12)->has_stmt_tree());
+  TEST_INT(nth_stmt(file, 10)->stmt_tag(true), Syntax_Tags::SG_IF_THEN_STMT);
+
+  /* A pinned tree stays, however many others are used */
+  {
+    auto const pin = nth_stmt(file, 0)->pinned_tree();
+    TEST_INT(pin->ccursor()->syntag, Syntax_Tags::SG_SUBROUTINE_STMT);
+    TEST_TRUE(matches_fresh_stmt_trees(file));
+    TEST_TRUE(nth_stmt(file, 0)->tree_pinned());
+    TEST_TRUE(nth_stmt(file, 0)->has_stmt_tree());
+    TEST_INT(budget->size(), 2u);
+  }
+  TEST_FALSE(nth_stmt(file, 0)->tree_pinned());
+  TEST_TRUE(matches_fresh_stmt_trees(file));
+  TEST_FALSE(nth_stmt(file, 0)->has_stmt_tree());
+  TEST_INT(budget->size(), 1u);
+
+  /* A larger budget holds them all */
+  file.set_stmt_tree_budget(1 << 20);
+  TEST_TRUE(matches_fresh_stmt_trees(file));
+  TEST_INT(budget->size(), file.statements().size());
+  TEST_TRUE(budget->bytes() <= (1u << 20));
+
+  /* Edited and inserted statements are attached when they are re-parsed */
+  auto body = nth_stmt(file, 4);
+  file.logical_file().replace_stmt_text(body, {"x(i) = i"},
+                                        Syntax_Tags::SG_ASSIGNMENT_STMT);
+  file.logical_file().emplace_ll_stmt(body, Logical_Line{"call f(x(i))"},
+                                      Syntax_Tags::SG_CALL_STMT);
+  TEST_TRUE(file.prefetch_parse_tree());
+  TEST_INT(budget->size(), 0u);
+  TEST_TRUE(std::next(body)->tree_budget() == budget);
+  TEST_TRUE(matches_full_parse(file));
+  TEST_TRUE(matches_fresh_stmt_trees(file));
+  TEST_INT(budget->size(), file.statements().size());
+
+  /* Shrinking the budget drops the least recently used trees */
+  size_t const half = budget->bytes() / 2;
+  file.set_stmt_tree_budget(half);
+  TEST_TRUE(budget->bytes() <= half);
+  TEST_FALSE(nth_stmt(file, 0)->has_stmt_tree());
+  TEST_TRUE(nth_stmt(file, 14)->has_stmt_tree());
+
+  /* Without a budget, the trees stay */
+  file.set_stmt_tree_budget(0);
+  TEST_TRUE(file.stmt_tree_budget() == nullptr);
+  TEST_TRUE(nth_stmt(file, 0)->tree_budget() == nullptr);
+  TEST_TRUE(matches_fresh_stmt_trees(file));
+  for (auto const &stmt : file.statements())
+    TEST_TRUE(stmt.has_stmt_tree());
+  return true;
+}
+
+// clang-format off
+std::string const module_source{
+  "module m\n"
+  "  implicit none\n"
+  "  type :: t\n"
+  "    integer :: k = 0\n"
+  "  end type t\n"
+  "contains\n"
+  "  function g(v) result(r)\n"
+  "    class(t), intent(in) :: v\n"
+  "    integer :: r\n"
+  "    select case (v%k)\n"
+  "    case (1:3)\n"
+  "      r = v%k * 2\n"
+  "    case default\n"
+  "      r = -1\n"
+  "    end select\n"
+  "    do while (r < 3)\n"
+  "      r = r + 1\n"
+  "    end do\n"
+  "  end function g\n"
+  "end module m\n"};
+// clang-format on
+
+/* A parse that starts from the prefetched statement trees matches the
+   serial one */
+bool parallel_parse() {
+  for (std::string const &src : {two_subroutines, module_source}) {
+    std::istringstream serial_is{src};
+    File serial(serial_is, "serial.f90", 0);
+    TEST_TRUE(serial.prefetch_parse_tree());
+    for (size_t budget : {size_t{0}, size_t{1}}) {
+      std::istringstream is{src};
+      File file(is, "parallel.f90", 0);
+      file.set_parse_threads(4);
+      TEST_INT(file.parse_threads(), 4);
+      file.set_stmt_tree_budget(budget);
+      TEST_TRUE(file.prefetch_parse_tree());
+      TEST_TRUE(check_links(*file.parse_tree()));
+      TEST_EQ_NODISPLAY(tree_text(serial), tree_text(file));
+      TEST_EQ_NODISPLAY(stmt_trees_text(serial), stmt_trees_text(file));
+    }
+  }
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(edit_in_do_loop);
+  TEST(edit_changes_construct);
+  TEST(edit_in_shared_do);
+  TEST(edits_in_two_constructs);
+  TEST(edit_cycles_stay_flat);
+  TEST(stmt_index_lookups);
+  TEST(stmt_index_after_edits);
+  TEST(stmt_index_many_inserts);
+  TEST(stmt_tree_budget);
+  TEST(parallel_parse);
+
+  TEST_MAIN_REPORT;
+}
@@ -0,0 +1,253 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Project_Index
+*/
+#include "flpr/Project_Index.hh"
+#include "test_helpers.hh"
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using FLPR::Project_Index;
+using File = FLPR::Parsed_File<>;
+using Unit_Kind = Project_Index::Unit_Kind;
+
+// clang-format off
+std::string const base_text{
+  "module base\n"
+  "  use, intrinsic :: iso_c_binding\n"
+  "  integer :: n\n"
+  "  common /shared/ x, y // z\n"
+  "  interface norm\n"
+  "    module procedure norm_r\n"
+  "  end interface norm\n"
+  "  interface operator(+)\n"
+  "    module procedure add\n"
+  "  end interface\n"
+  "contains\n"
+  "  real function norm_r(x)\n"
+  "    real :: x\n"
+  "    norm_r = abs(x)\n"
+  "  end function norm_r\n"
+  "  subroutine add\n"
+  "  contains\n"
+  "    subroutine inner\n"
+  "    end subroutine inner\n"
+  "  end subroutine add\n"
+  "end module base\n"
+};
+
+std::string const middle_text{
+  "module middle\n"
+  "  use :: base, only : n\n"
+  "  use iso_fortran_env\n"
+  "end module middle\n"
+  "subroutine extra\n"
+  "  use middle\n"
+  "end subroutine extra\n"
+};
+
+std::string const top_text{
+  "program top\n"
+  "  use middle\n"
+  "  use base\n"
+  "  call helper\n"
+  "end program top\n"
+  "subroutine helper\n"
+  "  use base\n"
+  "end subroutine helper\n"
+};
+// clang-format on
+
+/* Join a list of names, stripping a directory prefix */
+std::string join(std::vector<std::string> const &names,
+                 std::string const &prefix = std::string{}) {
+  std::string result;
+  for (auto const &n : names) {
+    if (!result.empty())
+      result += ' ';
+    result += (!prefix.empty() && n.compare(0, prefix.size(), prefix) == 0)
+                  ? n.substr(prefix.size())
+                  : n;
+  }
+  return result;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool summaries() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const base = dir.write("base.f90", base_text);
+  std::string const middle = dir.write("middle.f90", middle_text);
+  Project_Index index;
+  TEST_TRUE(index.update_files({base, middle}, 2));
+  TEST_INT(index.size(), 2);
+
+  auto fs = index.summary(base);
+  TEST_TRUE(fs != nullptr);
+  TEST_TRUE(fs->ok);
+  TEST_INT(fs->units.size(), 1);
+  auto const &m = fs->units[0];
+  TEST_TRUE(m.kind == Unit_Kind::MODULE);
+  TEST_EQ(std::string{"base"}, m.name);
+  TEST_INT(m.uses.size(), 1);
+  TEST_EQ(std::string{"iso_c_binding"}, m.uses[0].module);
+  TEST_TRUE(m.uses[0].intrinsic);
+  TEST_EQ(std::string{"norm_r add"}, join(m.procedures));
+  TEST_EQ(std::string{"norm operator(+)"}, join(m.interfaces));
+  TEST_EQ(std::string{"shared"}, join(m.common_blocks));
+
+  fs = index.summary(middle);
+  TEST_TRUE(fs != nullptr);
+  TEST_INT(fs->units.size(), 2);
+  TEST_EQ(std::string{"base iso_fortran_env"},
+          fs->units[0].uses[0].module + ' ' + fs->units[0].uses[1].module);
+  TEST_FALSE(fs->units[0].uses[1].intrinsic);
+  TEST_TRUE(fs->units[1].kind == Unit_Kind::EXTERNAL_SUBPROGRAM);
+  TEST_EQ(std::string{"extra"}, fs->units[1].name);
+  TEST_EQ(std::string{"extra"}, join(fs->units[1].procedures));
+  TEST_EQ(std::string{}, fs->units[1].module_key());
+  return true;
+}
+
+bool dependencies() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const prefix{dir.path + '/'};
+  std::string const base = dir.write("base.f90", base_text);
+  std::string const middle = dir.write("middle.f90", middle_text);
+  std::string const top = dir.write("top.f90", top_text);
+  Project_Index index;
+  TEST_TRUE(index.update_files({top, middle, base}, 3));
+
+  auto const fs = index.summary(top);
+  TEST_INT(fs->units.size(), 2);
+  TEST_TRUE(fs->units[0].kind == Unit_Kind::MAIN_PROGRAM);
+  TEST_TRUE(fs->units[1].kind == Unit_Kind::EXTERNAL_SUBPROGRAM);
+  TEST_EQ(std::string{"helper"}, fs->units[1].name);
+
+  TEST_EQ(base, index.defining_file("base"));
+  TEST_EQ(std::string{}, index.defining_file("nowhere"));
+  TEST_EQ(std::string{"base"}, join(index.module_dependencies("middle")));
+  TEST_EQ(std::string{}, join(index.module_dependencies("base")));
+  TEST_EQ(std::string{"middle"}, join(index.module_dependents("base")));
+  TEST_EQ(std::string{"middle.f90 top.f90"},
+          join(index.files_using("middle"), prefix));
+  TEST_EQ(std::string{"middle.f90 top.f90"},
+          join(index.files_using("base"), prefix));
+  TEST_EQ(std::string{"base.f90"},
+          join(index.file_dependencies(middle), prefix));
+  TEST_EQ(std::string{"base.f90 middle.f90"},
+          join(index.file_dependencies(top), prefix));
+  TEST_EQ(std::string{"middle.f90 top.f90"},
+          join(index.dependent_files(base), prefix));
+  TEST_EQ(std::string{"top.f90"}, join(index.dependent_files(middle), prefix));
+  TEST_EQ(std::string{"iso_fortran_env"}, join(index.unresolved_modules()));
+
+  std::vector<std::string> order;
+  TEST_TRUE(index.build_order(order));
+  TEST_EQ(std::string{"base.f90 middle.f90 top.f90"}, join(order, prefix));
+  return true;
+}
+
+bool cycle() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const prefix{dir.path + '/'};
+  std::string const a =
+      dir.write("a.f90", "module a\n  use b\nend module a\n");
+  std::string const b =
+      dir.write("b.f90", "module b\n  use a\nend module b\n");
+  std::string const c =
+      dir.write("c.f90", "module c\nend module c\n");
+  Project_Index index;
+  TEST_TRUE(index.update_files({a, b, c}, 2));
+  std::vector<std::string> order;
+  std::cerr << "Expect a report of a cycle among a.f90 and b.f90:\n";
+  TEST_FALSE(index.build_order(order));
+  TEST_EQ(std::string{"c.f90"}, join(order, prefix));
+  return true;
+}
+
+bool refresh() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const prefix{dir.path + '/'};
+  std::string const base = dir.write("base.f90", base_text);
+  std::string const middle = dir.write("middle.f90", middle_text);
+  std::string const top = dir.write("top.f90", top_text);
+  Project_Index index;
+  TEST_TRUE(index.update_files({top, middle, base}, 2));
+  TEST_INT(index.refresh(2), 0);
+
+  /* middle no longer uses base, and top is gone */
+  dir.write("middle.f90", "module middle\nend module middle\n");
+  unlink(top.c_str());
+  TEST_INT(index.refresh(2), 2);
+  TEST_INT(index.size(), 2);
+  TEST_TRUE(index.summary(top) == nullptr);
+  TEST_EQ(std::string{}, join(index.module_dependencies("middle")));
+  TEST_EQ(std::string{}, join(index.dependent_files(base), prefix));
+  TEST_TRUE(index.files_using("middle").empty());
+  TEST_EQ(std::string{}, join(index.unresolved_modules()));
+
+  /* A file that won't parse is kept, and tried again */
+  std::string const bad = dir.write(
+      "bad.f90", "module bad\n  use base\nend module bad\nend module\n");
+  std::cerr << "Expect a report that bad.f90 couldn't be parsed:\n";
+  TEST_FALSE(index.update_file(bad));
+  TEST_TRUE(index.summary(bad) != nullptr);
+  TEST_FALSE(index.summary(bad)->ok);
+  TEST_TRUE(index.files_using("base").empty());
+  dir.write("bad.f90", "module bad\n  use base\nend module bad\n");
+  TEST_INT(index.refresh(1), 1);
+  TEST_TRUE(index.summary(bad)->ok);
+  TEST_EQ(std::string{"bad.f90"}, join(index.files_using("base"), prefix));
+  return true;
+}
+
+bool from_parsed_file() {
+  Temp_Dir dir;
+  TEST_TRUE(bool(dir));
+  std::string const base = dir.write("base.f90", base_text);
+  std::string const middle = dir.write("middle.f90", middle_text);
+  Project_Index index;
+  TEST_TRUE(index.update_file(base));
+  File file(middle, 0);
+  TEST_TRUE(index.update_file(middle, file));
+  TEST_EQ(std::string{"base"}, join(index.module_dependencies("middle")));
+  TEST_EQ(std::string{"iso_fortran_env"}, join(index.unresolved_modules()));
+
+  /* Dropping a file removes what it provides */
+  TEST_TRUE(index.remove_file(base));
+  TEST_FALSE(index.remove_file(base));
+  TEST_EQ(std::string{"base iso_fortran_env"},
+          join(index.unresolved_modules()));
+  std::vector<std::string> order;
+  TEST_TRUE(index.build_order(order));
+  TEST_INT(order.size(), 1);
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(summaries);
+  TEST(dependencies);
+  TEST(cycle);
+  TEST(refresh);
+  TEST(from_parsed_file);
+
+  TEST_MAIN_REPORT;
+}
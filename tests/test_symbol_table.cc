@@ -0,0 +1,139 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+  Testing for Symbol_Table, and the Token_Text symbols that use it
+*/
+#include "flpr/Logical_Line.hh"
+#include "flpr/Symbol_Table.hh"
+#include "test_helpers.hh"
+#include <string>
+#include <thread>
+#include <vector>
+
+using FLPR::Logical_Line;
+using FLPR::Symbol_Table;
+using FLPR::Token_Text;
+
+bool intern_folds_case() {
+  Symbol_Table table;
+  TEST_INT(table.size(), 0u);
+  TEST_INT(table.find("abc"), Symbol_Table::none);
+  Symbol_Table::Symbol const abc = table.intern("abc");
+  TEST_INT(table.intern("ABC"), abc);
+  TEST_INT(table.intern("aBc"), abc);
+  TEST_INT(table.find("AbC"), abc);
+  TEST_STR("abc", table.spelling(abc));
+  TEST_INT(table.size(), 1u);
+
+  Symbol_Table::Symbol const abcd = table.intern("Abc_D");
+  TEST_TRUE(abcd != abc);
+  TEST_STR("abc_d", table.spelling(abcd));
+  /* Only ASCII letters are folded */
+  TEST_TRUE(table.intern("x_1") != table.intern("X_2"));
+  TEST_INT(table.size(), 4u);
+  return true;
+}
+
+bool spellings_stay_put() {
+  Symbol_Table table;
+  std::string const &first = table.spelling(table.intern("first"));
+  for (int i = 0; i < 10000; ++i)
+    table.intern("name_" + std::to_string(i));
+  TEST_STR("first", first);
+  TEST_INT(table.size(), 10001u);
+  TEST_STR("name_9999", table.spelling(table.find("NAME_9999")));
+  return true;
+}
+
+bool concurrent_intern() {
+  Symbol_Table table;
+  int const num_threads = 4;
+  int const num_names = 2000;
+  std::vector<std::vector<Symbol_Table::Symbol>> syms(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&table, &syms, t] {
+      /* Every thread interns the same names, in different cases */
+      for (int i = 0; i < num_names; ++i) {
+        std::string name{"var_" + std::to_string(i)};
+        if (t & 1)
+          name[0] = 'V';
+        syms[t].push_back(table.intern(name));
+      }
+    });
+  }
+  for (auto &th : threads)
+    th.join();
+  TEST_INT(table.size(), static_cast<size_t>(num_names));
+  for (int t = 1; t < num_threads; ++t)
+    TEST_TRUE(syms[t] == syms[0]);
+  return true;
+}
+
+bool token_symbols() {
+  Logical_Line ll{"call Foo(foo, FOO, bar)"};
+  std::vector<Token_Text const *> toks;
+  for (Token_Text const &tt : ll.fragments())
+    toks.push_back(&tt);
+  TEST_INT(toks.size(), 9u);
+  TEST_STR("Foo", toks[1]->text());
+  TEST_INT(toks[1]->symbol(), toks[3]->symbol());
+  TEST_INT(toks[1]->symbol(), toks[5]->symbol());
+  TEST_TRUE(toks[1]->symbol() != toks[7]->symbol());
+  TEST_INT(toks[1]->symbol(), Symbol_Table::global().find("foo"));
+  TEST_STR("foo", toks[1]->lower());
+  return true;
+}
+
+bool only_names_interned() {
+  Logical_Line ll{"X = 'Some Text' // 1.5E3_DP .EQ. y"};
+  size_t const before = Symbol_Table::global().size();
+  std::vector<std::string> lowered;
+  for (Token_Text const &tt : ll.fragments()) {
+    lowered.push_back(tt.lower());
+    if (!FLPR::Syntax_Tags::is_name(tt.token))
+      TEST_INT(tt.symbol(), Symbol_Table::none);
+  }
+  TEST_INT(lowered.size(), 11u);
+  TEST_STR("x", lowered[0]);
+  TEST_STR("'some text'", lowered[2]);
+  TEST_STR("e", lowered[5]);
+  TEST_STR("dp", lowered[8]);
+  TEST_STR(".eq.", lowered[9]);
+  TEST_STR("y", lowered[10]);
+  /* At most x and y were added */
+  TEST_TRUE(Symbol_Table::global().size() <= before + 2);
+  TEST_INT(Symbol_Table::global().find("'some text'"), Symbol_Table::none);
+  TEST_INT(Symbol_Table::global().find(".eq."), Symbol_Table::none);
+  return true;
+}
+
+bool mod_text_resets_symbol() {
+  Token_Text tt{std::string{"Alpha"}, FLPR::Syntax_Tags::TK_NAME, 1, 1};
+  Symbol_Table::Symbol const alpha = tt.symbol();
+  TEST_STR("alpha", tt.lower());
+  tt.mod_text() = "BETA";
+  TEST_TRUE(tt.symbol() != alpha);
+  TEST_STR("beta", tt.lower());
+  TEST_INT(tt.symbol(), Symbol_Table::global().find("beta"));
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+  TEST(intern_folds_case);
+  TEST(spellings_stay_put);
+  TEST(concurrent_intern);
+  TEST(token_symbols);
+  TEST(only_names_interned);
+  TEST(mod_text_resets_symbol);
+  TEST_MAIN_REPORT;
+}
@@ -0,0 +1,218 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Text_Writer
+*/
+#include "flpr/Logical_File.hh"
+#include "flpr/Text_Writer.hh"
+#include "test_helpers.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using FLPR::Logical_File;
+using FLPR::Text_Writer;
+
+/* Return the text of lf, printed through iostreams */
+std::string stream_text(Logical_File const &lf) {
+  std::ostringstream os;
+  for (auto const &ll : lf.lines)
+    os << ll;
+  return os.str();
+}
+
+/* Return the contents of a file */
+std::string slurp(std::string const &fname) {
+  std::ifstream is(fname);
+  return std::string{std::istreambuf_iterator<char>(is),
+                     std::istreambuf_iterator<char>()};
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool matches_ostream_free() {
+  // clang-format off
+  std::istringstream is{
+    "! comment\n"
+    "subroutine s(x) ! trailing\n"
+    "\n"
+    "  x = 1 + &\n"
+    "      & 2   \n"
+    "10 continue; x = 3\n"
+    "#ifdef FOO\n"
+    "end subroutine\n"};
+  // clang-format on
+  Logical_File lf;
+  TEST_TRUE(lf.read_and_scan(is, "test.f90", 0));
+  Text_Writer out;
+  out.append(lf.lines);
+  TEST_EQ_NODISPLAY(stream_text(lf), std::string{out.text()});
+  return true;
+}
+
+bool matches_ostream_fixed() {
+  // clang-format off
+  std::istringstream is{
+    "c comment\n"
+    "      subroutine s(x)\n"
+    "      x = 1 +\n"
+    "     &    2\n"
+    "   10 continue\n"
+    "      end\n"};
+  // clang-format on
+  Logical_File lf;
+  TEST_TRUE(lf.read_and_scan(is, "test.f", 72));
+  lf.make_stmts();
+  /* Relabel a statement, so that the label field has to be padded out */
+  lf.set_stmt_label(std::next(lf.ll_stmts.begin()), 5);
+  Text_Writer out;
+  out.append(lf.lines);
+  TEST_EQ_NODISPLAY(stream_text(lf), std::string{out.text()});
+  out.clear();
+  TEST_TRUE(out.empty());
+  return true;
+}
+
+bool passthrough() {
+  // clang-format off
+  std::string const text{
+    "c comment\n"
+    "      subroutine s(x)\n"
+    "   x = 1\n"
+    "   10 continue\n"
+    "      x = 2\n"
+    "      end\n"};
+  // clang-format on
+  std::istringstream is{text};
+  Logical_File lf;
+  TEST_TRUE(lf.read_and_scan(is, "test.f", 72));
+
+  /* Untouched lines are copied exactly, even where operator<< would realign
+     the main text */
+  Text_Writer out;
+  out.append(lf.lines);
+  TEST_EQ_NODISPLAY(text, std::string{out.text()});
+  TEST_FALSE(text == stream_text(lf));
+
+  /* Only the edited statement is rendered */
+  lf.make_stmts();
+  auto stmt = std::next(lf.ll_stmts.begin(), 3);
+  lf.replace_stmt_text(stmt, {"x = 3"}, FLPR::Syntax_Tags::SG_ASSIGNMENT_STMT);
+  out.clear();
+  out.append(lf.lines);
+  // clang-format off
+  TEST_EQ_NODISPLAY(std::string{"c comment\n"
+                                "      subroutine s(x)\n"
+                                "   x = 1\n"
+                                "   10 continue\n"
+                                "      x = 3\n"
+                                "      end\n"},
+                    std::string{out.text()});
+  // clang-format on
+  return true;
+}
+
+/* A file without a final newline is copied without adding one */
+bool no_final_newline() {
+  for (char const *const end : {"", "   "}) {
+    std::string const text{std::string{"program p\n  x = 1\nend program p"} +
+                           end};
+    std::istringstream is{text};
+    Logical_File lf;
+    TEST_TRUE(lf.read_and_scan(is, "test.f90", 0));
+    Text_Writer out;
+    out.append(lf.lines);
+    TEST_EQ_NODISPLAY(text, std::string{out.text()});
+
+    /* Rendering the last line, rather than copying it, agrees */
+    lf.make_stmts();
+    lf.ll_stmts.back().set_leading_spaces(2, 2);
+    out.clear();
+    out.append(lf.lines);
+    TEST_EQ(std::string{"program p\n  x = 1\n  end program p"} + end,
+            std::string{out.text()});
+  }
+  return true;
+}
+
+bool write_to_fd() {
+  std::FILE *f = std::tmpfile();
+  TEST_TRUE(f != nullptr);
+  Text_Writer out;
+  std::istringstream is{"program p\nend program p\n"};
+  Logical_File lf;
+  TEST_TRUE(lf.read_and_scan(is, "test.f90", 0));
+  out.append(lf.lines);
+  std::string const expected{out.text()};
+  TEST_TRUE(out.write(fileno(f)));
+  TEST_TRUE(out.empty());
+  std::rewind(f);
+  std::string got(expected.size() + 1, '\0');
+  got.resize(std::fread(got.data(), 1, got.size(), f));
+  std::fclose(f);
+  TEST_EQ_NODISPLAY(expected, got);
+  return true;
+}
+
+bool replace_file() {
+  std::string const original{"program p\n  x = 1\nend program p\n"};
+  char name[] = "/tmp/test_text_writer.XXXXXX";
+  int const fd = mkstemp(name);
+  TEST_TRUE(fd >= 0);
+  TEST_INT(write(fd, original.data(), original.size()),
+           static_cast<ssize_t>(original.size()));
+  TEST_INT(fchmod(fd, 0640), 0);
+  close(fd);
+  struct stat before;
+  TEST_INT(stat(name, &before), 0);
+
+  std::istringstream is{original};
+  Logical_File lf;
+  TEST_TRUE(lf.read_and_scan(is, "test.f90", 0));
+
+  /* Unchanged text leaves the file alone */
+  Text_Writer out;
+  out.append(lf.lines);
+  TEST_TRUE(out.replace_file(name, original));
+  TEST_TRUE(out.empty());
+  struct stat after;
+  TEST_INT(stat(name, &after), 0);
+  TEST_TRUE(before.st_ino == after.st_ino);
+
+  /* Changed text replaces it, keeping the permissions */
+  lf.lines.front().suppress = true;
+  out.append(lf.lines);
+  TEST_TRUE(out.replace_file(name, original));
+  TEST_INT(stat(name, &after), 0);
+  TEST_FALSE(before.st_ino == after.st_ino);
+  TEST_INT((after.st_mode & 07777), 0640u);
+  TEST_EQ_NODISPLAY(std::string{"  x = 1\nend program p\n"}, slurp(name));
+  unlink(name);
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(matches_ostream_free);
+  TEST(matches_ostream_fixed);
+  TEST(passthrough);
+  TEST(no_final_newline);
+  TEST(write_to_fd);
+  TEST(replace_file);
+
+  TEST_MAIN_REPORT;
+}
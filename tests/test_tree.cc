@@ -271,6 +271,36 @@ bool graft_front() {
   return true;
 }
 
+bool clone() {
+  Tree<int> t{1};
+  auto c = t.cursor();
+  t->emplace_back(Tree<int>::node(2));
+  t->emplace_back(Tree<int>::node(3));
+  c.down();
+  c.node().emplace_back(Tree<int>::node(4));
+
+  Tree<int> copy = t.clone();
+  copy.check();
+  TEST_INT(copy.size(), 4);
+  TEST_INT(**copy, 1);
+  auto cc = copy.cursor();
+  cc.down();
+  TEST_INT(*cc, 2);
+  TEST_INT(cc.num_branches(), 1);
+  TEST_INT(*cc.node().branches().front(), 4);
+  cc.next();
+  TEST_INT(*cc, 3);
+  TEST_TRUE(cc.is_leaf());
+
+  /* the copy is independent of the original */
+  *cc = 30;
+  TEST_INT(*t->branches().back(), 3);
+
+  Tree<int> empty;
+  TEST_FALSE(empty.clone());
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
 
@@ -285,6 +315,7 @@ int main() {
   TEST(graft_front);
   TEST(cursor);
   TEST(const_cursor);
+  TEST(clone);
 
   TEST_MAIN_REPORT;
 }
@@ -0,0 +1,254 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Tree_Image and Tree_Image_Writer
+*/
+#include "flpr/Parsed_File.hh"
+#include "flpr/Tree_Image_Writer.hh"
+#include "test_helpers.hh"
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using FLPR::Syntax_Tags;
+using FLPR::Tree_Image;
+using FLPR::Tree_Image_Writer;
+using File = FLPR::Parsed_File<>;
+using Node = File::Parse_Tree::node;
+using ST_Node = FLPR::Stmt::Stmt_Tree::node;
+
+// clang-format off
+std::string const free_text{
+  "module m\n"
+  "  integer :: n = 3 ! trailing\n"
+  "contains\n"
+  "  subroutine a(x)\n"
+  "    real :: x(n)\n"
+  "    integer :: i, j\n"
+  "    do 10 i = 1, n\n"
+  "    do 10 j = 1, &\n"
+  "         & n\n"
+  "10  x(i) = x(i) + j\n"
+  "    if (x(1) > 0) then\n"
+  "      x(1) = 0; x(2) = 1\n"
+  "    end if\n"
+  "  end subroutine a\n"
+  "end module m\n"};
+// clang-format on
+
+/* An image of a Stmt_Tree must match it node for node */
+bool same_stmt_tree(Tree_Image const &image, Tree_Image::Node const &in,
+                    ST_Node const &n) {
+  TEST_TRUE(bool(in));
+  TEST_INT(in.syntag(), n->syntag);
+  TEST_FALSE(in.is_stmt());
+  TEST_INT(in.num_branches(), n.num_branches());
+  TEST_EQ(range_text(n->token_range, true), span_text(image, in));
+  if (n.is_fork()) {
+    auto ib = in.branches().begin();
+    for (auto const &b : n.branches()) {
+      TEST_TRUE(same_stmt_tree(image, *ib, b));
+      ++ib;
+    }
+    TEST_TRUE(ib == in.branches().end());
+  }
+  return true;
+}
+
+/* ... and so must an image of a Prgm_Tree */
+bool same_prgm_tree(Tree_Image const &image, Tree_Image::Node const &in,
+                    Node const &n) {
+  TEST_TRUE(bool(in));
+  TEST_INT(in.syntag(), n->syntag());
+  TEST_INT(in.is_stmt(), n->is_stmt());
+  if (n->is_stmt()) {
+    TEST_EQ(range_text(n->ll_stmt(), true), span_text(image, in));
+    TEST_INT(in.num_branches(), 1u);
+    return same_stmt_tree(image, in.first_branch(),
+                          *n->ll_stmt().stmt_tree());
+  }
+  TEST_INT(in.num_branches(), n.num_branches());
+  if (n.is_fork()) {
+    auto ib = in.branches().begin();
+    for (auto const &b : n.branches()) {
+      TEST_TRUE(same_prgm_tree(image, *ib, b));
+      /* Each branch lies within its parent */
+      TEST_TRUE(ib->token_begin() >= in.token_begin());
+      TEST_TRUE(ib->token_end() <= in.token_end());
+      ++ib;
+    }
+    TEST_TRUE(ib == in.branches().end());
+  }
+  return true;
+}
+
+/* Visit every node of an image, returning the number visited */
+std::size_t count_nodes(Tree_Image::Node const &n) {
+  std::size_t count{1};
+  for (auto const &b : n.branches())
+    count += count_nodes(b);
+  return count;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool prgm_tree() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  Tree_Image_Writer writer;
+  TEST_TRUE(writer.encode(file.parse_tree(), "m.f90"));
+
+  Tree_Image const image = Tree_Image::from_string(writer.image());
+  TEST_TRUE(bool(image));
+  TEST_TRUE(image.kind() == Tree_Image::Kind::PRGM_TREE);
+  TEST_EQ(std::string{"m.f90"}, std::string{image.source_name()});
+  TEST_FALSE(image.empty());
+  TEST_TRUE(same_prgm_tree(image, image.root(), *file.parse_tree()));
+
+  /* The first and last tokens of the file */
+  TEST_EQ(std::string{"module"}, std::string{image.token(0).text});
+  auto const last = image.token(image.num_tokens() - 1);
+  TEST_EQ(std::string{"m"}, std::string{last.text});
+  TEST_INT(last.line, 15);
+  TEST_INT(last.col, 12);
+  TEST_INT(image.root().token_end(), image.num_tokens());
+  return true;
+}
+
+bool without_stmt_trees() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  Tree_Image_Writer writer;
+  TEST_TRUE(writer.encode(file.parse_tree(), "m.f90", false));
+  std::size_t const small = writer.image().size();
+  Tree_Image const image = Tree_Image::from_string(writer.image());
+  TEST_TRUE(bool(image));
+
+  /* The statement leaves are leaves */
+  std::size_t stmts{0};
+  Tree_Image::Node n = image.root();
+  TEST_INT(n.num_branches(), 1u);
+  n = n.first_branch().first_branch();
+  TEST_INT(n.syntag(), Syntax_Tags::PG_MODULE);
+  for (auto const &b : n.branches()) {
+    if (b.is_stmt()) {
+      TEST_TRUE(b.is_leaf());
+      stmts += 1;
+    }
+  }
+  TEST_INT(stmts, 2u);
+
+  TEST_TRUE(writer.encode(file.parse_tree(), "m.f90"));
+  TEST_TRUE(small < writer.image().size());
+  return true;
+}
+
+bool stmt_tree() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  TEST_TRUE(file.prefetch_parse_tree());
+  auto const &stmt = *std::next(file.statements().begin(), 8);
+  auto const &st = stmt.stmt_tree();
+  Tree_Image_Writer writer;
+  TEST_TRUE(writer.encode(st));
+  Tree_Image const image = Tree_Image::from_string(writer.image());
+  TEST_TRUE(bool(image));
+  TEST_TRUE(image.kind() == Tree_Image::Kind::STMT_TREE);
+  TEST_TRUE(image.source_name().empty());
+  TEST_INT(image.num_tokens(), (*st)->token_range.size());
+  TEST_EQ(std::string{"x"}, std::string{image.token(0).text});
+  TEST_TRUE(same_stmt_tree(image, image.root(), *st));
+
+  /* An empty tree */
+  TEST_TRUE(writer.encode(FLPR::Stmt::Stmt_Tree{}));
+  Tree_Image const empty = Tree_Image::from_string(writer.image());
+  TEST_TRUE(bool(empty));
+  TEST_TRUE(empty.empty());
+  TEST_FALSE(bool(empty.root()));
+  TEST_INT(empty.num_tokens(), 0u);
+  return true;
+}
+
+bool file_round_trip() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  Tree_Image_Writer writer;
+  TEST_TRUE(writer.encode(file.parse_tree(), "m.f90"));
+  char name[] = "/tmp/test_tree_image.XXXXXX";
+  int const fd = mkstemp(name);
+  TEST_TRUE(fd >= 0);
+  close(fd);
+  TEST_TRUE(writer.save(name));
+
+  Tree_Image const image = Tree_Image::from_file(name);
+  unlink(name);
+  TEST_TRUE(bool(image));
+  TEST_TRUE(same_prgm_tree(image, image.root(), *file.parse_tree()));
+
+  /* The subtree sizes let siblings be skipped without decoding them */
+  auto const module = image.root().first_branch().first_branch();
+  Tree_Image::Node last;
+  std::size_t count{0};
+  for (auto const &b : module.branches()) {
+    last = b;
+    count += 1;
+  }
+  TEST_INT(count, module.num_branches());
+  TEST_TRUE(last.is_stmt());
+  TEST_FALSE(bool(last.next_sibling()));
+  auto const end = image.token(last.token_begin());
+  TEST_EQ(std::string{"end"}, std::string{end.text});
+
+  TEST_FALSE(bool(Tree_Image::from_file("/no/such/file.flprt")));
+  return true;
+}
+
+bool corrupt_image() {
+  std::istringstream is{free_text};
+  File file(is, "m.f90", 0);
+  Tree_Image_Writer writer;
+  TEST_TRUE(writer.encode(file.parse_tree(), "m.f90"));
+  std::string const good = writer.image();
+
+  /* Wrong magic or version, or truncated */
+  std::string bad{good};
+  bad[0] = 'X';
+  TEST_FALSE(bool(Tree_Image::from_string(bad)));
+  bad = good;
+  bad[Tree_Image::magic.size()] += 1;
+  TEST_FALSE(bool(Tree_Image::from_string(bad)));
+  for (std::size_t size : {good.size() / 4, good.size() / 2, good.size() - 1})
+    TEST_FALSE(bool(Tree_Image::from_string(good.substr(0, size))));
+
+  /* Damage to the nodes must not lead outside of the image */
+  for (std::size_t i = good.size() / 2; i < good.size(); i += 7) {
+    bad = good;
+    bad[i] = static_cast<char>(0xff);
+    Tree_Image const damaged = Tree_Image::from_string(bad);
+    if (damaged)
+      TEST_TRUE(count_nodes(damaged.root()) < bad.size());
+  }
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(prgm_tree);
+  TEST(without_stmt_trees);
+  TEST(stmt_tree);
+  TEST(file_round_trip);
+  TEST(corrupt_image);
+
+  TEST_MAIN_REPORT;
+}
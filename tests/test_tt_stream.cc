@@ -80,6 +80,47 @@ bool test_chop_at_open_paren() {
   return true;
 }
 
+/* Streams over the same statement can share one TT_Array */
+bool test_shared_array() {
+  LL_Helper l({"if (a) b = c"});
+  LL_Stmt &stmt = l.ll_stmts().front();
+  TT_Array toks{stmt};
+  TT_Stream ts1{stmt, toks};
+  TT_Stream ts2{stmt, toks};
+  ts1.consume(3);
+  TEST_EQ(ts2.peek(), Syntax_Tags::KW_IF);
+  ts1.rewind();
+  ts1.unkeyword(1);
+  TEST_EQ(ts2.peek(), Syntax_Tags::TK_NAME);
+  TEST_EQ(toks[0].token, Syntax_Tags::TK_NAME);
+
+  /* Stream positions of captures and iterators */
+  ts2.consume(4);
+  auto cap = ts2.capture_begin();
+  ts2.consume(2);
+  ts2.capture_end(cap);
+  TEST_INT(ts2.capture_to_range(cap).size(), 2);
+  cap = ts2.capture_begin();
+  ts2.put_back();
+  ts2.put_back();
+  ts2.capture_end(cap);
+  TEST_TRUE(ts2.capture_to_range(cap).empty());
+  ts2.rewind(toks.at(5));
+  TEST_INT(ts2.num_consumed(), 5);
+  ts2.rewind(toks.at(toks.size()));
+  TEST_INT(ts2.num_consumed(), 7);
+
+  /* A stream that is moved takes its own TT_Array along */
+  TT_Stream own = l.stream1();
+  own.consume(2);
+  TT_Stream moved{std::move(own)};
+  TEST_EQ(moved.peek(), Syntax_Tags::TK_NAME);
+  TEST_INT(moved.num_consumed(), 2);
+  moved.consume_until_eol();
+  TEST_INT(moved.num_consumed(), 7);
+  return true;
+}
+
 bool test_consume_until_eol() {
   {
     LL_Helper l({"(this is a test)"});
@@ -182,8 +223,63 @@ bool test_move_before_close_paren() {
   return true;
 }
 
+bool test_tt_array() {
+  TT_List tl;
+  tl.emplace_back(std::string{"IF"}, Syntax_Tags::KW_IF, 1, 1);
+  tl.emplace_back(std::string{"("}, Syntax_Tags::TK_PARENL, 1, 3);
+  tl.emplace_back(std::string{"Foo"}, Syntax_Tags::TK_NAME, 1, 4);
+  TT_Range r{tl};
+  TT_Array a{r};
+  TEST_INT(a.size(), 3);
+  TEST_EQ(a[0].token, Syntax_Tags::KW_IF);
+  TEST_INT(a[2].length, 3);
+  TEST_TRUE(a[2].tt == std::prev(tl.end()));
+  TEST_TRUE(a.at(3) == tl.end());
+  TEST_INT(a.index_of(std::next(tl.begin())), 1);
+  TEST_INT(a[0].fold_hash, TT_Array::fold_hash("if"));
+  TEST_INT(a[2].fold_hash, TT_Array::fold_hash("fOO"));
+  TEST_TRUE(a[2].fold_hash != TT_Array::fold_hash("bar"));
+
+  /* the entries are a snapshot until refreshed */
+  tl.front().token = Syntax_Tags::TK_NAME;
+  TEST_EQ(a[0].token, Syntax_Tags::KW_IF);
+  a.refresh();
+  TEST_EQ(a[0].token, Syntax_Tags::TK_NAME);
+  return true;
+}
+
+bool test_mark_rewind() {
+  LL_Helper l({"if (a) b = c"});
+  TT_Stream ts = l.stream1();
+  ts.consume(2);
+  auto m = ts.mark();
+  auto it = ts.next_iterator();
+  ts.consume_until_eol();
+  ts.rewind(m);
+  TEST_EQ(ts.peek(), Syntax_Tags::TK_NAME);
+  TEST_INT(ts.num_consumed(), 2);
+  ts.consume_until_eol();
+  ts.rewind(it);
+  TEST_INT(ts.num_consumed(), 2);
+  TEST_INT(ts.peek_length(), 1);
+  TEST_INT(ts.peek_fold_hash(), TT_Array::fold_hash("A"));
+  ts.consume(100);
+  TEST_TRUE(ts.is_eol());
+  TEST_INT(ts.peek_length(), 0);
+
+  /* unkeyword updates the stream as well as the Token_Texts */
+  ts.rewind();
+  TEST_EQ(ts.peek(), Syntax_Tags::KW_IF);
+  ts.unkeyword(1);
+  TEST_EQ(ts.peek(), Syntax_Tags::TK_NAME);
+  return true;
+}
+
 int main() {
   TEST_MAIN_DECL;
+  TEST(test_tt_array);
+  TEST(test_mark_rewind);
+  TEST(test_shared_array);
   TEST(test_consume_until_eol);
   TEST(test_move_to_close_paren);
   TEST(test_move_to_open_paren);
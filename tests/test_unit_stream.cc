@@ -0,0 +1,129 @@
+/*
+   Copyright (c) 2019-2020, Triad National Security, LLC. All rights reserved.
+
+   This is open source software; you can redistribute it and/or modify it
+   under the terms of the BSD-3 License. If software is modified to produce
+   derivative works, such modified software should be clearly marked, so as
+   not to confuse it with the version available from LANL. Full text of the
+   BSD-3 License can be found in the LICENSE file of the repository.
+*/
+
+/*
+   Testing for Unit_Stream
+*/
+#include "flpr/Unit_Stream.hh"
+#include "test_helpers.hh"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using FLPR::Text_Buffer;
+using Units = FLPR::Unit_Stream<>;
+
+/* Read all of the units in text, returning the first line number of each,
+   and the concatenation of their output */
+bool read_units(std::string const &text, std::vector<int> &first_lines,
+                std::string &output) {
+  Units units{Text_Buffer::from_string(std::string{text}), "units.f90", 0};
+  std::ostringstream os;
+  while (auto unit = units.next()) {
+    TEST_TRUE(bool(*unit));
+    TEST_FALSE(unit->parse_tree().empty());
+    TEST_TRUE(bool(*unit));
+    first_lines.push_back(unit->logical_lines().front().start_line());
+    for (auto const &ll : unit->logical_lines())
+      os << ll;
+  }
+  TEST_FALSE(bool(units));
+  output = os.str();
+  return true;
+}
+
+/* -------------------------- The unit tests ---------------------------- */
+
+bool three_units() {
+  // clang-format off
+  std::string const text{
+    "! leading comment\n"
+    "subroutine a(f)\n"
+    "  interface\n"
+    "    function f(x)\n"
+    "      real :: x, f\n"
+    "    end function f\n"
+    "  end interface\n"
+    "end subroutine a\n"
+    "module m\n"
+    "contains\n"
+    "  subroutine s\n"
+    "  end subroutine\n"
+    "  function g()\n"
+    "    integer :: g\n"
+    "    g = 1\n"
+    "  end function g\n"
+    "end module m\n"
+    "program p\n"
+    "  use m\n"
+    "  call s\n"
+    "end program p\n"
+    "! trailing comment\n"};
+  // clang-format on
+  std::vector<int> first_lines;
+  std::string output;
+  TEST_TRUE(read_units(text, first_lines, output));
+  TEST_INT(first_lines.size(), 3);
+  TEST_INT(first_lines[0], 1);
+  TEST_INT(first_lines[1], 9);
+  TEST_INT(first_lines[2], 18);
+  TEST_EQ_NODISPLAY(text, output);
+  return true;
+}
+
+bool end_without_start() {
+  // clang-format off
+  std::string const text{
+    "x = 1\n"
+    "end\n"
+    "subroutine s; end subroutine s\n"
+    "subroutine t\n"
+    "end subroutine t; subroutine u\n"
+    "end subroutine u\n"};
+  // clang-format on
+  std::vector<int> first_lines;
+  std::string output;
+  TEST_TRUE(read_units(text, first_lines, output));
+  /* A compound line can't be split between units */
+  TEST_INT(first_lines.size(), 3);
+  TEST_INT(first_lines[0], 1);
+  TEST_INT(first_lines[1], 3);
+  TEST_INT(first_lines[2], 4);
+  TEST_EQ_NODISPLAY(text, output);
+  return true;
+}
+
+bool window_growth() {
+  /* The first unit is larger than the initial window */
+  std::string text{"subroutine big\n"};
+  int const N = FLPR::Unit_Splitter::initial_window / 2 + 10;
+  for (int i = 0; i < N; ++i)
+    text += "  x = x + &\n    1\n";
+  text += "end subroutine big\n";
+  text += "subroutine small\n";
+  text += "end subroutine small\n";
+  std::vector<int> first_lines;
+  std::string output;
+  TEST_TRUE(read_units(text, first_lines, output));
+  TEST_INT(first_lines.size(), 2);
+  TEST_INT(first_lines[1], 2 * N + 3);
+  TEST_EQ_NODISPLAY(text, output);
+  return true;
+}
+
+int main() {
+  TEST_MAIN_DECL;
+
+  TEST(three_units);
+  TEST(end_without_start);
+  TEST(window_growth);
+
+  TEST_MAIN_REPORT;
+}